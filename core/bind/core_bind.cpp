@@ -2474,6 +2474,162 @@ _Thread::~_Thread() {
 }
 /////////////////////////////////////
 
+_WorkerThreadPool *_WorkerThreadPool::singleton = NULL;
+
+void _WorkerThreadPool::_call(ScriptTask *p_task, const Variant **p_args, int p_argcount) {
+
+	Object *instance = ObjectDB::get_instance(p_task->instance);
+	if (!instance) {
+		ERR_EXPLAIN("Instance running task method '" + String(p_task->method) + "' was freed.");
+		ERR_FAIL();
+	}
+
+	Variant::CallError ce;
+	instance->call(p_task->method, p_args, p_argcount, ce);
+	if (ce.error != Variant::CallError::CALL_OK) {
+		ERR_EXPLAIN("Error running task: " + Variant::get_call_error_text(instance, p_task->method, p_args, p_argcount, ce));
+		ERR_FAIL();
+	}
+}
+
+void _WorkerThreadPool::_run_task(ScriptTask *p_task) {
+
+	const Variant *args[1] = { &p_task->userdata };
+	_call(p_task, args, 1);
+}
+
+void _WorkerThreadPool::_run_group_task(uint32_t p_index, ScriptTask *p_task) {
+
+	Variant index = p_index;
+	const Variant *args[2] = { &index, &p_task->userdata };
+	_call(p_task, args, 2);
+}
+
+_WorkerThreadPool::ScriptTask *_WorkerThreadPool::_take_script_task(Map<uint32_t, ScriptTask *> &p_map, uint32_t p_id) {
+
+	MutexLock lock(mutex);
+
+	Map<uint32_t, ScriptTask *>::Element *E = p_map.find(p_id);
+	if (!E)
+		return NULL;
+
+	ScriptTask *task = E->get();
+	p_map.erase(E);
+	return task;
+}
+
+int _WorkerThreadPool::add_task(Object *p_instance, const StringName &p_method, const Variant &p_userdata, const PoolIntArray &p_dependencies) {
+
+	ERR_FAIL_COND_V(!p_instance, 0);
+	ERR_FAIL_COND_V(p_method == StringName(), 0);
+
+	ScriptTask *task = memnew(ScriptTask);
+	task->instance = p_instance->get_instance_id();
+	task->method = p_method;
+	task->userdata = p_userdata;
+
+	Vector<ThreadWorkPool::TaskID> dependencies;
+	dependencies.resize(p_dependencies.size());
+	PoolIntArray::Read r = p_dependencies.read();
+	for (int i = 0; i < p_dependencies.size(); i++) {
+		dependencies.write[i] = r[i];
+	}
+
+	// Register before adding, the task may complete (and be waited for) right away.
+	MutexLock lock(mutex);
+	ThreadWorkPool::TaskID id = ThreadWorkPool::get_singleton()->add_task(this, &_WorkerThreadPool::_run_task, task, dependencies);
+	tasks[id] = task;
+
+	return id;
+}
+
+bool _WorkerThreadPool::is_task_completed(int p_task) const {
+
+	return ThreadWorkPool::get_singleton()->is_task_completed(p_task);
+}
+
+void _WorkerThreadPool::wait_for_task_completion(int p_task) {
+
+	ScriptTask *task = _take_script_task(tasks, p_task);
+	ERR_FAIL_COND(!task);
+
+	ThreadWorkPool::get_singleton()->wait_for_task_completion(p_task);
+	memdelete(task);
+}
+
+int _WorkerThreadPool::add_group_task(Object *p_instance, const StringName &p_method, int p_elements, const Variant &p_userdata) {
+
+	ERR_FAIL_COND_V(!p_instance, 0);
+	ERR_FAIL_COND_V(p_method == StringName(), 0);
+	ERR_FAIL_COND_V(p_elements < 0, 0);
+
+	ScriptTask *task = memnew(ScriptTask);
+	task->instance = p_instance->get_instance_id();
+	task->method = p_method;
+	task->userdata = p_userdata;
+
+	MutexLock lock(mutex);
+	ThreadWorkPool::GroupID id = ThreadWorkPool::get_singleton()->add_group_work(p_elements, this, &_WorkerThreadPool::_run_group_task, task, 1);
+	groups[id] = task;
+
+	return id;
+}
+
+bool _WorkerThreadPool::is_group_task_completed(int p_group) const {
+
+	return ThreadWorkPool::get_singleton()->is_group_completed(p_group);
+}
+
+void _WorkerThreadPool::wait_for_group_task_completion(int p_group) {
+
+	ScriptTask *task = _take_script_task(groups, p_group);
+	ERR_FAIL_COND(!task);
+
+	ThreadWorkPool::get_singleton()->wait_for_group_completion(p_group);
+	memdelete(task);
+}
+
+int _WorkerThreadPool::get_thread_count() const {
+
+	return ThreadWorkPool::get_singleton()->get_thread_count();
+}
+
+void _WorkerThreadPool::_bind_methods() {
+
+	ClassDB::bind_method(D_METHOD("add_task", "instance", "method", "userdata", "dependencies"), &_WorkerThreadPool::add_task, DEFVAL(Variant()), DEFVAL(PoolIntArray()));
+	ClassDB::bind_method(D_METHOD("is_task_completed", "task_id"), &_WorkerThreadPool::is_task_completed);
+	ClassDB::bind_method(D_METHOD("wait_for_task_completion", "task_id"), &_WorkerThreadPool::wait_for_task_completion);
+
+	ClassDB::bind_method(D_METHOD("add_group_task", "instance", "method", "elements", "userdata"), &_WorkerThreadPool::add_group_task, DEFVAL(Variant()));
+	ClassDB::bind_method(D_METHOD("is_group_task_completed", "group_id"), &_WorkerThreadPool::is_group_task_completed);
+	ClassDB::bind_method(D_METHOD("wait_for_group_task_completion", "group_id"), &_WorkerThreadPool::wait_for_group_task_completion);
+
+	ClassDB::bind_method(D_METHOD("get_thread_count"), &_WorkerThreadPool::get_thread_count);
+}
+
+_WorkerThreadPool::_WorkerThreadPool() {
+
+	singleton = this;
+	mutex = Mutex::create();
+}
+
+_WorkerThreadPool::~_WorkerThreadPool() {
+
+	for (Map<ThreadWorkPool::TaskID, ScriptTask *>::Element *E = tasks.front(); E; E = E->next()) {
+		ThreadWorkPool::get_singleton()->wait_for_task_completion(E->key());
+		memdelete(E->get());
+	}
+	for (Map<ThreadWorkPool::GroupID, ScriptTask *>::Element *E = groups.front(); E; E = E->next()) {
+		ThreadWorkPool::get_singleton()->wait_for_group_completion(E->key());
+		memdelete(E->get());
+	}
+
+	if (mutex)
+		memdelete(mutex);
+	singleton = NULL;
+}
+/////////////////////////////////////
+
 PoolStringArray _ClassDB::get_class_list() const {
 
 	List<StringName> classes;
@@ -40,6 +40,7 @@
 #include "os/os.h"
 #include "os/semaphore.h"
 #include "os/thread.h"
+#include "os/thread_work_pool.h"
 
 class _ResourceLoader : public Object {
 	GDCLASS(_ResourceLoader, Object);
@@ -630,6 +631,48 @@ public:
 
 VARIANT_ENUM_CAST(_Thread::Priority);
 
+class _WorkerThreadPool : public Object {
+
+	GDCLASS(_WorkerThreadPool, Object);
+
+	struct ScriptTask {
+
+		ObjectID instance;
+		StringName method;
+		Variant userdata;
+	};
+
+	Mutex *mutex;
+	Map<ThreadWorkPool::TaskID, ScriptTask *> tasks;
+	Map<ThreadWorkPool::GroupID, ScriptTask *> groups;
+
+	void _call(ScriptTask *p_task, const Variant **p_args, int p_argcount);
+	void _run_task(ScriptTask *p_task);
+	void _run_group_task(uint32_t p_index, ScriptTask *p_task);
+
+	ScriptTask *_take_script_task(Map<uint32_t, ScriptTask *> &p_map, uint32_t p_id);
+
+protected:
+	static void _bind_methods();
+	static _WorkerThreadPool *singleton;
+
+public:
+	static _WorkerThreadPool *get_singleton() { return singleton; }
+
+	int add_task(Object *p_instance, const StringName &p_method, const Variant &p_userdata = Variant(), const PoolIntArray &p_dependencies = PoolIntArray());
+	bool is_task_completed(int p_task) const;
+	void wait_for_task_completion(int p_task);
+
+	int add_group_task(Object *p_instance, const StringName &p_method, int p_elements, const Variant &p_userdata = Variant());
+	bool is_group_task_completed(int p_group) const;
+	void wait_for_group_task_completion(int p_group);
+
+	int get_thread_count() const;
+
+	_WorkerThreadPool();
+	~_WorkerThreadPool();
+};
+
 class _ClassDB : public Object {
 
 	GDCLASS(_ClassDB, Object)
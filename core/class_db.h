@@ -32,6 +32,7 @@
 #define CLASS_DB_H
 
 #include "method_bind.h"
+#include "oa_hash_map.h"
 #include "object.h"
 #include "print_string.h"
 
@@ -114,7 +115,7 @@ public:
 
 		APIType api;
 		ClassInfo *inherits_ptr;
-		HashMap<StringName, MethodBind *> method_map;
+		OAHashMap<StringName, MethodBind *> method_map;
 		HashMap<StringName, int> constant_map;
 		HashMap<StringName, List<StringName> > enum_map;
 		HashMap<StringName, MethodInfo> signal_map;
@@ -126,7 +127,7 @@ public:
 		List<MethodInfo> virtual_methods;
 		StringName category;
 #endif
-		HashMap<StringName, PropertySetGet> property_setget;
+		OAHashMap<StringName, PropertySetGet> property_setget;
 
 		StringName inherits;
 		StringName name;
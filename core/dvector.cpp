@@ -37,13 +37,63 @@ uint8_t *MemoryPool::pool_memory = NULL;
 size_t *MemoryPool::pool_size = NULL;
 
 MemoryPool::Alloc *MemoryPool::allocs = NULL;
-MemoryPool::Alloc *MemoryPool::free_list = NULL;
+uint64_t MemoryPool::free_list = 0;
 uint32_t MemoryPool::alloc_count = 0;
 uint32_t MemoryPool::allocs_used = 0;
-Mutex *MemoryPool::alloc_mutex = NULL;
 
-size_t MemoryPool::total_memory = 0;
-size_t MemoryPool::max_memory = 0;
+uint64_t MemoryPool::total_memory = 0;
+uint64_t MemoryPool::max_memory = 0;
+
+MemoryPool::Alloc *MemoryPool::take_alloc() {
+
+	while (true) {
+
+		uint64_t head = free_list;
+		uint32_t index = head & 0xFFFFFFFF;
+		if (index == 0) {
+			return NULL;
+		}
+
+		// allocs are never freed, so reading the next one is safe even if another
+		// thread took this alloc meanwhile, the counter makes the exchange fail then
+		Alloc *alloc = &allocs[index - 1];
+		uint64_t next = alloc->free_list ? uint64_t(alloc->free_list - allocs) + 1 : 0;
+		uint64_t new_head = ((head >> 32) + 1) << 32 | next;
+
+		if (atomic_compare_exchange(&free_list, head, new_head)) {
+			atomic_increment(&allocs_used);
+			return alloc;
+		}
+	}
+}
+
+void MemoryPool::release_alloc(Alloc *p_alloc) {
+
+	uint64_t index = uint64_t(p_alloc - allocs) + 1;
+
+	while (true) {
+
+		uint64_t head = free_list;
+		uint32_t first = head & 0xFFFFFFFF;
+		p_alloc->free_list = first ? &allocs[first - 1] : NULL;
+		uint64_t new_head = ((head >> 32) + 1) << 32 | index;
+
+		if (atomic_compare_exchange(&free_list, head, new_head)) {
+			atomic_decrement(&allocs_used);
+			return;
+		}
+	}
+}
+
+void MemoryPool::update_memory(size_t p_old_size, size_t p_new_size) {
+
+	if (p_new_size > p_old_size) {
+		uint64_t total = atomic_add(&total_memory, uint64_t(p_new_size - p_old_size));
+		atomic_exchange_if_greater(&max_memory, total);
+	} else if (p_new_size < p_old_size) {
+		atomic_sub(&total_memory, uint64_t(p_old_size - p_new_size));
+	}
+}
 
 void MemoryPool::setup(uint32_t p_max_allocs) {
 
@@ -56,15 +106,12 @@ void MemoryPool::setup(uint32_t p_max_allocs) {
 		allocs[i].free_list = &allocs[i + 1];
 	}
 
-	free_list = &allocs[0];
-
-	alloc_mutex = Mutex::create();
+	free_list = 1; // the first alloc
 }
 
 void MemoryPool::cleanup() {
 
 	memdelete_arr(allocs);
-	memdelete(alloc_mutex);
 
 	ERR_EXPLAINC("There are still MemoryPool allocs in use at exit!");
 	ERR_FAIL_COND(allocs_used > 0);
@@ -66,12 +66,16 @@ struct MemoryPool {
 	};
 
 	static Alloc *allocs;
-	static Alloc *free_list;
+	static uint64_t free_list; // index + 1 of the first free alloc in the low bits, a counter in the high bits to avoid ABA
 	static uint32_t alloc_count;
 	static uint32_t allocs_used;
-	static Mutex *alloc_mutex;
-	static size_t total_memory;
-	static size_t max_memory;
+	static uint64_t total_memory;
+	static uint64_t max_memory;
+
+	// Lock free, so threads handing arrays to each other don't serialize on a mutex.
+	static Alloc *take_alloc(); // NULL if all of them are in use
+	static void release_alloc(Alloc *p_alloc);
+	static void update_memory(size_t p_old_size, size_t p_new_size);
 
 	static void setup(uint32_t p_max_allocs = (1 << 16));
 	static void cleanup();
@@ -99,20 +103,14 @@ class PoolVector {
 
 		//must allocate something
 
-		MemoryPool::alloc_mutex->lock();
-		if (MemoryPool::allocs_used == MemoryPool::alloc_count) {
-			MemoryPool::alloc_mutex->unlock();
+		MemoryPool::Alloc *new_alloc = MemoryPool::take_alloc();
+		if (!new_alloc) {
 			ERR_EXPLAINC("All memory pool allocations are in use, can't COW.");
 			ERR_FAIL();
 		}
 
 		MemoryPool::Alloc *old_alloc = alloc;
-
-		//take one from the free list
-		alloc = MemoryPool::free_list;
-		MemoryPool::free_list = alloc->free_list;
-		//increment the used counter
-		MemoryPool::allocs_used++;
+		alloc = new_alloc;
 
 		//copy the alloc data
 		alloc->size = old_alloc->size;
@@ -121,14 +119,9 @@ class PoolVector {
 		alloc->lock = 0;
 
 #ifdef DEBUG_ENABLED
-		MemoryPool::total_memory += alloc->size;
-		if (MemoryPool::total_memory > MemoryPool::max_memory) {
-			MemoryPool::max_memory = MemoryPool::total_memory;
-		}
+		MemoryPool::update_memory(0, alloc->size);
 #endif
 
-		MemoryPool::alloc_mutex->unlock();
-
 		if (MemoryPool::memory_pool) {
 
 		} else {
@@ -153,9 +146,7 @@ class PoolVector {
 			//this should never happen but..
 
 #ifdef DEBUG_ENABLED
-			MemoryPool::alloc_mutex->lock();
-			MemoryPool::total_memory -= old_alloc->size;
-			MemoryPool::alloc_mutex->unlock();
+			MemoryPool::update_memory(old_alloc->size, 0);
 #endif
 
 			{
@@ -179,11 +170,7 @@ class PoolVector {
 				old_alloc->mem = NULL;
 				old_alloc->size = 0;
 
-				MemoryPool::alloc_mutex->lock();
-				old_alloc->free_list = MemoryPool::free_list;
-				MemoryPool::free_list = old_alloc;
-				MemoryPool::allocs_used--;
-				MemoryPool::alloc_mutex->unlock();
+				MemoryPool::release_alloc(old_alloc);
 			}
 		}
 	}
@@ -232,9 +219,7 @@ class PoolVector {
 		}
 
 #ifdef DEBUG_ENABLED
-		MemoryPool::alloc_mutex->lock();
-		MemoryPool::total_memory -= alloc->size;
-		MemoryPool::alloc_mutex->unlock();
+		MemoryPool::update_memory(alloc->size, 0);
 #endif
 
 		if (MemoryPool::memory_pool) {
@@ -247,11 +232,7 @@ class PoolVector {
 			alloc->mem = NULL;
 			alloc->size = 0;
 
-			MemoryPool::alloc_mutex->lock();
-			alloc->free_list = MemoryPool::free_list;
-			MemoryPool::free_list = alloc;
-			MemoryPool::allocs_used--;
-			MemoryPool::alloc_mutex->unlock();
+			MemoryPool::release_alloc(alloc);
 		}
 
 		alloc = NULL;
@@ -517,24 +498,16 @@ Error PoolVector<T>::resize(int p_size) {
 			return OK; //nothing to do here
 
 		//must allocate something
-		MemoryPool::alloc_mutex->lock();
-		if (MemoryPool::allocs_used == MemoryPool::alloc_count) {
-			MemoryPool::alloc_mutex->unlock();
+		alloc = MemoryPool::take_alloc();
+		if (!alloc) {
 			ERR_EXPLAINC("All memory pool allocations are in use.");
 			ERR_FAIL_V(ERR_OUT_OF_MEMORY);
 		}
 
-		//take one from the free list
-		alloc = MemoryPool::free_list;
-		MemoryPool::free_list = alloc->free_list;
-		//increment the used counter
-		MemoryPool::allocs_used++;
-
 		//cleanup the alloc
 		alloc->size = 0;
 		alloc->refcount.init();
 		alloc->pool_id = POOL_ALLOCATOR_INVALID_ID;
-		MemoryPool::alloc_mutex->unlock();
 
 	} else {
 
@@ -554,13 +527,7 @@ Error PoolVector<T>::resize(int p_size) {
 	_copy_on_write(); // make it unique
 
 #ifdef DEBUG_ENABLED
-	MemoryPool::alloc_mutex->lock();
-	MemoryPool::total_memory -= alloc->size;
-	MemoryPool::total_memory += new_size;
-	if (MemoryPool::total_memory > MemoryPool::max_memory) {
-		MemoryPool::max_memory = MemoryPool::total_memory;
-	}
-	MemoryPool::alloc_mutex->unlock();
+	MemoryPool::update_memory(alloc->size, new_size);
 #endif
 
 	int cur_elements = alloc->size / sizeof(T);
@@ -610,11 +577,7 @@ Error PoolVector<T>::resize(int p_size) {
 				alloc->mem = NULL;
 				alloc->size = 0;
 
-				MemoryPool::alloc_mutex->lock();
-				alloc->free_list = MemoryPool::free_list;
-				MemoryPool::free_list = alloc;
-				MemoryPool::allocs_used--;
-				MemoryPool::alloc_mutex->unlock();
+				MemoryPool::release_alloc(alloc);
 
 			} else {
 				alloc->mem = memrealloc(alloc->mem, new_size);
@@ -0,0 +1,213 @@
+/*************************************************************************/
+/*  frame_arena.cpp                                                      */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "frame_arena.h"
+
+#include "os/copymem.h"
+#include "safe_refcount.h"
+
+#ifdef NO_THREADS
+#define FRAME_ARENA_THREAD_LOCAL
+#else
+#define FRAME_ARENA_THREAD_LOCAL thread_local
+#endif
+
+struct Chunk {
+	Chunk *next;
+	size_t size;
+	size_t used;
+};
+
+enum {
+	CHUNK_HEADER_SIZE = (sizeof(Chunk) + FrameArena::ALIGNMENT - 1) & ~(FrameArena::ALIGNMENT - 1)
+};
+
+static _FORCE_INLINE_ uint8_t *_get_chunk_data(Chunk *p_chunk) {
+
+	return (uint8_t *)p_chunk + CHUNK_HEADER_SIZE;
+}
+
+static _FORCE_INLINE_ size_t _align(size_t p_bytes) {
+
+	return (p_bytes + FrameArena::ALIGNMENT - 1) & ~size_t(FrameArena::ALIGNMENT - 1);
+}
+
+static volatile uint32_t frame = 0;
+static volatile uint32_t chunk_count = 0;
+
+enum ThreadArenaState {
+	THREAD_ARENA_UNUSED, // zero, so it's the state thread locals start with
+	THREAD_ARENA_ACTIVE,
+	THREAD_ARENA_DESTROYED // the thread is exiting, chunks taken from now on are not released
+};
+
+struct ThreadArena {
+	Chunk *chunks; // allocated from in this frame, the first one is the current
+	Chunk *previous_chunks; // allocated from in the previous frame
+	Chunk *free_chunks;
+	uint32_t frame;
+	uint32_t state;
+};
+
+static FRAME_ARENA_THREAD_LOCAL ThreadArena thread_arena;
+
+static void _free_chunks(Chunk *p_chunk) {
+
+	while (p_chunk) {
+		Chunk *next = p_chunk->next;
+		memfree(p_chunk);
+		atomic_decrement(&chunk_count);
+		p_chunk = next;
+	}
+}
+
+// Gives the chunks of a thread back to the heap when it exits.
+struct ThreadArenaReleaser {
+
+	~ThreadArenaReleaser() {
+
+		ThreadArena &ta = thread_arena;
+		_free_chunks(ta.chunks);
+		_free_chunks(ta.previous_chunks);
+		_free_chunks(ta.free_chunks);
+		ta.chunks = NULL;
+		ta.previous_chunks = NULL;
+		ta.free_chunks = NULL;
+		ta.state = THREAD_ARENA_DESTROYED;
+	}
+};
+
+static FRAME_ARENA_THREAD_LOCAL ThreadArenaReleaser thread_arena_releaser;
+
+static _FORCE_INLINE_ ThreadArena *_get_thread_arena() {
+
+	ThreadArena *ta = &thread_arena;
+	if (unlikely(ta->state == THREAD_ARENA_UNUSED)) {
+		(void)&thread_arena_releaser; // makes sure it's destroyed when the thread exits
+		ta->state = THREAD_ARENA_ACTIVE;
+		ta->frame = frame;
+	}
+
+	if (unlikely(ta->frame != frame)) {
+		// the chunks of the previous frame can be reused now, the ones of this frame are kept for one more
+		Chunk *c = ta->previous_chunks;
+		while (c) {
+			Chunk *next = c->next;
+			c->next = ta->free_chunks;
+			ta->free_chunks = c;
+			c = next;
+		}
+		ta->previous_chunks = ta->chunks;
+		ta->chunks = NULL;
+		ta->frame = frame;
+	}
+
+	return ta;
+}
+
+static Chunk *_add_chunk(ThreadArena *p_arena, size_t p_bytes) {
+
+	// the smallest free chunk that fits, so the big ones are there for big allocations
+	Chunk **best_prev = NULL;
+	for (Chunk **prev = &p_arena->free_chunks; *prev; prev = &(*prev)->next) {
+		if ((*prev)->size >= p_bytes && (!best_prev || (*prev)->size < (*best_prev)->size)) {
+			best_prev = prev;
+		}
+	}
+
+	Chunk *c;
+	if (best_prev) {
+		c = *best_prev;
+		*best_prev = c->next;
+	} else {
+		size_t size = MAX(size_t(FrameArena::CHUNK_SIZE), p_bytes);
+		c = (Chunk *)memalloc(CHUNK_HEADER_SIZE + size);
+		ERR_FAIL_COND_V(!c, NULL);
+		c->size = size;
+		atomic_increment(&chunk_count);
+	}
+
+	c->used = 0;
+	c->next = p_arena->chunks;
+	p_arena->chunks = c;
+	return c;
+}
+
+void *FrameArena::alloc(size_t p_bytes) {
+
+	ThreadArena *ta = _get_thread_arena();
+	p_bytes = _align(p_bytes);
+
+	Chunk *c = ta->chunks;
+	if (unlikely(!c || c->used + p_bytes > c->size)) {
+		c = _add_chunk(ta, p_bytes);
+		ERR_FAIL_COND_V(!c, NULL);
+	}
+
+	void *ptr = _get_chunk_data(c) + c->used;
+	c->used += p_bytes;
+	return ptr;
+}
+
+void *FrameArena::realloc(void *p_ptr, size_t p_old_bytes, size_t p_new_bytes) {
+
+	ThreadArena *ta = _get_thread_arena();
+	p_old_bytes = _align(p_old_bytes);
+	p_new_bytes = _align(p_new_bytes);
+
+	Chunk *c = ta->chunks;
+	if (c && (uint8_t *)p_ptr + p_old_bytes == _get_chunk_data(c) + c->used) {
+		size_t from = (uint8_t *)p_ptr - _get_chunk_data(c);
+		if (from + p_new_bytes <= c->size) {
+			c->used = from + p_new_bytes;
+			return p_ptr;
+		}
+	}
+
+	void *ptr = alloc(p_new_bytes);
+	ERR_FAIL_COND_V(!ptr, NULL);
+	copymem(ptr, p_ptr, MIN(p_old_bytes, p_new_bytes));
+	return ptr;
+}
+
+void FrameArena::next_frame() {
+
+	atomic_increment(&frame);
+}
+
+uint32_t FrameArena::get_frame() {
+
+	return frame;
+}
+
+uint32_t FrameArena::get_chunk_count() {
+
+	return chunk_count;
+}
@@ -0,0 +1,157 @@
+/*************************************************************************/
+/*  frame_arena.h                                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include "error_macros.h"
+#include "os/memory.h"
+
+// Linear allocator for data that only lives during a frame, like the buffers the
+// servers fill again every frame. Every thread allocates from chunks of its own and
+// nothing is freed, the chunks are reused as a whole once the frame is over.
+// Main::iteration starts a new frame; a thread notices it the next time it allocates,
+// and keeps what it allocated in the previous frame until it allocates in the frame
+// after that. So memory is only reused once its thread allocates again after two new
+// frames started. Main::iteration starts one at most once per iteration, and only after
+// the physics servers synced, so neither a physics step nor a draw sees two of them.
+
+class FrameArena {
+public:
+	enum {
+		CHUNK_SIZE = 64 * 1024,
+		ALIGNMENT = 16
+	};
+
+	static void *alloc(size_t p_bytes);
+	// Grows in place if p_ptr was the last allocation of the thread, copies otherwise.
+	static void *realloc(void *p_ptr, size_t p_old_bytes, size_t p_new_bytes);
+
+	static void next_frame();
+	static uint32_t get_frame();
+
+	static uint32_t get_chunk_count();
+};
+
+// For List, Map and Set, which elements can then be left behind when the frame is over.
+class FrameAllocator {
+public:
+	_FORCE_INLINE_ static void *alloc(size_t p_memory) { return FrameArena::alloc(p_memory); }
+	_FORCE_INLINE_ static void free(void *p_ptr) {}
+};
+
+// Array which memory comes from the frame arena, for plain types only: elements are
+// moved with memcpy and never destructed. Clearing it doesn't give the memory back,
+// so it can be kept as a member and filled again in later frames.
+
+template <class T>
+class FrameVector {
+
+	T *data;
+	int count;
+	int capacity;
+
+	void _grow(int p_capacity) {
+
+		int capacity_new = MAX(p_capacity, MAX(capacity * 2, 8));
+		if (data) {
+			data = (T *)FrameArena::realloc(data, capacity * sizeof(T), capacity_new * sizeof(T));
+		} else {
+			data = (T *)FrameArena::alloc(capacity_new * sizeof(T));
+		}
+		capacity = capacity_new;
+	}
+
+public:
+	_FORCE_INLINE_ void push_back(const T &p_elem) {
+
+		if (unlikely(count == capacity)) {
+			_grow(count + 1);
+		}
+		data[count++] = p_elem;
+	}
+
+	// New elements are left uninitialized.
+	void resize(int p_size) {
+
+		ERR_FAIL_COND(p_size < 0);
+		if (p_size > capacity) {
+			_grow(p_size);
+		}
+		count = p_size;
+	}
+
+	void reserve(int p_capacity) {
+
+		if (p_capacity > capacity) {
+			_grow(p_capacity);
+		}
+	}
+
+	// Forgets the memory rather than keeping it, it may belong to an earlier frame.
+	_FORCE_INLINE_ void clear() {
+
+		data = NULL;
+		count = 0;
+		capacity = 0;
+	}
+
+	_FORCE_INLINE_ int size() const { return count; }
+	_FORCE_INLINE_ bool empty() const { return count == 0; }
+
+	_FORCE_INLINE_ T *ptr() { return data; }
+	_FORCE_INLINE_ const T *ptr() const { return data; }
+
+	_FORCE_INLINE_ T &operator[](int p_index) {
+
+		CRASH_BAD_INDEX(p_index, count);
+		return data[p_index];
+	}
+
+	_FORCE_INLINE_ const T &operator[](int p_index) const {
+
+		CRASH_BAD_INDEX(p_index, count);
+		return data[p_index];
+	}
+
+	FrameVector() {
+
+		data = NULL;
+		count = 0;
+		capacity = 0;
+	}
+
+private:
+	// Copies would share the memory, and growing one would overwrite the other.
+	FrameVector(const FrameVector &);
+	FrameVector &operator=(const FrameVector &);
+};
+
+#endif // FRAME_ARENA_H
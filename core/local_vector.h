@@ -0,0 +1,306 @@
+/*************************************************************************/
+/*  local_vector.h                                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef LOCAL_VECTOR_H
+#define LOCAL_VECTOR_H
+
+#include "error_macros.h"
+#include "os/copymem.h"
+#include "os/memory.h"
+#include "sort.h"
+#include "vector.h"
+
+// Array that is never shared: copies are real copies, so writing doesn't check a
+// reference count and may not copy the data first like Vector does. Capacity grows
+// geometrically and is kept when the array shrinks, which makes it good for buffers
+// that are filled again and again. Types which can be constructed, copied and
+// destructed trivially are handled with plain memory operations. Like Vector, it
+// expects the elements to survive being moved in memory.
+
+template <class T>
+class LocalVector {
+
+	T *data;
+	int count;
+	int capacity;
+
+	void _grow(int p_capacity) {
+
+		int capacity_new = MAX(p_capacity, MAX(capacity + (capacity >> 1), 8));
+		data = (T *)memrealloc(data, capacity_new * sizeof(T));
+		CRASH_COND(!data);
+		capacity = capacity_new;
+	}
+
+	void _copy_from(const T *p_from, int p_count) {
+
+		reserve(p_count);
+		if (__has_trivial_copy(T)) {
+			copymem((void *)data, p_from, p_count * sizeof(T));
+		} else {
+			for (int i = 0; i < p_count; i++) {
+				memnew_placement(&data[i], T(p_from[i]));
+			}
+		}
+		count = p_count;
+	}
+
+public:
+	_FORCE_INLINE_ void push_back(const T &p_elem) {
+
+		if (unlikely(count == capacity)) {
+			_grow(count + 1);
+		}
+		if (__has_trivial_copy(T)) {
+			data[count] = p_elem;
+		} else {
+			memnew_placement(&data[count], T(p_elem));
+		}
+		count++;
+	}
+
+	void insert(int p_index, const T &p_elem) {
+
+		ERR_FAIL_INDEX(p_index, count + 1);
+		if (p_index == count) {
+			push_back(p_elem);
+			return;
+		}
+		// goes through a copy, p_elem may be in the array
+		T elem = p_elem;
+		if (count == capacity) {
+			_grow(count + 1);
+		}
+		if (__has_trivial_copy(T)) {
+			movemem((void *)&data[p_index + 1], &data[p_index], (count - p_index) * sizeof(T));
+			data[p_index] = elem;
+		} else {
+			// shift by assignment, the new last element is copy constructed
+			memnew_placement(&data[count], T(data[count - 1]));
+			for (int i = count - 1; i > p_index; i--) {
+				data[i] = data[i - 1];
+			}
+			data[p_index] = elem;
+		}
+		count++;
+	}
+
+	void remove(int p_index) {
+
+		ERR_FAIL_INDEX(p_index, count);
+		count--;
+		if (__has_trivial_copy(T) && __has_trivial_destructor(T)) {
+			movemem((void *)&data[p_index], &data[p_index + 1], (count - p_index) * sizeof(T));
+		} else {
+			for (int i = p_index; i < count; i++) {
+				data[i] = data[i + 1];
+			}
+			data[count].~T();
+		}
+	}
+
+	// Faster than remove(), but the last element takes the place of the removed one.
+	void remove_unordered(int p_index) {
+
+		ERR_FAIL_INDEX(p_index, count);
+		count--;
+		if (p_index < count) {
+			data[p_index] = data[count];
+		}
+		if (!__has_trivial_destructor(T)) {
+			data[count].~T();
+		}
+	}
+
+	void erase(const T &p_val) {
+
+		int idx = find(p_val);
+		if (idx >= 0) {
+			remove(idx);
+		}
+	}
+
+	int find(const T &p_val, int p_from = 0) const {
+
+		for (int i = p_from; i < count; i++) {
+			if (data[i] == p_val) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	void invert() {
+
+		for (int i = 0; i < count / 2; i++) {
+			SWAP(data[i], data[count - i - 1]);
+		}
+	}
+
+	void resize(int p_size) {
+
+		ERR_FAIL_COND(p_size < 0);
+		if (p_size < count) {
+			if (!__has_trivial_destructor(T)) {
+				for (int i = p_size; i < count; i++) {
+					data[i].~T();
+				}
+			}
+			count = p_size;
+		} else if (p_size > count) {
+			if (p_size > capacity) {
+				_grow(p_size);
+			}
+			if (!__has_trivial_constructor(T)) {
+				for (int i = count; i < p_size; i++) {
+					memnew_placement(&data[i], T);
+				}
+			}
+			count = p_size;
+		}
+	}
+
+	void reserve(int p_capacity) {
+
+		if (p_capacity > capacity) {
+			data = (T *)memrealloc(data, p_capacity * sizeof(T));
+			CRASH_COND(!data);
+			capacity = p_capacity;
+		}
+	}
+
+	// Keeps the memory for the next elements.
+	_FORCE_INLINE_ void clear() { resize(0); }
+
+	// Gives the memory back.
+	void reset() {
+
+		clear();
+		if (data) {
+			memfree(data);
+			data = NULL;
+			capacity = 0;
+		}
+	}
+
+	_FORCE_INLINE_ int size() const { return count; }
+	_FORCE_INLINE_ int get_capacity() const { return capacity; }
+	_FORCE_INLINE_ bool empty() const { return count == 0; }
+
+	_FORCE_INLINE_ T *ptr() { return data; }
+	_FORCE_INLINE_ const T *ptr() const { return data; }
+
+	_FORCE_INLINE_ T &operator[](int p_index) {
+
+		CRASH_BAD_INDEX(p_index, count);
+		return data[p_index];
+	}
+
+	_FORCE_INLINE_ const T &operator[](int p_index) const {
+
+		CRASH_BAD_INDEX(p_index, count);
+		return data[p_index];
+	}
+
+	template <class C>
+	void sort_custom() {
+
+		if (count == 0) {
+			return;
+		}
+		SortArray<T, C> sorter;
+		sorter.sort(data, count);
+	}
+
+	void sort() {
+
+		sort_custom<_DefaultComparator<T> >();
+	}
+
+	operator Vector<T>() const {
+
+		Vector<T> ret;
+		ret.resize(count);
+		T *w = ret.ptrw();
+		if (__has_trivial_copy(T)) {
+			copymem((void *)w, data, count * sizeof(T));
+		} else {
+			for (int i = 0; i < count; i++) {
+				w[i] = data[i];
+			}
+		}
+		return ret;
+	}
+
+	void operator=(const LocalVector &p_from) {
+
+		if (&p_from == this) {
+			return;
+		}
+		clear();
+		_copy_from(p_from.data, p_from.count);
+	}
+
+	void operator=(const Vector<T> &p_from) {
+
+		clear();
+		_copy_from(p_from.ptr(), p_from.size());
+	}
+
+	LocalVector(const LocalVector &p_from) {
+
+		data = NULL;
+		count = 0;
+		capacity = 0;
+		_copy_from(p_from.data, p_from.count);
+	}
+
+	LocalVector(const Vector<T> &p_from) {
+
+		data = NULL;
+		count = 0;
+		capacity = 0;
+		_copy_from(p_from.ptr(), p_from.size());
+	}
+
+	_FORCE_INLINE_ LocalVector() {
+
+		data = NULL;
+		count = 0;
+		capacity = 0;
+	}
+
+	_FORCE_INLINE_ ~LocalVector() {
+
+		reset();
+	}
+};
+
+#endif // LOCAL_VECTOR_H
@@ -0,0 +1,1160 @@
+/*************************************************************************/
+/*  bvh.h                                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef BVH_H
+#define BVH_H
+
+#include "aabb.h"
+#include "list.h"
+#include "math_2d.h"
+#include "os/memory.h"
+#include "plane.h"
+#include "vector.h"
+
+/**
+	Dynamic bounding volume hierarchy, a drop-in alternative to Octree.
+
+	Elements are stored in the leaves of a binary tree kept balanced with tree
+	rotations, so insertion, removal and queries stay logarithmic regardless of
+	the size and distribution of the elements. Leaves store the element bounds
+	grown by a margin ("fat" bounds), so elements moving by a small amount don't
+	need to be reinserted.
+
+	Pairing works like in Octree: two elements are considered for pairing if at
+	least one of them is pairable and the type of one is in the mask of the
+	other. A pair is cached as long as the fat bounds of both elements overlap,
+	and the callbacks are called when their actual bounds start or stop
+	intersecting. Pairable and non-pairable elements live in separate trees, so
+	non-pairable elements never have to test against each other.
+
+	Pair updates can optionally be deferred: moved elements are then only
+	queued, and their pairs are updated in a single batch by update_pairs().
+	The tree itself is always up to date, so culling is unaffected.
+
+	Nodes live in a flat array and are referenced by index.
+*/
+
+typedef uint32_t BVHElementID;
+
+#define BVH_ELEMENT_INVALID_ID 0
+
+template <class T, bool use_pairs = false, class BOUNDS = AABB, class POINT = Vector3>
+class BVH {
+public:
+	typedef void *(*PairCallback)(void *, BVHElementID, T *, int, BVHElementID, T *, int);
+	typedef void (*UnpairCallback)(void *, BVHElementID, T *, int, BVHElementID, T *, int, void *);
+
+private:
+	enum {
+		TREE_STATIC, // non pairable elements
+		TREE_PAIRABLE,
+		TREE_MAX
+	};
+
+	enum {
+		DIRTY_PAIRS = 1, // bounds changed, existing pairs must be checked
+		DIRTY_CANDIDATES = 2 // fat bounds changed, pairs must be searched again
+	};
+
+	enum {
+		// fat bounds are extended by this many times the last motion of the element
+		MOTION_PREDICTION = 2,
+		NODE_NULL = -1,
+		// the tree is kept balanced, so its height (and the traversal stack) stays far below this
+		STACK_SIZE = 128
+	};
+
+	struct Node {
+
+		BOUNDS bounds; // fat bounds for leaves
+		int32_t parent; // next free node when not used
+		int32_t children[2];
+		int32_t height; // 0 for leaves
+		BVHElementID element;
+
+		_FORCE_INLINE_ bool is_leaf() const { return children[0] == NODE_NULL; }
+	};
+
+	struct PairData;
+
+	struct Element {
+
+		T *userdata;
+		int subindex;
+		bool pairable;
+		uint32_t pairable_mask;
+		uint32_t pairable_type;
+
+		BOUNDS bounds;
+		int32_t leaf;
+		uint64_t last_pass;
+		uint64_t last_batch; // last update_pairs() batch that searched pairs for this element
+		BVHElementID next_free;
+		uint32_t dirty;
+
+		List<PairData *> pair_list;
+	};
+
+	struct PairData {
+
+		bool intersect;
+		BVHElementID A, B;
+		void *ud;
+		typename List<PairData *>::Element *eA, *eB;
+	};
+
+	Node *nodes;
+	int32_t node_capacity;
+	int32_t free_node;
+	int32_t root[TREE_MAX];
+
+	Element **elements;
+	uint32_t element_capacity;
+	BVHElementID free_element;
+
+	int element_count;
+	int pair_count;
+	uint64_t pass;
+	real_t margin;
+
+	bool deferred_pairs;
+	Vector<BVHElementID> dirty_elements;
+	uint64_t batch;
+
+	PairCallback pair_callback;
+	UnpairCallback unpair_callback;
+	void *pair_callback_userdata;
+	void *unpair_callback_userdata;
+
+	/* bounds helpers, overloaded for the supported bounds types */
+
+	static _FORCE_INLINE_ bool _bounds_empty(const AABB &p_bounds) { return p_bounds.has_no_surface(); }
+	static _FORCE_INLINE_ bool _bounds_empty(const Rect2 &p_bounds) { return p_bounds.position == Point2() && p_bounds.size == Size2(); }
+
+	// same test as the structure being replaced (inclusive for Octree, exclusive for the 2D hash grid)
+	static _FORCE_INLINE_ bool _bounds_intersect(const AABB &p_a, const AABB &p_b) { return p_a.intersects_inclusive(p_b); }
+	static _FORCE_INLINE_ bool _bounds_intersect(const Rect2 &p_a, const Rect2 &p_b) { return p_a.intersects(p_b); }
+
+	static _FORCE_INLINE_ bool _bounds_overlap(const AABB &p_a, const AABB &p_b) { return p_a.intersects_inclusive(p_b); }
+	static _FORCE_INLINE_ bool _bounds_overlap(const Rect2 &p_a, const Rect2 &p_b) {
+		return p_a.position.x <= p_b.position.x + p_b.size.x && p_a.position.x + p_a.size.x >= p_b.position.x &&
+			   p_a.position.y <= p_b.position.y + p_b.size.y && p_a.position.y + p_a.size.y >= p_b.position.y;
+	}
+
+	static _FORCE_INLINE_ bool _bounds_encloses(const AABB &p_a, const AABB &p_b) {
+		Vector3 a_end = p_a.position + p_a.size;
+		Vector3 b_end = p_b.position + p_b.size;
+		return p_a.position.x <= p_b.position.x && p_a.position.y <= p_b.position.y && p_a.position.z <= p_b.position.z &&
+			   a_end.x >= b_end.x && a_end.y >= b_end.y && a_end.z >= b_end.z;
+	}
+	static _FORCE_INLINE_ bool _bounds_encloses(const Rect2 &p_a, const Rect2 &p_b) {
+		Point2 a_end = p_a.position + p_a.size;
+		Point2 b_end = p_b.position + p_b.size;
+		return p_a.position.x <= p_b.position.x && p_a.position.y <= p_b.position.y && a_end.x >= b_end.x && a_end.y >= b_end.y;
+	}
+
+	// fat bounds never grow this much on their own, the element shrank (i.e. after a fast motion) and needs tighter ones
+	_FORCE_INLINE_ bool _bounds_too_fat(const BOUNDS &p_fat, const BOUNDS &p_bounds) const {
+		for (int i = 0; i < int(sizeof(POINT) / sizeof(real_t)); i++) {
+			if (p_fat.size[i] > (p_bounds.size[i] + margin * 2) * 4)
+				return true;
+		}
+		return false;
+	}
+
+	// grows the bounds in the direction of the motion
+	static _FORCE_INLINE_ void _bounds_expand(BOUNDS &r_bounds, const POINT &p_motion) {
+		for (int i = 0; i < int(sizeof(POINT) / sizeof(real_t)); i++) {
+			if (p_motion[i] < 0) {
+				r_bounds.position[i] += p_motion[i];
+				r_bounds.size[i] -= p_motion[i];
+			} else {
+				r_bounds.size[i] += p_motion[i];
+			}
+		}
+	}
+
+	// surface area heuristic
+	static _FORCE_INLINE_ real_t _bounds_cost(const AABB &p_bounds) { return p_bounds.size.x * p_bounds.size.y + p_bounds.size.y * p_bounds.size.z + p_bounds.size.z * p_bounds.size.x; }
+	static _FORCE_INLINE_ real_t _bounds_cost(const Rect2 &p_bounds) { return p_bounds.size.x + p_bounds.size.y; }
+
+	/* tree */
+
+	int32_t _alloc_node();
+	void _free_node(int32_t p_node);
+	int32_t _balance(int p_tree, int32_t p_node);
+	void _insert_leaf(int p_tree, int32_t p_leaf);
+	void _remove_leaf(int p_tree, int32_t p_leaf);
+	void _fix_upwards(int p_tree, int32_t p_node);
+
+	_FORCE_INLINE_ Element *_get_element(BVHElementID p_id) const {
+		if (p_id == BVH_ELEMENT_INVALID_ID || p_id > element_capacity)
+			return NULL;
+		Element *e = elements[p_id - 1];
+		return (e && e->userdata) ? e : NULL;
+	}
+
+	_FORCE_INLINE_ int _get_tree(const Element *p_element) const { return (use_pairs && p_element->pairable) ? TREE_PAIRABLE : TREE_STATIC; }
+
+	void _insert_element(BVHElementID p_id, Element *p_element, const POINT &p_motion = POINT());
+	void _remove_element(Element *p_element);
+
+	/* pairs */
+
+	_FORCE_INLINE_ bool _can_pair(const Element *p_A, const Element *p_B) const {
+
+		if (p_A == p_B || (p_A->userdata == p_B->userdata && p_A->userdata))
+			return false;
+		if (!p_A->pairable && !p_B->pairable)
+			return false;
+		if (!(p_A->pairable_type & p_B->pairable_mask) && !(p_B->pairable_type & p_A->pairable_mask))
+			return false; // none can pair with none
+		return true;
+	}
+
+	void _pair_check(PairData *p_pair);
+	void _pair_add(BVHElementID p_A, Element *p_element_A, BVHElementID p_B, Element *p_element_B);
+	void _pair_remove(PairData *p_pair);
+	void _element_remove_pairs(Element *p_element);
+	void _element_check_pairs(Element *p_element);
+	void _element_update_pairs(BVHElementID p_id, Element *p_element);
+	void _element_set_dirty(BVHElementID p_id, Element *p_element, uint32_t p_dirty);
+
+	/* culling */
+
+	struct _CullAABB {
+		BOUNDS bounds;
+		_FORCE_INLINE_ bool test_node(const BOUNDS &p_bounds) const { return _bounds_overlap(bounds, p_bounds); }
+		_FORCE_INLINE_ bool test_element(const BOUNDS &p_bounds) const { return _bounds_intersect(bounds, p_bounds); }
+	};
+
+	struct _CullSegment {
+		POINT from;
+		POINT to;
+		_FORCE_INLINE_ bool test_node(const BOUNDS &p_bounds) const { return p_bounds.intersects_segment(from, to); }
+		_FORCE_INLINE_ bool test_element(const BOUNDS &p_bounds) const { return p_bounds.intersects_segment(from, to); }
+	};
+
+	struct _CullPoint {
+		POINT point;
+		_FORCE_INLINE_ bool test_node(const BOUNDS &p_bounds) const { return p_bounds.has_point(point); }
+		_FORCE_INLINE_ bool test_element(const BOUNDS &p_bounds) const { return p_bounds.has_point(point); }
+	};
+
+	struct _CullConvex {
+		const Plane *planes;
+		int plane_count;
+		_FORCE_INLINE_ bool test_node(const BOUNDS &p_bounds) const { return p_bounds.intersects_convex_shape(planes, plane_count); }
+		_FORCE_INLINE_ bool test_element(const BOUNDS &p_bounds) const { return p_bounds.intersects_convex_shape(planes, plane_count); }
+	};
+
+	template <class Q>
+	int _cull(const Q &p_query, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) const;
+
+public:
+	BVHElementID create(T *p_userdata, const BOUNDS &p_bounds = BOUNDS(), int p_subindex = 0, bool p_pairable = false, uint32_t p_pairable_type = 0, uint32_t pairable_mask = 1);
+	void move(BVHElementID p_id, const BOUNDS &p_bounds);
+	void set_pairable(BVHElementID p_id, bool p_pairable = false, uint32_t p_pairable_type = 0, uint32_t pairable_mask = 1);
+	void erase(BVHElementID p_id);
+
+	bool is_pairable(BVHElementID p_id) const;
+	T *get(BVHElementID p_id) const;
+	int get_subindex(BVHElementID p_id) const;
+
+	// Culling doesn't modify the tree, so it can be done from several threads at the same time.
+	int cull_convex(const Vector<Plane> &p_convex, T **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) const;
+	int cull_convex(const Plane *p_planes, int p_plane_count, T **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) const;
+	int cull_aabb(const BOUNDS &p_bounds, T **p_result_array, int p_result_max, int *p_subindex_array = NULL, uint32_t p_mask = 0xFFFFFFFF) const;
+	int cull_segment(const POINT &p_from, const POINT &p_to, T **p_result_array, int p_result_max, int *p_subindex_array = NULL, uint32_t p_mask = 0xFFFFFFFF) const;
+	int cull_point(const POINT &p_point, T **p_result_array, int p_result_max, int *p_subindex_array = NULL, uint32_t p_mask = 0xFFFFFFFF) const;
+
+	void set_pair_callback(PairCallback p_callback, void *p_userdata);
+	void set_unpair_callback(UnpairCallback p_callback, void *p_userdata);
+
+	void set_margin(real_t p_margin);
+	real_t get_margin() const { return margin; }
+
+	void set_deferred_pairs(bool p_enable);
+	bool is_deferred_pairs() const { return deferred_pairs; }
+	void update_pairs();
+
+	int get_element_count() const { return element_count; }
+	int get_pair_count() const { return pair_count; }
+	int get_height() const;
+
+	BVH(real_t p_margin = 0.1);
+	~BVH();
+};
+
+/* PRIVATE FUNCTIONS */
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+int32_t BVH<T, use_pairs, BOUNDS, POINT>::_alloc_node() {
+
+	if (free_node == NODE_NULL) {
+
+		int32_t new_capacity = node_capacity ? node_capacity * 2 : 16;
+		nodes = (Node *)memrealloc(nodes, sizeof(Node) * new_capacity);
+
+		for (int32_t i = node_capacity; i < new_capacity; i++) {
+			nodes[i].parent = (i + 1 < new_capacity) ? i + 1 : NODE_NULL;
+			nodes[i].height = -1;
+		}
+
+		free_node = node_capacity;
+		node_capacity = new_capacity;
+	}
+
+	int32_t node = free_node;
+	free_node = nodes[node].parent;
+
+	Node &n = nodes[node];
+	n.parent = NODE_NULL;
+	n.children[0] = NODE_NULL;
+	n.children[1] = NODE_NULL;
+	n.height = 0;
+	n.element = BVH_ELEMENT_INVALID_ID;
+
+	return node;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_free_node(int32_t p_node) {
+
+	nodes[p_node].parent = free_node;
+	nodes[p_node].height = -1;
+	free_node = p_node;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+int32_t BVH<T, use_pairs, BOUNDS, POINT>::_balance(int p_tree, int32_t p_node) {
+
+	// Rotates the tree around p_node if its children heights differ by more than one,
+	// returns the node that took its place.
+
+	Node *A = &nodes[p_node];
+	if (A->is_leaf() || A->height < 2)
+		return p_node;
+
+	int32_t iB = A->children[0];
+	int32_t iC = A->children[1];
+	Node *B = &nodes[iB];
+	Node *C = &nodes[iC];
+
+	int32_t balance = C->height - B->height;
+
+	if (balance > 1) {
+		// rotate C up
+		int32_t iF = C->children[0];
+		int32_t iG = C->children[1];
+		Node *F = &nodes[iF];
+		Node *G = &nodes[iG];
+
+		C->children[0] = p_node;
+		C->parent = A->parent;
+		A->parent = iC;
+
+		if (C->parent != NODE_NULL) {
+			Node &parent = nodes[C->parent];
+			parent.children[parent.children[0] == p_node ? 0 : 1] = iC;
+		} else {
+			root[p_tree] = iC;
+		}
+
+		if (F->height > G->height) {
+			C->children[1] = iF;
+			A->children[1] = iG;
+			G->parent = p_node;
+			A->bounds = B->bounds.merge(G->bounds);
+			C->bounds = A->bounds.merge(F->bounds);
+			A->height = 1 + MAX(B->height, G->height);
+			C->height = 1 + MAX(A->height, F->height);
+		} else {
+			C->children[1] = iG;
+			A->children[1] = iF;
+			F->parent = p_node;
+			A->bounds = B->bounds.merge(F->bounds);
+			C->bounds = A->bounds.merge(G->bounds);
+			A->height = 1 + MAX(B->height, F->height);
+			C->height = 1 + MAX(A->height, G->height);
+		}
+
+		return iC;
+	}
+
+	if (balance < -1) {
+		// rotate B up
+		int32_t iD = B->children[0];
+		int32_t iE = B->children[1];
+		Node *D = &nodes[iD];
+		Node *E = &nodes[iE];
+
+		B->children[0] = p_node;
+		B->parent = A->parent;
+		A->parent = iB;
+
+		if (B->parent != NODE_NULL) {
+			Node &parent = nodes[B->parent];
+			parent.children[parent.children[0] == p_node ? 0 : 1] = iB;
+		} else {
+			root[p_tree] = iB;
+		}
+
+		if (D->height > E->height) {
+			B->children[1] = iD;
+			A->children[0] = iE;
+			E->parent = p_node;
+			A->bounds = C->bounds.merge(E->bounds);
+			B->bounds = A->bounds.merge(D->bounds);
+			A->height = 1 + MAX(C->height, E->height);
+			B->height = 1 + MAX(A->height, D->height);
+		} else {
+			B->children[1] = iE;
+			A->children[0] = iD;
+			D->parent = p_node;
+			A->bounds = C->bounds.merge(D->bounds);
+			B->bounds = A->bounds.merge(E->bounds);
+			A->height = 1 + MAX(C->height, D->height);
+			B->height = 1 + MAX(A->height, E->height);
+		}
+
+		return iB;
+	}
+
+	return p_node;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_fix_upwards(int p_tree, int32_t p_node) {
+
+	while (p_node != NODE_NULL) {
+
+		p_node = _balance(p_tree, p_node);
+
+		Node &n = nodes[p_node];
+		const Node &c0 = nodes[n.children[0]];
+		const Node &c1 = nodes[n.children[1]];
+
+		n.height = 1 + MAX(c0.height, c1.height);
+		n.bounds = c0.bounds.merge(c1.bounds);
+
+		p_node = n.parent;
+	}
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_insert_leaf(int p_tree, int32_t p_leaf) {
+
+	if (root[p_tree] == NODE_NULL) {
+		root[p_tree] = p_leaf;
+		nodes[p_leaf].parent = NODE_NULL;
+		return;
+	}
+
+	// find the best sibling, descending to the child which grows the least
+
+	BOUNDS leaf_bounds = nodes[p_leaf].bounds;
+	int32_t index = root[p_tree];
+
+	while (!nodes[index].is_leaf()) {
+
+		const Node &n = nodes[index];
+
+		real_t cost = _bounds_cost(n.bounds);
+		real_t combined_cost = _bounds_cost(n.bounds.merge(leaf_bounds));
+
+		// cost of creating a new parent for this node and the new leaf
+		real_t new_parent_cost = 2.0 * combined_cost;
+		// minimum cost of pushing the leaf further down the tree
+		real_t inheritance_cost = 2.0 * (combined_cost - cost);
+
+		real_t child_cost[2];
+		for (int i = 0; i < 2; i++) {
+
+			const Node &child = nodes[n.children[i]];
+			child_cost[i] = _bounds_cost(child.bounds.merge(leaf_bounds)) + inheritance_cost;
+			if (!child.is_leaf()) {
+				child_cost[i] -= _bounds_cost(child.bounds);
+			}
+		}
+
+		if (new_parent_cost < child_cost[0] && new_parent_cost < child_cost[1])
+			break;
+
+		index = child_cost[0] < child_cost[1] ? n.children[0] : n.children[1];
+	}
+
+	int32_t sibling = index;
+
+	// create a new parent, nodes may be reallocated here
+	int32_t old_parent = nodes[sibling].parent;
+	int32_t new_parent = _alloc_node();
+
+	Node &np = nodes[new_parent];
+	np.parent = old_parent;
+	np.bounds = leaf_bounds.merge(nodes[sibling].bounds);
+	np.height = nodes[sibling].height + 1;
+	np.children[0] = sibling;
+	np.children[1] = p_leaf;
+
+	if (old_parent != NODE_NULL) {
+		Node &op = nodes[old_parent];
+		op.children[op.children[0] == sibling ? 0 : 1] = new_parent;
+	} else {
+		root[p_tree] = new_parent;
+	}
+
+	nodes[sibling].parent = new_parent;
+	nodes[p_leaf].parent = new_parent;
+
+	_fix_upwards(p_tree, new_parent);
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_remove_leaf(int p_tree, int32_t p_leaf) {
+
+	if (p_leaf == root[p_tree]) {
+		root[p_tree] = NODE_NULL;
+		return;
+	}
+
+	int32_t parent = nodes[p_leaf].parent;
+	int32_t grand_parent = nodes[parent].parent;
+	int32_t sibling = nodes[parent].children[nodes[parent].children[0] == p_leaf ? 1 : 0];
+
+	_free_node(parent);
+
+	if (grand_parent != NODE_NULL) {
+
+		Node &gp = nodes[grand_parent];
+		gp.children[gp.children[0] == parent ? 0 : 1] = sibling;
+		nodes[sibling].parent = grand_parent;
+
+		_fix_upwards(p_tree, grand_parent);
+	} else {
+
+		root[p_tree] = sibling;
+		nodes[sibling].parent = NODE_NULL;
+	}
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_insert_element(BVHElementID p_id, Element *p_element, const POINT &p_motion) {
+
+	int32_t leaf = _alloc_node();
+	nodes[leaf].bounds = p_element->bounds.grow(margin);
+	_bounds_expand(nodes[leaf].bounds, p_motion * MOTION_PREDICTION);
+	nodes[leaf].element = p_id;
+	p_element->leaf = leaf;
+
+	_insert_leaf(_get_tree(p_element), leaf);
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_remove_element(Element *p_element) {
+
+	_remove_leaf(_get_tree(p_element), p_element->leaf);
+	_free_node(p_element->leaf);
+	p_element->leaf = NODE_NULL;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_pair_check(PairData *p_pair) {
+
+	Element *A = elements[p_pair->A - 1];
+	Element *B = elements[p_pair->B - 1];
+
+	bool intersect = _bounds_intersect(A->bounds, B->bounds);
+
+	if (intersect != p_pair->intersect) {
+
+		if (intersect) {
+
+			if (pair_callback) {
+				p_pair->ud = pair_callback(pair_callback_userdata, p_pair->A, A->userdata, A->subindex, p_pair->B, B->userdata, B->subindex);
+			}
+			pair_count++;
+		} else {
+
+			if (unpair_callback) {
+				unpair_callback(unpair_callback_userdata, p_pair->A, A->userdata, A->subindex, p_pair->B, B->userdata, B->subindex, p_pair->ud);
+			}
+			pair_count--;
+		}
+
+		p_pair->intersect = intersect;
+	}
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_pair_add(BVHElementID p_A, Element *p_element_A, BVHElementID p_B, Element *p_element_B) {
+
+	if (p_A > p_B) {
+		SWAP(p_A, p_B);
+		SWAP(p_element_A, p_element_B);
+	}
+
+	PairData *pair = memnew(PairData);
+	pair->intersect = false;
+	pair->A = p_A;
+	pair->B = p_B;
+	pair->ud = NULL;
+	pair->eA = p_element_A->pair_list.push_back(pair);
+	pair->eB = p_element_B->pair_list.push_back(pair);
+
+	_pair_check(pair);
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_pair_remove(PairData *p_pair) {
+
+	Element *A = elements[p_pair->A - 1];
+	Element *B = elements[p_pair->B - 1];
+
+	if (p_pair->intersect) {
+
+		if (unpair_callback) {
+			unpair_callback(unpair_callback_userdata, p_pair->A, A->userdata, A->subindex, p_pair->B, B->userdata, B->subindex, p_pair->ud);
+		}
+		pair_count--;
+	}
+
+	A->pair_list.erase(p_pair->eA);
+	B->pair_list.erase(p_pair->eB);
+	memdelete(p_pair);
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_element_remove_pairs(Element *p_element) {
+
+	while (p_element->pair_list.front()) {
+		_pair_remove(p_element->pair_list.front()->get());
+	}
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_element_check_pairs(Element *p_element) {
+
+	for (typename List<PairData *>::Element *E = p_element->pair_list.front(); E; E = E->next()) {
+
+		PairData *pair = E->get();
+		if (elements[pair->A - 1]->last_batch == batch || elements[pair->B - 1]->last_batch == batch)
+			continue; // the other element already checked this pair in this batch
+		_pair_check(pair);
+	}
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_element_update_pairs(BVHElementID p_id, Element *p_element) {
+
+	// called after the element got new fat bounds
+
+	const BOUNDS &fat = nodes[p_element->leaf].bounds;
+
+	pass++;
+
+	typename List<PairData *>::Element *E = p_element->pair_list.front();
+	while (E) {
+
+		typename List<PairData *>::Element *N = E->next();
+
+		PairData *pair = E->get();
+		Element *other = elements[(pair->A == p_id ? pair->B : pair->A) - 1];
+
+		if (other->last_batch == batch) {
+			// already checked against the current bounds of this element in this batch
+			other->last_pass = pass;
+		} else if (_bounds_overlap(fat, nodes[other->leaf].bounds)) {
+			other->last_pass = pass;
+			_pair_check(pair);
+		} else {
+			_pair_remove(pair);
+		}
+
+		E = N;
+	}
+
+	// find new candidates, non pairable elements can't pair among themselves
+
+	int32_t stack[STACK_SIZE];
+
+	for (int i = (p_element->pairable ? 0 : 1); i < TREE_MAX; i++) {
+
+		if (root[i] == NODE_NULL)
+			continue;
+
+		int stack_size = 0;
+		stack[stack_size++] = root[i];
+
+		while (stack_size) {
+
+			// nodes are not reallocated while iterating, as pairs don't allocate them
+			const Node &n = nodes[stack[--stack_size]];
+
+			if (!_bounds_overlap(fat, n.bounds))
+				continue;
+
+			if (!n.is_leaf()) {
+				stack[stack_size++] = n.children[0];
+				stack[stack_size++] = n.children[1];
+				continue;
+			}
+
+			Element *other = elements[n.element - 1];
+			if (other->last_pass == pass || other->last_batch == batch || !_can_pair(p_element, other))
+				continue;
+
+			other->last_pass = pass;
+			_pair_add(p_id, p_element, n.element, other);
+		}
+	}
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::_element_set_dirty(BVHElementID p_id, Element *p_element, uint32_t p_dirty) {
+
+	if (!deferred_pairs) {
+		if (p_dirty & DIRTY_CANDIDATES)
+			_element_update_pairs(p_id, p_element);
+		else
+			_element_check_pairs(p_element);
+		return;
+	}
+
+	if (!p_element->dirty)
+		dirty_elements.push_back(p_id);
+	p_element->dirty |= p_dirty;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+template <class Q>
+int BVH<T, use_pairs, BOUNDS, POINT>::_cull(const Q &p_query, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) const {
+
+	int result_idx = 0;
+	int32_t stack[STACK_SIZE];
+
+	for (int i = 0; i < TREE_MAX; i++) {
+
+		if (root[i] == NODE_NULL)
+			continue;
+
+		int stack_size = 0;
+		stack[stack_size++] = root[i];
+
+		while (stack_size) {
+
+			const Node &n = nodes[stack[--stack_size]];
+
+			if (!p_query.test_node(n.bounds))
+				continue;
+
+			if (!n.is_leaf()) {
+				stack[stack_size++] = n.children[0];
+				stack[stack_size++] = n.children[1];
+				continue;
+			}
+
+			const Element *e = elements[n.element - 1];
+
+			if (use_pairs && !(e->pairable_type & p_mask))
+				continue;
+
+			if (!p_query.test_element(e->bounds))
+				continue;
+
+			if (result_idx == p_result_max)
+				return result_idx; // pointless to continue
+
+			p_result_array[result_idx] = e->userdata;
+			if (p_subindex_array)
+				p_subindex_array[result_idx] = e->subindex;
+			result_idx++;
+		}
+	}
+
+	return result_idx;
+}
+
+/* PUBLIC FUNCTIONS */
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+BVHElementID BVH<T, use_pairs, BOUNDS, POINT>::create(T *p_userdata, const BOUNDS &p_bounds, int p_subindex, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) {
+
+	ERR_FAIL_COND_V(!p_userdata, BVH_ELEMENT_INVALID_ID);
+
+	if (free_element == BVH_ELEMENT_INVALID_ID) {
+
+		uint32_t new_capacity = element_capacity ? element_capacity * 2 : 16;
+		elements = (Element **)memrealloc(elements, sizeof(Element *) * new_capacity);
+
+		for (uint32_t i = element_capacity; i < new_capacity; i++) {
+			elements[i] = NULL;
+		}
+
+		free_element = element_capacity + 1;
+		element_capacity = new_capacity;
+	}
+
+	BVHElementID id = free_element;
+	Element *e = elements[id - 1];
+
+	if (e) {
+		free_element = e->next_free;
+	} else {
+		e = memnew(Element);
+		elements[id - 1] = e;
+		free_element = (id < element_capacity && !elements[id]) ? id + 1 : BVH_ELEMENT_INVALID_ID;
+	}
+
+	e->userdata = p_userdata;
+	e->subindex = p_subindex;
+	e->pairable = p_pairable;
+	e->pairable_type = p_pairable_type;
+	e->pairable_mask = p_pairable_mask;
+	e->bounds = p_bounds;
+	e->leaf = NODE_NULL;
+	e->last_pass = 0;
+	e->last_batch = 0;
+	e->next_free = BVH_ELEMENT_INVALID_ID;
+	e->dirty = 0;
+
+	element_count++;
+
+	if (!_bounds_empty(p_bounds)) {
+
+		_insert_element(id, e);
+		if (use_pairs)
+			_element_set_dirty(id, e, DIRTY_CANDIDATES);
+	}
+
+	return id;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::move(BVHElementID p_id, const BOUNDS &p_bounds) {
+
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
+
+	if (_bounds_empty(p_bounds)) {
+
+		if (e->leaf != NODE_NULL) {
+			if (use_pairs)
+				_element_remove_pairs(e);
+			_remove_element(e);
+		}
+		e->bounds = p_bounds;
+		return;
+	}
+
+	if (e->leaf != NODE_NULL && _bounds_encloses(nodes[e->leaf].bounds, p_bounds) && !_bounds_too_fat(nodes[e->leaf].bounds, p_bounds)) {
+		// still inside the fat bounds, the tree and the pair candidates don't change
+		e->bounds = p_bounds;
+		if (use_pairs)
+			_element_set_dirty(p_id, e, DIRTY_PAIRS);
+		return;
+	}
+
+	POINT motion;
+
+	if (e->leaf != NODE_NULL) {
+
+		_remove_element(e);
+
+		// predict where the element goes next, unless it jumped further than its own size (likely teleported)
+		motion = p_bounds.position - e->bounds.position;
+		for (int i = 0; i < int(sizeof(POINT) / sizeof(real_t)); i++) {
+			if (ABS(motion[i]) > p_bounds.size[i]) {
+				motion = POINT();
+				break;
+			}
+		}
+	}
+
+	e->bounds = p_bounds;
+	_insert_element(p_id, e, motion);
+
+	if (use_pairs)
+		_element_set_dirty(p_id, e, DIRTY_CANDIDATES);
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::set_pairable(BVHElementID p_id, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) {
+
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
+
+	if (p_pairable == e->pairable && e->pairable_type == p_pairable_type && e->pairable_mask == p_pairable_mask)
+		return; // no changes, return
+
+	bool in_tree = e->leaf != NODE_NULL;
+
+	if (in_tree) {
+		if (use_pairs)
+			_element_remove_pairs(e);
+		_remove_element(e);
+	}
+
+	e->pairable = p_pairable;
+	e->pairable_type = p_pairable_type;
+	e->pairable_mask = p_pairable_mask;
+
+	if (in_tree) {
+		_insert_element(p_id, e);
+		if (use_pairs)
+			_element_set_dirty(p_id, e, DIRTY_CANDIDATES);
+	}
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::erase(BVHElementID p_id) {
+
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
+
+	if (e->leaf != NODE_NULL) {
+		if (use_pairs)
+			_element_remove_pairs(e);
+		_remove_element(e);
+	}
+
+	// keep the element allocated, it will be reused, update_pairs() skips it if still queued
+	e->userdata = NULL;
+	e->dirty = 0;
+	e->next_free = free_element;
+	free_element = p_id;
+
+	element_count--;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+bool BVH<T, use_pairs, BOUNDS, POINT>::is_pairable(BVHElementID p_id) const {
+
+	const Element *e = _get_element(p_id);
+	ERR_FAIL_COND_V(!e, false);
+	return e->pairable;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+T *BVH<T, use_pairs, BOUNDS, POINT>::get(BVHElementID p_id) const {
+
+	const Element *e = _get_element(p_id);
+	ERR_FAIL_COND_V(!e, NULL);
+	return e->userdata;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+int BVH<T, use_pairs, BOUNDS, POINT>::get_subindex(BVHElementID p_id) const {
+
+	const Element *e = _get_element(p_id);
+	ERR_FAIL_COND_V(!e, -1);
+	return e->subindex;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+int BVH<T, use_pairs, BOUNDS, POINT>::cull_convex(const Vector<Plane> &p_convex, T **p_result_array, int p_result_max, uint32_t p_mask) const {
+
+	return cull_convex(p_convex.ptr(), p_convex.size(), p_result_array, p_result_max, p_mask);
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+int BVH<T, use_pairs, BOUNDS, POINT>::cull_convex(const Plane *p_planes, int p_plane_count, T **p_result_array, int p_result_max, uint32_t p_mask) const {
+
+	if (!p_plane_count)
+		return 0;
+
+	_CullConvex query;
+	query.planes = p_planes;
+	query.plane_count = p_plane_count;
+
+	return _cull(query, p_result_array, p_result_max, NULL, p_mask);
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+int BVH<T, use_pairs, BOUNDS, POINT>::cull_aabb(const BOUNDS &p_bounds, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) const {
+
+	_CullAABB query;
+	query.bounds = p_bounds;
+
+	return _cull(query, p_result_array, p_result_max, p_subindex_array, p_mask);
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+int BVH<T, use_pairs, BOUNDS, POINT>::cull_segment(const POINT &p_from, const POINT &p_to, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) const {
+
+	_CullSegment query;
+	query.from = p_from;
+	query.to = p_to;
+
+	return _cull(query, p_result_array, p_result_max, p_subindex_array, p_mask);
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+int BVH<T, use_pairs, BOUNDS, POINT>::cull_point(const POINT &p_point, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) const {
+
+	_CullPoint query;
+	query.point = p_point;
+
+	return _cull(query, p_result_array, p_result_max, p_subindex_array, p_mask);
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::set_pair_callback(PairCallback p_callback, void *p_userdata) {
+
+	pair_callback = p_callback;
+	pair_callback_userdata = p_userdata;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::set_unpair_callback(UnpairCallback p_callback, void *p_userdata) {
+
+	unpair_callback = p_callback;
+	unpair_callback_userdata = p_userdata;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::set_margin(real_t p_margin) {
+
+	ERR_FAIL_COND(p_margin < 0);
+	// only affects elements inserted from now on
+	margin = p_margin;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::set_deferred_pairs(bool p_enable) {
+
+	if (deferred_pairs == p_enable)
+		return;
+
+	update_pairs();
+	deferred_pairs = p_enable;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+void BVH<T, use_pairs, BOUNDS, POINT>::update_pairs() {
+
+	if (!dirty_elements.size())
+		return;
+
+	// Elements are processed in the order they were first changed, so results don't depend on addresses.
+	// Once an element searched its pairs, the elements processed after it can skip it.
+	for (int i = 0; i < dirty_elements.size(); i++) {
+
+		BVHElementID id = dirty_elements[i];
+		Element *e = elements[id - 1];
+
+		uint32_t dirty = e->dirty;
+		if (!dirty)
+			continue; // erased, or queued again after being reused
+		e->dirty = 0;
+
+		if (e->leaf == NODE_NULL)
+			continue; // removed from the tree, pairs are already gone
+
+		if (dirty & DIRTY_CANDIDATES) {
+			_element_update_pairs(id, e);
+			e->last_batch = batch;
+		} else {
+			_element_check_pairs(e);
+		}
+	}
+
+	dirty_elements.clear();
+	batch++; // stamps must not match outside of update_pairs()
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+int BVH<T, use_pairs, BOUNDS, POINT>::get_height() const {
+
+	int height = 0;
+	for (int i = 0; i < TREE_MAX; i++) {
+		if (root[i] != NODE_NULL)
+			height = MAX(height, nodes[root[i]].height + 1);
+	}
+	return height;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+BVH<T, use_pairs, BOUNDS, POINT>::BVH(real_t p_margin) {
+
+	nodes = NULL;
+	node_capacity = 0;
+	free_node = NODE_NULL;
+	for (int i = 0; i < TREE_MAX; i++) {
+		root[i] = NODE_NULL;
+	}
+
+	elements = NULL;
+	element_capacity = 0;
+	free_element = BVH_ELEMENT_INVALID_ID;
+
+	element_count = 0;
+	pair_count = 0;
+	pass = 1;
+	margin = p_margin;
+	deferred_pairs = false;
+	batch = 1;
+
+	pair_callback = NULL;
+	unpair_callback = NULL;
+	pair_callback_userdata = NULL;
+	unpair_callback_userdata = NULL;
+}
+
+template <class T, bool use_pairs, class BOUNDS, class POINT>
+BVH<T, use_pairs, BOUNDS, POINT>::~BVH() {
+
+	for (uint32_t i = 0; i < element_capacity; i++) {
+
+		Element *e = elements[i];
+		if (!e)
+			continue;
+
+		// pairs are just freed, like in Octree no callbacks are called on destruction
+		while (e->pair_list.front()) {
+			PairData *pair = e->pair_list.front()->get();
+			elements[pair->A - 1]->pair_list.erase(pair->eA);
+			elements[pair->B - 1]->pair_list.erase(pair->eB);
+			memdelete(pair);
+		}
+	}
+
+	for (uint32_t i = 0; i < element_capacity; i++) {
+		if (elements[i])
+			memdelete(elements[i]);
+	}
+
+	if (elements)
+		memfree(elements);
+	if (nodes)
+		memfree(nodes);
+}
+
+#endif // BVH_H
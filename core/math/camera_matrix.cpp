@@ -289,7 +289,7 @@ bool CameraMatrix::get_endpoints(const Transform &p_transform, Vector3 *p_8point
 	return true;
 }
 
-Vector<Plane> CameraMatrix::get_projection_planes(const Transform &p_transform) const {
+void CameraMatrix::get_projection_planes(const Transform &p_transform, Plane *r_planes) const {
 
 	/** Fast Plane Extraction from combined modelview/projection matrices.
 	 * References:
@@ -297,8 +297,6 @@ Vector<Plane> CameraMatrix::get_projection_planes(const Transform &p_transform)
 	 * http://www2.ravensoft.com/users/ggribb/plane%20extraction.pdf
 	 */
 
-	Vector<Plane> planes;
-
 	const real_t *matrix = (const real_t *)this->matrix;
 
 	Plane new_plane;
@@ -312,7 +310,7 @@ Vector<Plane> CameraMatrix::get_projection_planes(const Transform &p_transform)
 	new_plane.normal = -new_plane.normal;
 	new_plane.normalize();
 
-	planes.push_back(p_transform.xform(new_plane));
+	r_planes[0] = p_transform.xform(new_plane);
 
 	///////--- Far Plane ---///////
 	new_plane = Plane(matrix[3] - matrix[2],
@@ -323,7 +321,7 @@ Vector<Plane> CameraMatrix::get_projection_planes(const Transform &p_transform)
 	new_plane.normal = -new_plane.normal;
 	new_plane.normalize();
 
-	planes.push_back(p_transform.xform(new_plane));
+	r_planes[1] = p_transform.xform(new_plane);
 
 	///////--- Left Plane ---///////
 	new_plane = Plane(matrix[3] + matrix[0],
@@ -334,7 +332,7 @@ Vector<Plane> CameraMatrix::get_projection_planes(const Transform &p_transform)
 	new_plane.normal = -new_plane.normal;
 	new_plane.normalize();
 
-	planes.push_back(p_transform.xform(new_plane));
+	r_planes[2] = p_transform.xform(new_plane);
 
 	///////--- Top Plane ---///////
 	new_plane = Plane(matrix[3] - matrix[1],
@@ -345,7 +343,7 @@ Vector<Plane> CameraMatrix::get_projection_planes(const Transform &p_transform)
 	new_plane.normal = -new_plane.normal;
 	new_plane.normalize();
 
-	planes.push_back(p_transform.xform(new_plane));
+	r_planes[3] = p_transform.xform(new_plane);
 
 	///////--- Right Plane ---///////
 	new_plane = Plane(matrix[3] - matrix[0],
@@ -356,7 +354,7 @@ Vector<Plane> CameraMatrix::get_projection_planes(const Transform &p_transform)
 	new_plane.normal = -new_plane.normal;
 	new_plane.normalize();
 
-	planes.push_back(p_transform.xform(new_plane));
+	r_planes[4] = p_transform.xform(new_plane);
 
 	///////--- Bottom Plane ---///////
 	new_plane = Plane(matrix[3] + matrix[1],
@@ -367,8 +365,14 @@ Vector<Plane> CameraMatrix::get_projection_planes(const Transform &p_transform)
 	new_plane.normal = -new_plane.normal;
 	new_plane.normalize();
 
-	planes.push_back(p_transform.xform(new_plane));
+	r_planes[5] = p_transform.xform(new_plane);
+}
 
+Vector<Plane> CameraMatrix::get_projection_planes(const Transform &p_transform) const {
+
+	Vector<Plane> planes;
+	planes.resize(6);
+	get_projection_planes(p_transform, planes.ptrw());
 	return planes;
 }
 
@@ -73,6 +73,7 @@ struct CameraMatrix {
 	bool is_orthogonal() const;
 
 	Vector<Plane> get_projection_planes(const Transform &p_transform) const;
+	void get_projection_planes(const Transform &p_transform, Plane *r_planes) const; // fills 6 planes, in the order of the Planes enum
 
 	bool get_endpoints(const Transform &p_transform, Vector3 *p_8points) const;
 	void get_viewport_size(real_t &r_width, real_t &r_height) const;
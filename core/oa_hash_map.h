@@ -32,8 +32,8 @@
 #define OA_HASH_MAP_H
 
 #include "hashfuncs.h"
+#include "list.h"
 #include "math_funcs.h"
-#include "os/copymem.h"
 #include "os/memory.h"
 
 /**
@@ -43,7 +43,16 @@
  * and enables faster lookups.
  *
  * The entries are stored inplace, so huge keys or values might fill cache lines
- * a lot faster.
+ * a lot faster. Hashes, keys and values are kept in separate arrays, so probing
+ * only touches the hashes until one matches.
+ *
+ * Erasing shifts the following entries back instead of leaving tombstones,
+ * so lookups never slow down after many insertions and deletions. Unlike
+ * HashMap, this means that pointers to keys and values are invalidated when
+ * the map is modified, don't keep them around.
+ *
+ * Besides its own API, it provides the same functions as HashMap (set, getptr,
+ * get, operator[], erase, next, get_key_list...) so one can replace the other.
  */
 template <class TKey, class TValue,
 		class Hasher = HashMapHasherDefault,
@@ -59,27 +68,29 @@ private:
 
 	uint32_t num_elements;
 
+	uint8_t capacity_power;
+
 	static const uint32_t EMPTY_HASH = 0;
-	static const uint32_t DELETED_HASH_BIT = 1 << 31;
+	static const uint32_t MIN_CAPACITY_POWER = 3;
 
-	_FORCE_INLINE_ uint32_t _hash(const TKey &p_key) {
+	_FORCE_INLINE_ static uint32_t _hash(const TKey &p_key) {
 		uint32_t hash = Hasher::hash(p_key);
 
 		if (hash == EMPTY_HASH) {
 			hash = EMPTY_HASH + 1;
-		} else if (hash & DELETED_HASH_BIT) {
-			hash &= ~DELETED_HASH_BIT;
 		}
 
 		return hash;
 	}
 
-	_FORCE_INLINE_ uint32_t _get_probe_length(uint32_t p_pos, uint32_t p_hash) {
-		p_hash = p_hash & ~DELETED_HASH_BIT; // we don't care if it was deleted or not
-
-		uint32_t original_pos = p_hash % capacity;
+	// Fibonacci hashing uses the high bits, so hashes that only differ in their
+	// high bits (like aligned pointers or multiples of a power of two) still spread.
+	_FORCE_INLINE_ uint32_t _get_home(uint32_t p_hash) const {
+		return (p_hash * 2654435769u) >> (32 - capacity_power);
+	}
 
-		return p_pos - original_pos;
+	_FORCE_INLINE_ uint32_t _get_probe_length(uint32_t p_pos, uint32_t p_hash) const {
+		return (p_pos - _get_home(p_hash)) & (capacity - 1);
 	}
 
 	_FORCE_INLINE_ void _construct(uint32_t p_pos, uint32_t p_hash, const TKey &p_key, const TValue &p_value) {
@@ -90,9 +101,14 @@ private:
 		num_elements++;
 	}
 
-	bool _lookup_pos(const TKey &p_key, uint32_t &r_pos) {
-		uint32_t hash = _hash(p_key);
-		uint32_t pos = hash % capacity;
+	template <class K>
+	_FORCE_INLINE_ bool _lookup_pos_with_hash(const K &p_key, uint32_t p_hash, uint32_t &r_pos) const {
+
+		if (unlikely(!hashes)) {
+			return false;
+		}
+
+		uint32_t pos = _get_home(p_hash);
 		uint32_t distance = 0;
 
 		while (42) {
@@ -104,54 +120,85 @@ private:
 				return false;
 			}
 
-			if (hashes[pos] == hash && Comparator::compare(keys[pos], p_key)) {
+			if (hashes[pos] == p_hash && Comparator::compare(keys[pos], p_key)) {
 				r_pos = pos;
 				return true;
 			}
 
-			pos = (pos + 1) % capacity;
+			pos = (pos + 1) & (capacity - 1);
 			distance++;
 		}
 	}
 
-	void _insert_with_hash(uint32_t p_hash, const TKey &p_key, const TValue &p_value) {
+	_FORCE_INLINE_ bool _lookup_pos(const TKey &p_key, uint32_t &r_pos) const {
+		return _lookup_pos_with_hash(p_key, _hash(p_key), r_pos);
+	}
+
+	// Returns the position the new entry ended up at.
+	uint32_t _insert_with_hash(uint32_t p_hash, const TKey &p_key, const TValue &p_value) {
 
 		uint32_t hash = p_hash;
 		uint32_t distance = 0;
-		uint32_t pos = hash % capacity;
+		uint32_t pos = _get_home(hash);
+
+		for (; hashes[pos] != EMPTY_HASH; pos = (pos + 1) & (capacity - 1), distance++) {
+			// not an empty slot, let's check the probing length of the existing one
+			uint32_t existing_probe_len = _get_probe_length(pos, hashes[pos]);
+			if (existing_probe_len < distance) {
+				break;
+			}
+		}
+
+		if (hashes[pos] == EMPTY_HASH) {
+			_construct(pos, hash, p_key, p_value);
+			return pos;
+		}
 
-		TKey key = p_key;
-		TValue value = p_value;
+		// The new entry takes this slot, the richer one is moved further along.
+		uint32_t result = pos;
+
+		TKey key = keys[pos];
+		TValue value = values[pos];
+		SWAP(hash, hashes[pos]);
+		keys[pos] = p_key;
+		values[pos] = p_value;
+		distance = _get_probe_length(pos, hash);
 
 		while (42) {
-			if (hashes[pos] == EMPTY_HASH) {
-				_construct(pos, hash, p_key, p_value);
+			pos = (pos + 1) & (capacity - 1);
+			distance++;
 
-				return;
+			if (hashes[pos] == EMPTY_HASH) {
+				_construct(pos, hash, key, value);
+				return result;
 			}
 
-			// not an empty slot, let's check the probing length of the existing one
 			uint32_t existing_probe_len = _get_probe_length(pos, hashes[pos]);
 			if (existing_probe_len < distance) {
-
-				if (hashes[pos] & DELETED_HASH_BIT) {
-					// we found a place where we can fit in!
-					_construct(pos, hash, p_key, p_value);
-
-					return;
-				}
-
 				SWAP(hash, hashes[pos]);
 				SWAP(key, keys[pos]);
 				SWAP(value, values[pos]);
 				distance = existing_probe_len;
 			}
+		}
+	}
 
-			pos = (pos + 1) % capacity;
-			distance++;
+	void _allocate(uint8_t p_capacity_power) {
+
+		capacity_power = p_capacity_power;
+		capacity = 1 << p_capacity_power;
+		num_elements = 0;
+
+		keys = (TKey *)memalloc(sizeof(TKey) * capacity);
+		values = (TValue *)memalloc(sizeof(TValue) * capacity);
+		hashes = (uint32_t *)memalloc(sizeof(uint32_t) * capacity);
+
+		for (uint32_t i = 0; i < capacity; i++) {
+			hashes[i] = EMPTY_HASH;
 		}
 	}
-	void _resize_and_rehash() {
+
+	void _resize_and_rehash(uint8_t p_capacity_power) {
 
 		TKey *old_keys = keys;
 		TValue *old_values = values;
@@ -159,46 +206,98 @@ private:
 
 		uint32_t old_capacity = capacity;
 
-		capacity = old_capacity * 2;
-		num_elements = 0;
+		_allocate(p_capacity_power);
 
-		keys = memnew_arr(TKey, capacity);
-		values = memnew_arr(TValue, capacity);
-		hashes = memnew_arr(uint32_t, capacity);
-
-		for (int i = 0; i < capacity; i++) {
-			hashes[i] = 0;
+		if (!old_hashes) {
+			return;
 		}
 
 		for (uint32_t i = 0; i < old_capacity; i++) {
 			if (old_hashes[i] == EMPTY_HASH) {
 				continue;
 			}
-			if (old_hashes[i] & DELETED_HASH_BIT) {
-				continue;
-			}
 
 			_insert_with_hash(old_hashes[i], old_keys[i], old_values[i]);
+			old_keys[i].~TKey();
+			old_values[i].~TValue();
+		}
+
+		memfree(old_keys);
+		memfree(old_values);
+		memfree(old_hashes);
+	}
+
+	// Keeps the load factor under 7/8, grows the table before it's exceeded.
+	_FORCE_INLINE_ void _reserve_one() {
+
+		if (unlikely(!hashes)) {
+			_resize_and_rehash(capacity_power);
+		} else if ((num_elements + 1) * 8 > capacity * 7) {
+			_resize_and_rehash(capacity_power + 1);
+		}
+	}
+
+	void _erase_pos(uint32_t p_pos) {
+
+		keys[p_pos].~TKey();
+		values[p_pos].~TValue();
+
+		// backward shift deletion, move the following entries closer to their home
+		uint32_t pos = p_pos;
+		uint32_t next = (pos + 1) & (capacity - 1);
+
+		while (hashes[next] != EMPTY_HASH && _get_probe_length(next, hashes[next]) != 0) {
+
+			memnew_placement(&keys[pos], TKey(keys[next]));
+			memnew_placement(&values[pos], TValue(values[next]));
+			hashes[pos] = hashes[next];
+			keys[next].~TKey();
+			values[next].~TValue();
+
+			pos = next;
+			next = (next + 1) & (capacity - 1);
+		}
+
+		hashes[pos] = EMPTY_HASH;
+		num_elements--;
+	}
+
+	void _copy_from(const OAHashMap &p_map) {
+
+		clear();
+
+		capacity_power = p_map.capacity_power;
+		capacity = p_map.capacity;
+
+		if (!p_map.hashes) {
+			return;
 		}
 
-		memdelete_arr(old_keys);
-		memdelete_arr(old_values);
-		memdelete_arr(old_hashes);
+		_allocate(p_map.capacity_power);
+
+		for (uint32_t i = 0; i < capacity; i++) {
+			if (p_map.hashes[i] == EMPTY_HASH) {
+				continue;
+			}
+			_construct(i, p_map.hashes[i], p_map.keys[i], p_map.values[i]);
+		}
 	}
 
 public:
 	_FORCE_INLINE_ uint32_t get_capacity() const { return capacity; }
 	_FORCE_INLINE_ uint32_t get_num_elements() const { return num_elements; }
 
-	void insert(const TKey &p_key, const TValue &p_value) {
+	_FORCE_INLINE_ unsigned int size() const { return num_elements; }
+	_FORCE_INLINE_ bool empty() const { return num_elements == 0; }
 
-		if ((float)num_elements / (float)capacity > 0.9) {
-			_resize_and_rehash();
-		}
-
-		uint32_t hash = _hash(p_key);
+	/**
+	 * Inserts an entry without checking if the key is already in the map,
+	 * use set() unless it's known not to be there.
+	 */
+	void insert(const TKey &p_key, const TValue &p_value) {
 
-		_insert_with_hash(hash, p_key, p_value);
+		_reserve_one();
+		_insert_with_hash(_hash(p_key), p_key, p_value);
 	}
 
 	void set(const TKey &p_key, const TValue &p_data) {
@@ -206,8 +305,7 @@ public:
 		bool exists = _lookup_pos(p_key, pos);
 
 		if (exists) {
-			values[pos].~TValue();
-			memnew_placement(&values[pos], TValue(p_data));
+			values[pos] = p_data;
 		} else {
 			insert(p_key, p_data);
 		}
@@ -219,36 +317,158 @@ public:
 	 * if r_data is not NULL then the value will be written to the object
 	 * it points to.
 	 */
-	bool lookup(const TKey &p_key, TValue &r_data) {
+	bool lookup(const TKey &p_key, TValue &r_data) const {
 		uint32_t pos = 0;
 		bool exists = _lookup_pos(p_key, pos);
 
 		if (exists) {
-			r_data.~TValue();
-			memnew_placement(&r_data, TValue(values[pos]));
+			r_data = values[pos];
 			return true;
 		}
 
 		return false;
 	}
 
-	_FORCE_INLINE_ bool has(const TKey &p_key) {
+	_FORCE_INLINE_ bool has(const TKey &p_key) const {
 		uint32_t _pos = 0;
 		return _lookup_pos(p_key, _pos);
 	}
 
+	_FORCE_INLINE_ TValue *getptr(const TKey &p_key) {
+		uint32_t pos = 0;
+		if (_lookup_pos(p_key, pos)) {
+			return &values[pos];
+		}
+		return NULL;
+	}
+
+	_FORCE_INLINE_ const TValue *getptr(const TKey &p_key) const {
+		uint32_t pos = 0;
+		if (_lookup_pos(p_key, pos)) {
+			return &values[pos];
+		}
+		return NULL;
+	}
+
+	/**
+	 * Same as getptr, with a custom key (that can be compared to TKey) and its
+	 * hash, which must be the same Hasher returns for the equivalent TKey.
+	 */
+	template <class C>
+	_FORCE_INLINE_ TValue *custom_getptr(C p_custom_key, uint32_t p_custom_hash) {
+		uint32_t pos = 0;
+		if (_lookup_pos_with_hash(p_custom_key, p_custom_hash == EMPTY_HASH ? EMPTY_HASH + 1 : p_custom_hash, pos)) {
+			return &values[pos];
+		}
+		return NULL;
+	}
+
+	template <class C>
+	_FORCE_INLINE_ const TValue *custom_getptr(C p_custom_key, uint32_t p_custom_hash) const {
+		uint32_t pos = 0;
+		if (_lookup_pos_with_hash(p_custom_key, p_custom_hash == EMPTY_HASH ? EMPTY_HASH + 1 : p_custom_hash, pos)) {
+			return &values[pos];
+		}
+		return NULL;
+	}
+
+	/**
+	 * Same as HashMap::get, errors if the key is not in the map.
+	 */
+	const TValue &get(const TKey &p_key) const {
+		const TValue *res = getptr(p_key);
+		CRASH_COND(!res);
+		return *res;
+	}
+
+	TValue &get(const TKey &p_key) {
+		TValue *res = getptr(p_key);
+		CRASH_COND(!res);
+		return *res;
+	}
+
+	_FORCE_INLINE_ const TValue &operator[](const TKey &p_key) const {
+		return get(p_key);
+	}
+
+	TValue &operator[](const TKey &p_key) {
+		uint32_t hash = _hash(p_key);
+		uint32_t pos = 0;
+
+		if (!_lookup_pos_with_hash(p_key, hash, pos)) {
+			_reserve_one();
+			pos = _insert_with_hash(hash, p_key, TValue());
+		}
+
+		return values[pos];
+	}
+
 	void remove(const TKey &p_key) {
+		erase(p_key);
+	}
+
+	bool erase(const TKey &p_key) {
 		uint32_t pos = 0;
 		bool exists = _lookup_pos(p_key, pos);
 
 		if (!exists) {
-			return;
+			return false;
 		}
 
-		hashes[pos] |= DELETED_HASH_BIT;
-		values[pos].~TValue();
-		keys[pos].~TKey();
-		num_elements--;
+		_erase_pos(pos);
+		return true;
+	}
+
+	/**
+	 * Same as HashMap::next, returns the key after p_key, or the first one if
+	 * p_key is NULL. p_key must point into the map, as returned by this function.
+	 */
+	const TKey *next(const TKey *p_key) const {
+
+		if (unlikely(!hashes)) {
+			return NULL;
+		}
+
+		uint32_t pos = p_key ? uint32_t(p_key - keys) + 1 : 0;
+
+		for (; pos < capacity; pos++) {
+			if (hashes[pos] != EMPTY_HASH) {
+				return &keys[pos];
+			}
+		}
+
+		return NULL;
+	}
+
+	void get_key_list(List<TKey> *p_keys) const {
+
+		for (uint32_t i = 0; i < capacity && hashes; i++) {
+			if (hashes[i] != EMPTY_HASH) {
+				p_keys->push_back(keys[i]);
+			}
+		}
+	}
+
+	void clear() {
+
+		if (hashes) {
+			for (uint32_t i = 0; i < capacity; i++) {
+				if (hashes[i] == EMPTY_HASH) {
+					continue;
+				}
+				keys[i].~TKey();
+				values[i].~TValue();
+			}
+
+			memfree(keys);
+			memfree(values);
+			memfree(hashes);
+		}
+
+		keys = NULL;
+		values = NULL;
+		hashes = NULL;
+		num_elements = 0;
 	}
 
 	struct Iterator {
@@ -283,15 +503,12 @@ public:
 		it.key = NULL;
 		it.value = NULL;
 
-		for (uint32_t i = it.pos; i < capacity; i++) {
+		for (uint32_t i = it.pos; i < capacity && hashes; i++) {
 			it.pos = i + 1;
 
 			if (hashes[i] == EMPTY_HASH) {
 				continue;
 			}
-			if (hashes[i] & DELETED_HASH_BIT) {
-				continue;
-			}
 
 			it.valid = true;
 			it.key = &keys[i];
@@ -302,25 +519,42 @@ public:
 		return it;
 	}
 
-	OAHashMap(uint32_t p_initial_capacity = 64) {
+	void operator=(const OAHashMap &p_map) {
+		if (&p_map != this) {
+			_copy_from(p_map);
+		}
+	}
 
-		capacity = p_initial_capacity;
+	OAHashMap(const OAHashMap &p_map) {
+
+		keys = NULL;
+		values = NULL;
+		hashes = NULL;
 		num_elements = 0;
+		_copy_from(p_map);
+	}
 
-		keys = memnew_arr(TKey, p_initial_capacity);
-		values = memnew_arr(TValue, p_initial_capacity);
-		hashes = memnew_arr(uint32_t, p_initial_capacity);
+	/**
+	 * The storage is only allocated when the first entry is added, with at least
+	 * p_initial_capacity slots (rounded up to a power of two).
+	 */
+	OAHashMap(uint32_t p_initial_capacity = 8) {
+
+		keys = NULL;
+		values = NULL;
+		hashes = NULL;
+		num_elements = 0;
 
-		for (int i = 0; i < p_initial_capacity; i++) {
-			hashes[i] = 0;
+		capacity_power = MIN_CAPACITY_POWER;
+		while ((1u << capacity_power) < p_initial_capacity) {
+			capacity_power++;
 		}
+		capacity = 1 << capacity_power;
 	}
 
 	~OAHashMap() {
 
-		memdelete_arr(keys);
-		memdelete_arr(values);
-		memdelete(hashes);
+		clear();
 	}
 };
 
@@ -0,0 +1,75 @@
+/*************************************************************************/
+/*  oa_hash_set.h                                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef OA_HASH_SET_H
+#define OA_HASH_SET_H
+
+#include "oa_hash_map.h"
+
+/**
+ * Set counterpart of OAHashMap, for the cases Set is only used to check for
+ * membership and order doesn't matter.
+ */
+template <class TKey,
+		class Hasher = HashMapHasherDefault,
+		class Comparator = HashMapComparatorDefault<TKey> >
+class OAHashSet {
+
+	struct Empty {};
+
+	OAHashMap<TKey, Empty, Hasher, Comparator> map;
+
+public:
+	_FORCE_INLINE_ unsigned int size() const { return map.size(); }
+	_FORCE_INLINE_ bool empty() const { return map.empty(); }
+
+	// Returns false if the key was already in the set.
+	bool insert(const TKey &p_key) {
+		if (map.has(p_key)) {
+			return false;
+		}
+		map.insert(p_key, Empty());
+		return true;
+	}
+
+	_FORCE_INLINE_ bool has(const TKey &p_key) const { return map.has(p_key); }
+	_FORCE_INLINE_ bool erase(const TKey &p_key) { return map.erase(p_key); }
+
+	// Same as OAHashMap::next.
+	_FORCE_INLINE_ const TKey *next(const TKey *p_key) const { return map.next(p_key); }
+
+	void get_key_list(List<TKey> *p_keys) const { map.get_key_list(p_keys); }
+	void clear() { map.clear(); }
+
+	OAHashSet(uint32_t p_initial_capacity = 8) :
+			map(p_initial_capacity) {}
+};
+
+#endif // OA_HASH_SET_H
@@ -35,6 +35,41 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef SMALL_ALLOCATOR_ENABLED
+#include "small_allocator.h"
+
+static _FORCE_INLINE_ void *_system_alloc(size_t p_bytes) {
+
+	void *mem = SmallAllocator::alloc(p_bytes);
+	return mem ? mem : malloc(p_bytes);
+}
+
+static _FORCE_INLINE_ void *_system_realloc(void *p_memory, size_t p_bytes) {
+
+	if (SmallAllocator::owns(p_memory)) {
+		if (p_bytes == 0) {
+			SmallAllocator::free(p_memory);
+			return NULL;
+		}
+		return SmallAllocator::realloc(p_memory, p_bytes);
+	}
+	return realloc(p_memory, p_bytes);
+}
+
+static _FORCE_INLINE_ void _system_free(void *p_memory) {
+
+	if (SmallAllocator::owns(p_memory)) {
+		SmallAllocator::free(p_memory);
+	} else {
+		free(p_memory);
+	}
+}
+#else
+#define _system_alloc malloc
+#define _system_realloc realloc
+#define _system_free free
+#endif
+
 void *operator new(size_t p_size, const char *p_description) {
 
 	return Memory::alloc_static(p_size, false);
@@ -80,7 +115,7 @@ void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
 	bool prepad = p_pad_align;
 #endif
 
-	void *mem = malloc(p_bytes + (prepad ? PAD_ALIGN : 0));
+	void *mem = _system_alloc(p_bytes + (prepad ? PAD_ALIGN : 0));
 
 	ERR_FAIL_COND_V(!mem, NULL);
 
@@ -130,12 +165,12 @@ void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
 #endif
 
 		if (p_bytes == 0) {
-			free(mem);
+			_system_free(mem);
 			return NULL;
 		} else {
 			*s = p_bytes;
 
-			mem = (uint8_t *)realloc(mem, p_bytes + PAD_ALIGN);
+			mem = (uint8_t *)_system_realloc(mem, p_bytes + PAD_ALIGN);
 			ERR_FAIL_COND_V(!mem, NULL);
 
 			s = (uint64_t *)mem;
@@ -146,7 +181,7 @@ void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
 		}
 	} else {
 
-		mem = (uint8_t *)realloc(mem, p_bytes);
+		mem = (uint8_t *)_system_realloc(mem, p_bytes);
 
 		ERR_FAIL_COND_V(mem == NULL && p_bytes > 0, NULL);
 
@@ -176,10 +211,10 @@ void Memory::free_static(void *p_ptr, bool p_pad_align) {
 		atomic_sub(&mem_usage, *s);
 #endif
 
-		free(mem);
+		_system_free(mem);
 	} else {
 
-		free(mem);
+		_system_free(mem);
 	}
 }
 
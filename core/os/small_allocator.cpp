@@ -0,0 +1,345 @@
+/*************************************************************************/
+/*  small_allocator.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "small_allocator.h"
+
+#include "os/spin_lock.h"
+#include "safe_refcount.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NO_THREADS
+#define SMALL_ALLOCATOR_THREAD_LOCAL
+#else
+#define SMALL_ALLOCATOR_THREAD_LOCAL thread_local
+#endif
+
+// Size classes are 16 bytes apart up to 128, then 32 bytes apart up to MAX_SIZE.
+enum {
+	CLASS_COUNT = 12,
+	SPANS_PER_BLOCK = 16, // spans are taken from malloc this many at a time
+	ADDRESS_BITS = sizeof(void *) == 8 ? 48 : 32,
+	LEAF_BITS = 16,
+	LEAF_SIZE = 1 << LEAF_BITS,
+	TOP_SIZE = 1 << (ADDRESS_BITS - SmallAllocator::SPAN_SHIFT - LEAF_BITS)
+};
+
+static _FORCE_INLINE_ uint32_t _get_class(size_t p_bytes) {
+
+	if (p_bytes <= 128) {
+		return p_bytes ? (p_bytes + 15) / 16 - 1 : 0;
+	}
+	return (p_bytes + 31) / 32 + 3;
+}
+
+static _FORCE_INLINE_ size_t _get_class_size(uint32_t p_class) {
+
+	return p_class < 8 ? (p_class + 1) * 16 : (p_class - 3) * 32;
+}
+
+// Amount of blocks moved at once between the thread caches and the central lists.
+static _FORCE_INLINE_ uint32_t _get_batch_size(uint32_t p_class) {
+
+	return CLAMP(4096 / _get_class_size(p_class), 8, 64);
+}
+
+// The size class of every span, indexed by address, 0 for memory that isn't owned.
+// Leaves are only added, so they can be read without locking.
+static uint64_t page_map[TOP_SIZE];
+
+static _FORCE_INLINE_ uint8_t *_get_leaf(uintptr_t p_key) {
+
+	uintptr_t top = p_key >> LEAF_BITS;
+	if (unlikely(top >= TOP_SIZE)) {
+		return NULL;
+	}
+	return (uint8_t *)(uintptr_t)page_map[top];
+}
+
+// Returns -1 for memory that isn't owned.
+static _FORCE_INLINE_ int _get_span_class(const void *p_ptr) {
+
+	uintptr_t key = uintptr_t(p_ptr) >> SmallAllocator::SPAN_SHIFT;
+	uint8_t *leaf = _get_leaf(key);
+	return leaf ? int(leaf[key & (LEAF_SIZE - 1)]) - 1 : -1;
+}
+
+struct Block {
+	Block *next;
+};
+
+struct CentralList {
+	SpinLock lock;
+	Block *free_list;
+	uint8_t *span_pos;
+	uint8_t *span_end;
+};
+
+static CentralList central[CLASS_COUNT];
+
+static SpinLock span_lock;
+static uint8_t *block_pos = NULL;
+static uint8_t *block_end = NULL;
+static uint32_t span_count = 0;
+
+// Called with the central list of p_class locked.
+static bool _add_span(CentralList &p_central, uint32_t p_class) {
+
+	span_lock.lock();
+
+	if (block_pos == block_end) {
+		uint8_t *block = (uint8_t *)::malloc((SPANS_PER_BLOCK + 1) * SmallAllocator::SPAN_SIZE);
+		if (!block) {
+			span_lock.unlock();
+			return false;
+		}
+		uint8_t *aligned = (uint8_t *)((uintptr_t(block) + SmallAllocator::SPAN_SIZE - 1) & ~uintptr_t(SmallAllocator::SPAN_SIZE - 1));
+		uint8_t *end = aligned + SPANS_PER_BLOCK * SmallAllocator::SPAN_SIZE;
+		if ((uintptr_t(end) >> (SmallAllocator::SPAN_SHIFT + LEAF_BITS)) >= TOP_SIZE) {
+			// out of the range of the page map, can't tell it apart from malloc memory
+			::free(block);
+			span_lock.unlock();
+			return false;
+		}
+		block_pos = aligned;
+		block_end = end;
+	}
+
+	uint8_t *span = block_pos;
+	uintptr_t key = uintptr_t(span) >> SmallAllocator::SPAN_SHIFT;
+	uint8_t *leaf = _get_leaf(key);
+	if (!leaf) {
+		leaf = (uint8_t *)::calloc(LEAF_SIZE, 1);
+		if (!leaf) {
+			span_lock.unlock();
+			return false;
+		}
+		// exchanged to make sure the zeroed leaf is visible before the pointer to it
+		atomic_compare_exchange(&page_map[key >> LEAF_BITS], uint64_t(0), uint64_t(uintptr_t(leaf)));
+	}
+	leaf[key & (LEAF_SIZE - 1)] = p_class + 1;
+
+	block_pos += SmallAllocator::SPAN_SIZE;
+	atomic_increment(&span_count);
+
+	span_lock.unlock();
+
+	p_central.span_pos = span;
+	p_central.span_end = span + SmallAllocator::SPAN_SIZE - SmallAllocator::SPAN_SIZE % _get_class_size(p_class);
+	return true;
+}
+
+// Takes up to p_count blocks from the central list, returns how many.
+static uint32_t _take_from_central(uint32_t p_class, uint32_t p_count, Block **r_first) {
+
+	CentralList &c = central[p_class];
+	size_t size = _get_class_size(p_class);
+	uint32_t taken = 0;
+	Block *first = NULL;
+
+	c.lock.lock();
+
+	while (taken < p_count && c.free_list) {
+		Block *b = c.free_list;
+		c.free_list = b->next;
+		b->next = first;
+		first = b;
+		taken++;
+	}
+
+	while (taken < p_count) {
+		if (c.span_pos == c.span_end && !_add_span(c, p_class)) {
+			break;
+		}
+		Block *b = (Block *)c.span_pos;
+		c.span_pos += size;
+		b->next = first;
+		first = b;
+		taken++;
+	}
+
+	c.lock.unlock();
+
+	*r_first = first;
+	return taken;
+}
+
+static void _give_to_central(uint32_t p_class, Block *p_first, Block *p_last) {
+
+	CentralList &c = central[p_class];
+
+	c.lock.lock();
+	p_last->next = c.free_list;
+	c.free_list = p_first;
+	c.lock.unlock();
+}
+
+enum ThreadCacheState {
+	THREAD_CACHE_UNUSED, // zero, so it's the state thread locals start with
+	THREAD_CACHE_ACTIVE,
+	THREAD_CACHE_DESTROYED // the thread is exiting, blocks go straight to the central lists
+};
+
+struct ThreadCache {
+	Block *free_list[CLASS_COUNT];
+	uint32_t count[CLASS_COUNT];
+	uint32_t state;
+};
+
+static SMALL_ALLOCATOR_THREAD_LOCAL ThreadCache thread_cache;
+
+// Gives the blocks cached by a thread back when it exits.
+struct ThreadCacheFlusher {
+
+	~ThreadCacheFlusher() {
+
+		ThreadCache &tc = thread_cache;
+		for (uint32_t i = 0; i < CLASS_COUNT; i++) {
+			Block *first = tc.free_list[i];
+			if (!first) {
+				continue;
+			}
+			Block *last = first;
+			while (last->next) {
+				last = last->next;
+			}
+			_give_to_central(i, first, last);
+			tc.free_list[i] = NULL;
+			tc.count[i] = 0;
+		}
+		tc.state = THREAD_CACHE_DESTROYED;
+	}
+};
+
+static SMALL_ALLOCATOR_THREAD_LOCAL ThreadCacheFlusher thread_cache_flusher;
+
+static _FORCE_INLINE_ ThreadCache *_get_thread_cache() {
+
+	ThreadCache *tc = &thread_cache;
+	if (likely(tc->state == THREAD_CACHE_ACTIVE)) {
+		return tc;
+	}
+	if (tc->state == THREAD_CACHE_DESTROYED) {
+		return NULL;
+	}
+
+	(void)&thread_cache_flusher; // makes sure it's destroyed when the thread exits
+	tc->state = THREAD_CACHE_ACTIVE;
+	return tc;
+}
+
+void *SmallAllocator::alloc(size_t p_bytes) {
+
+	if (p_bytes > MAX_SIZE) {
+		return NULL;
+	}
+
+	uint32_t c = _get_class(p_bytes);
+	ThreadCache *tc = _get_thread_cache();
+
+	if (unlikely(!tc)) {
+		Block *b;
+		return _take_from_central(c, 1, &b) ? b : NULL;
+	}
+
+	Block *b = tc->free_list[c];
+	if (likely(b)) {
+		tc->free_list[c] = b->next;
+		tc->count[c]--;
+		return b;
+	}
+
+	uint32_t taken = _take_from_central(c, _get_batch_size(c), &b);
+	if (!taken) {
+		return NULL;
+	}
+	tc->free_list[c] = b->next;
+	tc->count[c] = taken - 1;
+	return b;
+}
+
+void *SmallAllocator::realloc(void *p_ptr, size_t p_bytes) {
+
+	int c = _get_span_class(p_ptr);
+	if (p_bytes <= MAX_SIZE && (int)_get_class(p_bytes) == c) {
+		return p_ptr; // still the same size class
+	}
+	size_t size = _get_class_size(c);
+
+	void *mem = alloc(p_bytes);
+	if (!mem) {
+		mem = ::malloc(p_bytes);
+		if (!mem) {
+			return NULL;
+		}
+	}
+	memcpy(mem, p_ptr, MIN(size, p_bytes));
+	free(p_ptr);
+	return mem;
+}
+
+void SmallAllocator::free(void *p_ptr) {
+
+	int c = _get_span_class(p_ptr);
+	Block *b = (Block *)p_ptr;
+	ThreadCache *tc = _get_thread_cache();
+
+	if (unlikely(!tc)) {
+		_give_to_central(c, b, b);
+		return;
+	}
+
+	b->next = tc->free_list[c];
+	tc->free_list[c] = b;
+	tc->count[c]++;
+
+	uint32_t batch = _get_batch_size(c);
+	if (unlikely(tc->count[c] >= batch * 2)) {
+		// too many cached, give a batch back so other threads can use them
+		Block *last = b;
+		for (uint32_t i = 1; i < batch; i++) {
+			last = last->next;
+		}
+		tc->free_list[c] = last->next;
+		tc->count[c] -= batch;
+		_give_to_central(c, b, last);
+	}
+}
+
+bool SmallAllocator::owns(const void *p_ptr) {
+
+	return _get_span_class(p_ptr) >= 0;
+}
+
+uint32_t SmallAllocator::get_span_count() {
+
+	return span_count;
+}
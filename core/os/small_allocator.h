@@ -0,0 +1,63 @@
+/*************************************************************************/
+/*  small_allocator.h                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef SMALL_ALLOCATOR_H
+#define SMALL_ALLOCATOR_H
+
+#include "typedefs.h"
+#include <stddef.h>
+
+// Serves allocations of up to MAX_SIZE bytes from per thread caches of fixed size
+// blocks, so the many short lived list and map elements, variant payloads and
+// strings don't go through malloc. Blocks are carved from spans that hold a single
+// size class, spans are kept for reuse and never given back to the system.
+// Memory::alloc_static uses it when built with small_allocator=yes.
+
+class SmallAllocator {
+public:
+	enum {
+		MAX_SIZE = 256,
+		SPAN_SHIFT = 16,
+		SPAN_SIZE = 1 << SPAN_SHIFT
+	};
+
+	// Returns NULL if p_bytes is too big or no span could be set up, use malloc then.
+	static void *alloc(size_t p_bytes);
+	// Reallocates a block owned by this allocator, which may move to malloc if it grows too big.
+	static void *realloc(void *p_ptr, size_t p_bytes);
+	// p_ptr must be owned by this allocator.
+	static void free(void *p_ptr);
+
+	static bool owns(const void *p_ptr);
+
+	static uint32_t get_span_count();
+};
+
+#endif // SMALL_ALLOCATOR_H
@@ -0,0 +1,605 @@
+/*************************************************************************/
+/*  thread_work_pool.cpp                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "thread_work_pool.h"
+
+#include "os/os.h"
+
+ThreadWorkPool *ThreadWorkPool::singleton = NULL;
+
+void ThreadWorkPool::TaskQueue::push(BaseTask *p_task) {
+
+	MutexLock lock(mutex);
+
+	if (back - front == capacity) {
+		uint32_t new_capacity = capacity ? capacity << 1 : 16;
+		BaseTask **new_tasks = (BaseTask **)memalloc(sizeof(BaseTask *) * new_capacity);
+		for (uint32_t i = front; i != back; i++) {
+			new_tasks[i & (new_capacity - 1)] = tasks[i & (capacity - 1)];
+		}
+		if (tasks) {
+			memfree(tasks);
+		}
+		tasks = new_tasks;
+		capacity = new_capacity;
+	}
+
+	tasks[back & (capacity - 1)] = p_task;
+	back++;
+}
+
+ThreadWorkPool::BaseTask *ThreadWorkPool::TaskQueue::pop() {
+
+	MutexLock lock(mutex);
+
+	if (front == back)
+		return NULL;
+
+	back--;
+	return tasks[back & (capacity - 1)];
+}
+
+ThreadWorkPool::BaseTask *ThreadWorkPool::TaskQueue::steal() {
+
+	MutexLock lock(mutex);
+
+	if (front == back)
+		return NULL;
+
+	BaseTask *task = tasks[front & (capacity - 1)];
+	front++;
+	return task;
+}
+
+ThreadWorkPool::TaskQueue::TaskQueue() {
+
+	mutex = Mutex::create(false);
+	tasks = NULL;
+	capacity = 0;
+	front = 0;
+	back = 0;
+}
+
+ThreadWorkPool::TaskQueue::~TaskQueue() {
+
+	if (tasks) {
+		memfree(tasks);
+	}
+	if (mutex) {
+		memdelete(mutex);
+	}
+}
+
+void ThreadWorkPool::_thread_function(void *p_user) {
+
+	ThreadData *data = (ThreadData *)p_user;
+	ThreadWorkPool *pool = data->pool;
+	data->id = Thread::get_caller_id();
+
+	while (true) {
+
+		pool->work_semaphore->wait();
+
+		if (pool->exit_threads)
+			break;
+
+		BaseTask *task = pool->_take_task(data->index);
+		if (task) {
+			pool->_run_task(task, data->index);
+			continue;
+		}
+
+		pool->mutex->lock();
+		SelfList<BaseWork> *first = pool->queue.first();
+		if (!first) {
+			//someone else took care of it already
+			pool->mutex->unlock();
+			continue;
+		}
+		BaseWork *work = first->self();
+		work->users++;
+		pool->mutex->unlock();
+
+		work->process();
+		pool->_leave(work);
+	}
+}
+
+uint32_t ThreadWorkPool::_get_chunk_size(uint32_t p_elements, uint32_t p_chunk_size) const {
+
+	if (p_chunk_size > 0)
+		return p_chunk_size;
+
+	// A few chunks per thread keeps them busy when elements take uneven time to process,
+	// without making threads fight over the index too often.
+	uint32_t chunks = (thread_count + 1) * 4;
+	return MAX(1, p_elements / chunks);
+}
+
+Semaphore *ThreadWorkPool::_alloc_semaphore() {
+
+	if (free_semaphores.size()) {
+		Semaphore *semaphore = free_semaphores[free_semaphores.size() - 1];
+		free_semaphores.resize(free_semaphores.size() - 1);
+		return semaphore;
+	}
+
+	return Semaphore::create();
+}
+
+void ThreadWorkPool::_submit(BaseWork *p_work, bool p_caller_joins) {
+
+	mutex->lock();
+	if (p_caller_joins) {
+		p_work->users++;
+	}
+	queue.add_last(&p_work->queue_elem);
+	mutex->unlock();
+
+	uint32_t chunks = (p_work->elements + p_work->chunk_size - 1) / p_work->chunk_size;
+	if (p_caller_joins) {
+		chunks--;
+	}
+	uint32_t wake = MIN(chunks, (uint32_t)thread_count);
+	for (uint32_t i = 0; i < wake; i++) {
+		work_semaphore->post();
+	}
+}
+
+void ThreadWorkPool::_join(BaseWork *p_work) {
+
+	mutex->lock();
+	if (p_work->exhausted) {
+		mutex->unlock();
+		return;
+	}
+	p_work->users++;
+	mutex->unlock();
+
+	p_work->process();
+	_leave(p_work);
+}
+
+void ThreadWorkPool::_leave(BaseWork *p_work) {
+
+	MutexLock lock(mutex);
+
+	// Whoever leaves did so because there is nothing left to claim, so no one else needs to join.
+	if (!p_work->exhausted) {
+		p_work->exhausted = true;
+		queue.remove(&p_work->queue_elem);
+	}
+
+	p_work->users--;
+	if (p_work->users == 0) {
+		p_work->completed = true;
+		if (p_work->done) {
+			p_work->done->post();
+		}
+	}
+}
+
+void ThreadWorkPool::_wait(BaseWork *p_work) {
+
+	mutex->lock();
+	if (p_work->completed) {
+		mutex->unlock();
+		return;
+	}
+
+	Semaphore *done = _alloc_semaphore();
+	p_work->done = done;
+	mutex->unlock();
+
+	done->wait();
+
+	mutex->lock();
+	p_work->done = NULL;
+	free_semaphores.push_back(done);
+	mutex->unlock();
+}
+
+ThreadWorkPool::GroupID ThreadWorkPool::_add_group(BaseWork *p_work) {
+
+	if (p_work->elements == 0) {
+		p_work->exhausted = true;
+		p_work->completed = true;
+	}
+
+	mutex->lock();
+	GroupID id = ++last_group_id;
+	groups[id] = p_work;
+	mutex->unlock();
+
+	if (!p_work->completed && thread_count) {
+		_submit(p_work, false);
+	}
+	// Without threads, the work is done when waiting for it.
+
+	return id;
+}
+
+bool ThreadWorkPool::is_group_completed(GroupID p_group) const {
+
+	MutexLock lock(mutex);
+
+	BaseWork *const *work = groups.getptr(p_group);
+	ERR_FAIL_COND_V(!work, true);
+
+	return (*work)->completed;
+}
+
+void ThreadWorkPool::wait_for_group_completion(GroupID p_group) {
+
+	mutex->lock();
+	BaseWork **workp = groups.getptr(p_group);
+	if (!workp) {
+		mutex->unlock();
+		ERR_EXPLAIN("Invalid or already waited for group: " + itos(p_group));
+		ERR_FAIL();
+	}
+	BaseWork *work = *workp;
+	mutex->unlock();
+
+	if (thread_count == 0) {
+		if (!work->completed) {
+			work->process();
+			work->exhausted = true;
+			work->completed = true;
+		}
+	} else {
+		// Help with whatever is left instead of just blocking.
+		_join(work);
+		_wait(work);
+	}
+
+	mutex->lock();
+	groups.erase(p_group);
+	mutex->unlock();
+
+	memdelete(work);
+}
+
+int ThreadWorkPool::_get_thread_index() const {
+
+	Thread::ID caller = Thread::get_caller_id();
+	for (int i = 0; i < thread_count; i++) {
+		if (thread_data[i].id == caller)
+			return i;
+	}
+	return -1;
+}
+
+void ThreadWorkPool::_queue_task(BaseTask *p_task, int p_thread_index) {
+
+	// Tasks added from outside the pool go to the shared queue at index 0.
+	task_queues[p_thread_index + 1].push(p_task);
+
+	if (thread_count) {
+		work_semaphore->post();
+	}
+}
+
+ThreadWorkPool::BaseTask *ThreadWorkPool::_take_task(int p_thread_index) {
+
+	int own = p_thread_index + 1;
+	BaseTask *task = NULL;
+
+	if (own > 0) {
+		task = task_queues[own].pop();
+		if (task)
+			return task;
+	}
+
+	for (int i = 0; i < queue_count; i++) {
+		int victim = (own + i) % queue_count;
+		if (victim == own && own > 0)
+			continue;
+		task = task_queues[victim].steal();
+		if (task)
+			return task;
+	}
+
+	return NULL;
+}
+
+void ThreadWorkPool::_run_task(BaseTask *p_task, int p_thread_index) {
+
+#ifdef DEBUG_ENABLED
+	mutex->lock();
+	p_task->running = true;
+	p_task->running_thread = Thread::get_caller_id();
+	mutex->unlock();
+#endif
+
+	p_task->run();
+
+	MutexLock lock(mutex);
+
+	p_task->completed = true;
+#ifdef DEBUG_ENABLED
+	p_task->running = false;
+#endif
+
+	for (int i = 0; i < p_task->dependents.size(); i++) {
+		BaseTask *dependent = p_task->dependents[i];
+		dependent->pending_dependencies--;
+		if (dependent->pending_dependencies == 0) {
+			_queue_task(dependent, p_thread_index);
+		}
+	}
+	p_task->dependents.clear();
+
+	if (p_task->done) {
+		p_task->done->post();
+	}
+}
+
+ThreadWorkPool::TaskID ThreadWorkPool::_add_task(BaseTask *p_task, const TaskID *p_dependencies, int p_dependency_count) {
+
+	ERR_FAIL_COND_V(!task_queues, 0);
+
+	MutexLock lock(mutex);
+
+	TaskID id = ++last_task_id;
+	p_task->id = id;
+	tasks[id] = p_task;
+
+	for (int i = 0; i < p_dependency_count; i++) {
+		BaseTask **dependency = tasks.getptr(p_dependencies[i]);
+		if (!dependency) {
+			// Already waited for, so it is done.
+			ERR_CONTINUE(p_dependencies[i] == 0 || p_dependencies[i] >= id);
+			continue;
+		}
+		if (!(*dependency)->completed) {
+			(*dependency)->dependents.push_back(p_task);
+			p_task->pending_dependencies++;
+		}
+	}
+
+	if (p_task->pending_dependencies == 0) {
+		_queue_task(p_task, _get_thread_index());
+	}
+
+	return id;
+}
+
+bool ThreadWorkPool::is_task_completed(TaskID p_task) const {
+
+	MutexLock lock(mutex);
+
+	BaseTask *const *task = tasks.getptr(p_task);
+	ERR_FAIL_COND_V(!task, true);
+
+	return (*task)->completed;
+}
+
+#ifdef DEBUG_ENABLED
+// Whether p_task can't complete before a task running on p_thread returns, because it is that task or depends on it.
+bool ThreadWorkPool::_waits_for_thread(BaseTask *p_task, Thread::ID p_thread) const {
+
+	Vector<BaseTask *> blocked;
+	const TaskID *key = NULL;
+	while ((key = tasks.next(key))) {
+		BaseTask *task = tasks.get(*key);
+		if (task->running && task->running_thread == p_thread) {
+			blocked.push_back(task);
+		}
+	}
+
+	for (int i = 0; i < blocked.size(); i++) {
+		BaseTask *task = blocked[i];
+		if (task == p_task) {
+			return true;
+		}
+		for (int j = 0; j < task->dependents.size(); j++) {
+			if (blocked.find(task->dependents[j]) == -1) {
+				blocked.push_back(task->dependents[j]);
+			}
+		}
+	}
+
+	return false;
+}
+#endif
+
+void ThreadWorkPool::wait_for_task_completion(TaskID p_task) {
+
+	mutex->lock();
+	BaseTask **taskp = tasks.getptr(p_task);
+	if (!taskp || (*taskp)->done) {
+		mutex->unlock();
+		ERR_EXPLAIN("Invalid or already waited for task: " + itos(p_task));
+		ERR_FAIL();
+	}
+	BaseTask *task = *taskp;
+	bool completed = task->completed;
+#ifdef DEBUG_ENABLED
+	if (!completed && _waits_for_thread(task, Thread::get_caller_id())) {
+		mutex->unlock();
+		ERR_EXPLAIN("Task " + itos(p_task) + " can't complete before the task waiting for it returns, it would deadlock.");
+		ERR_FAIL();
+	}
+#endif
+	mutex->unlock();
+
+	int thread_index = _get_thread_index();
+
+	while (!completed) {
+
+		BaseTask *other = _take_task(thread_index);
+		if (!other)
+			break;
+		_run_task(other, thread_index);
+
+		mutex->lock();
+		completed = task->completed;
+		mutex->unlock();
+	}
+
+	mutex->lock();
+	if (!task->completed) {
+		// It is running (or about to) in some other thread.
+		Semaphore *done = _alloc_semaphore();
+		task->done = done;
+		mutex->unlock();
+
+		done->wait();
+
+		mutex->lock();
+		task->done = NULL;
+		free_semaphores.push_back(done);
+	}
+	tasks.erase(p_task);
+	mutex->unlock();
+
+	memdelete(task);
+}
+
+void ThreadWorkPool::init(int p_threads) {
+
+	ERR_FAIL_COND(task_queues);
+
+#ifndef NO_THREADS
+	if (p_threads < 0) {
+		// The thread submitting the work also processes it.
+		p_threads = OS::get_singleton()->get_processor_count() - 1;
+	}
+#else
+	p_threads = 0;
+#endif
+
+	exit_threads = false;
+	p_threads = MAX(p_threads, 0);
+
+	queue_count = p_threads + 1;
+	task_queues = memnew_arr(TaskQueue, queue_count);
+
+	if (p_threads == 0)
+		return;
+
+	work_semaphore = Semaphore::create();
+	thread_data = memnew_arr(ThreadData, p_threads);
+
+	for (int i = 0; i < p_threads; i++) {
+		thread_data[i].pool = this;
+		thread_data[i].index = i;
+		thread_data[i].id = 0;
+		thread_data[i].thread = NULL;
+	}
+
+	for (int i = 0; i < p_threads; i++) {
+		Thread *thread = Thread::create(_thread_function, &thread_data[i]);
+		if (!thread)
+			break;
+		thread_data[i].thread = thread;
+		thread_data[i].id = thread->get_id();
+		thread_count++;
+	}
+}
+
+void ThreadWorkPool::finish() {
+
+	if (thread_count) {
+
+		exit_threads = true;
+		for (int i = 0; i < thread_count; i++) {
+			work_semaphore->post();
+		}
+		for (int i = 0; i < thread_count; i++) {
+			Thread::wait_to_finish(thread_data[i].thread);
+			memdelete(thread_data[i].thread);
+		}
+		thread_count = 0;
+	}
+
+	if (thread_data) {
+		memdelete_arr(thread_data);
+		thread_data = NULL;
+	}
+
+	if (work_semaphore) {
+		memdelete(work_semaphore);
+		work_semaphore = NULL;
+	}
+
+	for (int i = 0; i < free_semaphores.size(); i++) {
+		memdelete(free_semaphores[i]);
+	}
+	free_semaphores.clear();
+
+	const TaskID *k = NULL;
+	while ((k = tasks.next(k))) {
+		ERR_PRINTS("Task " + itos(*k) + " was never waited for.");
+		memdelete(tasks[*k]);
+	}
+	tasks.clear();
+
+	if (task_queues) {
+		memdelete_arr(task_queues);
+		task_queues = NULL;
+		queue_count = 0;
+	}
+}
+
+ThreadWorkPool::ThreadWorkPool() {
+
+	singleton = this;
+	mutex = Mutex::create();
+	work_semaphore = NULL;
+	thread_data = NULL;
+	thread_count = 0;
+	task_queues = NULL;
+	queue_count = 0;
+	last_group_id = 0;
+	last_task_id = 0;
+	exit_threads = false;
+}
+
+ThreadWorkPool::~ThreadWorkPool() {
+
+	finish();
+
+	const GroupID *k = NULL;
+	while ((k = groups.next(k))) {
+		ERR_PRINTS("Group " + itos(*k) + " was never waited for.");
+		BaseWork *work = groups[*k];
+		if (work->queue_elem.in_list()) {
+			queue.remove(&work->queue_elem);
+		}
+		memdelete(work);
+	}
+	groups.clear();
+
+	if (mutex)
+		memdelete(mutex);
+	singleton = NULL;
+}
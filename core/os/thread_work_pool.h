@@ -0,0 +1,300 @@
+/*************************************************************************/
+/*  thread_work_pool.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef THREAD_WORK_POOL_H
+#define THREAD_WORK_POOL_H
+
+#include "hash_map.h"
+#include "os/mutex.h"
+#include "os/semaphore.h"
+#include "os/thread.h"
+#include "safe_refcount.h"
+#include "self_list.h"
+#include "vector.h"
+
+/**
+ * Engine-wide pool of persistent worker threads.
+ *
+ * Work is submitted as a range of elements which is split in chunks, pool threads
+ * (and the thread waiting for the work) keep claiming chunks until the range is
+ * exhausted. This avoids creating and joining threads every time something needs
+ * to be processed in parallel.
+ *
+ * Single tasks are also supported. Each pool thread owns a task queue: tasks added
+ * from a pool thread go to its own queue and are run newest first, idle threads
+ * steal the oldest tasks from the other queues. Tasks may depend on other tasks,
+ * they are only queued once all their dependencies completed.
+ */
+
+class ThreadWorkPool {
+public:
+	typedef uint32_t GroupID;
+	typedef uint32_t TaskID;
+
+private:
+	struct BaseTask {
+
+		TaskID id;
+
+		// Protected by the pool mutex.
+		uint32_t pending_dependencies;
+		Vector<BaseTask *> dependents;
+		bool completed;
+		Semaphore *done;
+#ifdef DEBUG_ENABLED
+		bool running;
+		Thread::ID running_thread;
+#endif
+
+		virtual void run() = 0;
+
+		BaseTask() {
+			id = 0;
+			pending_dependencies = 0;
+			completed = false;
+			done = NULL;
+#ifdef DEBUG_ENABLED
+			running = false;
+			running_thread = 0;
+#endif
+		}
+		virtual ~BaseTask() {}
+	};
+
+	template <class C, class M, class U>
+	struct Task : public BaseTask {
+
+		C *instance;
+		M method;
+		U userdata;
+
+		virtual void run() {
+			(instance->*method)(userdata);
+		}
+	};
+
+	// Double ended queue, the owner pushes and pops at the back, thieves take from the front.
+	struct TaskQueue {
+
+		Mutex *mutex;
+		BaseTask **tasks;
+		uint32_t capacity; // Always a power of two.
+		uint32_t front;
+		uint32_t back;
+
+		void push(BaseTask *p_task);
+		BaseTask *pop();
+		BaseTask *steal();
+
+		TaskQueue();
+		~TaskQueue();
+	};
+
+	struct ThreadData {
+
+		ThreadWorkPool *pool;
+		Thread *thread;
+		Thread::ID id;
+		int index;
+	};
+
+	struct BaseWork {
+
+		SelfList<BaseWork> queue_elem;
+
+		uint32_t elements;
+		uint32_t chunk_size;
+		volatile uint32_t index;
+
+		// Protected by the pool mutex.
+		uint32_t users;
+		bool exhausted;
+		bool completed;
+		Semaphore *done;
+
+		void process() {
+
+			while (true) {
+				uint32_t from = atomic_add(&index, chunk_size) - chunk_size;
+				if (from >= elements)
+					break;
+				uint32_t to = MIN(from + chunk_size, elements);
+				for (uint32_t i = from; i < to; i++) {
+					work(i);
+				}
+			}
+		}
+
+		virtual void work(uint32_t p_index) = 0;
+
+		BaseWork() :
+				queue_elem(this) {
+			elements = 0;
+			chunk_size = 1;
+			index = 0;
+			users = 0;
+			exhausted = false;
+			completed = false;
+			done = NULL;
+		}
+		virtual ~BaseWork() {}
+	};
+
+	template <class C, class M, class U>
+	struct Work : public BaseWork {
+
+		C *instance;
+		M method;
+		U userdata;
+
+		virtual void work(uint32_t p_index) {
+			(instance->*method)(p_index, userdata);
+		}
+	};
+
+	static ThreadWorkPool *singleton;
+
+	ThreadData *thread_data;
+	int thread_count;
+	Mutex *mutex;
+	Semaphore *work_semaphore;
+	Vector<Semaphore *> free_semaphores;
+	SelfList<BaseWork>::List queue;
+	HashMap<GroupID, BaseWork *> groups;
+	GroupID last_group_id;
+	bool exit_threads;
+
+	// A shared one for tasks added from outside the pool, plus one per thread.
+	TaskQueue *task_queues;
+	int queue_count;
+	HashMap<TaskID, BaseTask *> tasks;
+	TaskID last_task_id;
+
+	static void _thread_function(void *p_user);
+
+	uint32_t _get_chunk_size(uint32_t p_elements, uint32_t p_chunk_size) const;
+	Semaphore *_alloc_semaphore();
+	void _submit(BaseWork *p_work, bool p_caller_joins);
+	void _join(BaseWork *p_work);
+	void _leave(BaseWork *p_work);
+	void _wait(BaseWork *p_work);
+	GroupID _add_group(BaseWork *p_work);
+
+	int _get_thread_index() const;
+	TaskID _add_task(BaseTask *p_task, const TaskID *p_dependencies, int p_dependency_count);
+	void _queue_task(BaseTask *p_task, int p_thread_index);
+	BaseTask *_take_task(int p_thread_index);
+	void _run_task(BaseTask *p_task, int p_thread_index);
+#ifdef DEBUG_ENABLED
+	bool _waits_for_thread(BaseTask *p_task, Thread::ID p_thread) const;
+#endif
+
+public:
+	_FORCE_INLINE_ static ThreadWorkPool *get_singleton() { return singleton; }
+
+	_FORCE_INLINE_ int get_thread_count() const { return thread_count; }
+
+	// Calls p_method for every index in [0, p_elements) and returns once all of them were processed.
+	// The calling thread takes part in the work, so this is safe to use from within pool threads.
+	// A p_chunk_size of 0 lets the pool pick one based on the amount of elements and threads.
+	template <class C, class M, class U>
+	void do_work(uint32_t p_elements, C *p_instance, M p_method, U p_userdata, uint32_t p_chunk_size = 0) {
+
+		if (p_elements == 0)
+			return;
+
+		Work<C, M, U> work;
+		work.instance = p_instance;
+		work.method = p_method;
+		work.userdata = p_userdata;
+		work.elements = p_elements;
+		work.chunk_size = _get_chunk_size(p_elements, p_chunk_size);
+
+		if (thread_count == 0 || p_elements <= work.chunk_size) {
+			work.process();
+			return;
+		}
+
+		_submit(&work, true);
+		work.process();
+		_leave(&work);
+		_wait(&work);
+	}
+
+	// Same as do_work, but returns right away. The group must be waited for with wait_for_group_completion.
+	template <class C, class M, class U>
+	GroupID add_group_work(uint32_t p_elements, C *p_instance, M p_method, U p_userdata, uint32_t p_chunk_size = 0) {
+
+		Work<C, M, U> *work = memnew((Work<C, M, U>));
+		work->instance = p_instance;
+		work->method = p_method;
+		work->userdata = p_userdata;
+		work->elements = p_elements;
+		work->chunk_size = _get_chunk_size(p_elements, p_chunk_size);
+
+		return _add_group(work);
+	}
+
+	bool is_group_completed(GroupID p_group) const;
+	void wait_for_group_completion(GroupID p_group);
+
+	// Queues a call to p_method(p_userdata). The task only starts after all the given dependencies completed.
+	// Every task must be waited for with wait_for_task_completion, which is also what frees it.
+	template <class C, class M, class U>
+	TaskID add_task(C *p_instance, M p_method, U p_userdata, const TaskID *p_dependencies = NULL, int p_dependency_count = 0) {
+
+		Task<C, M, U> *task = memnew((Task<C, M, U>));
+		task->instance = p_instance;
+		task->method = p_method;
+		task->userdata = p_userdata;
+		return _add_task(task, p_dependencies, p_dependency_count);
+	}
+
+	template <class C, class M, class U>
+	TaskID add_task(C *p_instance, M p_method, U p_userdata, const Vector<TaskID> &p_dependencies) {
+
+		return add_task(p_instance, p_method, p_userdata, p_dependencies.ptr(), p_dependencies.size());
+	}
+
+	bool is_task_completed(TaskID p_task) const;
+	// Runs other queued tasks while the awaited one is not done, so it can be called from within tasks.
+	// Those run on top of the caller's stack, which only continues once they return. So a task must
+	// never wait for a task that is running further down its own thread's stack, nor for one that
+	// depends on such a task: nothing else can complete it. Debug builds check for this.
+	void wait_for_task_completion(TaskID p_task);
+
+	void init(int p_threads = -1);
+	void finish();
+
+	ThreadWorkPool();
+	~ThreadWorkPool();
+};
+
+#endif // THREAD_WORK_POOL_H
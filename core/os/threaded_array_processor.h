@@ -34,6 +34,7 @@
 #include "os/mutex.h"
 #include "os/os.h"
 #include "os/thread.h"
+#include "os/thread_work_pool.h"
 #include "safe_refcount.h"
 #include "thread_safe.h"
 
@@ -50,50 +51,16 @@ struct ThreadArrayProcessData {
 	}
 };
 
-#ifndef NO_THREADS
-
-template <class T>
-void process_array_thread(void *ud) {
-
-	T &data = *(T *)ud;
-	while (true) {
-		uint32_t index = atomic_increment(&data.index);
-		if (index >= data.elements)
-			break;
-		data.process(index);
-	}
-}
-
+// Runs on the engine ThreadWorkPool, which falls back to processing serially when no threads are available.
 template <class C, class M, class U>
 void thread_process_array(uint32_t p_elements, C *p_instance, M p_method, U p_userdata) {
 
-	ThreadArrayProcessData<C, U> data;
-	data.method = p_method;
-	data.instance = p_instance;
-	data.userdata = p_userdata;
-	data.index = 0;
-	data.elements = p_elements;
-	data.process(data.index); //process first, let threads increment for next
-
-	Vector<Thread *> threads;
-
-	threads.resize(OS::get_singleton()->get_processor_count());
-
-	for (int i = 0; i < threads.size(); i++) {
-		threads.write[i] = Thread::create(process_array_thread<ThreadArrayProcessData<C, U> >, &data);
+	ThreadWorkPool *pool = ThreadWorkPool::get_singleton();
+	if (pool) {
+		pool->do_work(p_elements, p_instance, p_method, p_userdata);
+		return;
 	}
 
-	for (int i = 0; i < threads.size(); i++) {
-		Thread::wait_to_finish(threads[i]);
-		memdelete(threads[i]);
-	}
-}
-
-#else
-
-template <class C, class M, class U>
-void thread_process_array(uint32_t p_elements, C *p_instance, M p_method, U p_userdata) {
-
 	ThreadArrayProcessData<C, U> data;
 	data.method = p_method;
 	data.instance = p_instance;
@@ -105,6 +72,4 @@ void thread_process_array(uint32_t p_elements, C *p_instance, M p_method, U p_us
 	}
 }
 
-#endif
-
 #endif // THREADED_ARRAY_PROCESSOR_H
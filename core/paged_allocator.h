@@ -0,0 +1,127 @@
+/*************************************************************************/
+/*  paged_allocator.h                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef PAGED_ALLOCATOR_H
+#define PAGED_ALLOCATOR_H
+
+#include "os/memory.h"
+#include "os/spin_lock.h"
+
+// Allocates objects of one type from pages of them. Freed objects are kept in a list to be
+// reused, so after the first pages objects that are created and freed all the time don't
+// go through the heap anymore. Pages are never released: allocators are meant to be global,
+// and objects freed after it was destroyed (static ones) must still have somewhere to go.
+
+template <class T>
+class PagedAllocator {
+
+	enum {
+		PAGE_SIZE = 256
+	};
+
+	union Slot {
+		Slot *next;
+		uint8_t data[sizeof(T)];
+	};
+
+	struct Page {
+		Page *next;
+		Slot slots[PAGE_SIZE];
+	};
+
+	SpinLock spin_lock;
+	Slot *free_slots;
+	Page *pages;
+	uint32_t page_count;
+	uint64_t alloc_count;
+
+	void _add_page() {
+
+		Page *page = (Page *)memalloc(sizeof(Page));
+		page->next = pages;
+		pages = page;
+		page_count++;
+
+		for (int i = 0; i < PAGE_SIZE - 1; i++) {
+			page->slots[i].next = &page->slots[i + 1];
+		}
+		page->slots[PAGE_SIZE - 1].next = free_slots;
+		free_slots = &page->slots[0];
+	}
+
+	_FORCE_INLINE_ void *_alloc_slot() {
+
+		spin_lock.lock();
+		if (unlikely(!free_slots)) {
+			_add_page();
+		}
+		Slot *slot = free_slots;
+		free_slots = slot->next;
+		alloc_count++;
+		spin_lock.unlock();
+
+		return slot;
+	}
+
+public:
+	_FORCE_INLINE_ T *alloc() {
+
+		return memnew_placement(_alloc_slot(), T);
+	}
+
+	_FORCE_INLINE_ T *alloc(const T &p_value) {
+
+		return memnew_placement(_alloc_slot(), T(p_value));
+	}
+
+	_FORCE_INLINE_ void free(T *p_object) {
+
+		p_object->~T();
+
+		Slot *slot = (Slot *)p_object;
+		spin_lock.lock();
+		slot->next = free_slots;
+		free_slots = slot;
+		spin_lock.unlock();
+	}
+
+	// Statistics, objects ever allocated and pages taken from the heap for them.
+	uint64_t get_alloc_count() const { return alloc_count; }
+	uint32_t get_page_count() const { return page_count; }
+
+	PagedAllocator() {
+		free_slots = NULL;
+		pages = NULL;
+		page_count = 0;
+		alloc_count = 0;
+	}
+};
+
+#endif // PAGED_ALLOCATOR_H
@@ -58,6 +58,7 @@
 #include "math/triangle_mesh.h"
 #include "os/input.h"
 #include "os/main_loop.h"
+#include "os/thread_work_pool.h"
 #include "packed_data_container.h"
 #include "path_remap.h"
 #include "project_settings.h"
@@ -78,9 +79,12 @@ static _ClassDB *_classdb = NULL;
 static _Marshalls *_marshalls = NULL;
 static TranslationLoaderPO *resource_format_po = NULL;
 static _JSON *_json = NULL;
+static _WorkerThreadPool *_worker_thread_pool = NULL;
 
 static IP *ip = NULL;
 
+static ThreadWorkPool *thread_work_pool = NULL;
+
 static _Geometry *_geometry = NULL;
 
 extern Mutex *_global_mutex;
@@ -98,6 +102,9 @@ void register_core_types() {
 
 	_global_mutex = Mutex::create();
 
+	thread_work_pool = memnew(ThreadWorkPool);
+	thread_work_pool->init();
+
 	StringName::setup();
 
 	register_global_constants();
@@ -195,6 +202,7 @@ void register_core_types() {
 	_classdb = memnew(_ClassDB);
 	_marshalls = memnew(_Marshalls);
 	_json = memnew(_JSON);
+	_worker_thread_pool = memnew(_WorkerThreadPool);
 }
 
 void register_core_settings() {
@@ -218,6 +226,7 @@ void register_core_singletons() {
 	ClassDB::register_class<InputMap>();
 	ClassDB::register_class<_JSON>();
 	ClassDB::register_class<Expression>();
+	ClassDB::register_class<_WorkerThreadPool>();
 
 	Engine::get_singleton()->add_singleton(Engine::Singleton("ProjectSettings", ProjectSettings::get_singleton()));
 	Engine::get_singleton()->add_singleton(Engine::Singleton("IP", IP::get_singleton()));
@@ -232,6 +241,7 @@ void register_core_singletons() {
 	Engine::get_singleton()->add_singleton(Engine::Singleton("Input", Input::get_singleton()));
 	Engine::get_singleton()->add_singleton(Engine::Singleton("InputMap", InputMap::get_singleton()));
 	Engine::get_singleton()->add_singleton(Engine::Singleton("JSON", _JSON::get_singleton()));
+	Engine::get_singleton()->add_singleton(Engine::Singleton("WorkerThreadPool", _WorkerThreadPool::get_singleton()));
 }
 
 void unregister_core_types() {
@@ -243,6 +253,7 @@ void unregister_core_types() {
 	memdelete(_classdb);
 	memdelete(_marshalls);
 	memdelete(_json);
+	memdelete(_worker_thread_pool);
 
 	memdelete(_geometry);
 
@@ -260,6 +271,9 @@ void unregister_core_types() {
 	if (ip)
 		memdelete(ip);
 
+	if (thread_work_pool)
+		memdelete(thread_work_pool);
+
 	ObjectDB::cleanup();
 
 	unregister_variant_methods();
@@ -32,6 +32,7 @@
 #define RID_H
 
 #include "list.h"
+#include "oa_hash_set.h"
 #include "os/memory.h"
 #include "safe_refcount.h"
 #include "set.h"
@@ -128,11 +129,17 @@ public:
 	virtual ~RID_OwnerBase() {}
 };
 
+#ifdef DEBUG_ENABLED
+struct RID_DataHasher {
+	static _FORCE_INLINE_ uint32_t hash(const RID_Data *p_data) { return hash_one_uint64((uint64_t)p_data); }
+};
+#endif
+
 template <class T>
 class RID_Owner : public RID_OwnerBase {
 public:
 #ifdef DEBUG_ENABLED
-	mutable Set<RID_Data *> id_map;
+	mutable OAHashSet<RID_Data *, RID_DataHasher> id_map;
 #endif
 public:
 	_FORCE_INLINE_ RID make_rid(T *p_data) {
@@ -197,9 +204,9 @@ public:
 
 #ifdef DEBUG_ENABLED
 
-		for (typename Set<RID_Data *>::Element *E = id_map.front(); E; E = E->next()) {
+		for (RID_Data *const *E = id_map.next(NULL); E; E = id_map.next(E)) {
 			RID r;
-			_set_data(r, static_cast<T *>(E->get()));
+			_set_data(r, static_cast<T *>(*E));
 			p_owned->push_back(r);
 		}
 #endif
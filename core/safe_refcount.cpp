@@ -166,4 +166,34 @@ uint64_t atomic_add(volatile uint64_t *pw, volatile uint64_t val) {
 uint64_t atomic_exchange_if_greater(volatile uint64_t *pw, volatile uint64_t val) {
 	return _atomic_exchange_if_greater_impl(pw, val);
 }
+
+bool atomic_compare_exchange(volatile uint32_t *pw, uint32_t p_expected, uint32_t p_value) {
+	return InterlockedCompareExchange((LONG volatile *)pw, p_value, p_expected) == (LONG)p_expected;
+}
+
+bool atomic_compare_exchange(volatile uint64_t *pw, uint64_t p_expected, uint64_t p_value) {
+	return InterlockedCompareExchange64((LONGLONG volatile *)pw, p_value, p_expected) == (LONGLONG)p_expected;
+}
+
+// x86 doesn't reorder loads with other loads nor stores with other stores, only the compiler has to be kept from it.
+#if defined(_M_IX86) || defined(_M_X64)
+#define ATOMIC_ORDER_BARRIER _ReadWriteBarrier()
+#else
+#define ATOMIC_ORDER_BARRIER MemoryBarrier()
+#endif
+
+uint32_t atomic_load_acquire(const volatile uint32_t *pw) {
+	uint32_t value = *pw;
+	ATOMIC_ORDER_BARRIER;
+	return value;
+}
+
+void atomic_store_release(volatile uint32_t *pw, uint32_t p_value) {
+	ATOMIC_ORDER_BARRIER;
+	*pw = p_value;
+}
+
+void atomic_fence_acquire() {
+	ATOMIC_ORDER_BARRIER;
+}
 #endif
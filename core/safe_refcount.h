@@ -95,6 +95,32 @@ static _ALWAYS_INLINE_ T atomic_exchange_if_greater(volatile T *pw, volatile V v
 	return *pw;
 }
 
+template <class T>
+static _ALWAYS_INLINE_ bool atomic_compare_exchange(volatile T *pw, T p_expected, T p_value) {
+
+	if (*pw != p_expected)
+		return false;
+
+	*pw = p_value;
+
+	return true;
+}
+
+template <class T>
+static _ALWAYS_INLINE_ T atomic_load_acquire(const volatile T *pw) {
+
+	return *pw;
+}
+
+template <class T>
+static _ALWAYS_INLINE_ void atomic_store_release(volatile T *pw, T p_value) {
+
+	*pw = p_value;
+}
+
+static _ALWAYS_INLINE_ void atomic_fence_acquire() {
+}
+
 #elif defined(__GNUC__)
 
 /* Implementation for GCC & Clang */
@@ -150,6 +176,31 @@ static _ALWAYS_INLINE_ T atomic_exchange_if_greater(volatile T *pw, volatile V v
 	}
 }
 
+template <class T>
+static _ALWAYS_INLINE_ bool atomic_compare_exchange(volatile T *pw, T p_expected, T p_value) {
+
+	return __sync_bool_compare_and_swap(pw, p_expected, p_value);
+}
+
+// Loads after it see what was written before a release store of the value it read.
+template <class T>
+static _ALWAYS_INLINE_ T atomic_load_acquire(const volatile T *pw) {
+
+	return __atomic_load_n(pw, __ATOMIC_ACQUIRE);
+}
+
+template <class T>
+static _ALWAYS_INLINE_ void atomic_store_release(volatile T *pw, T p_value) {
+
+	__atomic_store_n(pw, p_value, __ATOMIC_RELEASE);
+}
+
+// Keeps the loads before it from moving after the ones that follow.
+static _ALWAYS_INLINE_ void atomic_fence_acquire() {
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
 #elif defined(_MSC_VER)
 // For MSVC use a separate compilation unit to prevent windows.h from polluting
 // the global namespace.
@@ -159,6 +210,7 @@ uint32_t atomic_increment(volatile uint32_t *pw);
 uint32_t atomic_sub(volatile uint32_t *pw, volatile uint32_t val);
 uint32_t atomic_add(volatile uint32_t *pw, volatile uint32_t val);
 uint32_t atomic_exchange_if_greater(volatile uint32_t *pw, volatile uint32_t val);
+bool atomic_compare_exchange(volatile uint32_t *pw, uint32_t p_expected, uint32_t p_value);
 
 uint64_t atomic_conditional_increment(volatile uint64_t *pw);
 uint64_t atomic_decrement(volatile uint64_t *pw);
@@ -166,6 +218,10 @@ uint64_t atomic_increment(volatile uint64_t *pw);
 uint64_t atomic_sub(volatile uint64_t *pw, volatile uint64_t val);
 uint64_t atomic_add(volatile uint64_t *pw, volatile uint64_t val);
 uint64_t atomic_exchange_if_greater(volatile uint64_t *pw, volatile uint64_t val);
+bool atomic_compare_exchange(volatile uint64_t *pw, uint64_t p_expected, uint64_t p_value);
+uint32_t atomic_load_acquire(const volatile uint32_t *pw);
+void atomic_store_release(volatile uint32_t *pw, uint32_t p_value);
+void atomic_fence_acquire();
 
 #else
 //no threads supported?
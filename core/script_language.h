@@ -205,6 +205,7 @@ public:
 	virtual String get_extension() const = 0;
 	virtual Error execute_file(const String &p_path) = 0;
 	virtual void finish() = 0;
+	virtual void preload_scripts() {} // optional, called when a game starts, once the names of the autoloads are known
 
 	/* EDITOR FUNCTIONS */
 	struct Warning {
@@ -305,6 +306,8 @@ public:
 	virtual int profiling_get_accumulated_data(ProfilingInfo *p_info_arr, int p_info_max) = 0;
 	virtual int profiling_get_frame_data(ProfilingInfo *p_info_arr, int p_info_max) = 0;
 
+	virtual bool sampling_start_to_file(const String &p_path) { return false; } //optional, samples the call stacks and saves them to p_path on exit
+
 	virtual void *alloc_instance_binding_data(Object *p_object) { return NULL; } //optional, not used by all languages
 	virtual void free_instance_binding_data(void *p_data) {} //optional, not used by all languages
 
@@ -33,12 +33,25 @@
 #include "core_string_names.h"
 #include "io/marshalls.h"
 #include "math_funcs.h"
+#include "paged_allocator.h"
 #include "print_string.h"
 #include "resource.h"
 #include "scene/gui/control.h"
 #include "scene/main/node.h"
 #include "variant_parser.h"
 
+// The math types that don't fit in a Variant, pooled as they are copied around all the time
+static PagedAllocator<Transform2D> transform2d_allocator;
+static PagedAllocator< ::AABB> aabb_allocator;
+static PagedAllocator<Basis> basis_allocator;
+static PagedAllocator<Transform> transform_allocator;
+
+void Variant::get_allocator_stats(uint64_t *r_alloc_count, uint32_t *r_page_count) {
+
+	*r_alloc_count = transform2d_allocator.get_alloc_count() + aabb_allocator.get_alloc_count() + basis_allocator.get_alloc_count() + transform_allocator.get_alloc_count();
+	*r_page_count = transform2d_allocator.get_page_count() + aabb_allocator.get_page_count() + basis_allocator.get_page_count() + transform_allocator.get_page_count();
+}
+
 String Variant::get_type_name(Variant::Type p_type) {
 
 	switch (p_type) {
@@ -943,7 +956,7 @@ void Variant::reference(const Variant &p_variant) {
 		} break;
 		case TRANSFORM2D: {
 
-			_data._transform2d = memnew(Transform2D(*p_variant._data._transform2d));
+			_data._transform2d = transform2d_allocator.alloc(*p_variant._data._transform2d);
 		} break;
 		case VECTOR3: {
 
@@ -956,7 +969,7 @@ void Variant::reference(const Variant &p_variant) {
 
 		case AABB: {
 
-			_data._aabb = memnew(::AABB(*p_variant._data._aabb));
+			_data._aabb = aabb_allocator.alloc(*p_variant._data._aabb);
 		} break;
 		case QUAT: {
 
@@ -965,12 +978,12 @@ void Variant::reference(const Variant &p_variant) {
 		} break;
 		case BASIS: {
 
-			_data._basis = memnew(Basis(*p_variant._data._basis));
+			_data._basis = basis_allocator.alloc(*p_variant._data._basis);
 
 		} break;
 		case TRANSFORM: {
 
-			_data._transform = memnew(Transform(*p_variant._data._transform));
+			_data._transform = transform_allocator.alloc(*p_variant._data._transform);
 		} break;
 
 		// misc types
@@ -1077,19 +1090,19 @@ void Variant::clear() {
 	*/
 		case TRANSFORM2D: {
 
-			memdelete(_data._transform2d);
+			transform2d_allocator.free(_data._transform2d);
 		} break;
 		case AABB: {
 
-			memdelete(_data._aabb);
+			aabb_allocator.free(_data._aabb);
 		} break;
 		case BASIS: {
 
-			memdelete(_data._basis);
+			basis_allocator.free(_data._basis);
 		} break;
 		case TRANSFORM: {
 
-			memdelete(_data._transform);
+			transform_allocator.free(_data._transform);
 		} break;
 
 		// misc types
@@ -2208,13 +2221,13 @@ Variant::Variant(const Plane &p_plane) {
 Variant::Variant(const ::AABB &p_aabb) {
 
 	type = AABB;
-	_data._aabb = memnew(::AABB(p_aabb));
+	_data._aabb = aabb_allocator.alloc(p_aabb);
 }
 
 Variant::Variant(const Basis &p_matrix) {
 
 	type = BASIS;
-	_data._basis = memnew(Basis(p_matrix));
+	_data._basis = basis_allocator.alloc(p_matrix);
 }
 
 Variant::Variant(const Quat &p_quat) {
@@ -2225,13 +2238,13 @@ Variant::Variant(const Quat &p_quat) {
 Variant::Variant(const Transform &p_transform) {
 
 	type = TRANSFORM;
-	_data._transform = memnew(Transform(p_transform));
+	_data._transform = transform_allocator.alloc(p_transform);
 }
 
 Variant::Variant(const Transform2D &p_transform) {
 
 	type = TRANSFORM2D;
-	_data._transform2d = memnew(Transform2D(p_transform));
+	_data._transform2d = transform2d_allocator.alloc(p_transform);
 }
 Variant::Variant(const Color &p_color) {
 
@@ -150,6 +150,8 @@ private:
 public:
 	_FORCE_INLINE_ Type get_type() const { return type; }
 	static String get_type_name(Variant::Type p_type);
+	// Transform2D, AABB, Basis and Transform come from pools, objects ever taken and heap pages used for them.
+	static void get_allocator_stats(uint64_t *r_alloc_count, uint32_t *r_page_count);
 	static bool can_convert(Type p_type_from, Type p_type_to);
 	static bool can_convert_strict(Type p_type_from, Type p_type_to);
 
@@ -157,6 +159,15 @@ public:
 	_FORCE_INLINE_ bool is_num() const { return type == INT || type == REAL; };
 	_FORCE_INLINE_ bool is_array() const { return type >= ARRAY; };
 	bool is_shared() const;
+
+	// In place access to the Array or PoolVector held, the type must match. Lets the script
+	// VMs loop over and index them without copying them or going through get() and set().
+	_FORCE_INLINE_ Array &get_array_ref() { return *reinterpret_cast<Array *>(_data._mem); }
+	_FORCE_INLINE_ const Array &get_array_ref() const { return *reinterpret_cast<const Array *>(_data._mem); }
+	template <class T>
+	_FORCE_INLINE_ PoolVector<T> &get_pool_vector_ref() { return *reinterpret_cast<PoolVector<T> *>(_data._mem); }
+	template <class T>
+	_FORCE_INLINE_ const PoolVector<T> &get_pool_vector_ref() const { return *reinterpret_cast<const PoolVector<T> *>(_data._mem); }
 	bool is_zero() const;
 	bool is_one() const;
 
@@ -358,6 +369,11 @@ public:
 	};
 
 	void call_ptr(const StringName &p_method, const Variant **p_args, int p_argcount, Variant *r_ret, CallError &r_error);
+
+	// Methods of built-in types can be looked up once and called later without searching them by name.
+	typedef const void *BuiltInMethod;
+	static BuiltInMethod get_built_in_method(Variant::Type p_type, const StringName &p_method);
+	void call_built_in_method(BuiltInMethod p_method, const Variant **p_args, int p_argcount, Variant *r_ret, CallError &r_error);
 	Variant call(const StringName &p_method, const Variant **p_args, int p_argcount, CallError &r_error);
 	Variant call(const StringName &p_method, const Variant &p_arg1 = Variant(), const Variant &p_arg2 = Variant(), const Variant &p_arg3 = Variant(), const Variant &p_arg4 = Variant(), const Variant &p_arg5 = Variant());
 
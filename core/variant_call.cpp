@@ -1065,6 +1065,31 @@ void Variant::call_ptr(const StringName &p_method, const Variant **p_args, int p
 		*r_ret = ret;
 }
 
+Variant::BuiltInMethod Variant::get_built_in_method(Variant::Type p_type, const StringName &p_method) {
+
+	ERR_FAIL_INDEX_V(p_type, VARIANT_MAX, NULL);
+
+	const Map<StringName, _VariantCall::FuncData>::Element *E = _VariantCall::type_funcs[p_type].functions.find(p_method);
+	if (!E)
+		return NULL;
+
+	return &E->get();
+}
+
+void Variant::call_built_in_method(BuiltInMethod p_method, const Variant **p_args, int p_argcount, Variant *r_ret, CallError &r_error) {
+
+	ERR_FAIL_COND(!p_method);
+
+	Variant ret;
+	r_error.error = Variant::CallError::CALL_OK;
+
+	_VariantCall::FuncData *funcdata = const_cast<_VariantCall::FuncData *>(static_cast<const _VariantCall::FuncData *>(p_method));
+	funcdata->call(ret, *this, p_args, p_argcount, r_error);
+
+	if (r_error.error == Variant::CallError::CALL_OK && r_ret)
+		*r_ret = ret;
+}
+
 #define VCALL(m_type, m_method) _VariantCall::_call_##m_type##_##m_method
 
 Variant Variant::construct(const Variant::Type p_type, const Variant **p_args, int p_argcount, CallError &r_error, bool p_strict) {
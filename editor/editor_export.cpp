@@ -540,6 +540,12 @@ void EditorExportPlugin::_export_file(const String &p_path, const String &p_type
 void EditorExportPlugin::_export_begin(const Set<String> &p_features, bool p_debug, const String &p_path, int p_flags) {
 }
 
+void EditorExportPlugin::_export_prepare(const Set<String> &p_paths) {
+}
+
+void EditorExportPlugin::_export_finish() {
+}
+
 void EditorExportPlugin::skip() {
 
 	skipped = true;
@@ -623,6 +629,7 @@ Error EditorExportPlatform::export_project_files(const Ref<EditorExportPreset> &
 
 	Vector<Ref<EditorExportPlugin> > export_plugins = EditorExport::get_singleton()->get_export_plugins();
 	for (int i = 0; i < export_plugins.size(); i++) {
+		export_plugins.write[i]->_export_prepare(paths);
 		if (p_so_func) {
 			for (int j = 0; j < export_plugins[i]->shared_objects.size(); j++) {
 				p_so_func(p_udata, export_plugins[i]->shared_objects[j]);
@@ -277,6 +277,7 @@ class EditorExportPlugin : public Reference {
 	}
 
 	_FORCE_INLINE_ void _export_end() {
+		_export_finish();
 		ios_frameworks.clear();
 		ios_bundle_files.clear();
 		ios_plist_content = "";
@@ -301,6 +302,8 @@ protected:
 
 	virtual void _export_file(const String &p_path, const String &p_type, const Set<String> &p_features);
 	virtual void _export_begin(const Set<String> &p_features, bool p_debug, const String &p_path, int p_flags);
+	virtual void _export_prepare(const Set<String> &p_paths); // all the files to export, before _export_file is called for them
+	virtual void _export_finish();
 
 	static void _bind_methods();
 
@@ -33,6 +33,7 @@
 #include "app_icon.gen.h"
 #include "core/register_core_types.h"
 #include "drivers/register_driver_types.h"
+#include "frame_arena.h"
 #include "message_queue.h"
 #include "modules/register_module_types.h"
 #include "os/os.h"
@@ -113,6 +114,7 @@ static bool init_use_custom_pos = false;
 #ifdef DEBUG_ENABLED
 static bool debug_collisions = false;
 static bool debug_navigation = false;
+static String gdscript_samples_path;
 #endif
 static int frame_delay = 0;
 static Vector2 init_custom_pos;
@@ -252,6 +254,7 @@ void Main::print_help(const char *p_binary) {
 #ifdef DEBUG_ENABLED
 	OS::get_singleton()->print("  --debug-collisions               Show collisions shapes when running the scene.\n");
 	OS::get_singleton()->print("  --debug-navigation               Show navigation polygons when running the scene.\n");
+	OS::get_singleton()->print("  --gdscript-samples <file>        Sample the GDScript call stacks and save them to <file> on exit, in the folded format of flame graph tools.\n");
 #endif
 	OS::get_singleton()->print("  --frame-delay <ms>               Simulate high CPU load (delay each frame by <ms> milliseconds).\n");
 	OS::get_singleton()->print("  --time-scale <scale>             Force time scale (higher values are faster, 1.0 is normal speed).\n");
@@ -637,6 +640,15 @@ Error Main::setup(const char *execpath, int argc, char *argv[], bool p_second_ph
 			debug_collisions = true;
 		} else if (I->get() == "--debug-navigation") {
 			debug_navigation = true;
+		} else if (I->get() == "--gdscript-samples") {
+			if (I->next()) {
+
+				gdscript_samples_path = I->next()->get();
+				N = I->next()->next();
+			} else {
+				OS::get_singleton()->print("Missing GDScript samples file argument, aborting.\n");
+				goto error;
+			}
 #endif
 		} else if (I->get() == "--remote-debug") {
 			if (I->next()) {
@@ -1192,6 +1204,21 @@ Error Main::setup2(Thread::ID p_main_tid_override) {
 
 	ScriptServer::init_languages();
 
+#ifdef DEBUG_ENABLED
+	if (gdscript_samples_path != String()) {
+		bool sampling = false;
+		for (int i = 0; i < ScriptServer::get_language_count(); i++) {
+			ScriptLanguage *lang = ScriptServer::get_language(i);
+			if (lang->get_name() == "GDScript") {
+				sampling = lang->sampling_start_to_file(gdscript_samples_path);
+			}
+		}
+		if (!sampling) {
+			WARN_PRINT("GDScript is not available, --gdscript-samples is ignored.");
+		}
+	}
+#endif
+
 	MAIN_PRINT("Main: Load Translations");
 
 	translation_server->setup(); //register translations, load them, etc.
@@ -1478,6 +1505,10 @@ bool Main::start() {
 					}
 				}
 
+				for (int i = 0; i < ScriptServer::get_language_count(); i++) {
+					ScriptServer::get_language(i)->preload_scripts();
+				}
+
 				//second pass, load into global constants
 				List<Node *> to_add;
 				for (List<PropertyInfo>::Element *E = props.front(); E; E = E->next()) {
@@ -1722,8 +1753,18 @@ bool Main::force_redraw_requested = false;
 static uint64_t physics_process_max = 0;
 static uint64_t idle_process_max = 0;
 
+// A step may still be running on the physics thread until the physics servers sync.
+static bool physics_step_queued = false;
+
 bool Main::iteration() {
 
+	// What the servers allocated for the frame before the previous one can be reused now.
+	// Not while the physics thread may be in a step though, it starts the frame after syncing.
+	bool frame_started = !physics_step_queued;
+	if (frame_started) {
+		FrameArena::next_frame();
+	}
+
 	uint64_t ticks = OS::get_singleton()->get_ticks_usec();
 	Engine::get_singleton()->_frame_ticks = ticks;
 	main_timer_sync.set_cpu_ticks_usec(ticks);
@@ -1774,6 +1815,12 @@ bool Main::iteration() {
 		Physics2DServer::get_singleton()->sync();
 		Physics2DServer::get_singleton()->flush_queries();
 
+		physics_step_queued = false;
+		if (!frame_started) {
+			frame_started = true;
+			FrameArena::next_frame();
+		}
+
 		if (OS::get_singleton()->get_main_loop()->iteration(frame_slice * time_scale)) {
 			exit = true;
 			break;
@@ -1785,6 +1832,7 @@ bool Main::iteration() {
 
 		Physics2DServer::get_singleton()->end_sync();
 		Physics2DServer::get_singleton()->step(frame_slice * time_scale);
+		physics_step_queued = true;
 
 		message_queue->flush();
 
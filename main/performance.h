@@ -78,6 +78,8 @@ public:
 		PHYSICS_3D_ISLAND_COUNT,
 		//physics
 		AUDIO_OUTPUT_LATENCY,
+		RENDER_OCCLUDERS_IN_FRAME,
+		RENDER_OCCLUDED_OBJECTS_IN_FRAME,
 		MONITOR_MAX
 	};
 
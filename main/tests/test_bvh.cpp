@@ -0,0 +1,236 @@
+/*************************************************************************/
+/*  test_bvh.cpp                                                         */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_bvh.h"
+
+#include "core/math/bvh.h"
+#include "core/math/math_funcs.h"
+#include "core/math/octree.h"
+#include "core/os/os.h"
+
+namespace TestBVH {
+
+// Compares the pairs and the speed of BVH and Octree, used the same way as the physics broadphase.
+
+enum {
+	ELEMENT_COUNT = 10000,
+	STATIC_EVERY = 10,
+	FRAME_COUNT = 100,
+	QUERY_COUNT = 1000,
+	QUERY_MAX_RESULTS = 256
+};
+
+struct TestElement {
+
+	int index;
+	uint32_t id;
+	AABB aabb;
+	Vector3 velocity;
+	bool is_static;
+};
+
+struct PairStats {
+
+	int count;
+	uint64_t checksum; // order independent, to compare the pairs of both structures
+
+	_FORCE_INLINE_ uint64_t pair_hash(TestElement *p_A, TestElement *p_B) {
+		uint64_t a = MIN(p_A->index, p_B->index);
+		uint64_t b = MAX(p_A->index, p_B->index);
+		return (a * 2654435761ULL) ^ (b * 40503ULL + 0x9e3779b97f4a7c15ULL);
+	}
+};
+
+static void *_pair(void *p_self, uint32_t, TestElement *p_A, int, uint32_t, TestElement *p_B, int) {
+
+	PairStats *stats = (PairStats *)p_self;
+	stats->count++;
+	stats->checksum += stats->pair_hash(p_A, p_B);
+	return NULL;
+}
+
+static void _unpair(void *p_self, uint32_t, TestElement *p_A, int, uint32_t, TestElement *p_B, int, void *) {
+
+	PairStats *stats = (PairStats *)p_self;
+	stats->count--;
+	stats->checksum -= stats->pair_hash(p_A, p_B);
+}
+
+static real_t _randf(uint64_t *r_seed) {
+
+	return (real_t)Math::rand_from_seed(r_seed) / (real_t)Math::RANDOM_MAX;
+}
+
+static void _init_elements(Vector<TestElement> &r_elements) {
+
+	uint64_t seed = 1234;
+	real_t world_size = 400.0;
+
+	r_elements.resize(ELEMENT_COUNT);
+	for (int i = 0; i < ELEMENT_COUNT; i++) {
+
+		TestElement &e = r_elements.write[i];
+		e.index = i;
+		e.is_static = (i % STATIC_EVERY) == 0;
+
+		Vector3 size(0.5 + _randf(&seed), 0.5 + _randf(&seed), 0.5 + _randf(&seed));
+		if (e.is_static && (i % (STATIC_EVERY * 50)) == 0) {
+			size *= 40.0; // a few large static objects, like level geometry
+		}
+
+		e.aabb = AABB(Vector3(_randf(&seed), _randf(&seed) * 0.1, _randf(&seed)) * world_size, size);
+		e.velocity = e.is_static ? Vector3() : Vector3(_randf(&seed) - 0.5, _randf(&seed) - 0.5, _randf(&seed) - 0.5) * 0.2;
+	}
+}
+
+static void _step_elements(Vector<TestElement> &r_elements) {
+
+	for (int i = 0; i < r_elements.size(); i++) {
+
+		TestElement &e = r_elements.write[i];
+		if (e.is_static)
+			continue;
+		e.aabb.position += e.velocity;
+	}
+}
+
+// pairs are reported right away by the octree, but may be batched by the BVH
+static void _update_pairs(Octree<TestElement, true> &p_octree) {}
+static void _update_pairs(BVH<TestElement, true> &p_bvh) { p_bvh.update_pairs(); }
+
+template <class S>
+static uint64_t _run(S &p_structure, PairStats &r_stats, Vector<TestElement> &r_elements, Vector<PairStats> &r_frame_stats, uint64_t &r_query_usec, int &r_query_results) {
+
+	p_structure.set_pair_callback(_pair, &r_stats);
+	p_structure.set_unpair_callback(_unpair, &r_stats);
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+
+	for (int i = 0; i < r_elements.size(); i++) {
+
+		TestElement &e = r_elements.write[i];
+		e.id = p_structure.create(&e, AABB(), 0, false, 1, 0);
+		p_structure.set_pairable(e.id, !e.is_static, 1, e.is_static ? 0 : 0xFFFFF);
+		p_structure.move(e.id, e.aabb);
+	}
+	_update_pairs(p_structure);
+
+	for (int f = 0; f < FRAME_COUNT; f++) {
+
+		_step_elements(r_elements);
+
+		for (int i = 0; i < r_elements.size(); i++) {
+
+			const TestElement &e = r_elements[i];
+			if (!e.is_static)
+				p_structure.move(e.id, e.aabb);
+		}
+		_update_pairs(p_structure);
+
+		r_frame_stats.push_back(r_stats);
+	}
+
+	uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+
+	TestElement *results[QUERY_MAX_RESULTS];
+	uint64_t seed = 4321;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	r_query_results = 0;
+	for (int i = 0; i < QUERY_COUNT; i++) {
+
+		AABB query(Vector3(_randf(&seed), 0, _randf(&seed)) * 400.0, Vector3(10, 40, 10));
+		r_query_results += p_structure.cull_aabb(query, results, QUERY_MAX_RESULTS);
+	}
+	r_query_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	for (int i = 0; i < r_elements.size(); i++) {
+		p_structure.erase(r_elements[i].id);
+	}
+	_update_pairs(p_structure);
+
+	return elapsed;
+}
+
+MainLoop *test() {
+
+	OS::get_singleton()->print("\n\nBVH vs Octree, %d elements (1 in %d static), %d frames\n", ELEMENT_COUNT, STATIC_EVERY, FRAME_COUNT);
+
+	Vector<PairStats> octree_frames;
+	Vector<PairStats> bvh_frames;
+	Vector<PairStats> deferred_frames;
+	uint64_t octree_query_usec, bvh_query_usec, deferred_query_usec;
+	int octree_query_results, bvh_query_results, deferred_query_results;
+	uint64_t octree_usec, bvh_usec, deferred_usec;
+
+	{
+		Vector<TestElement> elements;
+		_init_elements(elements);
+
+		Octree<TestElement, true> octree;
+		PairStats stats = { 0, 0 };
+		octree_usec = _run(octree, stats, elements, octree_frames, octree_query_usec, octree_query_results);
+		OS::get_singleton()->print("pairs left after erasing: %d\n", stats.count);
+	}
+
+	{
+		Vector<TestElement> elements;
+		_init_elements(elements);
+
+		BVH<TestElement, true> bvh;
+		PairStats stats = { 0, 0 };
+		bvh_usec = _run(bvh, stats, elements, bvh_frames, bvh_query_usec, bvh_query_results);
+		OS::get_singleton()->print("pairs left after erasing: %d\n", stats.count);
+	}
+
+	{
+		Vector<TestElement> elements;
+		_init_elements(elements);
+
+		BVH<TestElement, true> bvh;
+		bvh.set_deferred_pairs(true);
+		PairStats stats = { 0, 0 };
+		deferred_usec = _run(bvh, stats, elements, deferred_frames, deferred_query_usec, deferred_query_results);
+		OS::get_singleton()->print("pairs left after erasing: %d\n", stats.count);
+	}
+
+	bool pairs_match = octree_frames.size() == bvh_frames.size() && octree_frames.size() == deferred_frames.size();
+	for (int i = 0; pairs_match && i < octree_frames.size(); i++) {
+		pairs_match = octree_frames[i].count == bvh_frames[i].count && octree_frames[i].checksum == bvh_frames[i].checksum;
+		pairs_match = pairs_match && octree_frames[i].count == deferred_frames[i].count && octree_frames[i].checksum == deferred_frames[i].checksum;
+	}
+
+	OS::get_singleton()->print("pairs in last frame: %d (octree) %d (bvh), all frames match: %s\n", octree_frames[FRAME_COUNT - 1].count, bvh_frames[FRAME_COUNT - 1].count, pairs_match ? "yes" : "NO");
+	OS::get_singleton()->print("insert + move: %d msec (octree) %d msec (bvh) %d msec (bvh, deferred pairs)\n", int(octree_usec / 1000), int(bvh_usec / 1000), int(deferred_usec / 1000));
+	OS::get_singleton()->print("%d aabb queries: %d msec, %d results (octree) %d msec, %d results (bvh)\n", QUERY_COUNT, int(octree_query_usec / 1000), octree_query_results, int(bvh_query_usec / 1000), bvh_query_results);
+
+	return NULL;
+}
+} // namespace TestBVH
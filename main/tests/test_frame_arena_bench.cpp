@@ -0,0 +1,143 @@
+/*************************************************************************/
+/*  test_frame_arena_bench.cpp                                           */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_frame_arena_bench.h"
+
+#include "core/frame_arena.h"
+#include "core/map.h"
+#include "core/os/os.h"
+#include "core/vector.h"
+
+namespace TestFrameArenaBench {
+
+// Buffers rebuilt every frame like the servers do, the constraints of the physics
+// islands and the sorted canvas layers of a viewport, from the heap and from the
+// frame arena.
+
+enum {
+	FRAMES = 20000,
+	ISLANDS = 64,
+	CONSTRAINTS_PER_ISLAND = 16,
+	LAYERS = 16
+};
+
+template <class V>
+static uint64_t _fill_islands(V &r_islands, V &r_constraints, int p_frame) {
+
+	r_islands.clear();
+	r_constraints.clear();
+
+	for (int i = 0; i < ISLANDS; i++) {
+		r_islands.push_back(p_frame + i);
+		for (int j = 0; j < CONSTRAINTS_PER_ISLAND; j++) {
+			r_constraints.push_back(p_frame + i * CONSTRAINTS_PER_ISLAND + j);
+		}
+	}
+
+	uint64_t total = 0;
+	for (int i = 0; i < r_constraints.size(); i++) {
+		total += r_constraints[i];
+	}
+	return total + r_islands.size();
+}
+
+template <class M>
+static uint64_t _sort_layers(int p_frame) {
+
+	M layers;
+	for (int i = 0; i < LAYERS; i++) {
+		layers[(p_frame * 7 + i * 13) % 101] = i;
+	}
+
+	uint64_t total = 0;
+	for (typename M::Element *E = layers.front(); E; E = E->next()) {
+		total += E->key() * E->get();
+	}
+	return total;
+}
+
+MainLoop *test() {
+
+	OS *os = OS::get_singleton();
+
+	os->print("\n\nFrame arena benchmark, %d frames\n", FRAMES);
+
+	uint64_t begin = os->get_ticks_usec();
+	uint64_t heap_result = 0;
+	{
+		Vector<int> islands;
+		Vector<int> constraints;
+		for (int i = 0; i < FRAMES; i++) {
+			heap_result += _fill_islands(islands, constraints, i);
+			heap_result += _sort_layers<Map<int, int> >(i);
+		}
+	}
+	os->print("heap: %d msec\n", int((os->get_ticks_usec() - begin) / 1000));
+
+	begin = os->get_ticks_usec();
+	uint64_t arena_result = 0;
+	uint32_t chunks_after_first_frames = 0;
+	{
+		FrameVector<int> islands;
+		FrameVector<int> constraints;
+		for (int i = 0; i < FRAMES; i++) {
+			FrameArena::next_frame();
+			arena_result += _fill_islands(islands, constraints, i);
+			arena_result += _sort_layers<Map<int, int, Comparator<int>, FrameAllocator> >(i);
+			if (i == 2) {
+				chunks_after_first_frames = FrameArena::get_chunk_count();
+			}
+		}
+	}
+	os->print("frame arena: %d msec\n", int((os->get_ticks_usec() - begin) / 1000));
+
+	os->print("results match: %s\n", heap_result == arena_result ? "yes" : "NO");
+	os->print("chunks: %d after the first frames, %d at the end\n", chunks_after_first_frames, FrameArena::get_chunk_count());
+
+	// what was allocated in a frame must still be there during the next one
+	FrameArena::next_frame();
+	FrameVector<int> previous;
+	for (int i = 0; i < 1000; i++) {
+		previous.push_back(i);
+	}
+	FrameArena::next_frame();
+	FrameVector<int> current;
+	for (int i = 0; i < 1000; i++) {
+		current.push_back(-i);
+	}
+	bool kept = true;
+	for (int i = 0; i < 1000; i++) {
+		kept = kept && previous[i] == i;
+	}
+	os->print("previous frame kept: %s\n", kept ? "yes" : "NO");
+
+	return NULL;
+}
+}
@@ -560,7 +560,11 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 
 			switch (code[ip]) {
 
-				case GDScriptFunction::OPCODE_OPERATOR: {
+				case GDScriptFunction::OPCODE_OPERATOR:
+				case GDScriptFunction::OPCODE_OPERATOR_INT:
+				case GDScriptFunction::OPCODE_OPERATOR_REAL:
+				case GDScriptFunction::OPCODE_OPERATOR_VECTOR2:
+				case GDScriptFunction::OPCODE_OPERATOR_VECTOR3: {
 
 					int op = code[ip + 1];
 					txt += "op ";
@@ -598,7 +602,8 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 					incr += 4;
 
 				} break;
-				case GDScriptFunction::OPCODE_SET_NAMED: {
+				case GDScriptFunction::OPCODE_SET_NAMED:
+				case GDScriptFunction::OPCODE_SET_NAMED_VECTOR: {
 
 					txt += " set_named ";
 					txt += DADDR(1);
@@ -609,16 +614,17 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 					incr += 4;
 
 				} break;
-				case GDScriptFunction::OPCODE_GET_NAMED: {
+				case GDScriptFunction::OPCODE_GET_NAMED:
+				case GDScriptFunction::OPCODE_GET_NAMED_VECTOR: {
 
 					txt += " get_named ";
-					txt += DADDR(3);
+					txt += DADDR(4);
 					txt += "=";
 					txt += DADDR(1);
 					txt += "[\"";
 					txt += func.get_global_name(code[ip + 2]);
 					txt += "\"]";
-					incr += 4;
+					incr += 5;
 
 				} break;
 				case GDScriptFunction::OPCODE_SET_MEMBER: {
@@ -728,18 +734,21 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 				} break;
 
 				case GDScriptFunction::OPCODE_CALL:
-				case GDScriptFunction::OPCODE_CALL_RETURN: {
+				case GDScriptFunction::OPCODE_CALL_RETURN:
+				case GDScriptFunction::OPCODE_CALL_PTRCALL:
+				case GDScriptFunction::OPCODE_CALL_PTRCALL_RETURN: {
 
-					bool ret = code[ip] == GDScriptFunction::OPCODE_CALL_RETURN;
+					bool ret = code[ip] == GDScriptFunction::OPCODE_CALL_RETURN || code[ip] == GDScriptFunction::OPCODE_CALL_PTRCALL_RETURN;
+					bool ptrcall = code[ip] == GDScriptFunction::OPCODE_CALL_PTRCALL || code[ip] == GDScriptFunction::OPCODE_CALL_PTRCALL_RETURN;
 
 					if (ret)
-						txt += " call-ret ";
+						txt += ptrcall ? " call-ptrcall-ret " : " call-ret ";
 					else
-						txt += " call ";
+						txt += ptrcall ? " call-ptrcall " : " call ";
 
 					int argc = code[ip + 1];
 					if (ret) {
-						txt += DADDR(4 + argc) + "=";
+						txt += DADDR(5 + argc) + "=";
 					}
 
 					txt += DADDR(2) + ".";
@@ -749,11 +758,11 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 					for (int i = 0; i < argc; i++) {
 						if (i > 0)
 							txt += ", ";
-						txt += DADDR(4 + i);
+						txt += DADDR(5 + i);
 					}
 					txt += ")";
 
-					incr = 5 + argc;
+					incr = 6 + argc;
 
 				} break;
 				case GDScriptFunction::OPCODE_CALL_BUILT_IN: {
@@ -842,6 +851,17 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 
 					incr = 3;
 				} break;
+				case GDScriptFunction::OPCODE_JUMP_IF_NOT_COMPARE: {
+
+					txt += " jump-if-not ";
+					txt += DADDR(2);
+					txt += " " + Variant::get_operator_name(Variant::Operator(code[ip + 1])) + " ";
+					txt += DADDR(3);
+					txt += " to ";
+					txt += itos(code[ip + 4]);
+
+					incr = 5;
+				} break;
 				case GDScriptFunction::OPCODE_JUMP_TO_DEF_ARGUMENT: {
 
 					txt += " jump-to-default-argument ";
@@ -0,0 +1,570 @@
+/*************************************************************************/
+/*  test_gdscript_bench.cpp                                              */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_gdscript_bench.h"
+
+#include "io/resource_loader.h"
+#include "os/dir_access.h"
+#include "os/file_access.h"
+#include "os/os.h"
+#include "project_settings.h"
+
+#ifdef GDSCRIPT_ENABLED
+
+#include "modules/gdscript/gdscript.h"
+#include "modules/gdscript/gdscript_batch_loader.h"
+#include "modules/gdscript/gdscript_bytecode.h"
+#include "modules/gdscript/gdscript_compiler.h"
+
+namespace TestGDScriptBench {
+
+// Runs the same functions with and without static types, the typed version
+// gets the specialized opcodes for numbers and vectors and calls native
+// methods through ptrcall. Calls and member access go through the inline
+// caches in both, and loops over pool arrays and arrays take the fast paths
+// for iteration and indexing. Transforms and AABBs in Variants come from
+// pools, so once warmed up the transform loop takes no memory from the heap.
+// Loading is timed compiling from tokens (like exported .gdc files) and from
+// the saved compiled code, and yield with a coroutine that is resumed over
+// and over. Constant folding is checked compiling the same function with and
+// without the optimizations. A tree of scripts that extend and preload each
+// other is loaded one at a time, then with the batch loader.
+
+enum {
+	ITERATIONS = 1000000,
+	LOADS = 200,
+	YIELDS = 100000,
+	BATCH_SCRIPTS = 256,
+	BATCH_FUNCTIONS = 16
+};
+
+static const char *typed_source =
+		"extends Reference\n"
+		"\n"
+		"func int_loop(n: int) -> int:\n"
+		"	var total: int = 0\n"
+		"	var i: int = 0\n"
+		"	while i < n:\n"
+		"		total += i * 3 % 7 - (total >> 4)\n"
+		"		i += 1\n"
+		"	return total\n"
+		"\n"
+		"func real_loop(n: int) -> float:\n"
+		"	var total: float = 0.0\n"
+		"	var i: int = 0\n"
+		"	while i < n:\n"
+		"		total += i * 0.5 - total * 0.001\n"
+		"		i += 1\n"
+		"	return total\n"
+		"\n"
+		"func vector_loop(n: int) -> float:\n"
+		"	var v2: Vector2 = Vector2(1, 2)\n"
+		"	var v3: Vector3 = Vector3(1, 2, 3)\n"
+		"	var i: int = 0\n"
+		"	while i < n:\n"
+		"		v2.x += v2.y * 0.001\n"
+		"		v3 = v3 * 0.999 + v3 / 1000.0\n"
+		"		v3.z -= v3.x * 0.001\n"
+		"		i += 1\n"
+		"	return v2.x + v3.x + v3.z\n"
+		"\n"
+		"var value: int = 1\n"
+		"\n"
+		"func add(a: int, b: int) -> int:\n"
+		"	return a + b * value\n"
+		"\n"
+		"func call_loop(n: int) -> int:\n"
+		"	var total: int = 0\n"
+		"	var i: int = 0\n"
+		"	while i < n:\n"
+		"		total = add(total, i) + get_class().length()\n"
+		"		i += 1\n"
+		"	return total\n"
+		"\n"
+		"func member_loop(n: int) -> int:\n"
+		"	var other = get_script().new()\n"
+		"	var resource: Resource = Resource.new()\n"
+		"	resource.resource_name = \"bench\"\n"
+		"	var total: int = 0\n"
+		"	var i: int = 0\n"
+		"	while i < n:\n"
+		"		total += other.value + resource.resource_name.length()\n"
+		"		i += 1\n"
+		"	return total\n"
+		"\n"
+		"func native_loop(n: int) -> int:\n"
+		"	var resource: Resource = Resource.new()\n"
+		"	var total: int = 0\n"
+		"	var i: int = 0\n"
+		"	while i < n:\n"
+		"		resource.set_local_to_scene(i % 3 == 0)\n"
+		"		if resource.is_local_to_scene():\n"
+		"			total += 1\n"
+		"		i += 1\n"
+		"	return total\n"
+		"\n"
+		"func built_in_loop(n: int) -> float:\n"
+		"	var v: Vector2 = Vector2(3, 4)\n"
+		"	var total: float = 0.0\n"
+		"	var i: int = 0\n"
+		"	while i < n:\n"
+		"		total += v.length() + v.normalized().x\n"
+		"		i += 1\n"
+		"	return total\n"
+		"\n"
+		"func packed_loop(n: int) -> float:\n"
+		"	var points: PoolVector2Array = PoolVector2Array()\n"
+		"	var values: PoolRealArray = PoolRealArray()\n"
+		"	var items: Array = []\n"
+		"	points.resize(100)\n"
+		"	values.resize(100)\n"
+		"	items.resize(100)\n"
+		"	for i in range(100):\n"
+		"		points[i] = Vector2(i, i * 0.5)\n"
+		"		values[i] = 0.0\n"
+		"	var total: float = 0.0\n"
+		"	for k in range(n / 100):\n"
+		"		for i in range(100):\n"
+		"			values[i] = values[i] + points[i].x + k\n"
+		"			items[i] = i\n"
+		"		for p in points:\n"
+		"			total += p.y\n"
+		"		for v in values:\n"
+		"			total += v * 0.001\n"
+		"		for item in items:\n"
+		"			total += item\n"
+		"	return total\n"
+		"\n"
+		"func transform_loop(n: int) -> float:\n"
+		"	var t: Transform = Transform()\n"
+		"	var t2: Transform2D = Transform2D(0.5, Vector2(1, 2))\n"
+		"	var box: AABB = AABB(Vector3(), Vector3(1, 1, 1))\n"
+		"	var total: float = 0.0\n"
+		"	var i: int = 0\n"
+		"	while i < n:\n"
+		"		t = t.rotated(Vector3(0, 1, 0), 0.001)\n"
+		"		t2 = t2.translated(Vector2(0.001, 0))\n"
+		"		box = box.expand(t.origin + Vector3(i % 10, 0, 0))\n"
+		"		total += t.basis.x.x + t2.origin.x + box.size.x\n"
+		"		i += 1\n"
+		"	return total\n";
+
+static const char *untyped_source =
+		"extends Reference\n"
+		"\n"
+		"func int_loop(n):\n"
+		"	var total = 0\n"
+		"	var i = 0\n"
+		"	while i < n:\n"
+		"		total += i * 3 % 7 - (total >> 4)\n"
+		"		i += 1\n"
+		"	return total\n"
+		"\n"
+		"func real_loop(n):\n"
+		"	var total = 0.0\n"
+		"	var i = 0\n"
+		"	while i < n:\n"
+		"		total += i * 0.5 - total * 0.001\n"
+		"		i += 1\n"
+		"	return total\n"
+		"\n"
+		"func vector_loop(n):\n"
+		"	var v2 = Vector2(1, 2)\n"
+		"	var v3 = Vector3(1, 2, 3)\n"
+		"	var i = 0\n"
+		"	while i < n:\n"
+		"		v2.x += v2.y * 0.001\n"
+		"		v3 = v3 * 0.999 + v3 / 1000.0\n"
+		"		v3.z -= v3.x * 0.001\n"
+		"		i += 1\n"
+		"	return v2.x + v3.x + v3.z\n"
+		"\n"
+		"var value = 1\n"
+		"\n"
+		"func add(a, b):\n"
+		"	return a + b * value\n"
+		"\n"
+		"func call_loop(n):\n"
+		"	var total = 0\n"
+		"	var i = 0\n"
+		"	while i < n:\n"
+		"		total = add(total, i) + get_class().length()\n"
+		"		i += 1\n"
+		"	return total\n"
+		"\n"
+		"func member_loop(n):\n"
+		"	var other = get_script().new()\n"
+		"	var resource = Resource.new()\n"
+		"	resource.resource_name = \"bench\"\n"
+		"	var total = 0\n"
+		"	var i = 0\n"
+		"	while i < n:\n"
+		"		total += other.value + resource.resource_name.length()\n"
+		"		i += 1\n"
+		"	return total\n"
+		"\n"
+		"func native_loop(n):\n"
+		"	var resource = Resource.new()\n"
+		"	var total = 0\n"
+		"	var i = 0\n"
+		"	while i < n:\n"
+		"		resource.set_local_to_scene(i % 3 == 0)\n"
+		"		if resource.is_local_to_scene():\n"
+		"			total += 1\n"
+		"		i += 1\n"
+		"	return total\n"
+		"\n"
+		"func built_in_loop(n):\n"
+		"	var v = Vector2(3, 4)\n"
+		"	var total = 0.0\n"
+		"	var i = 0\n"
+		"	while i < n:\n"
+		"		total += v.length() + v.normalized().x\n"
+		"		i += 1\n"
+		"	return total\n"
+		"\n"
+		"func packed_loop(n):\n"
+		"	var points = PoolVector2Array()\n"
+		"	var values = PoolRealArray()\n"
+		"	var items = []\n"
+		"	points.resize(100)\n"
+		"	values.resize(100)\n"
+		"	items.resize(100)\n"
+		"	for i in range(100):\n"
+		"		points[i] = Vector2(i, i * 0.5)\n"
+		"		values[i] = 0.0\n"
+		"	var total = 0.0\n"
+		"	for k in range(n / 100):\n"
+		"		for i in range(100):\n"
+		"			values[i] = values[i] + points[i].x + k\n"
+		"			items[i] = i\n"
+		"		for p in points:\n"
+		"			total += p.y\n"
+		"		for v in values:\n"
+		"			total += v * 0.001\n"
+		"		for item in items:\n"
+		"			total += item\n"
+		"	return total\n"
+		"\n"
+		"func transform_loop(n):\n"
+		"	var t = Transform()\n"
+		"	var t2 = Transform2D(0.5, Vector2(1, 2))\n"
+		"	var box = AABB(Vector3(), Vector3(1, 1, 1))\n"
+		"	var total = 0.0\n"
+		"	var i = 0\n"
+		"	while i < n:\n"
+		"		t = t.rotated(Vector3(0, 1, 0), 0.001)\n"
+		"		t2 = t2.translated(Vector2(0.001, 0))\n"
+		"		box = box.expand(t.origin + Vector3(i % 10, 0, 0))\n"
+		"		total += t.basis.x.x + t2.origin.x + box.size.x\n"
+		"		i += 1\n"
+		"	return total\n";
+
+static const char *yield_source =
+		"extends Reference\n"
+		"\n"
+		"func coroutine(n):\n"
+		"	var total = 0\n"
+		"	var name = \"bench\"\n"
+		"	var values = [1, 2, 3]\n"
+		"	var i = 0\n"
+		"	while i < n:\n"
+		"		total += yield() + values.size() + name.length()\n"
+		"		i += 1\n"
+		"	return total\n";
+
+static const char *folding_source =
+		"extends Reference\n"
+		"\n"
+		"const SCALE = 4\n"
+		"\n"
+		"func folding_loop(n):\n"
+		"	var step = 2\n"
+		"	var limit = step * SCALE + 1\n"
+		"	var offset = Vector2(3, 4).length() * sqrt(16.0)\n"
+		"	var verbose = false\n"
+		"	var total = 0.0\n"
+		"	var i = 0\n"
+		"	while i < n:\n"
+		"		if verbose:\n"
+		"			print(i)\n"
+		"		total += i % limit * step + offset\n"
+		"		total = total\n"
+		"		i += 1\n"
+		"	return total\n";
+
+static const char *batch_function_source =
+		"func f%d(a, b):\n"
+		"	var total = 0\n"
+		"	for i in range(a):\n"
+		"		if i % 2 == 0:\n"
+		"			total += i * b\n"
+		"		elif i % 3 == 0:\n"
+		"			total -= int(sqrt(i)) + b\n"
+		"		else:\n"
+		"			total += Vector2(i, b).length()\n"
+		"	var names = [\"a\", \"b\", str(total)]\n"
+		"	return names.size() + total\n"
+		"\n";
+
+// Every script extends its parent in the tree and preloads the script before the parent.
+static Vector<String> _write_batch_scripts(const String &p_dir) {
+
+	DirAccess *da = DirAccess::create_for_path(p_dir);
+	da->make_dir_recursive(p_dir);
+	memdelete(da);
+
+	Vector<String> paths;
+	for (int i = 0; i < BATCH_SCRIPTS; i++) {
+		paths.push_back(p_dir.plus_file("script_" + itos(i) + ".gd"));
+	}
+
+	for (int i = 0; i < BATCH_SCRIPTS; i++) {
+
+		String source;
+		if (i == 0) {
+			source += "extends Reference\n\n";
+		} else {
+			int parent = (i - 1) / 4;
+			source += "extends \"" + paths[parent] + "\"\n\n";
+			if (parent > 0) {
+				source += "const Other = preload(\"" + paths[parent - 1] + "\")\n\n";
+			}
+		}
+		for (int j = 0; j < BATCH_FUNCTIONS; j++) {
+			source += String(batch_function_source).replace("%d", itos(i) + "_" + itos(j));
+		}
+
+		FileAccess *f = FileAccess::open(paths[i], FileAccess::WRITE);
+		ERR_FAIL_COND_V(!f, Vector<String>());
+		f->store_string(source);
+		memdelete(f);
+	}
+
+	return paths;
+}
+
+static void _remove_batch_scripts(const String &p_dir, const Vector<String> &p_paths) {
+
+	DirAccess *da = DirAccess::create_for_path(p_dir);
+	for (int i = 0; i < p_paths.size(); i++) {
+		da->remove(p_paths[i]);
+	}
+	da->remove(p_dir);
+	memdelete(da);
+}
+
+static bool _all_valid(const Vector<Ref<GDScript> > &p_scripts) {
+
+	for (int i = 0; i < p_scripts.size(); i++) {
+		if (p_scripts[i].is_null() || !p_scripts[i]->is_valid()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static Ref<Reference> _instance(const String &p_source) {
+
+	Ref<GDScript> script;
+	script.instance();
+	script->set_source_code(p_source);
+	Error err = script->reload();
+	ERR_FAIL_COND_V(err != OK, Ref<Reference>());
+
+	Ref<Reference> instance;
+	instance.instance();
+	instance->set_script(script.get_ref_ptr());
+	return instance;
+}
+
+static Ref<GDScript> _load_compiled(const Vector<uint8_t> &p_buffer, bool &r_from_compiled) {
+
+	Ref<GDScript> script;
+	script.instance();
+
+	Vector<uint8_t> tokens;
+	r_from_compiled = GDScriptBytecode::load_buffer(p_buffer, script.ptr(), tokens) == OK;
+	if (r_from_compiled) {
+		return script;
+	}
+
+	GDScriptParser parser;
+	ERR_FAIL_COND_V(parser.parse_bytecode(tokens, "", "") != OK, Ref<GDScript>());
+	GDScriptCompiler compiler;
+	ERR_FAIL_COND_V(compiler.compile(&parser, script.ptr()) != OK, Ref<GDScript>());
+	return script;
+}
+
+static uint64_t _time_loads(const Vector<uint8_t> &p_buffer) {
+
+	bool from_compiled;
+	uint64_t from = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < LOADS; i++) {
+		_load_compiled(p_buffer, from_compiled);
+	}
+	return OS::get_singleton()->get_ticks_usec() - from;
+}
+
+static uint64_t _run_yields(Ref<Reference> p_instance, Variant &r_result) {
+
+	uint64_t from = OS::get_singleton()->get_ticks_usec();
+	r_result = p_instance->call("coroutine", YIELDS);
+	for (int i = 0; i < YIELDS; i++) {
+		Ref<GDScriptFunctionState> state = r_result;
+		ERR_FAIL_COND_V(state.is_null(), 0);
+		r_result = state->resume(i);
+	}
+	return OS::get_singleton()->get_ticks_usec() - from;
+}
+
+static uint64_t _run(Ref<Reference> p_instance, const StringName &p_method, Variant &r_result) {
+
+	uint64_t from = OS::get_singleton()->get_ticks_usec();
+	r_result = p_instance->call(p_method, ITERATIONS);
+	return OS::get_singleton()->get_ticks_usec() - from;
+}
+
+static int _code_size(Ref<Reference> p_instance, const StringName &p_method) {
+
+	Ref<GDScript> script = p_instance->get_script();
+	ERR_FAIL_COND_V(script.is_null() || !script->get_member_functions().has(p_method), 0);
+	return script->get_member_functions()[p_method]->get_code_size();
+}
+
+MainLoop *test() {
+
+	Ref<Reference> typed = _instance(typed_source);
+	Ref<Reference> untyped = _instance(untyped_source);
+	ERR_FAIL_COND_V(typed.is_null() || untyped.is_null(), NULL);
+
+	Vector<uint8_t> tokens = GDScriptTokenizerBuffer::parse_code_string(typed_source);
+	Vector<uint8_t> compiled = GDScriptBytecode::make_buffer(typed->get_script(), tokens);
+
+	bool from_compiled;
+	Ref<Reference> loaded;
+	loaded.instance();
+	loaded->set_script(_load_compiled(compiled, from_compiled).get_ref_ptr());
+
+	OS::get_singleton()->print("\n\nGDScript, %d iterations per function\n", ITERATIONS);
+
+	static const char *methods[] = { "int_loop", "real_loop", "vector_loop", "call_loop", "member_loop", "native_loop", "built_in_loop", "packed_loop", "transform_loop", NULL };
+
+	for (int i = 0; methods[i]; i++) {
+
+		Variant typed_result, untyped_result, loaded_result;
+		uint64_t untyped_usec = _run(untyped, methods[i], untyped_result);
+		uint64_t typed_usec = _run(typed, methods[i], typed_result);
+		_run(loaded, methods[i], loaded_result);
+
+		OS::get_singleton()->print("%s: %d msec (untyped) %d msec (typed), results match: %s\n", methods[i], int(untyped_usec / 1000), int(typed_usec / 1000), typed_result == untyped_result && typed_result == loaded_result ? "yes" : "NO");
+	}
+
+	uint64_t pool_allocs, pool_allocs_before;
+	uint32_t heap_pages, heap_pages_before;
+	Variant::get_allocator_stats(&pool_allocs_before, &heap_pages_before);
+	Variant transform_result;
+	_run(untyped, "transform_loop", transform_result);
+	Variant::get_allocator_stats(&pool_allocs, &heap_pages);
+
+	OS::get_singleton()->print("\ntransform_loop: %d transforms allocated from pools, %d pages taken from the heap\n", int(pool_allocs - pool_allocs_before), int(heap_pages - heap_pages_before));
+
+	Ref<Reference> coroutine = _instance(yield_source);
+	ERR_FAIL_COND_V(coroutine.is_null(), NULL);
+
+	Variant yield_result;
+	uint32_t frames_allocated = GDScriptLanguage::get_singleton()->get_frames_allocated();
+	uint64_t yield_usec = _run_yields(coroutine, yield_result);
+	int64_t expected = int64_t(YIELDS) * (YIELDS - 1) / 2 + int64_t(YIELDS) * 8;
+
+	OS::get_singleton()->print("\n%d yields: %d msec, frames allocated: %d, result matches: %s\n", YIELDS, int(yield_usec / 1000), int(GDScriptLanguage::get_singleton()->get_frames_allocated() - frames_allocated), yield_result == Variant(expected) ? "yes" : "NO");
+
+	bool optimize = GLOBAL_GET("debug/gdscript/compiler/optimize");
+	ProjectSettings::get_singleton()->set("debug/gdscript/compiler/optimize", false);
+	Ref<Reference> unoptimized = _instance(folding_source);
+	ProjectSettings::get_singleton()->set("debug/gdscript/compiler/optimize", true);
+	Ref<Reference> optimized = _instance(folding_source);
+	ProjectSettings::get_singleton()->set("debug/gdscript/compiler/optimize", optimize);
+	ERR_FAIL_COND_V(unoptimized.is_null() || optimized.is_null(), NULL);
+
+	Variant unoptimized_result, optimized_result;
+	uint64_t unoptimized_usec = _run(unoptimized, "folding_loop", unoptimized_result);
+	uint64_t optimized_usec = _run(optimized, "folding_loop", optimized_result);
+
+	OS::get_singleton()->print("\nfolding_loop: %d msec (unoptimized) %d msec (optimized), code size: %d -> %d, results match: %s\n", int(unoptimized_usec / 1000), int(optimized_usec / 1000), _code_size(unoptimized, "folding_loop"), _code_size(optimized, "folding_loop"), unoptimized_result == optimized_result ? "yes" : "NO");
+
+	String batch_dir = OS::get_singleton()->get_user_data_dir().plus_file("gdscript_bench_batch");
+	Vector<String> batch_paths = _write_batch_scripts(batch_dir);
+	ERR_FAIL_COND_V(batch_paths.empty(), NULL);
+
+	Vector<Ref<GDScript> > serial_scripts;
+	uint64_t serial_from = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < batch_paths.size(); i++) {
+		serial_scripts.push_back(ResourceLoader::load(batch_paths[i]));
+	}
+	uint64_t serial_usec = OS::get_singleton()->get_ticks_usec() - serial_from;
+	bool serial_valid = _all_valid(serial_scripts);
+	serial_scripts.clear();
+
+	GDScriptBatchLoader loader;
+	GDScriptBatchLoader::Stats stats;
+	uint64_t batch_from = OS::get_singleton()->get_ticks_usec();
+	loader.load(batch_paths, &stats);
+	uint64_t batch_usec = OS::get_singleton()->get_ticks_usec() - batch_from;
+
+	Vector<Ref<GDScript> > batch_scripts;
+	for (int i = 0; i < loader.get_script_count(); i++) {
+		batch_scripts.push_back(loader.get_script(i));
+	}
+	bool batch_valid = _all_valid(batch_scripts) && stats.parallel == BATCH_SCRIPTS;
+	batch_scripts.clear();
+	loader.clear();
+	_remove_batch_scripts(batch_dir, batch_paths);
+
+	OS::get_singleton()->print("\nLoading %d scripts: %d msec (one at a time) %d msec (batch, %d threads), all loaded: %s\n", BATCH_SCRIPTS, int(serial_usec / 1000), int(batch_usec / 1000), ThreadWorkPool::get_singleton()->get_thread_count(), serial_valid && batch_valid ? "yes" : "NO");
+
+	OS::get_singleton()->print("\nCompiled code loaded: %s\n", from_compiled ? "yes" : "NO");
+	OS::get_singleton()->print("Loading %d times: %d msec (tokens) %d msec (compiled)\n", LOADS, int(_time_loads(tokens) / 1000), int(_time_loads(compiled) / 1000));
+
+	return NULL;
+}
+} // namespace TestGDScriptBench
+
+#else
+
+namespace TestGDScriptBench {
+
+MainLoop *test() {
+
+	return NULL;
+}
+} // namespace TestGDScriptBench
+
+#endif
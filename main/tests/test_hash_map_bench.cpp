@@ -0,0 +1,206 @@
+/*************************************************************************/
+/*  test_hash_map_bench.cpp                                              */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_hash_map_bench.h"
+
+#include "core/hash_map.h"
+#include "core/map.h"
+#include "core/math/math_funcs.h"
+#include "core/oa_hash_map.h"
+#include "core/ordered_hash_map.h"
+#include "core/os/os.h"
+
+namespace TestHashMapBench {
+
+// Compares the maps of core for insertion, lookup, erasing and iteration, with
+// integer keys at several sizes and with StringName keys at the sizes of ClassDB.
+
+struct Timings {
+
+	uint64_t insert;
+	uint64_t lookup;
+	uint64_t miss;
+	uint64_t iterate;
+	uint64_t erase;
+	uint64_t checksum; // to check the maps agree, and so the loops aren't optimized away
+};
+
+// HashMap and OAHashMap share the same API.
+
+template <class M, class K>
+static void _insert(M &p_map, const K &p_key, int p_value) { p_map.set(p_key, p_value); }
+template <class M, class K>
+static const int *_find(const M &p_map, const K &p_key) { return p_map.getptr(p_key); }
+template <class M, class K>
+static void _erase(M &p_map, const K &p_key) { p_map.erase(p_key); }
+template <class M, class K>
+static uint64_t _iterate(const M &p_map, const K *) {
+	uint64_t sum = 0;
+	for (const K *E = p_map.next(NULL); E; E = p_map.next(E)) {
+		sum += *p_map.getptr(*E);
+	}
+	return sum;
+}
+
+template <class K>
+static void _insert(OrderedHashMap<K, int> &p_map, const K &p_key, int p_value) { p_map.insert(p_key, p_value); }
+template <class K>
+static const int *_find(const OrderedHashMap<K, int> &p_map, const K &p_key) {
+	typename OrderedHashMap<K, int>::ConstElement E = p_map.find(p_key);
+	return E ? &E.get() : NULL;
+}
+template <class K>
+static uint64_t _iterate(const OrderedHashMap<K, int> &p_map, const K *) {
+	uint64_t sum = 0;
+	for (typename OrderedHashMap<K, int>::ConstElement E = p_map.front(); E; E = E.next()) {
+		sum += E.get();
+	}
+	return sum;
+}
+
+template <class K>
+static void _insert(Map<K, int> &p_map, const K &p_key, int p_value) { p_map.insert(p_key, p_value); }
+template <class K>
+static const int *_find(const Map<K, int> &p_map, const K &p_key) {
+	const typename Map<K, int>::Element *E = p_map.find(p_key);
+	return E ? &E->get() : NULL;
+}
+template <class K>
+static uint64_t _iterate(const Map<K, int> &p_map, const K *) {
+	uint64_t sum = 0;
+	for (const typename Map<K, int>::Element *E = p_map.front(); E; E = E->next()) {
+		sum += E->get();
+	}
+	return sum;
+}
+
+template <class M, class K>
+static Timings _run(const Vector<K> &p_keys, const Vector<K> &p_missing) {
+
+	Timings t;
+	t.checksum = 0;
+	M map;
+	OS *os = OS::get_singleton();
+
+	uint64_t begin = os->get_ticks_usec();
+	for (int i = 0; i < p_keys.size(); i++) {
+		_insert(map, p_keys[i], i);
+	}
+	t.insert = os->get_ticks_usec() - begin;
+
+	begin = os->get_ticks_usec();
+	for (int i = 0; i < p_keys.size(); i++) {
+		const int *v = _find(map, p_keys[i]);
+		t.checksum += v ? *v : 0;
+	}
+	t.lookup = os->get_ticks_usec() - begin;
+
+	begin = os->get_ticks_usec();
+	for (int i = 0; i < p_missing.size(); i++) {
+		t.checksum += _find(map, p_missing[i]) ? 1 : 0;
+	}
+	t.miss = os->get_ticks_usec() - begin;
+
+	begin = os->get_ticks_usec();
+	t.checksum += _iterate(map, (const K *)NULL);
+	t.iterate = os->get_ticks_usec() - begin;
+
+	begin = os->get_ticks_usec();
+	for (int i = 0; i < p_keys.size(); i++) {
+		_erase(map, p_keys[i]);
+	}
+	t.erase = os->get_ticks_usec() - begin;
+
+	return t;
+}
+
+template <class K>
+static void _compare(const char *p_key_name, const Vector<K> &p_keys, const Vector<K> &p_missing) {
+
+	OS *os = OS::get_singleton();
+	os->print("\n%s keys, %d entries (usec)\n", p_key_name, p_keys.size());
+	os->print("%-16s %10s %10s %10s %10s %10s\n", "", "insert", "lookup", "miss", "iterate", "erase");
+
+	Timings results[4] = {
+		_run<HashMap<K, int> >(p_keys, p_missing),
+		_run<OAHashMap<K, int> >(p_keys, p_missing),
+		_run<OrderedHashMap<K, int> >(p_keys, p_missing),
+		_run<Map<K, int> >(p_keys, p_missing),
+	};
+	const char *names[4] = { "HashMap", "OAHashMap", "OrderedHashMap", "Map" };
+
+	for (int i = 0; i < 4; i++) {
+		const Timings &t = results[i];
+		os->print("%-16s %10d %10d %10d %10d %10d%s\n", names[i], (int)t.insert, (int)t.lookup, (int)t.miss, (int)t.iterate, (int)t.erase, t.checksum == results[0].checksum ? "" : "  MISMATCH");
+	}
+}
+
+static void _make_int_keys(int p_count, uint64_t p_seed, Vector<uint32_t> &r_keys) {
+
+	r_keys.resize(p_count);
+	for (int i = 0; i < p_count; i++) {
+		// odd keys are inserted, even ones are used for missed lookups
+		r_keys.write[i] = Math::rand_from_seed(&p_seed) | 1;
+	}
+}
+
+MainLoop *test() {
+
+	OS::get_singleton()->print("\n\nHashMap vs OAHashMap vs OrderedHashMap vs Map\n");
+
+	for (int count = 1000; count <= 1000000; count *= 10) {
+
+		Vector<uint32_t> keys;
+		Vector<uint32_t> missing;
+		_make_int_keys(count, 1234, keys);
+		_make_int_keys(count, 4321, missing);
+		for (int i = 0; i < missing.size(); i++) {
+			missing.write[i] &= ~1;
+		}
+
+		_compare("uint32_t", keys, missing);
+	}
+
+	// method and property names, like ClassDB and Node groups look up
+	for (int count = 1000; count <= 10000; count *= 10) {
+
+		Vector<StringName> keys;
+		Vector<StringName> missing;
+		for (int i = 0; i < count; i++) {
+			keys.push_back(StringName("method_" + itos(i)));
+			missing.push_back(StringName("missing_" + itos(i)));
+		}
+
+		_compare("StringName", keys, missing);
+	}
+
+	return NULL;
+}
+} // namespace TestHashMapBench
@@ -0,0 +1,170 @@
+/*************************************************************************/
+/*  test_local_vector_bench.cpp                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_local_vector_bench.h"
+
+#include "core/dvector.h"
+#include "core/local_vector.h"
+#include "core/math/vector3.h"
+#include "core/os/os.h"
+#include "core/ustring.h"
+#include "core/vector.h"
+
+namespace TestLocalVectorBench {
+
+// Buffers used the way the servers use them: filled with push_back, written and
+// read by index, then cleared and filled again.
+
+enum {
+	ELEMENTS = 100000,
+	ROUNDS = 100
+};
+
+static uint64_t _run_vector() {
+
+	uint64_t total = 0;
+	Vector<Vector3> v;
+	for (int r = 0; r < ROUNDS; r++) {
+		v.clear();
+		for (int i = 0; i < ELEMENTS; i++) {
+			v.push_back(Vector3(i, r, 0));
+		}
+		for (int i = 0; i < ELEMENTS; i++) {
+			v.write[i].z = v[i].x + v[i].y;
+		}
+		for (int i = 0; i < ELEMENTS; i++) {
+			total += v[i].z;
+		}
+	}
+	return total;
+}
+
+static uint64_t _run_pool_vector() {
+
+	uint64_t total = 0;
+	PoolVector<Vector3> v;
+	for (int r = 0; r < ROUNDS; r++) {
+		v.resize(0);
+		for (int i = 0; i < ELEMENTS; i++) {
+			v.push_back(Vector3(i, r, 0));
+		}
+		{
+			PoolVector<Vector3>::Write w = v.write();
+			for (int i = 0; i < ELEMENTS; i++) {
+				w[i].z = w[i].x + w[i].y;
+			}
+		}
+		PoolVector<Vector3>::Read rd = v.read();
+		for (int i = 0; i < ELEMENTS; i++) {
+			total += rd[i].z;
+		}
+	}
+	return total;
+}
+
+static uint64_t _run_local_vector() {
+
+	uint64_t total = 0;
+	LocalVector<Vector3> v;
+	for (int r = 0; r < ROUNDS; r++) {
+		v.clear();
+		for (int i = 0; i < ELEMENTS; i++) {
+			v.push_back(Vector3(i, r, 0));
+		}
+		for (int i = 0; i < ELEMENTS; i++) {
+			v[i].z = v[i].x + v[i].y;
+		}
+		for (int i = 0; i < ELEMENTS; i++) {
+			total += v[i].z;
+		}
+	}
+	return total;
+}
+
+static bool _check_operations() {
+
+	LocalVector<String> v;
+	Vector<String> ref;
+	for (int i = 0; i < 100; i++) {
+		v.push_back(itos(i));
+		ref.push_back(itos(i));
+	}
+	for (int i = 0; i < 20; i++) {
+		v.insert(i * 3, "i" + itos(i));
+		ref.insert(i * 3, "i" + itos(i));
+		v.remove(i * 2 + 1);
+		ref.remove(i * 2 + 1);
+	}
+	v.erase("50");
+	ref.erase("50");
+	v.remove_unordered(0);
+	ref.write[0] = ref[ref.size() - 1];
+	ref.remove(ref.size() - 1);
+
+	LocalVector<String> copy = v;
+	v.clear();
+	Vector<String> converted = copy;
+
+	if (!v.empty() || converted.size() != ref.size()) {
+		return false;
+	}
+	for (int i = 0; i < ref.size(); i++) {
+		if (converted[i] != ref[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+MainLoop *test() {
+
+	OS *os = OS::get_singleton();
+
+	os->print("\n\nLocal vector benchmark, %d rounds of %d elements\n", ROUNDS, ELEMENTS);
+
+	uint64_t begin = os->get_ticks_usec();
+	uint64_t vector_result = _run_vector();
+	os->print("Vector: %d msec\n", int((os->get_ticks_usec() - begin) / 1000));
+
+	begin = os->get_ticks_usec();
+	uint64_t pool_vector_result = _run_pool_vector();
+	os->print("PoolVector: %d msec\n", int((os->get_ticks_usec() - begin) / 1000));
+
+	begin = os->get_ticks_usec();
+	uint64_t local_vector_result = _run_local_vector();
+	os->print("LocalVector: %d msec\n", int((os->get_ticks_usec() - begin) / 1000));
+
+	bool match = vector_result == pool_vector_result && vector_result == local_vector_result;
+	os->print("results match: %s\n", match ? "yes" : "NO");
+	os->print("operations match Vector: %s\n", _check_operations() ? "yes" : "NO");
+
+	return NULL;
+}
+}
@@ -33,15 +33,22 @@
 
 #ifdef DEBUG_ENABLED
 
+#include "test_bvh.h"
+#include "test_frame_arena_bench.h"
 #include "test_gdscript.h"
+#include "test_gdscript_bench.h"
 #include "test_gui.h"
+#include "test_hash_map_bench.h"
 #include "test_image.h"
 #include "test_io.h"
+#include "test_local_vector_bench.h"
 #include "test_math.h"
+#include "test_memory_bench.h"
 #include "test_oa_hash_map.h"
 #include "test_ordered_hash_map.h"
 #include "test_physics.h"
 #include "test_physics_2d.h"
+#include "test_pool_vector_bench.h"
 #include "test_render.h"
 #include "test_shader_lang.h"
 #include "test_string.h"
@@ -62,8 +69,15 @@ const char **tests_get_names() {
 		"gd_parser",
 		"gd_compiler",
 		"gd_bytecode",
+		"gd_bench",
 		"image",
 		"ordered_hash_map",
+		"bvh",
+		"hash_map_bench",
+		"pool_vector_bench",
+		"memory_bench",
+		"frame_arena_bench",
+		"local_vector_bench",
 		NULL
 	};
 
@@ -139,6 +153,11 @@ MainLoop *test_main(String p_test, const List<String> &p_args) {
 		return TestGDScript::test(TestGDScript::TEST_BYTECODE);
 	}
 
+	if (p_test == "gd_bench") {
+
+		return TestGDScriptBench::test();
+	}
+
 	if (p_test == "image") {
 
 		return TestImage::test();
@@ -149,6 +168,36 @@ MainLoop *test_main(String p_test, const List<String> &p_args) {
 		return TestOrderedHashMap::test();
 	}
 
+	if (p_test == "bvh") {
+
+		return TestBVH::test();
+	}
+
+	if (p_test == "hash_map_bench") {
+
+		return TestHashMapBench::test();
+	}
+
+	if (p_test == "pool_vector_bench") {
+
+		return TestPoolVectorBench::test();
+	}
+
+	if (p_test == "memory_bench") {
+
+		return TestMemoryBench::test();
+	}
+
+	if (p_test == "frame_arena_bench") {
+
+		return TestFrameArenaBench::test();
+	}
+
+	if (p_test == "local_vector_bench") {
+
+		return TestLocalVectorBench::test();
+	}
+
 	return NULL;
 }
 
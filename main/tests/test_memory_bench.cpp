@@ -0,0 +1,210 @@
+/*************************************************************************/
+/*  test_memory_bench.cpp                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_memory_bench.h"
+
+#include "core/dictionary.h"
+#include "core/list.h"
+#include "core/map.h"
+#include "core/os/memory.h"
+#include "core/os/os.h"
+#include "core/os/small_allocator.h"
+#include "core/os/thread.h"
+#include "scene/main/node.h"
+#include "scene/resources/packed_scene.h"
+
+#ifdef GDSCRIPT_ENABLED
+#include "modules/gdscript/gdscript.h"
+#endif
+
+namespace TestMemoryBench {
+
+// Workloads made of many small, short lived allocations, to compare builds with
+// and without small_allocator=yes.
+
+enum {
+	CONTAINER_ITERATIONS = 2000,
+	SCENE_NODES = 10,
+	SCENE_INSTANCES = 500,
+	SCRIPT_ITERATIONS = 100000,
+	MAX_THREADS = 8
+};
+
+static uint64_t _churn_containers() {
+
+	uint64_t total = 0;
+
+	for (int i = 0; i < CONTAINER_ITERATIONS; i++) {
+
+		List<String> list;
+		Map<int, Variant> map;
+		Dictionary dict;
+
+		for (int j = 0; j < 64; j++) {
+			list.push_back(itos(j));
+			map[j] = Vector2(i, j);
+			dict[j] = list.back()->get();
+		}
+
+		while (list.size()) {
+			total += list.front()->get().length();
+			list.pop_front();
+		}
+		for (int j = 0; j < 64; j += 2) {
+			map.erase(j);
+		}
+		total += map.size() + dict.size();
+	}
+
+	return total;
+}
+
+struct ThreadData {
+	uint64_t result;
+};
+
+static void _thread_func(void *p_userdata) {
+
+	((ThreadData *)p_userdata)->result = _churn_containers();
+}
+
+static Node *_make_scene(int p_depth) {
+
+	Node *node = memnew(Node);
+	node->add_to_group("bench", true);
+	if (p_depth > 0) {
+		for (int i = 0; i < SCENE_NODES; i++) {
+			Node *child = _make_scene(p_depth - 1);
+			child->set_name("node_" + itos(i));
+			node->add_child(child);
+		}
+	}
+	return node;
+}
+
+static void _set_owner(Node *p_node, Node *p_owner) {
+
+	for (int i = 0; i < p_node->get_child_count(); i++) {
+		p_node->get_child(i)->set_owner(p_owner);
+		_set_owner(p_node->get_child(i), p_owner);
+	}
+}
+
+#ifdef GDSCRIPT_ENABLED
+static const char *script_source =
+		"extends Reference\n"
+		"\n"
+		"func churn(n):\n"
+		"	var total = 0\n"
+		"	for i in range(n):\n"
+		"		var d = { \"name\": \"item\" + str(i), \"value\": i, \"list\": [i, i + 1, i + 2] }\n"
+		"		var a = []\n"
+		"		for j in range(4):\n"
+		"			a.append(str(j) + d.name)\n"
+		"		total += a.size() + d.list.size()\n"
+		"	return total\n";
+#endif
+
+MainLoop *test() {
+
+	OS *os = OS::get_singleton();
+
+#ifdef SMALL_ALLOCATOR_ENABLED
+	os->print("\n\nMemory benchmark, with the small allocator\n");
+#else
+	os->print("\n\nMemory benchmark, with malloc\n");
+#endif
+
+	uint64_t mem_before = Memory::get_mem_usage();
+
+	uint64_t begin = os->get_ticks_usec();
+	uint64_t result = _churn_containers();
+	os->print("containers: %d msec (result %d)\n", int((os->get_ticks_usec() - begin) / 1000), int(result));
+
+	for (int thread_count = 2; thread_count <= MAX_THREADS; thread_count *= 2) {
+
+		ThreadData data[MAX_THREADS];
+		Thread *threads[MAX_THREADS];
+
+		begin = os->get_ticks_usec();
+		for (int i = 0; i < thread_count; i++) {
+			threads[i] = Thread::create(_thread_func, &data[i]);
+		}
+		bool results_match = true;
+		for (int i = 0; i < thread_count; i++) {
+			Thread::wait_to_finish(threads[i]);
+			memdelete(threads[i]);
+			results_match = results_match && data[i].result == result;
+		}
+		os->print("containers, %d threads: %d msec, results match: %s\n", thread_count, int((os->get_ticks_usec() - begin) / 1000), results_match ? "yes" : "NO");
+	}
+
+	{
+		Node *root = _make_scene(2);
+		_set_owner(root, root);
+		Ref<PackedScene> scene;
+		scene.instance();
+		Error err = scene->pack(root);
+		memdelete(root);
+		ERR_FAIL_COND_V(err != OK, NULL);
+
+		begin = os->get_ticks_usec();
+		for (int i = 0; i < SCENE_INSTANCES; i++) {
+			Node *instance = scene->instance();
+			ERR_FAIL_COND_V(!instance, NULL);
+			memdelete(instance);
+		}
+		os->print("scene instancing: %d msec (%d scenes of %d nodes)\n", int((os->get_ticks_usec() - begin) / 1000), SCENE_INSTANCES, 1 + SCENE_NODES + SCENE_NODES * SCENE_NODES);
+	}
+
+#ifdef GDSCRIPT_ENABLED
+	{
+		Ref<GDScript> script;
+		script.instance();
+		script->set_source_code(script_source);
+		ERR_FAIL_COND_V(script->reload() != OK, NULL);
+		Ref<Reference> instance;
+		instance.instance();
+		instance->set_script(script.get_ref_ptr());
+
+		begin = os->get_ticks_usec();
+		Variant script_result = instance->call("churn", SCRIPT_ITERATIONS);
+		os->print("gdscript: %d msec (result %s)\n", int((os->get_ticks_usec() - begin) / 1000), String(script_result).utf8().get_data());
+	}
+#endif
+
+	os->print("memory in use: %d bytes before, %d bytes after\n", int(mem_before), int(Memory::get_mem_usage()));
+#ifdef SMALL_ALLOCATOR_ENABLED
+	os->print("small allocator spans: %d (%d KiB)\n", SmallAllocator::get_span_count(), SmallAllocator::get_span_count() * (SmallAllocator::SPAN_SIZE / 1024));
+#endif
+
+	return NULL;
+}
+} // namespace TestMemoryBench
@@ -0,0 +1,136 @@
+/*************************************************************************/
+/*  test_pool_vector_bench.cpp                                           */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_pool_vector_bench.h"
+
+#include "core/dvector.h"
+#include "core/math/vector3.h"
+#include "core/os/os.h"
+#include "core/os/thread.h"
+
+namespace TestPoolVectorBench {
+
+// Threads sharing vertex arrays, like meshes handed from the scene to the servers:
+// every iteration takes a reference to a shared array and reads part of it, and
+// builds a small array of its own that is copied once before it's released.
+
+enum {
+	VERTEX_COUNT = 4096,
+	SHARED_ARRAYS = 8,
+	READ_COUNT = 64,
+	BUILD_COUNT = 32,
+	ITERATIONS = 200000,
+	MAX_THREADS = 8
+};
+
+struct ThreadData {
+
+	const PoolVector<Vector3> *shared;
+	real_t sum;
+};
+
+static void _thread_func(void *p_userdata) {
+
+	ThreadData *td = (ThreadData *)p_userdata;
+	real_t sum = 0;
+
+	for (int i = 0; i < ITERATIONS; i++) {
+
+		PoolVector<Vector3> vertices = td->shared[i % SHARED_ARRAYS];
+		{
+			PoolVector<Vector3>::Read r = vertices.read();
+			int from = (i * READ_COUNT) % (VERTEX_COUNT - READ_COUNT);
+			for (int j = 0; j < READ_COUNT; j++) {
+				sum += r[from + j].x;
+			}
+		}
+
+		if (i % 4 == 0) {
+			PoolVector<Vector3> built;
+			built.resize(BUILD_COUNT);
+			{
+				PoolVector<Vector3>::Write w = built.write();
+				for (int j = 0; j < BUILD_COUNT; j++) {
+					w[j] = Vector3(j, i, 0);
+				}
+			}
+			PoolVector<Vector3> handed = built;
+			sum += handed[BUILD_COUNT - 1].x;
+		}
+	}
+
+	td->sum = sum;
+}
+
+MainLoop *test() {
+
+	OS::get_singleton()->print("\n\nPoolVector contention, %d iterations per thread\n", ITERATIONS);
+
+	PoolVector<Vector3> shared[SHARED_ARRAYS];
+	for (int i = 0; i < SHARED_ARRAYS; i++) {
+		shared[i].resize(VERTEX_COUNT);
+		PoolVector<Vector3>::Write w = shared[i].write();
+		for (int j = 0; j < VERTEX_COUNT; j++) {
+			w[j] = Vector3(j % 16, i, 0);
+		}
+	}
+
+	uint32_t allocs_before = MemoryPool::allocs_used;
+
+	for (int thread_count = 1; thread_count <= MAX_THREADS; thread_count *= 2) {
+
+		ThreadData data[MAX_THREADS];
+		Thread *threads[MAX_THREADS];
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < thread_count; i++) {
+			data[i].shared = shared;
+			data[i].sum = 0;
+			threads[i] = Thread::create(_thread_func, &data[i]);
+		}
+		for (int i = 0; i < thread_count; i++) {
+			Thread::wait_to_finish(threads[i]);
+			memdelete(threads[i]);
+		}
+		uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+
+		bool sums_match = true;
+		for (int i = 1; i < thread_count; i++) {
+			sums_match = sums_match && data[i].sum == data[0].sum;
+		}
+
+		OS::get_singleton()->print("%d threads: %d msec, %d nsec per iteration and thread, results match: %s\n", thread_count, int(elapsed / 1000), int(elapsed * 1000 / (uint64_t(ITERATIONS) * thread_count)), sums_match ? "yes" : "NO");
+	}
+
+	OS::get_singleton()->print("allocs in use after the threads: %d (%d before)\n", MemoryPool::allocs_used, allocs_before);
+
+	return NULL;
+}
+} // namespace TestPoolVectorBench
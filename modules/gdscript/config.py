@@ -2,7 +2,7 @@ def can_build(env, platform):
     return True
 
 def configure(env):
-    pass
+    env.use_ptrcall = True
 
 def get_doc_classes():
     return [
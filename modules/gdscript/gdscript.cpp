@@ -31,6 +31,8 @@
 #include "gdscript.h"
 
 #include "engine.h"
+#include "gdscript_batch_loader.h"
+#include "gdscript_bytecode.h"
 #include "gdscript_compiler.h"
 #include "global_constants.h"
 #include "io/file_access_encrypted.h"
@@ -724,9 +726,7 @@ Vector<uint8_t> GDScript::get_as_byte_code() const {
 	return tokenizer.parse_code_string(source);
 };
 
-Error GDScript::load_byte_code(const String &p_path) {
-
-	Vector<uint8_t> bytecode;
+Error GDScript::read_byte_code(const String &p_path, Vector<uint8_t> &r_buffer) {
 
 	if (p_path.ends_with("gde")) {
 
@@ -741,14 +741,25 @@ Error GDScript::load_byte_code(const String &p_path) {
 		}
 		Error err = fae->open_and_parse(fa, key, FileAccessEncrypted::MODE_READ);
 		ERR_FAIL_COND_V(err, err);
-		bytecode.resize(fae->get_len());
-		fae->get_buffer(bytecode.ptrw(), bytecode.size());
+		r_buffer.resize(fae->get_len());
+		fae->get_buffer(r_buffer.ptrw(), r_buffer.size());
 		memdelete(fae);
 	} else {
 
-		bytecode = FileAccess::get_file_as_array(p_path);
+		r_buffer = FileAccess::get_file_as_array(p_path);
+	}
+	ERR_FAIL_COND_V(r_buffer.size() == 0, ERR_PARSE_ERROR);
+
+	return OK;
+}
+
+Error GDScript::load_byte_code(const String &p_path) {
+
+	Vector<uint8_t> bytecode;
+	Error err = read_byte_code(p_path, bytecode);
+	if (err != OK) {
+		return err;
 	}
-	ERR_FAIL_COND_V(bytecode.size() == 0, ERR_PARSE_ERROR);
 	path = p_path;
 
 	String basedir = path;
@@ -760,8 +771,23 @@ Error GDScript::load_byte_code(const String &p_path) {
 		basedir = basedir.get_base_dir();
 
 	valid = false;
+
+	// Exported with its compiled code, otherwise compiled from the tokens below
+	Vector<uint8_t> tokens;
+	if (GDScriptBytecode::load_buffer(bytecode, this, tokens) == OK) {
+
+		valid = true;
+
+		for (Map<StringName, Ref<GDScript> >::Element *E = subclasses.front(); E; E = E->next()) {
+
+			_set_subclass_path(E->get(), path);
+		}
+
+		return OK;
+	}
+
 	GDScriptParser parser;
-	Error err = parser.parse_bytecode(bytecode, basedir, get_path());
+	err = parser.parse_bytecode(tokens, basedir, get_path());
 	if (err) {
 		_err_print_error("GDScript::load_byte_code", path.empty() ? "built-in" : (const char *)path.utf8().get_data(), parser.get_error_line(), ("Parse Error: " + parser.get_error()).utf8().get_data(), ERR_HANDLER_SCRIPT);
 		ERR_FAIL_V(ERR_PARSE_ERROR);
@@ -911,6 +937,8 @@ GDScript::~GDScript() {
 		memdelete(E->get());
 	}
 
+	GDScriptLanguage::get_singleton()->invalidate_inline_caches();
+
 	for (Map<StringName, Ref<GDScript> >::Element *E = subclasses.front(); E; E = E->next()) {
 		E->get()->_owner = NULL; //bye, you are no longer owned cause I died
 	}
@@ -1388,6 +1416,7 @@ void GDScriptLanguage::init() {
 
 		_add_global(E->get().name, E->get().ptr);
 	}
+
 }
 
 String GDScriptLanguage::get_type() const {
@@ -1404,8 +1433,173 @@ Error GDScriptLanguage::execute_file(const String &p_path) {
 	return OK;
 }
 void GDScriptLanguage::finish() {
+
+	preloaded_scripts.clear();
+
+#ifdef DEBUG_ENABLED
+	if (sampling) {
+		sampling_stop();
+		if (sample_path != String()) {
+			if (sampling_save(sample_path) == OK) {
+				print_line("GDScript samples saved to: " + sample_path);
+			}
+			sampling_print_hot_lines(20);
+		}
+	}
+#endif
+}
+
+#ifdef DEBUG_ENABLED
+
+void GDScriptLanguage::_sample_thread_func(void *p_userdata) {
+
+	GDScriptLanguage *gdl = (GDScriptLanguage *)p_userdata;
+
+	while (!gdl->sampling_exit) {
+
+		OS::get_singleton()->delay_usec(gdl->sample_interval_usec);
+
+		if (gdl->sample_depth > 0) {
+			gdl->sample_requested = true;
+		} else {
+			gdl->engine_samples++;
+		}
+	}
+}
+
+void GDScriptLanguage::_take_sample() {
+
+	if (Thread::get_caller_id() != sampled_thread) {
+		return;
+	}
+
+	sample_requested = false;
+
+	String stack;
+	int depth = MIN(sample_depth, (int)SAMPLE_MAX_DEPTH);
+	for (int i = 0; i < depth; i++) {
+
+		const SampleFrame &frame = sample_stack[i];
+		if (i > 0) {
+			stack += ";";
+		}
+		String source = frame.function->get_source();
+		stack += (source.empty() ? String("built-in") : source) + ":" + String(frame.function->get_name()) + ":" + itos(*frame.line);
+	}
+
+	Map<String, int>::Element *E = sampled_stacks.find(stack);
+	if (E) {
+		E->get()++;
+	} else {
+		sampled_stacks.insert(stack, 1);
+	}
+}
+
+void GDScriptLanguage::sampling_start(int p_interval_usec) {
+
+	ERR_FAIL_COND(sampling);
+	ERR_FAIL_COND(p_interval_usec <= 0);
+
+	sampled_stacks.clear();
+	engine_samples = 0;
+	sample_interval_usec = p_interval_usec;
+	sample_requested = false;
+	sample_depth = 0;
+	sampled_thread = Thread::get_caller_id();
+	sampling_exit = false;
+
+	if (!sample_stack) {
+		sample_stack = memnew_arr(SampleFrame, SAMPLE_MAX_DEPTH);
+	}
+
+	sample_thread = Thread::create(_sample_thread_func, this);
+	ERR_EXPLAIN("Sampling GDScript needs threads.");
+	ERR_FAIL_COND(!sample_thread);
+
+	sampling = true;
+}
+
+void GDScriptLanguage::sampling_stop() {
+
+	ERR_FAIL_COND(!sampling);
+	ERR_FAIL_COND(Thread::get_caller_id() != sampled_thread);
+
+	sampling = false;
+	sampling_exit = true;
+	Thread::wait_to_finish(sample_thread);
+	memdelete(sample_thread);
+	sample_thread = NULL;
+
+	sample_requested = false;
+	// calls running now still leave through sample_exit(), the depth goes back to zero by itself
 }
 
+bool GDScriptLanguage::sampling_start_to_file(const String &p_path) {
+
+	sample_path = p_path;
+	sampling_start(GLOBAL_GET("debug/gdscript/profiler/sample_interval_usec"));
+	return true;
+}
+
+Error GDScriptLanguage::sampling_save(const String &p_path) {
+
+	Error err;
+	FileAccess *f = FileAccess::open(p_path, FileAccess::WRITE, &err);
+	ERR_EXPLAIN("Can't save GDScript samples to: " + p_path);
+	ERR_FAIL_COND_V(!f, err);
+
+	if (engine_samples) {
+		f->store_line("[engine] " + itos(engine_samples));
+	}
+	for (const Map<String, int>::Element *E = sampled_stacks.front(); E; E = E->next()) {
+		f->store_line(E->key() + " " + itos(E->get()));
+	}
+
+	f->close();
+	memdelete(f);
+	return OK;
+}
+
+void GDScriptLanguage::sampling_print_hot_lines(int p_max) {
+
+	struct LineSamples {
+		String line;
+		int samples;
+
+		bool operator<(const LineSamples &p_other) const { return samples > p_other.samples; }
+	};
+
+	Map<String, int> lines;
+	int total = engine_samples;
+	for (const Map<String, int>::Element *E = sampled_stacks.front(); E; E = E->next()) {
+
+		String line = E->key().get_slice(";", E->key().get_slice_count(";") - 1);
+		Map<String, int>::Element *L = lines.find(line);
+		if (L) {
+			L->get() += E->get();
+		} else {
+			lines.insert(line, E->get());
+		}
+		total += E->get();
+	}
+
+	Vector<LineSamples> sorted;
+	for (const Map<String, int>::Element *E = lines.front(); E; E = E->next()) {
+		LineSamples ls;
+		ls.line = E->key();
+		ls.samples = E->get();
+		sorted.push_back(ls);
+	}
+	sorted.sort();
+
+	print_line("GDScript hot lines (" + itos(total) + " samples, " + itos(engine_samples) + " outside of scripts):");
+	for (int i = 0; i < MIN(p_max, sorted.size()); i++) {
+		print_line("  " + rtos(Math::stepify(sorted[i].samples * 100.0 / total, 0.1)) + "%  " + sorted[i].line);
+	}
+}
+
+#endif
+
 void GDScriptLanguage::profiling_start() {
 
 #ifdef DEBUG_ENABLED
@@ -1691,6 +1885,25 @@ void GDScriptLanguage::reload_tool_script(const Ref<Script> &p_script, bool p_so
 #endif
 }
 
+void GDScriptLanguage::preload_scripts() {
+
+	if (!GLOBAL_GET("debug/gdscript/loading/preload_scripts").booleanize())
+		return;
+
+	Vector<String> paths;
+	GDScriptBatchLoader::find_scripts("res://", paths);
+
+	GDScriptBatchLoader loader;
+	loader.load(paths);
+
+	// Kept until the game ends, or they would be freed and loaded again when needed
+	for (int i = 0; i < loader.get_script_count(); i++) {
+		if (loader.get_script(i).is_valid()) {
+			preloaded_scripts.push_back(loader.get_script(i));
+		}
+	}
+}
+
 void GDScriptLanguage::frame() {
 
 	//print_line("calls: "+itos(calls));
@@ -2030,6 +2243,74 @@ GDScriptWarning::Code GDScriptWarning::get_code_from_name(const String &p_name)
 
 #endif // DEBUG_ENABLED
 
+int GDScriptLanguage::_get_frame_class(uint32_t p_size) {
+
+	int frame_class = 0;
+	while (frame_class < FRAME_POOL_CLASSES && (1U << (frame_class + FRAME_POOL_MIN_SHIFT)) < p_size) {
+		frame_class++;
+	}
+	return frame_class; // FRAME_POOL_CLASSES if too large to be pooled
+}
+
+uint8_t *GDScriptLanguage::alloc_frame(uint32_t p_size) {
+
+	int frame_class = _get_frame_class(p_size);
+	if (frame_class == FRAME_POOL_CLASSES) {
+		return (uint8_t *)memalloc(p_size);
+	}
+
+	if (frame_pool_lock) {
+		frame_pool_lock->lock();
+	}
+
+	uint8_t *frame = frame_pool[frame_class];
+	if (frame) {
+		frame_pool[frame_class] = *(uint8_t **)frame;
+		frame_pool_free[frame_class]--;
+		frames_reused++;
+	} else {
+		frames_allocated++;
+	}
+
+	if (frame_pool_lock) {
+		frame_pool_lock->unlock();
+	}
+
+	if (!frame) {
+		frame = (uint8_t *)memalloc(1U << (frame_class + FRAME_POOL_MIN_SHIFT));
+	}
+	return frame;
+}
+
+void GDScriptLanguage::free_frame(uint8_t *p_frame, uint32_t p_size) {
+
+	int frame_class = _get_frame_class(p_size);
+
+	if (frame_class < FRAME_POOL_CLASSES) {
+
+		if (frame_pool_lock) {
+			frame_pool_lock->lock();
+		}
+
+		bool pooled = frame_pool_free[frame_class] < FRAME_POOL_MAX_FREE;
+		if (pooled) {
+			*(uint8_t **)p_frame = frame_pool[frame_class];
+			frame_pool[frame_class] = p_frame;
+			frame_pool_free[frame_class]++;
+		}
+
+		if (frame_pool_lock) {
+			frame_pool_lock->unlock();
+		}
+
+		if (pooled) {
+			return;
+		}
+	}
+
+	memfree(p_frame);
+}
+
 GDScriptLanguage::GDScriptLanguage() {
 
 	calls = 0;
@@ -2046,11 +2327,37 @@ GDScriptLanguage::GDScriptLanguage() {
 
 #ifdef NO_THREADS
 	lock = NULL;
+	frame_pool_lock = NULL;
 #else
 	lock = Mutex::create();
+	frame_pool_lock = Mutex::create();
 #endif
 	profiling = false;
 	script_frame_time = 0;
+	inline_cache_version = 1; // caches not filled yet hold 0
+
+	for (int i = 0; i < FRAME_POOL_CLASSES; i++) {
+		frame_pool[i] = NULL;
+		frame_pool_free[i] = 0;
+	}
+	frames_allocated = 0;
+	frames_reused = 0;
+
+#ifdef DEBUG_ENABLED
+	sampling = false;
+	sampling_exit = false;
+	sample_requested = false;
+	sample_depth = 0;
+	sample_stack = NULL;
+	sampled_thread = 0;
+	sample_thread = NULL;
+	sample_interval_usec = 0;
+	engine_samples = 0;
+#endif
+
+	GLOBAL_DEF("debug/gdscript/compiler/optimize", false);
+	GLOBAL_DEF("debug/gdscript/compiler/optimize.release", true);
+	GLOBAL_DEF("debug/gdscript/loading/preload_scripts", false);
 
 	_debug_call_stack_pos = 0;
 	int dmcs = GLOBAL_DEF("debug/settings/gdscript/max_call_stack", 1024);
@@ -2068,6 +2375,8 @@ GDScriptLanguage::GDScriptLanguage() {
 	}
 
 #ifdef DEBUG_ENABLED
+	GLOBAL_DEF("debug/gdscript/profiler/sample_interval_usec", 1000);
+	ProjectSettings::get_singleton()->set_custom_property_info("debug/gdscript/profiler/sample_interval_usec", PropertyInfo(Variant::INT, "debug/gdscript/profiler/sample_interval_usec", PROPERTY_HINT_RANGE, "50,100000,1"));
 	GLOBAL_DEF("debug/gdscript/warnings/enable", true);
 	GLOBAL_DEF("debug/gdscript/warnings/treat_warnings_as_errors", false);
 	for (int i = 0; i < (int)GDScriptWarning::WARNING_MAX; i++) {
@@ -2083,6 +2392,25 @@ GDScriptLanguage::~GDScriptLanguage() {
 		memdelete(lock);
 		lock = NULL;
 	}
+	for (int i = 0; i < FRAME_POOL_CLASSES; i++) {
+		while (frame_pool[i]) {
+			uint8_t *next = *(uint8_t **)frame_pool[i];
+			memfree(frame_pool[i]);
+			frame_pool[i] = next;
+		}
+	}
+	if (frame_pool_lock) {
+		memdelete(frame_pool_lock);
+		frame_pool_lock = NULL;
+	}
+#ifdef DEBUG_ENABLED
+	if (sampling) {
+		sampling_stop();
+	}
+	if (sample_stack) {
+		memdelete_arr(sample_stack);
+	}
+#endif
 	if (_call_stack) {
 		memdelete_arr(_call_stack);
 	}
@@ -34,6 +34,7 @@
 #include "gdscript_function.h"
 #include "io/resource_loader.h"
 #include "io/resource_saver.h"
+#include "os/thread.h"
 #include "script_language.h"
 
 class GDScriptNativeClass : public Reference {
@@ -70,6 +71,7 @@ class GDScript : public Script {
 	friend class GDScriptInstance;
 	friend class GDScriptFunction;
 	friend class GDScriptCompiler;
+	friend class GDScriptBytecode;
 	friend class GDScriptFunctions;
 	friend class GDScriptLanguage;
 
@@ -183,6 +185,7 @@ public:
 	void set_script_path(const String &p_path) { path = p_path; } //because subclasses need a path too...
 	Error load_source_code(const String &p_path);
 	Error load_byte_code(const String &p_path);
+	static Error read_byte_code(const String &p_path, Vector<uint8_t> &r_buffer); // decrypted if .gde
 
 	Vector<uint8_t> get_as_byte_code() const;
 
@@ -344,9 +347,115 @@ class GDScriptLanguage : public ScriptLanguage {
 	bool profiling;
 	uint64_t script_frame_time;
 
+	volatile uint32_t inline_cache_version;
+
+	Vector<Ref<GDScript> > preloaded_scripts;
+
+	// Frames of functions suspended by yield, size classes of powers of two from 64 bytes.
+	enum {
+		FRAME_POOL_MIN_SHIFT = 6,
+		FRAME_POOL_CLASSES = 12,
+		FRAME_POOL_MAX_FREE = 1024
+	};
+
+	Mutex *frame_pool_lock;
+	uint8_t *frame_pool[FRAME_POOL_CLASSES];
+	int frame_pool_free[FRAME_POOL_CLASSES];
+	uint32_t frames_allocated;
+	uint32_t frames_reused;
+
+	static int _get_frame_class(uint32_t p_size);
+
+#ifdef DEBUG_ENABLED
+	// Sampling profiler: a thread asks for a sample at every interval, and the profiled thread
+	// records its script call stack at the next line it runs. Requests while no script runs
+	// are counted as time spent in the engine.
+	struct SampleFrame {
+		GDScriptFunction *function;
+		int *line;
+	};
+
+	enum {
+		SAMPLE_MAX_DEPTH = 1024
+	};
+
+	bool sampling;
+	volatile bool sampling_exit;
+	volatile bool sample_requested;
+	volatile int sample_depth;
+	SampleFrame *sample_stack;
+	Thread::ID sampled_thread;
+	Thread *sample_thread;
+	int sample_interval_usec;
+	uint64_t engine_samples;
+	Map<String, int> sampled_stacks;
+	String sample_path; // saved there on exit, from the command line
+
+	static void _sample_thread_func(void *p_userdata);
+	void _take_sample();
+#endif
+
 public:
 	int calls;
 
+	// Yielding moves the stack of the function to one of these instead of copying it, freed
+	// frames are kept to be reused by the next yield.
+	uint8_t *alloc_frame(uint32_t p_size);
+	void free_frame(uint8_t *p_frame, uint32_t p_size);
+	_FORCE_INLINE_ uint32_t get_frames_allocated() const { return frames_allocated; }
+	_FORCE_INLINE_ uint32_t get_frames_reused() const { return frames_reused; }
+
+	// Scripts being compiled or freed make the inline caches of all functions stale.
+	_FORCE_INLINE_ void invalidate_inline_caches() {
+		if (atomic_increment(&inline_cache_version) == 0) {
+			atomic_increment(&inline_cache_version); // 0 marks empty caches
+		}
+	}
+	_FORCE_INLINE_ uint32_t get_inline_cache_version() const { return atomic_load_acquire(&inline_cache_version); }
+
+#ifdef DEBUG_ENABLED
+	void sampling_start(int p_interval_usec);
+	void sampling_stop();
+	// Samples with the project interval and saves them to p_path on exit (--gdscript-samples).
+	virtual bool sampling_start_to_file(const String &p_path);
+	// Call stacks as "script:function:line" frames separated by ';' and followed by their sample
+	// count, the folded format of flame graph tools. The leaf frames give the hot lines.
+	Error sampling_save(const String &p_path);
+	void sampling_print_hot_lines(int p_max);
+
+	_FORCE_INLINE_ bool sample_enter(GDScriptFunction *p_function, int *p_line) {
+
+		if (likely(!sampling) || Thread::get_caller_id() != sampled_thread) {
+			return false;
+		}
+		if (sample_depth < SAMPLE_MAX_DEPTH) {
+			sample_stack[sample_depth].function = p_function;
+			sample_stack[sample_depth].line = p_line;
+		}
+		sample_depth++;
+		return true;
+	}
+
+	_FORCE_INLINE_ void sample_exit() {
+
+		// sampling may have been started again while calls tracked before were running
+		if (sample_depth <= 0) {
+			return;
+		}
+		sample_depth--;
+		if (sample_depth == 0) {
+			sample_requested = false; // back in the engine
+		}
+	}
+
+	_FORCE_INLINE_ void sample_poll() {
+
+		if (unlikely(sample_requested)) {
+			_take_sample();
+		}
+	}
+#endif
+
 	bool debug_break(const String &p_error, bool p_allow_continue = true);
 	bool debug_break_parse(const String &p_file, int p_line, const String &p_error);
 
@@ -432,6 +541,7 @@ public:
 	virtual String get_extension() const;
 	virtual Error execute_file(const String &p_path);
 	virtual void finish();
+	virtual void preload_scripts();
 
 	/* EDITOR FUNCTIONS */
 	virtual void get_reserved_words(List<String> *p_words) const;
@@ -0,0 +1,489 @@
+/*************************************************************************/
+/*  gdscript_batch_loader.cpp                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_batch_loader.h"
+
+#include "gdscript_bytecode.h"
+#include "gdscript_tokenizer.h"
+#include "io/resource_loader.h"
+#include "os/dir_access.h"
+#include "os/file_access.h"
+#include "os/os.h"
+#include "project_settings.h"
+
+static String _resolve_extends_path(const String &p_base_dir, const String &p_path) {
+
+	if (p_path.is_rel_path())
+		return p_base_dir.plus_file(p_path).simplify_path();
+	return p_path;
+}
+
+static String _resolve_preload_path(const String &p_base_dir, const String &p_path) {
+
+	String path = p_path;
+	if (!path.is_abs_path() && p_base_dir != "")
+		path = p_base_dir + "/" + path;
+	return path.replace("///", "//").simplify_path();
+}
+
+static _FORCE_INLINE_ bool _is_identifier_char(CharType c) {
+
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static _FORCE_INLINE_ bool _is_word(const CharType *p_code, int p_length, const char *p_word) {
+
+	for (int i = 0; i < p_length; i++) {
+		if (p_code[i] != p_word[i])
+			return false;
+	}
+	return p_word[p_length] == 0;
+}
+
+static _FORCE_INLINE_ int _skip_spaces(const CharType *p_code, int p_pos) {
+
+	while (p_code[p_pos] == ' ' || p_code[p_pos] == '\t' || (p_code[p_pos] == '\\' && p_code[p_pos + 1] == '\n')) {
+		p_pos += p_code[p_pos] == '\\' ? 2 : 1;
+	}
+	return p_pos;
+}
+
+// Skips the string starting at p_pos, with its contents in r_string (escapes aside, paths don't need them).
+static int _skip_string(const CharType *p_code, int p_pos, String *r_string = NULL) {
+
+	CharType quote = p_code[p_pos];
+	bool multiline = p_code[p_pos + 1] == quote && p_code[p_pos + 2] == quote;
+	int from = p_pos + (multiline ? 3 : 1);
+
+	for (int i = from; p_code[i]; i++) {
+
+		if (p_code[i] == '\\' && p_code[i + 1]) {
+			i++;
+		} else if (p_code[i] == quote && (!multiline || (p_code[i + 1] == quote && p_code[i + 2] == quote))) {
+			if (r_string) {
+				*r_string = String(&p_code[from], i - from);
+			}
+			return i + (multiline ? 3 : 1);
+		} else if (p_code[i] == '\n' && !multiline) {
+			break;
+		}
+	}
+
+	return -1;
+}
+
+bool GDScriptBatchLoader::_scan_source(const String &p_source, const String &p_path, const HashMap<String, String> &p_global_classes, Vector<String> &r_dependencies) {
+
+	// Not a full tokenizer, only strings and comments need to be skipped to find the names and paths used
+	String base_dir = p_path.get_base_dir();
+	const CharType *code = p_source.c_str();
+	int pos = 0;
+
+	while (code[pos]) {
+
+		CharType c = code[pos];
+
+		if (c == '#') {
+			while (code[pos] && code[pos] != '\n') {
+				pos++;
+			}
+		} else if (c == '"' || c == '\'') {
+			pos = _skip_string(code, pos);
+			if (pos == -1)
+				return false;
+		} else if (c >= '0' && c <= '9') {
+			while (_is_identifier_char(code[pos]) || code[pos] == '.') {
+				pos++;
+			}
+		} else if (_is_identifier_char(c)) {
+
+			int from = pos;
+			while (_is_identifier_char(code[pos])) {
+				pos++;
+			}
+			String path;
+
+			if (_is_word(&code[from], pos - from, "extends")) {
+				// Base classes by name are identifiers, found next
+				int next = _skip_spaces(code, pos);
+				if (code[next] == '"' || code[next] == '\'') {
+					pos = _skip_string(code, next, &path);
+					if (pos == -1)
+						return false;
+					path = _resolve_extends_path(base_dir, path);
+				}
+			} else if (_is_word(&code[from], pos - from, "preload")) {
+				// The path can also be a named constant, what it needs is not known then
+				int next = _skip_spaces(code, pos);
+				if (code[next] != '(')
+					return false;
+				next = _skip_spaces(code, next + 1);
+				if (code[next] != '"' && code[next] != '\'')
+					return false;
+				pos = _skip_string(code, next, &path);
+				if (pos == -1 || code[_skip_spaces(code, pos)] != ')')
+					return false;
+				path = _resolve_preload_path(base_dir, path);
+			} else if (!p_global_classes.empty()) {
+				const String *class_path = p_global_classes.getptr(String(&code[from], pos - from));
+				if (class_path) {
+					path = *class_path;
+				}
+			}
+
+			if (path != "" && path != p_path && r_dependencies.find(path) == -1) {
+				r_dependencies.push_back(path);
+			}
+		} else {
+			pos++;
+		}
+	}
+
+	return true;
+}
+
+bool GDScriptBatchLoader::_scan_tokens(GDScriptTokenizer *p_tokenizer, const String &p_path, const HashMap<String, String> &p_global_classes, Vector<String> &r_dependencies) {
+
+	String base_dir = p_path.get_base_dir();
+
+	while (p_tokenizer->get_token() != GDScriptTokenizer::TK_EOF) {
+
+		String path;
+
+		switch (p_tokenizer->get_token()) {
+
+			case GDScriptTokenizer::TK_ERROR: {
+				return false;
+			} break;
+			case GDScriptTokenizer::TK_PR_EXTENDS: {
+				if (p_tokenizer->get_token(1) != GDScriptTokenizer::TK_CONSTANT)
+					break;
+				if (p_tokenizer->get_token_constant(1).get_type() != Variant::STRING)
+					return false;
+				path = _resolve_extends_path(base_dir, p_tokenizer->get_token_constant(1));
+			} break;
+			case GDScriptTokenizer::TK_PR_PRELOAD: {
+				if (p_tokenizer->get_token(1) != GDScriptTokenizer::TK_PARENTHESIS_OPEN || p_tokenizer->get_token(2) != GDScriptTokenizer::TK_CONSTANT || p_tokenizer->get_token_constant(2).get_type() != Variant::STRING)
+					return false;
+				path = _resolve_preload_path(base_dir, p_tokenizer->get_token_constant(2));
+			} break;
+			case GDScriptTokenizer::TK_IDENTIFIER: {
+				const String *class_path = p_global_classes.getptr(p_tokenizer->get_token_identifier());
+				if (class_path) {
+					path = *class_path;
+				}
+			} break;
+			default: {
+			}
+		}
+
+		if (path != "" && path != p_path && r_dependencies.find(path) == -1) {
+			r_dependencies.push_back(path);
+		}
+
+		p_tokenizer->advance();
+	}
+
+	return true;
+}
+
+void GDScriptBatchLoader::_scan(uint32_t p_index, Entry *p_entries) {
+
+	Entry &e = p_entries[p_index];
+
+	if (e.cached && !keep_tokens)
+		return;
+
+	String load_path = ResourceLoader::path_remap(e.path);
+
+	if (load_path.ends_with(".gd")) {
+
+		Vector<uint8_t> file = FileAccess::get_file_as_array(load_path);
+		if (file.empty() || e.source.parse_utf8((const char *)file.ptr(), file.size()))
+			return;
+
+		e.scanned = _scan_source(e.source, e.path, global_classes, e.dependencies);
+		if (keep_tokens) {
+			e.tokens = GDScriptTokenizerBuffer::parse_code_string(e.source);
+		} else {
+			e.source = String();
+		}
+	} else {
+
+		Vector<uint8_t> buffer;
+		if (GDScript::read_byte_code(load_path, buffer) != OK)
+			return;
+
+		Vector<uint8_t> tokens = GDScriptBytecode::get_tokens(buffer);
+		GDScriptTokenizerBuffer tokenizer;
+		e.scanned = tokenizer.set_code_buffer(tokens) == OK && _scan_tokens(&tokenizer, e.path, global_classes, e.dependencies);
+		if (keep_tokens) {
+			e.tokens = tokens;
+		}
+	}
+}
+
+void GDScriptBatchLoader::_load(Entry *p_entry) {
+
+	p_entry->script = ResourceLoader::load(p_entry->path);
+}
+
+Error GDScriptBatchLoader::load(const Vector<String> &p_paths, Stats *r_stats) {
+
+	clear();
+
+	ThreadWorkPool *pool = ThreadWorkPool::get_singleton();
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+
+	Stats stats;
+	stats.cached = 0;
+	stats.parallel = 0;
+	stats.serial = 0;
+	stats.failed = 0;
+
+	for (int i = 0; i < p_paths.size(); i++) {
+
+		String path = ProjectSettings::get_singleton()->localize_path(p_paths[i]);
+		if (entry_map.has(path))
+			continue;
+
+		Entry e;
+		e.path = path;
+		e.cached = ResourceCache::has(path);
+		e.scanned = false;
+		e.serial = false;
+		e.task = 0;
+		if (e.cached) {
+			e.script = RES(ResourceCache::get(path));
+			stats.cached++;
+		}
+
+		entry_map[path] = entries.size();
+		entries.push_back(e);
+	}
+
+	stats.scripts = entries.size();
+
+	// Read the files and find what they need
+
+	List<StringName> class_list;
+	ScriptServer::get_global_class_list(&class_list);
+	for (List<StringName>::Element *E = class_list.front(); E; E = E->next()) {
+		global_classes[E->get()] = ScriptServer::get_global_class_path(E->get());
+	}
+
+	Entry *ptr = entries.ptrw();
+	int count = entries.size();
+
+	pool->do_work(count, this, &GDScriptBatchLoader::_scan, ptr);
+	global_classes.clear();
+
+	uint64_t scanned = OS::get_singleton()->get_ticks_usec();
+	stats.scan_usec = scanned - begin;
+
+	// Order the scripts so every one comes after those it needs, the ones left are in a cycle
+	// (or need one that is) and are loaded at the end. What isn't part of the batch is loaded first.
+
+	Vector<int> pending;
+	Vector<Vector<int> > dependents;
+	pending.resize(count);
+	dependents.resize(count);
+
+	for (int i = 0; i < count; i++) {
+
+		pending.write[i] = 0;
+		if (ptr[i].cached)
+			continue;
+
+		for (int j = 0; j < ptr[i].dependencies.size(); j++) {
+
+			String path = ProjectSettings::get_singleton()->localize_path(ptr[i].dependencies[j]);
+			const int *dependency = entry_map.getptr(path);
+
+			if (dependency) {
+				if (*dependency != i && !ptr[*dependency].cached) {
+					ptr[i].depends_on.push_back(*dependency);
+					dependents.write[*dependency].push_back(i);
+					pending.write[i]++;
+				}
+			} else if (!ResourceCache::has(path)) {
+				RES res = ResourceLoader::load(path);
+				if (res.is_valid()) {
+					external.push_back(res);
+				}
+			}
+		}
+	}
+
+	Vector<int> order;
+	for (int i = 0; i < count; i++) {
+		if (!ptr[i].cached && ptr[i].scanned && pending[i] == 0) {
+			order.push_back(i);
+		}
+	}
+	for (int i = 0; i < order.size(); i++) {
+		const Vector<int> &d = dependents[order[i]];
+		for (int j = 0; j < d.size(); j++) {
+			if (--pending.write[d[j]] == 0 && ptr[d[j]].scanned) {
+				order.push_back(d[j]);
+			}
+		}
+	}
+
+	// Loading what is outside the batch can load some of it too
+	for (int i = 0; i < order.size(); i++) {
+		if (ResourceCache::has(ptr[order[i]].path)) {
+			ptr[order[i]].cached = true;
+		}
+	}
+
+	uint64_t ordered = OS::get_singleton()->get_ticks_usec();
+
+	// Load a script as soon as all it needs is loaded
+
+	for (int i = 0; i < order.size(); i++) {
+
+		Entry &e = ptr[order[i]];
+		if (e.cached)
+			continue;
+
+		Vector<ThreadWorkPool::TaskID> dependencies;
+		for (int j = 0; j < e.depends_on.size(); j++) {
+			const Entry &dependency = ptr[e.depends_on[j]];
+			if (!dependency.cached) {
+				dependencies.push_back(dependency.task);
+			}
+		}
+
+		e.task = pool->add_task(this, &GDScriptBatchLoader::_load, &e, dependencies);
+		stats.parallel++;
+	}
+
+	for (int i = 0; i < order.size(); i++) {
+		if (ptr[order[i]].task) {
+			pool->wait_for_task_completion(ptr[order[i]].task);
+		}
+	}
+
+	uint64_t loaded = OS::get_singleton()->get_ticks_usec();
+	stats.parallel_usec = loaded - ordered;
+
+	// The rest one at a time, as ResourceLoader would
+
+	for (int i = 0; i < count; i++) {
+
+		Entry &e = ptr[i];
+		if (e.cached || e.task)
+			continue;
+
+		e.serial = true;
+		e.script = ResourceLoader::load(e.path);
+		stats.serial++;
+	}
+
+	uint64_t end = OS::get_singleton()->get_ticks_usec();
+	stats.serial_usec = (end - loaded) + (ordered - scanned);
+
+	for (int i = 0; i < count; i++) {
+		if (ptr[i].script.is_null() || !ptr[i].script->is_valid()) {
+			stats.failed++;
+		}
+	}
+
+	if (OS::get_singleton()->is_stdout_verbose()) {
+		print_line("GDScript: Loaded " + itos(stats.scripts) + " scripts in " + itos((end - begin) / 1000) + " msec with " + itos(pool->get_thread_count()) + " threads: scan " + itos(stats.scan_usec / 1000) + " msec, " + itos(stats.parallel) + " in parallel " + itos(stats.parallel_usec / 1000) + " msec, " + itos(stats.serial) + " one at a time " + itos(stats.serial_usec / 1000) + " msec (" + itos(stats.cached) + " already loaded, " + itos(stats.failed) + " failed).");
+	}
+
+	if (r_stats) {
+		*r_stats = stats;
+	}
+
+	return stats.failed ? FAILED : OK;
+}
+
+void GDScriptBatchLoader::clear() {
+
+	entries.clear();
+	entry_map.clear();
+	external.clear();
+}
+
+int GDScriptBatchLoader::find(const String &p_path) const {
+
+	const int *index = entry_map.getptr(p_path);
+	return index ? *index : -1;
+}
+
+static void _find_scripts(const String &p_dir, Set<String> &r_paths) {
+
+	DirAccess *da = DirAccess::open(p_dir);
+	if (!da)
+		return;
+
+	Vector<String> subdirs;
+
+	da->list_dir_begin();
+	for (String f = da->get_next(); f != ""; f = da->get_next()) {
+
+		if (f.begins_with("."))
+			continue;
+
+		if (da->current_is_dir()) {
+			subdirs.push_back(f);
+		} else if (f.ends_with(".gd") || f.ends_with(".gdc") || f.ends_with(".gde")) {
+			r_paths.insert(p_dir.plus_file(f.get_basename() + ".gd"));
+		}
+	}
+	da->list_dir_end();
+	memdelete(da);
+
+	for (int i = 0; i < subdirs.size(); i++) {
+
+		String dir = p_dir.plus_file(subdirs[i]);
+		if (!FileAccess::exists(dir.plus_file(".gdignore"))) {
+			_find_scripts(dir, r_paths);
+		}
+	}
+}
+
+void GDScriptBatchLoader::find_scripts(const String &p_dir, Vector<String> &r_paths) {
+
+	Set<String> paths;
+	_find_scripts(p_dir, paths);
+
+	for (Set<String>::Element *E = paths.front(); E; E = E->next()) {
+		r_paths.push_back(E->get());
+	}
+}
+
+GDScriptBatchLoader::GDScriptBatchLoader() {
+
+	keep_tokens = false;
+}
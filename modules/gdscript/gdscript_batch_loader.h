@@ -0,0 +1,106 @@
+/*************************************************************************/
+/*  gdscript_batch_loader.h                                              */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_BATCH_LOADER_H
+#define GDSCRIPT_BATCH_LOADER_H
+
+#include "gdscript.h"
+#include "os/thread_work_pool.h"
+
+class GDScriptTokenizer;
+
+// Loads many scripts at once, like loading all the scripts of a project. The files are read
+// and scanned for the scripts they need (base classes, preloads and global classes) in the
+// ThreadWorkPool, then every script is loaded in a task that waits for the tasks of the
+// scripts it needs, so the scripts that don't depend on each other are parsed and compiled
+// at the same time. Scripts which dependencies can't be found from their tokens, or that
+// are part of a dependency cycle, are loaded one at a time at the end.
+
+class GDScriptBatchLoader {
+public:
+	struct Stats {
+		int scripts;
+		int cached; // Already loaded before the batch.
+		int parallel;
+		int serial;
+		int failed;
+		uint64_t scan_usec;
+		uint64_t parallel_usec;
+		uint64_t serial_usec;
+	};
+
+private:
+	struct Entry {
+		String path;
+		String source;
+		Vector<uint8_t> tokens;
+		Vector<String> dependencies;
+		Vector<int> depends_on;
+		bool cached;
+		bool scanned;
+		bool serial;
+		ThreadWorkPool::TaskID task;
+		Ref<GDScript> script;
+	};
+
+	Vector<Entry> entries;
+	HashMap<String, int> entry_map;
+	Vector<RES> external; // Dependencies that are not in the batch, loaded before it.
+	bool keep_tokens;
+
+	HashMap<String, String> global_classes; // Copied while scanning, so threads don't need the StringName lock.
+
+	static bool _scan_source(const String &p_source, const String &p_path, const HashMap<String, String> &p_global_classes, Vector<String> &r_dependencies);
+	static bool _scan_tokens(GDScriptTokenizer *p_tokenizer, const String &p_path, const HashMap<String, String> &p_global_classes, Vector<String> &r_dependencies);
+
+	void _scan(uint32_t p_index, Entry *p_entries);
+	void _load(Entry *p_entry);
+
+public:
+	// Export needs the tokens of every script, they are kept when set (with the source code for .gd files).
+	void set_keep_tokens(bool p_keep) { keep_tokens = p_keep; }
+
+	Error load(const Vector<String> &p_paths, Stats *r_stats = NULL);
+	void clear();
+
+	int find(const String &p_path) const;
+	int get_script_count() const { return entries.size(); }
+	const String &get_path(int p_index) const { return entries[p_index].path; }
+	const String &get_source(int p_index) const { return entries[p_index].source; }
+	const Vector<uint8_t> &get_tokens(int p_index) const { return entries[p_index].tokens; }
+	Ref<GDScript> get_script(int p_index) const { return entries[p_index].script; }
+
+	// Paths of all the scripts in a directory and its subdirectories, also those exported as .gdc or .gde.
+	static void find_scripts(const String &p_dir, Vector<String> &r_paths);
+
+	GDScriptBatchLoader();
+};
+
+#endif // GDSCRIPT_BATCH_LOADER_H
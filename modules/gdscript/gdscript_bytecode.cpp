@@ -0,0 +1,1254 @@
+/*************************************************************************/
+/*  gdscript_bytecode.cpp                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_bytecode.h"
+
+#include "gdscript_compiler.h"
+#include "gdscript_functions.h"
+#include "io/marshalls.h"
+#include "io/resource_loader.h"
+#include "os/os.h"
+#include "version.h"
+
+#define COMPILED_VERSION 2
+
+enum {
+	HEADER_SIZE = 20,
+	FLAG_DEBUG_CODE = 1, // has line, assert and breakpoint instructions
+	FLAG_DEBUG_STACK = 2 // has the local variables of the stack
+};
+
+static uint32_t _get_flags() {
+
+	uint32_t flags = 0;
+#ifdef DEBUG_ENABLED
+	flags |= FLAG_DEBUG_CODE;
+#endif
+	if (ScriptDebugger::get_singleton()) {
+		flags |= FLAG_DEBUG_STACK;
+	}
+	return flags;
+}
+
+// How values are saved, objects are saved as references to what they were.
+enum {
+	VARIANT_VALUE,
+	VARIANT_NULL_OBJECT,
+	VARIANT_GLOBAL,
+	VARIANT_RESOURCE,
+	VARIANT_INNER_CLASS
+};
+
+// Compiled code is only valid for the same opcodes, built-in types and functions.
+static uint32_t _get_engine_hash() {
+
+	uint32_t hash = hash_djb2(VERSION_FULL_BUILD);
+	hash = hash_djb2_one_32(COMPILED_VERSION, hash);
+	hash = hash_djb2_one_32(GDScriptFunction::OPCODE_END, hash);
+	hash = hash_djb2_one_32(GDScriptFunction::ADDR_BITS, hash);
+	hash = hash_djb2_one_32(Variant::VARIANT_MAX, hash);
+	hash = hash_djb2_one_32(Variant::OP_MAX, hash);
+	hash = hash_djb2_one_32(GDScriptFunctions::FUNC_MAX, hash);
+	return hash;
+}
+
+static bool _has_objects(const Variant &p_value) {
+
+	switch (p_value.get_type()) {
+		case Variant::OBJECT: return true;
+		case Variant::ARRAY: {
+			Array array = p_value;
+			for (int i = 0; i < array.size(); i++) {
+				if (_has_objects(array[i])) {
+					return true;
+				}
+			}
+		} break;
+		case Variant::DICTIONARY: {
+			Dictionary dict = p_value;
+			List<Variant> keys;
+			dict.get_key_list(&keys);
+			for (List<Variant>::Element *E = keys.front(); E; E = E->next()) {
+				if (_has_objects(E->get()) || _has_objects(dict[E->get()])) {
+					return true;
+				}
+			}
+		} break;
+		default: {
+		}
+	}
+
+	return false;
+}
+
+// Positions of the operands of the code that are addresses. Fails for unknown opcodes
+// and instructions that don't fit in the code.
+static bool _find_addresses(const Vector<int> &p_code, Vector<int> &r_positions) {
+
+	const int *code = p_code.ptr();
+	int size = p_code.size();
+	int ip = 0;
+
+#define ARG(m_ofs) (ip + (m_ofs) < size ? code[ip + (m_ofs)] : -1)
+#define ADDR(m_ofs) r_positions.push_back(ip + (m_ofs))
+
+	while (ip < size) {
+
+		int len = 0;
+
+		switch (code[ip]) {
+
+			case GDScriptFunction::OPCODE_OPERATOR:
+			case GDScriptFunction::OPCODE_OPERATOR_INT:
+			case GDScriptFunction::OPCODE_OPERATOR_REAL:
+			case GDScriptFunction::OPCODE_OPERATOR_VECTOR2:
+			case GDScriptFunction::OPCODE_OPERATOR_VECTOR3: {
+				ADDR(2);
+				ADDR(3);
+				ADDR(4);
+				len = 5;
+			} break;
+			case GDScriptFunction::OPCODE_EXTENDS_TEST:
+			case GDScriptFunction::OPCODE_SET:
+			case GDScriptFunction::OPCODE_GET:
+			case GDScriptFunction::OPCODE_ASSIGN_TYPED_NATIVE:
+			case GDScriptFunction::OPCODE_ASSIGN_TYPED_SCRIPT:
+			case GDScriptFunction::OPCODE_CAST_TO_NATIVE:
+			case GDScriptFunction::OPCODE_CAST_TO_SCRIPT: {
+				ADDR(1);
+				ADDR(2);
+				ADDR(3);
+				len = 4;
+			} break;
+			case GDScriptFunction::OPCODE_SET_NAMED:
+			case GDScriptFunction::OPCODE_SET_NAMED_VECTOR: {
+				ADDR(1);
+				ADDR(3);
+				len = 4;
+			} break;
+			case GDScriptFunction::OPCODE_GET_NAMED:
+			case GDScriptFunction::OPCODE_GET_NAMED_VECTOR: {
+				ADDR(1);
+				ADDR(4);
+				len = 5;
+			} break;
+			case GDScriptFunction::OPCODE_SET_MEMBER:
+			case GDScriptFunction::OPCODE_GET_MEMBER: {
+				ADDR(2);
+				len = 3;
+			} break;
+			case GDScriptFunction::OPCODE_ASSIGN: {
+				ADDR(1);
+				ADDR(2);
+				len = 3;
+			} break;
+			case GDScriptFunction::OPCODE_ASSIGN_TRUE:
+			case GDScriptFunction::OPCODE_ASSIGN_FALSE:
+			case GDScriptFunction::OPCODE_YIELD_RESUME:
+			case GDScriptFunction::OPCODE_RETURN:
+			case GDScriptFunction::OPCODE_ASSERT: {
+				ADDR(1);
+				len = 2;
+			} break;
+			case GDScriptFunction::OPCODE_ASSIGN_TYPED_BUILTIN:
+			case GDScriptFunction::OPCODE_CAST_TO_BUILTIN: {
+				ADDR(2);
+				ADDR(3);
+				len = 4;
+			} break;
+			case GDScriptFunction::OPCODE_CONSTRUCT:
+			case GDScriptFunction::OPCODE_CALL_BUILT_IN:
+			case GDScriptFunction::OPCODE_CALL_SELF_BASE: {
+				int argc = ARG(2);
+				if (argc < 0) {
+					return false;
+				}
+				for (int i = 0; i <= argc; i++) {
+					ADDR(3 + i);
+				}
+				len = 4 + argc;
+			} break;
+			case GDScriptFunction::OPCODE_CONSTRUCT_ARRAY: {
+				int argc = ARG(1);
+				if (argc < 0) {
+					return false;
+				}
+				for (int i = 0; i <= argc; i++) {
+					ADDR(2 + i);
+				}
+				len = 3 + argc;
+			} break;
+			case GDScriptFunction::OPCODE_CONSTRUCT_DICTIONARY: {
+				int argc = ARG(1);
+				if (argc < 0) {
+					return false;
+				}
+				for (int i = 0; i <= argc * 2; i++) {
+					ADDR(2 + i);
+				}
+				len = 3 + argc * 2;
+			} break;
+			case GDScriptFunction::OPCODE_CALL:
+			case GDScriptFunction::OPCODE_CALL_RETURN:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL:
+			case GDScriptFunction::OPCODE_CALL_PTRCALL_RETURN: {
+				int argc = ARG(1);
+				if (argc < 0) {
+					return false;
+				}
+				ADDR(2);
+				for (int i = 0; i <= argc; i++) {
+					ADDR(5 + i);
+				}
+				len = 6 + argc;
+			} break;
+			case GDScriptFunction::OPCODE_YIELD_SIGNAL: {
+				ADDR(1);
+				ADDR(2);
+				len = 3;
+			} break;
+			case GDScriptFunction::OPCODE_JUMP_IF:
+			case GDScriptFunction::OPCODE_JUMP_IF_NOT: {
+				ADDR(1);
+				len = 3;
+			} break;
+			case GDScriptFunction::OPCODE_JUMP_IF_NOT_COMPARE: {
+				ADDR(2);
+				ADDR(3);
+				len = 5;
+			} break;
+			case GDScriptFunction::OPCODE_ITERATE_BEGIN:
+			case GDScriptFunction::OPCODE_ITERATE: {
+				ADDR(1);
+				ADDR(2);
+				ADDR(4);
+				len = 5;
+			} break;
+			case GDScriptFunction::OPCODE_JUMP:
+			case GDScriptFunction::OPCODE_LINE: {
+				len = 2;
+			} break;
+			case GDScriptFunction::OPCODE_YIELD:
+			case GDScriptFunction::OPCODE_JUMP_TO_DEF_ARGUMENT:
+			case GDScriptFunction::OPCODE_BREAKPOINT:
+			case GDScriptFunction::OPCODE_END: {
+				len = 1;
+			} break;
+			default: {
+				return false;
+			}
+		}
+
+		if (ip + len > size) {
+			return false;
+		}
+		ip += len;
+	}
+
+#undef ARG
+#undef ADDR
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////
+
+struct GDScriptBytecode::Writer {
+
+	Vector<uint8_t> buffer;
+	const GDScript *root;
+	Vector<StringName> global_names; // index in the global array to name
+	Map<const Object *, StringName> global_objects;
+	bool failed;
+	String error;
+
+	void fail(const String &p_error) {
+
+		if (!failed) {
+			failed = true;
+			error = p_error;
+		}
+	}
+
+	void put_32(uint32_t p_value) {
+
+		int pos = buffer.size();
+		buffer.resize(pos + 4);
+		encode_uint32(p_value, &buffer.write[pos]);
+	}
+
+	void put_string(const String &p_string) {
+
+		CharString cs = p_string.utf8();
+		put_32(cs.length());
+		int pos = buffer.size();
+		buffer.resize(pos + cs.length());
+		for (int i = 0; i < cs.length(); i++) {
+			buffer.write[pos + i] = cs[i];
+		}
+	}
+
+	bool get_inner_path(const GDScript *p_script, Vector<StringName> &r_path) const {
+
+		const GDScript *script = p_script;
+		while (script && script != root) {
+			r_path.insert(0, script->name);
+			script = script->_owner;
+		}
+		return script == root;
+	}
+
+	void put_variant(const Variant &p_value) {
+
+		if (p_value.get_type() == Variant::OBJECT) {
+
+			Object *obj = p_value;
+			if (!obj) {
+				put_32(VARIANT_NULL_OBJECT);
+				return;
+			}
+
+			Vector<StringName> inner_path;
+			GDScript *script = Object::cast_to<GDScript>(obj);
+			if (script && get_inner_path(script, inner_path)) {
+				put_32(VARIANT_INNER_CLASS);
+				put_32(inner_path.size());
+				for (int i = 0; i < inner_path.size(); i++) {
+					put_string(inner_path[i]);
+				}
+				return;
+			}
+
+			const Map<const Object *, StringName>::Element *E = global_objects.find(obj);
+			if (E) {
+				put_32(VARIANT_GLOBAL);
+				put_string(E->get());
+				return;
+			}
+
+			Resource *res = Object::cast_to<Resource>(obj);
+			if (res && res->get_path().is_resource_file()) {
+				put_32(VARIANT_RESOURCE);
+				put_string(res->get_path());
+				return;
+			}
+
+			fail("Constant of type '" + obj->get_class() + "' can't be saved.");
+			return;
+		}
+
+		if (_has_objects(p_value)) {
+			fail("Constant containing objects can't be saved.");
+			return;
+		}
+
+		int len;
+		Error err = encode_variant(p_value, NULL, len);
+		if (err != OK) {
+			fail("Constant of type '" + Variant::get_type_name(p_value.get_type()) + "' can't be saved.");
+			return;
+		}
+
+		put_32(VARIANT_VALUE);
+		put_32(len);
+		int pos = buffer.size();
+		buffer.resize(pos + len);
+		encode_variant(p_value, &buffer.write[pos], len);
+	}
+
+	void put_data_type(const GDScriptDataType &p_type) {
+
+		// the rest is left uninitialized when there's no type
+		put_32(p_type.has_type);
+		put_32(p_type.has_type ? p_type.kind : 0);
+		put_32(p_type.has_type ? p_type.builtin_type : Variant::NIL);
+		put_string(p_type.has_type ? String(p_type.native_type) : String());
+		put_variant(p_type.has_type && p_type.script_type.is_valid() ? Variant(p_type.script_type) : Variant());
+	}
+
+	Writer(const GDScript *p_root) {
+
+		root = p_root;
+		failed = false;
+
+		const Map<StringName, int> &globals = GDScriptLanguage::get_singleton()->get_global_map();
+		const Variant *global_array = GDScriptLanguage::get_singleton()->get_global_array();
+		global_names.resize(GDScriptLanguage::get_singleton()->get_global_array_size());
+
+		for (const Map<StringName, int>::Element *E = globals.front(); E; E = E->next()) {
+
+			global_names.write[E->get()] = E->key();
+			if (global_array[E->get()].get_type() == Variant::OBJECT) {
+				const Object *obj = global_array[E->get()];
+				if (obj) {
+					global_objects[obj] = E->key();
+				}
+			}
+		}
+
+		const Map<StringName, Variant> &named_globals = GDScriptLanguage::get_singleton()->get_named_globals_map();
+		for (const Map<StringName, Variant>::Element *E = named_globals.front(); E; E = E->next()) {
+
+			if (E->get().get_type() == Variant::OBJECT) {
+				const Object *obj = E->get();
+				if (obj) {
+					global_objects[obj] = E->key();
+				}
+			}
+		}
+	}
+};
+
+struct GDScriptBytecode::Reader {
+
+	const uint8_t *data;
+	int size;
+	int pos;
+	GDScript *root;
+	Map<GDScript *, int> inherited_counts;
+	bool failed;
+	String error;
+
+	void fail(const String &p_error) {
+
+		if (!failed) {
+			failed = true;
+			error = p_error;
+		}
+	}
+
+	uint32_t get_32() {
+
+		if (failed || pos + 4 > size) {
+			fail("Unexpected end of data.");
+			return 0;
+		}
+		uint32_t value = decode_uint32(&data[pos]);
+		pos += 4;
+		return value;
+	}
+
+	// Element counts can't be larger than the remaining data, so corrupted ones don't allocate much.
+	int get_count() {
+
+		int count = get_32();
+		if (count < 0 || count > size - pos) {
+			fail("Invalid element count.");
+			return 0;
+		}
+		return count;
+	}
+
+	String get_string() {
+
+		int len = get_count();
+		if (failed) {
+			return String();
+		}
+		String s;
+		s.parse_utf8((const char *)&data[pos], len);
+		pos += len;
+		return s;
+	}
+
+	Variant get_variant() {
+
+		switch (get_32()) {
+
+			case VARIANT_VALUE: {
+
+				int len = get_count();
+				if (failed) {
+					return Variant();
+				}
+				Variant value;
+				if (decode_variant(value, &data[pos], len, NULL, false) != OK) {
+					fail("Invalid constant.");
+					return Variant();
+				}
+				pos += len;
+				return value;
+			} break;
+			case VARIANT_NULL_OBJECT: {
+
+				return Variant((Object *)NULL);
+			} break;
+			case VARIANT_GLOBAL: {
+
+				StringName name = get_string();
+				const Map<StringName, int> &globals = GDScriptLanguage::get_singleton()->get_global_map();
+				const Map<StringName, int>::Element *E = globals.find(name);
+				if (E) {
+					return GDScriptLanguage::get_singleton()->get_global_array()[E->get()];
+				}
+				const Map<StringName, Variant> &named_globals = GDScriptLanguage::get_singleton()->get_named_globals_map();
+				if (named_globals.has(name)) {
+					return named_globals[name];
+				}
+				fail("Global '" + String(name) + "' not found.");
+			} break;
+			case VARIANT_RESOURCE: {
+
+				String path = get_string();
+				if (failed) {
+					return Variant();
+				}
+				RES res = ResourceLoader::load(path);
+				if (res.is_null()) {
+					fail("Can't load resource '" + path + "'.");
+					return Variant();
+				}
+				return res;
+			} break;
+			case VARIANT_INNER_CLASS: {
+
+				Ref<GDScript> script = Ref<GDScript>(root);
+				int count = get_count();
+				for (int i = 0; i < count && !failed; i++) {
+					StringName name = get_string();
+					if (!script->subclasses.has(name)) {
+						fail("Inner class '" + String(name) + "' not found.");
+						return Variant();
+					}
+					script = script->subclasses[name];
+				}
+				return script;
+			} break;
+			default: {
+				fail("Invalid constant.");
+			}
+		}
+
+		return Variant();
+	}
+
+	GDScriptDataType get_data_type() {
+
+		GDScriptDataType type;
+		type.has_type = get_32();
+		uint32_t kind = get_32();
+		uint32_t builtin_type = get_32();
+		type.native_type = get_string();
+		type.script_type = get_variant();
+
+		if (kind > GDScriptDataType::GDSCRIPT || builtin_type >= Variant::VARIANT_MAX) {
+			fail("Invalid type.");
+			return GDScriptDataType();
+		}
+		type.kind = (decltype(type.kind))kind;
+		type.builtin_type = (Variant::Type)builtin_type;
+		return type;
+	}
+};
+
+/////////////////////////////////////////////////////////////////////////
+
+void GDScriptBytecode::_save_class_tree(Writer &p_writer, const GDScript *p_script) {
+
+	p_writer.put_32(p_script->subclasses.size());
+	for (const Map<StringName, Ref<GDScript> >::Element *E = p_script->subclasses.front(); E; E = E->next()) {
+
+		p_writer.put_string(E->key());
+		_save_class_tree(p_writer, E->get().ptr());
+	}
+}
+
+void GDScriptBytecode::_save_class(Writer &p_writer, const GDScript *p_script) {
+
+	p_writer.put_32(p_script->tool);
+	p_writer.put_string(p_script->name);
+	p_writer.put_string(p_script->native.is_valid() ? String(p_script->native->get_name()) : String());
+	p_writer.put_variant(p_script->base.is_valid() ? Variant(p_script->base) : Variant());
+	p_writer.put_32(p_script->base.is_valid() ? p_script->base->member_indices.size() : 0);
+
+	p_writer.put_32(p_script->member_indices.size());
+	for (const Map<StringName, GDScript::MemberInfo>::Element *E = p_script->member_indices.front(); E; E = E->next()) {
+
+		p_writer.put_string(E->key());
+		p_writer.put_32(E->get().index);
+		p_writer.put_string(E->get().setter);
+		p_writer.put_string(E->get().getter);
+		p_writer.put_32(E->get().rpc_mode);
+		p_writer.put_data_type(E->get().data_type);
+	}
+
+	p_writer.put_32(p_script->members.size());
+	for (const Set<StringName>::Element *E = p_script->members.front(); E; E = E->next()) {
+
+		p_writer.put_string(E->get());
+	}
+
+	p_writer.put_32(p_script->member_info.size());
+	for (const Map<StringName, PropertyInfo>::Element *E = p_script->member_info.front(); E; E = E->next()) {
+
+		const PropertyInfo &info = E->get();
+		p_writer.put_string(E->key());
+		p_writer.put_32(info.type);
+		p_writer.put_string(info.class_name);
+		p_writer.put_32(info.hint);
+		p_writer.put_string(info.hint_string);
+		p_writer.put_32(info.usage);
+	}
+
+	p_writer.put_32(p_script->constants.size());
+	for (const Map<StringName, Variant>::Element *E = p_script->constants.front(); E; E = E->next()) {
+
+		p_writer.put_string(E->key());
+		p_writer.put_variant(E->get());
+	}
+
+	p_writer.put_32(p_script->_signals.size());
+	for (const Map<StringName, Vector<StringName> >::Element *E = p_script->_signals.front(); E; E = E->next()) {
+
+		p_writer.put_string(E->key());
+		p_writer.put_32(E->get().size());
+		for (int i = 0; i < E->get().size(); i++) {
+			p_writer.put_string(E->get()[i]);
+		}
+	}
+
+	p_writer.put_32(p_script->member_functions.size());
+	for (const Map<StringName, GDScriptFunction *>::Element *E = p_script->member_functions.front(); E; E = E->next()) {
+
+		_save_function(p_writer, E->get());
+	}
+
+	for (const Map<StringName, Ref<GDScript> >::Element *E = p_script->subclasses.front(); E; E = E->next()) {
+
+		_save_class(p_writer, E->get().ptr());
+	}
+}
+
+void GDScriptBytecode::_save_function(Writer &p_writer, const GDScriptFunction *p_function) {
+
+	p_writer.put_string(p_function->name);
+	p_writer.put_32(p_function->_static);
+	p_writer.put_32(p_function->rpc_mode);
+	p_writer.put_32(p_function->_argument_count);
+	p_writer.put_32(p_function->_stack_size);
+	p_writer.put_32(p_function->_call_size);
+	p_writer.put_32(p_function->_initial_line);
+	p_writer.put_32(p_function->_inline_cache_count);
+
+	p_writer.put_32(p_function->argument_types.size());
+	for (int i = 0; i < p_function->argument_types.size(); i++) {
+		p_writer.put_data_type(p_function->argument_types[i]);
+	}
+	p_writer.put_data_type(p_function->return_type);
+
+#ifdef TOOLS_ENABLED
+	p_writer.put_32(p_function->arg_names.size());
+	for (int i = 0; i < p_function->arg_names.size(); i++) {
+		p_writer.put_string(p_function->arg_names[i]);
+	}
+#else
+	p_writer.put_32(0);
+#endif
+
+	p_writer.put_32(p_function->constants.size());
+	for (int i = 0; i < p_function->constants.size(); i++) {
+		p_writer.put_variant(p_function->constants[i]);
+	}
+
+	p_writer.put_32(p_function->global_names.size());
+	for (int i = 0; i < p_function->global_names.size(); i++) {
+		p_writer.put_string(p_function->global_names[i]);
+	}
+
+	// Indices in the global array depend on what was registered, save globals by name
+	Vector<int> code = p_function->code;
+	Vector<int> positions;
+	if (!_find_addresses(code, positions)) {
+		p_writer.fail("Unknown instruction in function '" + String(p_function->name) + "'.");
+		return;
+	}
+
+	Vector<StringName> globals;
+	for (int i = 0; i < positions.size(); i++) {
+
+		int address = code[positions[i]];
+		int index = address & GDScriptFunction::ADDR_MASK;
+		StringName name;
+
+		switch ((address & GDScriptFunction::ADDR_TYPE_MASK) >> GDScriptFunction::ADDR_BITS) {
+			case GDScriptFunction::ADDR_TYPE_GLOBAL: {
+				ERR_FAIL_INDEX(index, p_writer.global_names.size());
+				name = p_writer.global_names[index];
+			} break;
+#ifdef TOOLS_ENABLED
+			case GDScriptFunction::ADDR_TYPE_NAMED_GLOBAL: {
+				ERR_FAIL_INDEX(index, p_function->named_globals.size());
+				name = p_function->named_globals[index];
+			} break;
+#endif
+			default: {
+				continue;
+			}
+		}
+
+		int global = globals.find(name);
+		if (global == -1) {
+			global = globals.size();
+			globals.push_back(name);
+		}
+		code.write[positions[i]] = global | (GDScriptFunction::ADDR_TYPE_GLOBAL << GDScriptFunction::ADDR_BITS);
+	}
+
+	p_writer.put_32(globals.size());
+	for (int i = 0; i < globals.size(); i++) {
+		p_writer.put_string(globals[i]);
+	}
+
+	p_writer.put_32(p_function->default_arguments.size());
+	for (int i = 0; i < p_function->default_arguments.size(); i++) {
+		p_writer.put_32(p_function->default_arguments[i]);
+	}
+
+	p_writer.put_32(code.size());
+	for (int i = 0; i < code.size(); i++) {
+		p_writer.put_32(code[i]);
+	}
+
+	p_writer.put_32(p_function->stack_debug.size());
+	for (const List<GDScriptFunction::StackDebug>::Element *E = p_function->stack_debug.front(); E; E = E->next()) {
+
+		p_writer.put_32(E->get().line);
+		p_writer.put_32(E->get().pos);
+		p_writer.put_32(E->get().added);
+		p_writer.put_string(E->get().identifier);
+	}
+
+#ifdef DEBUG_ENABLED
+	p_writer.put_string(p_function->profile.signature);
+#else
+	p_writer.put_string(String());
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////
+
+void GDScriptBytecode::_load_class_tree(Reader &p_reader, GDScript *p_script) {
+
+	int count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+
+		StringName name = p_reader.get_string();
+
+		Ref<GDScript> subclass;
+		subclass.instance();
+		subclass->_owner = p_script;
+		p_script->subclasses.insert(name, subclass);
+
+		_load_class_tree(p_reader, subclass.ptr());
+	}
+}
+
+void GDScriptBytecode::_load_class(Reader &p_reader, GDScript *p_script) {
+
+	p_script->tool = p_reader.get_32();
+	p_script->name = p_reader.get_string();
+
+	StringName native_name = p_reader.get_string();
+	if (native_name != StringName()) {
+
+		Ref<GDScriptNativeClass> native;
+		const Map<StringName, int> &globals = GDScriptLanguage::get_singleton()->get_global_map();
+		if (globals.has(native_name)) {
+			native = GDScriptLanguage::get_singleton()->get_global_array()[globals[native_name]];
+		}
+		if (native.is_null()) {
+			p_reader.fail("Native class '" + String(native_name) + "' not found.");
+			return;
+		}
+		p_script->native = native;
+	}
+
+	Variant base = p_reader.get_variant();
+	if (base.get_type() != Variant::NIL) {
+
+		p_script->base = base;
+		if (p_script->base.is_null()) {
+			p_reader.fail("Base script is not a GDScript.");
+			return;
+		}
+		p_script->_base = p_script->base.ptr();
+	}
+
+	// Members of the base are numbered first, they must not have changed. Inner classes
+	// used as base may not be loaded yet, so this is checked once everything is.
+	int inherited_count = p_reader.get_32();
+	p_reader.inherited_counts[p_script] = inherited_count;
+
+	int count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+
+		StringName name = p_reader.get_string();
+		GDScript::MemberInfo minfo;
+		minfo.index = p_reader.get_32();
+		minfo.setter = p_reader.get_string();
+		minfo.getter = p_reader.get_string();
+		minfo.rpc_mode = (MultiplayerAPI::RPCMode)p_reader.get_32();
+		minfo.data_type = p_reader.get_data_type();
+		if (minfo.index < 0 || minfo.index >= count) {
+			p_reader.fail("Invalid member index.");
+			return;
+		}
+		p_script->member_indices[name] = minfo;
+	}
+
+	count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+
+		p_script->members.insert(p_reader.get_string());
+	}
+
+	count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+
+		PropertyInfo info;
+		info.name = p_reader.get_string();
+		info.type = (Variant::Type)p_reader.get_32();
+		info.class_name = p_reader.get_string();
+		info.hint = (PropertyHint)p_reader.get_32();
+		info.hint_string = p_reader.get_string();
+		info.usage = p_reader.get_32();
+		p_script->member_info[info.name] = info;
+	}
+
+	count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+
+		StringName name = p_reader.get_string();
+		p_script->constants[name] = p_reader.get_variant();
+	}
+
+	count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+
+		StringName name = p_reader.get_string();
+		Vector<StringName> arguments;
+		int argument_count = p_reader.get_count();
+		for (int j = 0; j < argument_count && !p_reader.failed; j++) {
+			arguments.push_back(p_reader.get_string());
+		}
+		p_script->_signals[name] = arguments;
+	}
+
+	count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+
+		_load_function(p_reader, p_script);
+	}
+
+	if (p_reader.failed) {
+		return;
+	}
+
+	if (p_script->member_functions.has("_init")) {
+		p_script->initializer = p_script->member_functions["_init"];
+	} else {
+		p_reader.fail("Missing initializer.");
+		return;
+	}
+
+	for (Map<StringName, Ref<GDScript> >::Element *E = p_script->subclasses.front(); E && !p_reader.failed; E = E->next()) {
+
+		_load_class(p_reader, E->get().ptr());
+	}
+
+	p_script->valid = true;
+}
+
+void GDScriptBytecode::_load_function(Reader &p_reader, GDScript *p_script) {
+
+	StringName name = p_reader.get_string();
+	if (p_reader.failed) {
+		return;
+	}
+
+	if (p_script->member_functions.has(name)) {
+		p_reader.fail("Function '" + String(name) + "' is repeated.");
+		return;
+	}
+
+	// added first, so it's freed along with the script if loading fails
+	GDScriptFunction *gdfunc = memnew(GDScriptFunction);
+	p_script->member_functions[name] = gdfunc;
+
+	gdfunc->name = name;
+	gdfunc->_script = p_script;
+	gdfunc->source = p_reader.root->get_path(); // same as the compiler
+	gdfunc->_static = p_reader.get_32();
+	gdfunc->rpc_mode = (MultiplayerAPI::RPCMode)p_reader.get_32();
+	gdfunc->_argument_count = p_reader.get_32();
+	gdfunc->_stack_size = p_reader.get_32();
+	gdfunc->_call_size = p_reader.get_32();
+	gdfunc->_initial_line = p_reader.get_32();
+	int inline_cache_count = p_reader.get_count();
+
+	int count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+		gdfunc->argument_types.push_back(p_reader.get_data_type());
+	}
+	gdfunc->return_type = p_reader.get_data_type();
+
+	count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+#ifdef TOOLS_ENABLED
+		gdfunc->arg_names.push_back(p_reader.get_string());
+#else
+		p_reader.get_string();
+#endif
+	}
+
+	count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+		gdfunc->constants.push_back(p_reader.get_variant());
+	}
+
+	count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+		gdfunc->global_names.push_back(p_reader.get_string());
+	}
+
+	// addresses of the globals used by the code, looked up by name
+	Vector<int> globals;
+	count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+
+		StringName global = p_reader.get_string();
+		const Map<StringName, int> &global_map = GDScriptLanguage::get_singleton()->get_global_map();
+		if (global_map.has(global)) {
+			globals.push_back(global_map[global] | (GDScriptFunction::ADDR_TYPE_GLOBAL << GDScriptFunction::ADDR_BITS));
+			continue;
+		}
+#ifdef TOOLS_ENABLED
+		if (GDScriptLanguage::get_singleton()->get_named_globals_map().has(global)) {
+			globals.push_back(gdfunc->named_globals.size() | (GDScriptFunction::ADDR_TYPE_NAMED_GLOBAL << GDScriptFunction::ADDR_BITS));
+			gdfunc->named_globals.push_back(global);
+			continue;
+		}
+#endif
+		p_reader.fail("Identifier not found: " + String(global));
+	}
+
+	count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+		gdfunc->default_arguments.push_back(p_reader.get_32());
+	}
+
+	count = p_reader.get_count();
+	gdfunc->code.resize(count);
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+		gdfunc->code.write[i] = p_reader.get_32();
+	}
+
+	count = p_reader.get_count();
+	for (int i = 0; i < count && !p_reader.failed; i++) {
+
+		GDScriptFunction::StackDebug sd;
+		sd.line = p_reader.get_32();
+		sd.pos = p_reader.get_32();
+		sd.added = p_reader.get_32();
+		sd.identifier = p_reader.get_string();
+		gdfunc->stack_debug.push_back(sd);
+	}
+
+	String signature = p_reader.get_string();
+
+	if (p_reader.failed) {
+		return;
+	}
+
+	// Check the addresses as the VM trusts them, and resolve the globals
+	Vector<int> positions;
+	if (!_find_addresses(gdfunc->code, positions)) {
+		p_reader.fail("Invalid code in function '" + String(name) + "'.");
+		return;
+	}
+
+	for (int i = 0; i < positions.size(); i++) {
+
+		int address = gdfunc->code[positions[i]];
+		int index = address & GDScriptFunction::ADDR_MASK;
+		int limit = 0;
+
+		switch ((address & GDScriptFunction::ADDR_TYPE_MASK) >> GDScriptFunction::ADDR_BITS) {
+			case GDScriptFunction::ADDR_TYPE_SELF:
+			case GDScriptFunction::ADDR_TYPE_CLASS:
+			case GDScriptFunction::ADDR_TYPE_NIL: {
+				continue;
+			} break;
+			case GDScriptFunction::ADDR_TYPE_MEMBER: limit = p_script->member_indices.size(); break;
+			case GDScriptFunction::ADDR_TYPE_CLASS_CONSTANT: limit = gdfunc->global_names.size(); break;
+			case GDScriptFunction::ADDR_TYPE_LOCAL_CONSTANT: limit = gdfunc->constants.size(); break;
+			case GDScriptFunction::ADDR_TYPE_STACK:
+			case GDScriptFunction::ADDR_TYPE_STACK_VARIABLE: limit = gdfunc->_stack_size; break;
+			case GDScriptFunction::ADDR_TYPE_GLOBAL: {
+				if (index >= globals.size()) {
+					break;
+				}
+				gdfunc->code.write[positions[i]] = globals[index];
+				continue;
+			} break;
+			default: {
+			}
+		}
+
+		if (index >= limit) {
+			p_reader.fail("Invalid address in function '" + String(name) + "'.");
+			return;
+		}
+	}
+
+	for (int i = 0; i < gdfunc->default_arguments.size(); i++) {
+		if (gdfunc->default_arguments[i] < 0 || gdfunc->default_arguments[i] >= gdfunc->code.size()) {
+			p_reader.fail("Invalid default argument in function '" + String(name) + "'.");
+			return;
+		}
+	}
+
+	// same as what the compiler sets up
+	gdfunc->_constant_count = gdfunc->constants.size();
+	gdfunc->_constants_ptr = gdfunc->constants.size() ? gdfunc->constants.ptrw() : NULL;
+	gdfunc->_global_names_count = gdfunc->global_names.size();
+	gdfunc->_global_names_ptr = gdfunc->global_names.size() ? gdfunc->global_names.ptr() : NULL;
+#ifdef TOOLS_ENABLED
+	gdfunc->_named_globals_count = gdfunc->named_globals.size();
+	gdfunc->_named_globals_ptr = gdfunc->named_globals.size() ? gdfunc->named_globals.ptr() : NULL;
+#endif
+
+	gdfunc->_create_inline_caches(inline_cache_count);
+
+	gdfunc->_code_size = gdfunc->code.size();
+	gdfunc->_code_ptr = gdfunc->code.size() ? gdfunc->code.ptr() : NULL;
+
+	if (gdfunc->default_arguments.size()) {
+		gdfunc->_default_arg_count = gdfunc->default_arguments.size() - 1;
+		gdfunc->_default_arg_ptr = gdfunc->default_arguments.ptr();
+	} else {
+		gdfunc->_default_arg_count = 0;
+		gdfunc->_default_arg_ptr = NULL;
+	}
+
+#ifdef DEBUG_ENABLED
+	if (ScriptDebugger::get_singleton()) {
+		gdfunc->profile.signature = signature;
+	}
+
+	gdfunc->func_cname = (String(gdfunc->source) + " - " + String(name)).utf8();
+	gdfunc->_func_cname = gdfunc->func_cname.get_data();
+#endif
+}
+
+void GDScriptBytecode::_clear_class(GDScript *p_script) {
+
+	for (Map<StringName, GDScriptFunction *>::Element *E = p_script->member_functions.front(); E; E = E->next()) {
+		memdelete(E->get());
+	}
+	p_script->member_functions.clear();
+	p_script->native = Ref<GDScriptNativeClass>();
+	p_script->base = Ref<GDScript>();
+	p_script->_base = NULL;
+	p_script->members.clear();
+	p_script->constants.clear();
+	p_script->member_indices.clear();
+	p_script->member_info.clear();
+	p_script->_signals.clear();
+	p_script->subclasses.clear();
+	p_script->initializer = NULL;
+	p_script->tool = false;
+	p_script->valid = false;
+}
+
+/////////////////////////////////////////////////////////////////////////
+
+Ref<GDScript> GDScriptBytecode::_compile_without_debug_code(const Ref<GDScript> &p_script) {
+
+	// A separate script, so the one in use keeps its debug code
+	Ref<GDScript> script;
+	script.instance();
+	script->set_script_path(p_script->get_path());
+	script->set_source_code(p_script->get_source_code());
+
+	GDScriptParser parser;
+	Error err = parser.parse(script->get_source_code(), p_script->get_path().get_base_dir(), false, p_script->get_path());
+	if (err != OK) {
+		return Ref<GDScript>();
+	}
+
+	GDScriptCompiler compiler;
+	compiler.set_debug_code(false);
+	err = compiler.compile(&parser, script.ptr());
+	if (err != OK) {
+		return Ref<GDScript>();
+	}
+
+	return script;
+}
+
+Vector<uint8_t> GDScriptBytecode::make_buffer(const Ref<GDScript> &p_script, const Vector<uint8_t> &p_tokens, bool p_debug) {
+
+	ERR_FAIL_COND_V(p_script.is_null(), p_tokens);
+
+	if (!p_script->is_valid()) {
+		return p_tokens;
+	}
+
+	Ref<GDScript> script = p_script;
+	uint32_t flags = _get_flags();
+
+	if (!p_debug) {
+		// Release builds only use code compiled the way they would, without debug code nor stack
+		flags = 0;
+		if (_get_flags() & FLAG_DEBUG_CODE) {
+			script = _compile_without_debug_code(p_script);
+			if (script.is_null()) {
+				if (OS::get_singleton()->is_stdout_verbose()) {
+					print_line("GDScript: Exporting '" + p_script->get_path() + "' without compiled code: it doesn't compile without debug code.");
+				}
+				return p_tokens;
+			}
+		}
+	}
+
+	Writer writer(script.ptr());
+	_save_class_tree(writer, script.ptr());
+	_save_class(writer, script.ptr());
+
+	if (writer.failed) {
+		if (OS::get_singleton()->is_stdout_verbose()) {
+			print_line("GDScript: Exporting '" + p_script->get_path() + "' without compiled code: " + writer.error);
+		}
+		return p_tokens;
+	}
+
+	Vector<uint8_t> buffer;
+	buffer.resize(HEADER_SIZE + writer.buffer.size() + p_tokens.size());
+
+	uint8_t *w = buffer.ptrw();
+	w[0] = 'G';
+	w[1] = 'D';
+	w[2] = 'B';
+	w[3] = 'C';
+	encode_uint32(COMPILED_VERSION, &w[4]);
+	encode_uint32(_get_engine_hash(), &w[8]);
+	encode_uint32(flags, &w[12]);
+	encode_uint32(writer.buffer.size(), &w[16]);
+	copymem(&w[HEADER_SIZE], writer.buffer.ptr(), writer.buffer.size());
+	copymem(&w[HEADER_SIZE + writer.buffer.size()], p_tokens.ptr(), p_tokens.size());
+
+	return buffer;
+}
+
+Vector<uint8_t> GDScriptBytecode::get_tokens(const Vector<uint8_t> &p_buffer) {
+
+	const uint8_t *buf = p_buffer.ptr();
+
+	if (p_buffer.size() < HEADER_SIZE || buf[0] != 'G' || buf[1] != 'D' || buf[2] != 'B' || buf[3] != 'C') {
+		return p_buffer; // tokens only
+	}
+
+	int compiled_size = decode_uint32(&buf[16]);
+	ERR_FAIL_COND_V(compiled_size < 0 || compiled_size > p_buffer.size() - HEADER_SIZE, Vector<uint8_t>());
+
+	Vector<uint8_t> tokens;
+	tokens.resize(p_buffer.size() - HEADER_SIZE - compiled_size);
+	copymem(tokens.ptrw(), &buf[HEADER_SIZE + compiled_size], tokens.size());
+	return tokens;
+}
+
+Error GDScriptBytecode::load_buffer(const Vector<uint8_t> &p_buffer, GDScript *p_script, Vector<uint8_t> &r_tokens) {
+
+	const uint8_t *buf = p_buffer.ptr();
+
+	if (p_buffer.size() < HEADER_SIZE || buf[0] != 'G' || buf[1] != 'D' || buf[2] != 'B' || buf[3] != 'C') {
+		r_tokens = p_buffer; // tokens only
+		return ERR_UNAVAILABLE;
+	}
+
+	uint32_t version = decode_uint32(&buf[4]);
+	uint32_t engine_hash = decode_uint32(&buf[8]);
+	uint32_t flags = decode_uint32(&buf[12]);
+	int compiled_size = decode_uint32(&buf[16]);
+
+	ERR_FAIL_COND_V(compiled_size < 0 || compiled_size > p_buffer.size() - HEADER_SIZE, ERR_INVALID_DATA);
+
+	r_tokens.resize(p_buffer.size() - HEADER_SIZE - compiled_size);
+	copymem(r_tokens.ptrw(), &buf[HEADER_SIZE + compiled_size], r_tokens.size());
+
+	if (version != COMPILED_VERSION || engine_hash != _get_engine_hash()) {
+		if (OS::get_singleton()->is_stdout_verbose()) {
+			print_line("GDScript: Compiled code of '" + p_script->get_path() + "' is from another engine version, compiling it.");
+		}
+		return ERR_UNAVAILABLE;
+	}
+
+	// Debug builds need the debug instructions, and the stack when debugging; release builds
+	// would be slowed down by them, so only code compiled the same way is used
+	if ((flags & FLAG_DEBUG_CODE) != (_get_flags() & FLAG_DEBUG_CODE) || ((_get_flags() & FLAG_DEBUG_STACK) && !(flags & FLAG_DEBUG_STACK))) {
+		return ERR_UNAVAILABLE;
+	}
+
+	Reader reader;
+	reader.data = &buf[HEADER_SIZE];
+	reader.size = compiled_size;
+	reader.pos = 0;
+	reader.root = p_script;
+	reader.failed = false;
+
+	_clear_class(p_script);
+
+	// Functions and members are about to be replaced
+	GDScriptLanguage::get_singleton()->invalidate_inline_caches();
+
+	_load_class_tree(reader, p_script);
+	if (!reader.failed) {
+		_load_class(reader, p_script);
+	}
+
+	for (Map<GDScript *, int>::Element *E = reader.inherited_counts.front(); E && !reader.failed; E = E->next()) {
+
+		GDScript *script = E->key();
+		if ((script->base.is_valid() ? script->base->member_indices.size() : 0) != E->get()) {
+			reader.fail("Members of the base script have changed.");
+		}
+	}
+
+	if (reader.failed || reader.pos != reader.size) {
+		if (OS::get_singleton()->is_stdout_verbose()) {
+			print_line("GDScript: Can't use the compiled code of '" + p_script->get_path() + "', compiling it: " + (reader.failed ? reader.error : String("Unexpected data.")));
+		}
+		_clear_class(p_script);
+		return ERR_INVALID_DATA;
+	}
+
+	return OK;
+}
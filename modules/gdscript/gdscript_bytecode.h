@@ -0,0 +1,66 @@
+/*************************************************************************/
+/*  gdscript_bytecode.h                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_BYTECODE_H
+#define GDSCRIPT_BYTECODE_H
+
+#include "gdscript.h"
+
+// Exported scripts can carry their compiled code along with the tokens, so loading them
+// doesn't need to parse and compile them again. The compiled code is only used by the
+// engine build that saved it, otherwise (or when something it references can't be found)
+// the script is compiled from the tokens as usual.
+
+class GDScriptBytecode {
+
+	struct Writer;
+	struct Reader;
+
+	static void _save_class_tree(Writer &p_writer, const GDScript *p_script);
+	static void _save_class(Writer &p_writer, const GDScript *p_script);
+	static void _save_function(Writer &p_writer, const GDScriptFunction *p_function);
+
+	static void _load_class_tree(Reader &p_reader, GDScript *p_script);
+	static void _load_class(Reader &p_reader, GDScript *p_script);
+	static void _load_function(Reader &p_reader, GDScript *p_script);
+	static void _clear_class(GDScript *p_script);
+	static Ref<GDScript> _compile_without_debug_code(const Ref<GDScript> &p_script);
+
+public:
+	// Buffer to export, with the compiled code of the script if it can be saved.
+	// Release buffers hold the code compiled without debug code, as release builds expect.
+	static Vector<uint8_t> make_buffer(const Ref<GDScript> &p_script, const Vector<uint8_t> &p_tokens, bool p_debug = true);
+	// Tokens of an exported buffer, whether it has compiled code or not.
+	static Vector<uint8_t> get_tokens(const Vector<uint8_t> &p_buffer);
+	// Loads the compiled code into the script, the tokens are returned in case it can't be used.
+	static Error load_buffer(const Vector<uint8_t> &p_buffer, GDScript *p_script, Vector<uint8_t> &r_tokens);
+};
+
+#endif // GDSCRIPT_BYTECODE_H
@@ -31,6 +31,7 @@
 #include "gdscript_compiler.h"
 
 #include "gdscript.h"
+#include "project_settings.h"
 
 bool GDScriptCompiler::_is_class_member_property(CodeGen &codegen, const StringName &p_name) {
 
@@ -74,6 +75,141 @@ void GDScriptCompiler::_set_error(const String &p_error, const GDScriptParser::N
 	}
 }
 
+// The typed opcodes below check the operand types again when running, so guessing
+// wrong here only costs the fallback to the generic version.
+
+static Variant::Type _get_builtin_type(const GDScriptParser::Node *p_node) {
+
+	GDScriptParser::DataType datatype = p_node->get_datatype();
+	if (!datatype.has_type || datatype.is_meta_type || datatype.kind != GDScriptParser::DataType::BUILTIN) {
+		return Variant::NIL;
+	}
+	return datatype.builtin_type;
+}
+
+static bool _is_number_type(Variant::Type p_type) {
+
+	return p_type == Variant::INT || p_type == Variant::REAL;
+}
+
+static GDScriptFunction::Opcode _get_operator_opcode(Variant::Operator p_op, Variant::Type p_type_a, Variant::Type p_type_b) {
+
+	if (p_type_a == Variant::INT && p_type_b == Variant::INT) {
+		switch (p_op) {
+			case Variant::OP_NOT:
+			case Variant::OP_AND:
+			case Variant::OP_OR:
+			case Variant::OP_XOR:
+			case Variant::OP_IN: return GDScriptFunction::OPCODE_OPERATOR;
+			default: return GDScriptFunction::OPCODE_OPERATOR_INT;
+		}
+	}
+
+	if (_is_number_type(p_type_a) && _is_number_type(p_type_b)) {
+		switch (p_op) {
+			case Variant::OP_EQUAL:
+			case Variant::OP_NOT_EQUAL:
+			case Variant::OP_LESS:
+			case Variant::OP_LESS_EQUAL:
+			case Variant::OP_GREATER:
+			case Variant::OP_GREATER_EQUAL:
+			case Variant::OP_ADD:
+			case Variant::OP_SUBTRACT:
+			case Variant::OP_MULTIPLY:
+			case Variant::OP_DIVIDE:
+			case Variant::OP_NEGATE:
+			case Variant::OP_POSITIVE: return GDScriptFunction::OPCODE_OPERATOR_REAL;
+			default: return GDScriptFunction::OPCODE_OPERATOR;
+		}
+	}
+
+	Variant::Type vector_type = Variant::NIL;
+	if (p_type_a == Variant::VECTOR2 || p_type_a == Variant::VECTOR3) {
+		vector_type = p_type_a;
+	} else if (p_type_b == Variant::VECTOR2 || p_type_b == Variant::VECTOR3) {
+		vector_type = p_type_b;
+	}
+
+	if (vector_type != Variant::NIL) {
+		bool same = p_type_a == p_type_b;
+		bool scaled = (p_type_a == vector_type && _is_number_type(p_type_b)) || (_is_number_type(p_type_a) && p_type_b == vector_type);
+		bool supported = false;
+
+		switch (p_op) {
+			case Variant::OP_EQUAL:
+			case Variant::OP_NOT_EQUAL:
+			case Variant::OP_ADD:
+			case Variant::OP_SUBTRACT:
+			case Variant::OP_NEGATE:
+			case Variant::OP_POSITIVE: supported = same; break;
+			case Variant::OP_MULTIPLY: supported = same || scaled; break;
+			case Variant::OP_DIVIDE: supported = same || (scaled && p_type_a == vector_type); break;
+			default: break;
+		}
+
+		if (supported) {
+			return vector_type == Variant::VECTOR2 ? GDScriptFunction::OPCODE_OPERATOR_VECTOR2 : GDScriptFunction::OPCODE_OPERATOR_VECTOR3;
+		}
+	}
+
+	return GDScriptFunction::OPCODE_OPERATOR;
+}
+
+static bool _is_vector_member(const GDScriptParser::Node *p_base, const StringName &p_name) {
+
+	Variant::Type type = _get_builtin_type(p_base);
+	if (type == Variant::VECTOR2) {
+		return p_name == "x" || p_name == "y";
+	}
+	if (type == Variant::VECTOR3) {
+		return p_name == "x" || p_name == "y" || p_name == "z";
+	}
+	return false;
+}
+
+// Calls to native methods can skip the Variant conversions when the types of all the
+// arguments are known, the VM still checks them along with the receiver before doing so.
+static bool _is_ptrcall(const GDScriptParser::OperatorNode *p_call, const GDScript *p_script, bool p_static) {
+
+#ifdef GDSCRIPT_PTRCALL_ENABLED
+	const GDScriptParser::Node *instance = p_call->arguments[0];
+
+	StringName native_class;
+	if (instance->type == GDScriptParser::Node::TYPE_SELF) {
+		if (p_static) {
+			return false;
+		}
+		native_class = p_script->get_instance_base_type();
+	} else {
+		GDScriptParser::DataType datatype = instance->get_datatype();
+		if (!datatype.has_type || datatype.is_meta_type || datatype.kind != GDScriptParser::DataType::NATIVE) {
+			return false;
+		}
+		native_class = datatype.native_type;
+	}
+
+	if (native_class == StringName()) {
+		return false;
+	}
+
+	const StringName &method_name = static_cast<const GDScriptParser::IdentifierNode *>(p_call->arguments[1])->name;
+	MethodBind *method = ClassDB::get_method(native_class, method_name);
+	if (!method || !GDScriptFunction::can_ptrcall(method) || method->get_argument_count() != p_call->arguments.size() - 2) {
+		return false;
+	}
+
+	for (int i = 2; i < p_call->arguments.size(); i++) {
+		if (_get_builtin_type(p_call->arguments[i]) != method->get_argument_type(i - 2)) {
+			return false;
+		}
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
 bool GDScriptCompiler::_create_unary_operator(CodeGen &codegen, const GDScriptParser::OperatorNode *on, Variant::Operator op, int p_stack_level) {
 
 	ERR_FAIL_COND_V(on->arguments.size() != 1, false);
@@ -82,7 +218,9 @@ bool GDScriptCompiler::_create_unary_operator(CodeGen &codegen, const GDScriptPa
 	if (src_address_a < 0)
 		return false;
 
-	codegen.opcodes.push_back(GDScriptFunction::OPCODE_OPERATOR); // perform operator
+	Variant::Type type = _get_builtin_type(on->arguments[0]);
+
+	codegen.opcodes.push_back(_get_operator_opcode(op, type, type)); // perform operator
 	codegen.opcodes.push_back(op); //which operator
 	codegen.opcodes.push_back(src_address_a); // argument 1
 	codegen.opcodes.push_back(src_address_a); // argument 2 (repeated)
@@ -104,13 +242,67 @@ bool GDScriptCompiler::_create_binary_operator(CodeGen &codegen, const GDScriptP
 	if (src_address_b < 0)
 		return false;
 
-	codegen.opcodes.push_back(GDScriptFunction::OPCODE_OPERATOR); // perform operator
+	codegen.opcodes.push_back(_get_operator_opcode(op, _get_builtin_type(on->arguments[0]), _get_builtin_type(on->arguments[1]))); // perform operator
 	codegen.opcodes.push_back(op); //which operator
 	codegen.opcodes.push_back(src_address_a); // argument 1
 	codegen.opcodes.push_back(src_address_b); // argument 2 (unary only takes one parameter)
 	return true;
 }
 
+// Returns the position of the jump address, which is left for the caller to fill.
+int GDScriptCompiler::_create_jump_if_not(CodeGen &codegen, const GDScriptParser::Node *p_condition, int p_stack_level) {
+
+	if (p_condition->type == GDScriptParser::Node::TYPE_OPERATOR) {
+
+		const GDScriptParser::OperatorNode *on = static_cast<const GDScriptParser::OperatorNode *>(p_condition);
+		Variant::Operator op = Variant::OP_MAX;
+
+		switch (on->op) {
+			case GDScriptParser::OperatorNode::OP_EQUAL: op = Variant::OP_EQUAL; break;
+			case GDScriptParser::OperatorNode::OP_NOT_EQUAL: op = Variant::OP_NOT_EQUAL; break;
+			case GDScriptParser::OperatorNode::OP_LESS: op = Variant::OP_LESS; break;
+			case GDScriptParser::OperatorNode::OP_LESS_EQUAL: op = Variant::OP_LESS_EQUAL; break;
+			case GDScriptParser::OperatorNode::OP_GREATER: op = Variant::OP_GREATER; break;
+			case GDScriptParser::OperatorNode::OP_GREATER_EQUAL: op = Variant::OP_GREATER_EQUAL; break;
+			default: break;
+		}
+
+		if (op != Variant::OP_MAX && _is_number_type(_get_builtin_type(on->arguments[0])) && _is_number_type(_get_builtin_type(on->arguments[1]))) {
+
+			//compare and jump in one go, without storing the result
+			int src_address_a = _parse_expression(codegen, on->arguments[0], p_stack_level);
+			if (src_address_a < 0)
+				return -1;
+
+			int slevel = p_stack_level;
+			if (src_address_a & GDScriptFunction::ADDR_TYPE_STACK << GDScriptFunction::ADDR_BITS)
+				slevel++; //uses stack for return, increase stack
+
+			int src_address_b = _parse_expression(codegen, on->arguments[1], slevel);
+			if (src_address_b < 0)
+				return -1;
+
+			codegen.opcodes.push_back(GDScriptFunction::OPCODE_JUMP_IF_NOT_COMPARE);
+			codegen.opcodes.push_back(op);
+			codegen.opcodes.push_back(src_address_a);
+			codegen.opcodes.push_back(src_address_b);
+			int jump_addr = codegen.opcodes.size();
+			codegen.opcodes.push_back(0); //temporary
+			return jump_addr;
+		}
+	}
+
+	int ret = _parse_expression(codegen, p_condition, p_stack_level, false);
+	if (ret < 0)
+		return -1;
+
+	codegen.opcodes.push_back(GDScriptFunction::OPCODE_JUMP_IF_NOT);
+	codegen.opcodes.push_back(ret);
+	int jump_addr = codegen.opcodes.size();
+	codegen.opcodes.push_back(0); //temporary
+	return jump_addr;
+}
+
 GDScriptDataType GDScriptCompiler::_gdtype_from_datatype(const GDScriptParser::DataType &p_datatype) const {
 	if (!p_datatype.has_type) {
 		return GDScriptDataType();
@@ -663,10 +855,17 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 							arguments.push_back(ret);
 						}
 
-						codegen.opcodes.push_back(p_root ? GDScriptFunction::OPCODE_CALL : GDScriptFunction::OPCODE_CALL_RETURN); // perform operator
+						if (_is_ptrcall(on, codegen.script, codegen.function_node && codegen.function_node->_static)) {
+							codegen.opcodes.push_back(p_root ? GDScriptFunction::OPCODE_CALL_PTRCALL : GDScriptFunction::OPCODE_CALL_PTRCALL_RETURN);
+						} else {
+							codegen.opcodes.push_back(p_root ? GDScriptFunction::OPCODE_CALL : GDScriptFunction::OPCODE_CALL_RETURN); // perform operator
+						}
 						codegen.opcodes.push_back(on->arguments.size() - 2);
 						codegen.alloc_call(on->arguments.size() - 2);
-						for (int i = 0; i < arguments.size(); i++)
+						codegen.opcodes.push_back(arguments[0]); // base
+						codegen.opcodes.push_back(arguments[1]); // method name
+						codegen.opcodes.push_back(codegen.add_inline_cache());
+						for (int i = 2; i < arguments.size(); i++)
 							codegen.opcodes.push_back(arguments[i]);
 					}
 				} break;
@@ -754,9 +953,16 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 						}
 					}
 
-					codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_GET_NAMED : GDScriptFunction::OPCODE_GET); // perform operator
+					if (named && on->op == GDScriptParser::OperatorNode::OP_INDEX_NAMED && _is_vector_member(on->arguments[0], static_cast<GDScriptParser::IdentifierNode *>(on->arguments[1])->name)) {
+						codegen.opcodes.push_back(GDScriptFunction::OPCODE_GET_NAMED_VECTOR);
+					} else {
+						codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_GET_NAMED : GDScriptFunction::OPCODE_GET); // perform operator
+					}
 					codegen.opcodes.push_back(from); // argument 1
 					codegen.opcodes.push_back(index); // argument 2 (unary only takes one parameter)
+					if (named) {
+						codegen.opcodes.push_back(codegen.add_inline_cache());
+					}
 
 				} break;
 				case GDScriptParser::OperatorNode::OP_AND: {
@@ -1061,6 +1267,9 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 							codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_GET_NAMED : GDScriptFunction::OPCODE_GET);
 							codegen.opcodes.push_back(prev_pos);
 							codegen.opcodes.push_back(key_idx);
+							if (named) {
+								codegen.opcodes.push_back(codegen.add_inline_cache());
+							}
 							slevel++;
 							codegen.alloc_stack(slevel);
 							int dst_pos = (GDScriptFunction::ADDR_TYPE_STACK << GDScriptFunction::ADDR_BITS) | slevel;
@@ -1104,7 +1313,11 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 						if (set_value < 0) //error
 							return set_value;
 
-						codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_SET_NAMED : GDScriptFunction::OPCODE_SET);
+						if (named && _is_vector_member(op->arguments[0], static_cast<const GDScriptParser::IdentifierNode *>(op->arguments[1])->name)) {
+							codegen.opcodes.push_back(GDScriptFunction::OPCODE_SET_NAMED_VECTOR);
+						} else {
+							codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_SET_NAMED : GDScriptFunction::OPCODE_SET);
+						}
 						codegen.opcodes.push_back(prev_pos);
 						codegen.opcodes.push_back(set_index);
 						codegen.opcodes.push_back(set_value);
@@ -1292,10 +1505,12 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Blo
 		switch (s->type) {
 			case GDScriptParser::Node::TYPE_NEWLINE: {
 #ifdef DEBUG_ENABLED
-				const GDScriptParser::NewLineNode *nl = static_cast<const GDScriptParser::NewLineNode *>(s);
-				codegen.opcodes.push_back(GDScriptFunction::OPCODE_LINE);
-				codegen.opcodes.push_back(nl->line);
-				codegen.current_line = nl->line;
+				if (debug_code) {
+					const GDScriptParser::NewLineNode *nl = static_cast<const GDScriptParser::NewLineNode *>(s);
+					codegen.opcodes.push_back(GDScriptFunction::OPCODE_LINE);
+					codegen.opcodes.push_back(nl->line);
+					codegen.current_line = nl->line;
+				}
 #endif
 			} break;
 			case GDScriptParser::Node::TYPE_CONTROL_FLOW: {
@@ -1371,18 +1586,26 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Blo
 					case GDScriptParser::ControlFlowNode::CF_IF: {
 
 #ifdef DEBUG_ENABLED
-						codegen.opcodes.push_back(GDScriptFunction::OPCODE_LINE);
-						codegen.opcodes.push_back(cf->line);
-						codegen.current_line = cf->line;
+						if (debug_code) {
+							codegen.opcodes.push_back(GDScriptFunction::OPCODE_LINE);
+							codegen.opcodes.push_back(cf->line);
+							codegen.current_line = cf->line;
+						}
 #endif
-						int ret = _parse_expression(codegen, cf->arguments[0], p_stack_level, false);
-						if (ret < 0)
-							return ERR_PARSE_ERROR;
+						if (codegen.optimize && cf->arguments[0]->type == GDScriptParser::Node::TYPE_CONSTANT) {
+							// Only the branch taken is compiled
+							const GDScriptParser::BlockNode *taken = static_cast<const GDScriptParser::ConstantNode *>(cf->arguments[0])->value.booleanize() ? cf->body : cf->body_else;
+							if (taken) {
+								Error err = _parse_block(codegen, taken, p_stack_level, p_break_addr, p_continue_addr);
+								if (err)
+									return err;
+							}
+							break;
+						}
 
-						codegen.opcodes.push_back(GDScriptFunction::OPCODE_JUMP_IF_NOT);
-						codegen.opcodes.push_back(ret);
-						int else_addr = codegen.opcodes.size();
-						codegen.opcodes.push_back(0); //temporary
+						int else_addr = _create_jump_if_not(codegen, cf->arguments[0], p_stack_level);
+						if (else_addr < 0)
+							return ERR_PARSE_ERROR;
 
 						Error err = _parse_block(codegen, cf->body, p_stack_level, p_break_addr, p_continue_addr);
 						if (err)
@@ -1460,6 +1683,11 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Blo
 					} break;
 					case GDScriptParser::ControlFlowNode::CF_WHILE: {
 
+						bool constant_condition = codegen.optimize && cf->arguments[0]->type == GDScriptParser::Node::TYPE_CONSTANT;
+						if (constant_condition && !static_cast<const GDScriptParser::ConstantNode *>(cf->arguments[0])->value.booleanize()) {
+							break; // Never runs
+						}
+
 						codegen.opcodes.push_back(GDScriptFunction::OPCODE_JUMP);
 						codegen.opcodes.push_back(codegen.opcodes.size() + 3);
 						int break_addr = codegen.opcodes.size();
@@ -1467,12 +1695,12 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Blo
 						codegen.opcodes.push_back(0);
 						int continue_addr = codegen.opcodes.size();
 
-						int ret = _parse_expression(codegen, cf->arguments[0], p_stack_level, false);
-						if (ret < 0)
-							return ERR_PARSE_ERROR;
-						codegen.opcodes.push_back(GDScriptFunction::OPCODE_JUMP_IF_NOT);
-						codegen.opcodes.push_back(ret);
-						codegen.opcodes.push_back(break_addr);
+						if (!constant_condition) {
+							int exit_addr = _create_jump_if_not(codegen, cf->arguments[0], p_stack_level);
+							if (exit_addr < 0)
+								return ERR_PARSE_ERROR;
+							codegen.opcodes.write[exit_addr] = break_addr;
+						}
 						Error err = _parse_block(codegen, cf->body, p_stack_level, break_addr, continue_addr);
 						if (err)
 							return err;
@@ -1531,22 +1759,26 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Blo
 			} break;
 			case GDScriptParser::Node::TYPE_ASSERT: {
 #ifdef DEBUG_ENABLED
-				// try subblocks
+				if (debug_code) {
+					// try subblocks
 
-				const GDScriptParser::AssertNode *as = static_cast<const GDScriptParser::AssertNode *>(s);
+					const GDScriptParser::AssertNode *as = static_cast<const GDScriptParser::AssertNode *>(s);
 
-				int ret = _parse_expression(codegen, as->condition, p_stack_level, false);
-				if (ret < 0)
-					return ERR_PARSE_ERROR;
+					int ret = _parse_expression(codegen, as->condition, p_stack_level, false);
+					if (ret < 0)
+						return ERR_PARSE_ERROR;
 
-				codegen.opcodes.push_back(GDScriptFunction::OPCODE_ASSERT);
-				codegen.opcodes.push_back(ret);
+					codegen.opcodes.push_back(GDScriptFunction::OPCODE_ASSERT);
+					codegen.opcodes.push_back(ret);
+				}
 #endif
 			} break;
 			case GDScriptParser::Node::TYPE_BREAKPOINT: {
 #ifdef DEBUG_ENABLED
-				// try subblocks
-				codegen.opcodes.push_back(GDScriptFunction::OPCODE_BREAKPOINT);
+				if (debug_code) {
+					// try subblocks
+					codegen.opcodes.push_back(GDScriptFunction::OPCODE_BREAKPOINT);
+				}
 #endif
 			} break;
 			case GDScriptParser::Node::TYPE_LOCAL_VAR: {
@@ -1586,9 +1818,11 @@ Error GDScriptCompiler::_parse_function(GDScript *p_script, const GDScriptParser
 	codegen.script = p_script;
 	codegen.function_node = p_func;
 	codegen.stack_max = 0;
+	codegen.inline_cache_count = 0;
 	codegen.current_line = 0;
 	codegen.call_max = 0;
 	codegen.debug_stack = ScriptDebugger::get_singleton() != NULL;
+	codegen.optimize = GLOBAL_GET("debug/gdscript/compiler/optimize").booleanize();
 	Vector<StringName> argnames;
 
 	int stack_level = 0;
@@ -1747,6 +1981,8 @@ Error GDScriptCompiler::_parse_function(GDScript *p_script, const GDScriptParser
 	}
 #endif
 
+	gdfunc->_create_inline_caches(codegen.inline_cache_count);
+
 	if (codegen.opcodes.size()) {
 
 		gdfunc->code = codegen.opcodes;
@@ -2174,6 +2410,9 @@ Error GDScriptCompiler::compile(const GDScriptParser *p_parser, GDScript *p_scri
 	// Create scripts for subclasses beforehand so they can be referenced
 	_make_scripts(p_script, static_cast<const GDScriptParser::ClassNode *>(root), p_keep_state);
 
+	// Functions and members are about to be replaced
+	GDScriptLanguage::get_singleton()->invalidate_inline_caches();
+
 	Error err = _parse_class_level(p_script, NULL, static_cast<const GDScriptParser::ClassNode *>(root), p_keep_state);
 
 	if (err)
@@ -2200,5 +2439,16 @@ int GDScriptCompiler::get_error_column() const {
 	return err_column;
 }
 
+void GDScriptCompiler::set_debug_code(bool p_enabled) {
+
+	debug_code = p_enabled;
+}
+
 GDScriptCompiler::GDScriptCompiler() {
+
+#ifdef DEBUG_ENABLED
+	debug_code = true;
+#else
+	debug_code = false;
+#endif
 }
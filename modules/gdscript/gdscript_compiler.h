@@ -48,6 +48,7 @@ class GDScriptCompiler {
 		const GDScriptParser::ClassNode *class_node;
 		const GDScriptParser::FunctionNode *function_node;
 		bool debug_stack;
+		bool optimize; // prune the code constant conditions rule out, as the parser folds them
 
 		List<Map<StringName, int> > stack_id_stack;
 		Map<StringName, int> stack_identifiers;
@@ -130,9 +131,14 @@ class GDScriptCompiler {
 			if (p_params >= call_max) call_max = p_params;
 		}
 
+		int add_inline_cache() {
+			return inline_cache_count++;
+		}
+
 		int current_line;
 		int stack_max;
 		int call_max;
+		int inline_cache_count;
 	};
 
 	bool _is_class_member_property(CodeGen &codegen, const StringName &p_name);
@@ -142,6 +148,7 @@ class GDScriptCompiler {
 
 	bool _create_unary_operator(CodeGen &codegen, const GDScriptParser::OperatorNode *on, Variant::Operator op, int p_stack_level);
 	bool _create_binary_operator(CodeGen &codegen, const GDScriptParser::OperatorNode *on, Variant::Operator op, int p_stack_level, bool p_initializer = false);
+	int _create_jump_if_not(CodeGen &codegen, const GDScriptParser::Node *p_condition, int p_stack_level);
 
 	GDScriptDataType _gdtype_from_datatype(const GDScriptParser::DataType &p_datatype) const;
 
@@ -156,8 +163,11 @@ class GDScriptCompiler {
 	int err_column;
 	StringName source;
 	String error;
+	bool debug_code;
 
 public:
+	// Line, assert and breakpoint instructions, which debug builds add unless disabled here.
+	void set_debug_code(bool p_enabled);
 	Error compile(const GDScriptParser *p_parser, GDScript *p_script, bool p_keep_state = false);
 
 	String get_error() const;
@@ -30,6 +30,7 @@
 
 #include "gdscript_function.h"
 
+#include "core_string_names.h"
 #include "gdscript.h"
 #include "gdscript_functions.h"
 #include "os/os.h"
@@ -186,15 +187,757 @@ static String _get_var_type(const Variant *p_type) {
 	return basestr;
 }
 
+// Helpers for the typed opcodes. The compiler only emits those when it can infer the
+// operand types, but the values are still checked at runtime; returning false means
+// the instruction has to be carried out by the generic version instead.
+
+static _FORCE_INLINE_ bool _evaluate_int_operator(Variant::Operator p_op, int64_t p_a, int64_t p_b, Variant &r_dst) {
+
+	switch (p_op) {
+		case Variant::OP_EQUAL: r_dst = p_a == p_b; return true;
+		case Variant::OP_NOT_EQUAL: r_dst = p_a != p_b; return true;
+		case Variant::OP_LESS: r_dst = p_a < p_b; return true;
+		case Variant::OP_LESS_EQUAL: r_dst = p_a <= p_b; return true;
+		case Variant::OP_GREATER: r_dst = p_a > p_b; return true;
+		case Variant::OP_GREATER_EQUAL: r_dst = p_a >= p_b; return true;
+		case Variant::OP_ADD: r_dst = p_a + p_b; return true;
+		case Variant::OP_SUBTRACT: r_dst = p_a - p_b; return true;
+		case Variant::OP_MULTIPLY: r_dst = p_a * p_b; return true;
+		case Variant::OP_DIVIDE: {
+			if (p_b == 0)
+				return false; // let the generic version report it
+			r_dst = p_a / p_b;
+		}
+			return true;
+		case Variant::OP_MODULE: {
+			if (p_b == 0)
+				return false;
+			r_dst = p_a % p_b;
+		}
+			return true;
+		case Variant::OP_NEGATE: r_dst = -p_a; return true;
+		case Variant::OP_POSITIVE: r_dst = p_a; return true;
+		case Variant::OP_SHIFT_LEFT: r_dst = p_a << p_b; return true;
+		case Variant::OP_SHIFT_RIGHT: r_dst = p_a >> p_b; return true;
+		case Variant::OP_BIT_AND: r_dst = p_a & p_b; return true;
+		case Variant::OP_BIT_OR: r_dst = p_a | p_b; return true;
+		case Variant::OP_BIT_XOR: r_dst = p_a ^ p_b; return true;
+		case Variant::OP_BIT_NEGATE: r_dst = ~p_a; return true;
+		default: return false;
+	}
+}
+
+static _FORCE_INLINE_ bool _evaluate_real_operator(Variant::Operator p_op, double p_a, double p_b, Variant &r_dst) {
+
+	switch (p_op) {
+		case Variant::OP_EQUAL: r_dst = p_a == p_b; return true;
+		case Variant::OP_NOT_EQUAL: r_dst = p_a != p_b; return true;
+		case Variant::OP_LESS: r_dst = p_a < p_b; return true;
+		case Variant::OP_LESS_EQUAL: r_dst = p_a <= p_b; return true;
+		case Variant::OP_GREATER: r_dst = p_a > p_b; return true;
+		case Variant::OP_GREATER_EQUAL: r_dst = p_a >= p_b; return true;
+		case Variant::OP_ADD: r_dst = p_a + p_b; return true;
+		case Variant::OP_SUBTRACT: r_dst = p_a - p_b; return true;
+		case Variant::OP_MULTIPLY: r_dst = p_a * p_b; return true;
+		case Variant::OP_DIVIDE: {
+			if (p_b == 0)
+				return false;
+			r_dst = p_a / p_b;
+		}
+			return true;
+		case Variant::OP_NEGATE: r_dst = -p_a; return true;
+		case Variant::OP_POSITIVE: r_dst = p_a; return true;
+		default: return false;
+	}
+}
+
+static _FORCE_INLINE_ bool _is_number(Variant::Type p_type) {
+
+	return p_type == Variant::INT || p_type == Variant::REAL;
+}
+
+template <class T>
+static _FORCE_INLINE_ bool _evaluate_vector_operator(Variant::Operator p_op, Variant::Type p_type, const Variant &p_a, const Variant &p_b, Variant &r_dst) {
+
+	Variant::Type type_a = p_a.get_type();
+	Variant::Type type_b = p_b.get_type();
+
+	if (type_a == p_type && type_b == p_type) {
+		T a = p_a;
+		T b = p_b;
+		switch (p_op) {
+			case Variant::OP_EQUAL: r_dst = a == b; return true;
+			case Variant::OP_NOT_EQUAL: r_dst = a != b; return true;
+			case Variant::OP_ADD: r_dst = a + b; return true;
+			case Variant::OP_SUBTRACT: r_dst = a - b; return true;
+			case Variant::OP_MULTIPLY: r_dst = a * b; return true;
+			case Variant::OP_DIVIDE: r_dst = a / b; return true;
+			case Variant::OP_NEGATE: r_dst = -a; return true;
+			case Variant::OP_POSITIVE: r_dst = a; return true;
+			default: return false;
+		}
+	} else if (type_a == p_type && _is_number(type_b)) {
+		T a = p_a;
+		real_t b = p_b;
+		switch (p_op) {
+			case Variant::OP_MULTIPLY: r_dst = a * b; return true;
+			case Variant::OP_DIVIDE: r_dst = a / b; return true;
+			default: return false;
+		}
+	} else if (_is_number(type_a) && type_b == p_type && p_op == Variant::OP_MULTIPLY) {
+		real_t a = p_a;
+		T b = p_b;
+		r_dst = b * a;
+		return true;
+	}
+
+	return false;
+}
+
+static _FORCE_INLINE_ int _get_vector_axis(Variant::Type p_type, const StringName &p_name) {
+
+	const CoreStringNames *names = CoreStringNames::get_singleton();
+	if (p_name == names->x)
+		return 0;
+	if (p_name == names->y)
+		return 1;
+	if (p_name == names->z && p_type == Variant::VECTOR3)
+		return 2;
+	return -1;
+}
+
+static _FORCE_INLINE_ bool _compare_numbers(Variant::Operator p_op, const Variant &p_a, const Variant &p_b, bool &r_result) {
+
+	Variant::Type type_a = p_a.get_type();
+	Variant::Type type_b = p_b.get_type();
+
+	if (type_a == Variant::INT && type_b == Variant::INT) {
+		int64_t a = p_a;
+		int64_t b = p_b;
+		switch (p_op) {
+			case Variant::OP_EQUAL: r_result = a == b; return true;
+			case Variant::OP_NOT_EQUAL: r_result = a != b; return true;
+			case Variant::OP_LESS: r_result = a < b; return true;
+			case Variant::OP_LESS_EQUAL: r_result = a <= b; return true;
+			case Variant::OP_GREATER: r_result = a > b; return true;
+			case Variant::OP_GREATER_EQUAL: r_result = a >= b; return true;
+			default: return false;
+		}
+	} else if (_is_number(type_a) && _is_number(type_b)) {
+		double a = p_a;
+		double b = p_b;
+		switch (p_op) {
+			case Variant::OP_EQUAL: r_result = a == b; return true;
+			case Variant::OP_NOT_EQUAL: r_result = a != b; return true;
+			case Variant::OP_LESS: r_result = a < b; return true;
+			case Variant::OP_LESS_EQUAL: r_result = a <= b; return true;
+			case Variant::OP_GREATER: r_result = a > b; return true;
+			case Variant::OP_GREATER_EQUAL: r_result = a >= b; return true;
+			default: return false;
+		}
+	}
+
+	return false;
+}
+
+// Elements of arrays and pool arrays of numbers and 2D vectors, indexed by int. Negative or out of
+// range indices, other types and values needing conversion are left to the generic Variant path.
+
+template <class T>
+static _FORCE_INLINE_ bool _get_pool_element(const Variant &p_array, int64_t p_index, Variant &r_value) {
+
+	const PoolVector<T> &array = p_array.get_pool_vector_ref<T>();
+	if (unlikely(p_index < 0 || p_index >= array.size())) {
+		return false;
+	}
+	typename PoolVector<T>::Read r = array.read();
+	r_value = r[p_index];
+	return true;
+}
+
+static _FORCE_INLINE_ bool _get_element(const Variant &p_array, int64_t p_index, Variant &r_value) {
+
+	switch (p_array.get_type()) {
+		case Variant::ARRAY: {
+			const Array &array = p_array.get_array_ref();
+			if (unlikely(p_index < 0 || p_index >= array.size())) {
+				return false;
+			}
+			r_value = array[p_index];
+			return true;
+		}
+		case Variant::POOL_BYTE_ARRAY: return _get_pool_element<uint8_t>(p_array, p_index, r_value);
+		case Variant::POOL_INT_ARRAY: return _get_pool_element<int>(p_array, p_index, r_value);
+		case Variant::POOL_REAL_ARRAY: return _get_pool_element<real_t>(p_array, p_index, r_value);
+		case Variant::POOL_VECTOR2_ARRAY: return _get_pool_element<Vector2>(p_array, p_index, r_value);
+		default: return false;
+	}
+}
+
+template <class T>
+static _FORCE_INLINE_ bool _set_pool_element(Variant &p_array, int64_t p_index, const T &p_value) {
+
+	PoolVector<T> &array = p_array.get_pool_vector_ref<T>();
+	if (unlikely(p_index < 0 || p_index >= array.size())) {
+		return false;
+	}
+	array.set(p_index, p_value);
+	return true;
+}
+
+static _FORCE_INLINE_ bool _set_element(Variant &p_array, int64_t p_index, const Variant &p_value) {
+
+	switch (p_array.get_type()) {
+		case Variant::ARRAY: {
+			Array &array = p_array.get_array_ref();
+			if (unlikely(p_index < 0 || p_index >= array.size())) {
+				return false;
+			}
+			array[p_index] = p_value;
+			return true;
+		}
+		case Variant::POOL_BYTE_ARRAY: return p_value.get_type() == Variant::INT && _set_pool_element<uint8_t>(p_array, p_index, int64_t(p_value));
+		case Variant::POOL_INT_ARRAY: return p_value.get_type() == Variant::INT && _set_pool_element<int>(p_array, p_index, int64_t(p_value));
+		case Variant::POOL_REAL_ARRAY: return _is_number(p_value.get_type()) && _set_pool_element<real_t>(p_array, p_index, real_t(p_value));
+		case Variant::POOL_VECTOR2_ARRAY: return p_value.get_type() == Variant::VECTOR2 && _set_pool_element<Vector2>(p_array, p_index, p_value);
+		default: return false;
+	}
+}
+
+// Loops over ranges (the parser turns range(to) and range(from, to) into an int and a Vector2),
+// arrays and the pool arrays above, writing each element straight into the iterator. Returns false
+// for any other container, which goes through Variant::iter_init(), iter_next() and iter_get().
+static _FORCE_INLINE_ bool _iterate_fast(const Variant &p_container, Variant &r_counter, bool p_begin, Variant &r_iterator, bool &r_more) {
+
+	switch (p_container.get_type()) {
+		case Variant::INT:
+		case Variant::VECTOR2: {
+			int64_t from = 0;
+			int64_t to;
+			if (p_container.get_type() == Variant::INT) {
+				to = p_container;
+			} else {
+				Vector2 range = p_container;
+				from = range.x;
+				to = range.y;
+			}
+			int64_t index = p_begin ? from : int64_t(r_counter) + 1;
+			r_more = index < to;
+			if (r_more) {
+				r_iterator = index;
+			}
+			r_counter = index;
+			return true;
+		}
+		case Variant::ARRAY:
+		case Variant::POOL_BYTE_ARRAY:
+		case Variant::POOL_INT_ARRAY:
+		case Variant::POOL_REAL_ARRAY:
+		case Variant::POOL_VECTOR2_ARRAY: {
+			int64_t index = p_begin ? 0 : int64_t(r_counter) + 1;
+			r_more = _get_element(p_container, index, r_iterator);
+			r_counter = index;
+			return true;
+		}
+		default: return false;
+	}
+}
+
+bool GDScriptFunction::_get_inline_cache_receiver(const Variant *p_base, Object *&r_object, GDScriptInstance *&r_instance, InlineCache::Entry &r_receiver) {
+
+	r_instance = NULL;
+	r_receiver.script = NULL;
+	r_receiver.function = NULL;
+	r_receiver.method = NULL;
+	r_receiver.built_in = NULL;
+	r_receiver.ptrcall = false;
+	r_receiver.index = -1;
+
+	Variant::Type type = p_base->get_type();
+	if (type != Variant::OBJECT) {
+
+		if (type == Variant::NIL) {
+			return false;
+		}
+
+		r_object = NULL;
+		r_receiver.native_class = (const void *)(uintptr_t)type; // can't be confused with the address of a class name
+		return true;
+	}
+
+	r_object = *p_base;
+	if (!r_object) {
+		return false;
+	}
+
+#ifdef DEBUG_ENABLED
+	if (ScriptDebugger::get_singleton() && !p_base->is_ref() && !ObjectDB::instance_validate(r_object)) {
+		return false; // let the regular path report it
+	}
+#endif
+
+	ScriptInstance *script_instance = r_object->get_script_instance();
+	if (script_instance) {
+
+		if (script_instance->get_language() != GDScriptLanguage::get_singleton()) {
+			return false;
+		}
+#ifdef TOOLS_ENABLED
+		if (script_instance->is_placeholder()) {
+			return false;
+		}
+#endif
+		r_instance = static_cast<GDScriptInstance *>(script_instance);
+		r_receiver.script = r_instance->script.ptr();
+	}
+
+	r_receiver.native_class = r_object->get_class_name().data_unique_pointer();
+	return true;
+}
+
+GDScriptFunction::InlineCacheLookup GDScriptFunction::_find_inline_cache_entry(int p_cache, const InlineCache::Entry &p_receiver, InlineCache::Entry &r_entry) const {
+
+	const InlineCache &cache = _inline_caches_ptr[p_cache];
+	uint32_t version = atomic_load_acquire(&cache.version);
+	if (version != GDScriptLanguage::get_singleton()->get_inline_cache_version()) {
+		return INLINE_CACHE_MISS;
+	}
+
+	InlineCacheLookup lookup = INLINE_CACHE_MISS;
+	uint32_t entry_count = atomic_load_acquire(&cache.entry_count);
+	for (uint32_t i = 0; i < entry_count; i++) {
+
+		const InlineCache::Entry &entry = cache.entries[i];
+		if (entry.script == p_receiver.script && entry.native_class == p_receiver.native_class) {
+			r_entry = entry;
+			lookup = INLINE_CACHE_HIT;
+			break;
+		}
+	}
+
+	if (lookup == INLINE_CACHE_MISS && entry_count == INLINE_CACHE_SIZE) {
+		lookup = INLINE_CACHE_FULL;
+	}
+
+	// the cache may have been emptied while it was read
+	atomic_fence_acquire();
+	if (cache.version != version) {
+		return INLINE_CACHE_MISS;
+	}
+
+	return lookup;
+}
+
+void GDScriptFunction::_add_inline_cache_entry(int p_cache, uint32_t p_version, const InlineCache::Entry &p_entry) {
+
+	Mutex *lock = GDScriptLanguage::get_singleton()->lock;
+	if (lock) {
+		lock->lock();
+	}
+
+	InlineCache &cache = _inline_caches_ptr[p_cache];
+
+	// resolved before scripts changed again, don't keep it
+	if (p_version == GDScriptLanguage::get_singleton()->get_inline_cache_version()) {
+
+		bool emptied = false;
+		if (cache.version != p_version) {
+			// readers that already checked the old version see the change when they check it again,
+			// the exchange is a full barrier, so they can't see the new entries before it
+			atomic_compare_exchange(&cache.version, (uint32_t)cache.version, (uint32_t)0);
+			cache.entry_count = 0;
+			emptied = true;
+		}
+
+		if (cache.entry_count < INLINE_CACHE_SIZE) { // else filled by another thread meanwhile
+			cache.entries[cache.entry_count] = p_entry;
+			atomic_store_release(&cache.entry_count, cache.entry_count + 1);
+		}
+
+		if (emptied) {
+			atomic_store_release(&cache.version, p_version);
+		}
+	}
+
+	if (lock) {
+		lock->unlock();
+	}
+}
+
+void GDScriptFunction::_create_inline_caches(int p_count) {
+
+	ERR_FAIL_COND(_inline_caches_ptr);
+	if (!p_count) {
+		return;
+	}
+
+	_inline_caches_ptr = memnew_arr(InlineCache, p_count);
+	for (int i = 0; i < p_count; i++) {
+		_inline_caches_ptr[i].version = 0;
+		_inline_caches_ptr[i].entry_count = 0;
+	}
+	_inline_cache_count = p_count;
+}
+
+void GDScriptFunction::_resolve_call(Object *p_object, GDScriptInstance *p_instance, const StringName &p_method, InlineCache::Entry &r_entry) {
+
+	if (p_method == CoreStringNames::get_singleton()->_free) {
+		return; // needs the checks in Object::call()
+	}
+
+	// same order as Object::call(), script functions first
+	if (p_instance) {
+
+		for (GDScript *script = p_instance->script.ptr(); script; script = script->_base) {
+
+			Map<StringName, GDScriptFunction *>::Element *E = script->member_functions.find(p_method);
+			if (E) {
+				r_entry.function = E->get();
+				return;
+			}
+		}
+	}
+
+	r_entry.method = ClassDB::get_method(p_object->get_class_name(), p_method);
+	r_entry.ptrcall = r_entry.method && can_ptrcall(r_entry.method);
+}
+
+void GDScriptFunction::_resolve_get(Object *p_object, GDScriptInstance *p_instance, const StringName &p_name, InlineCache::Entry &r_entry) {
+
+	// same order as Object::get(), script members and constants first
+	if (p_instance) {
+
+		const GDScript *script = p_instance->script.ptr();
+		const Map<StringName, GDScript::MemberInfo>::Element *E = script->member_indices.find(p_name);
+		if (E) {
+			if (!E->get().getter) {
+				r_entry.index = E->get().index;
+			}
+			return;
+		}
+
+		for (const GDScript *sptr = script; sptr; sptr = sptr->_base) {
+
+			if (sptr->constants.has(p_name) || sptr->member_functions.has(GDScriptLanguage::get_singleton()->strings._get)) {
+				return;
+			}
+		}
+	}
+
+	const StringName &native_class = p_object->get_class_name();
+
+	bool has_property;
+	int index = ClassDB::get_property_index(native_class, p_name, &has_property);
+	if (!has_property) {
+		return;
+	}
+
+	bool is_constant;
+	ClassDB::get_integer_constant(native_class, p_name, &is_constant);
+	if (is_constant) {
+		return;
+	}
+
+	StringName getter = ClassDB::get_property_getter(native_class, p_name);
+	if (getter == StringName()) {
+		return;
+	}
+
+	if (p_instance) {
+
+		//getters can be overridden by the script
+		for (const GDScript *sptr = p_instance->script.ptr(); sptr; sptr = sptr->_base) {
+
+			if (sptr->member_functions.has(getter)) {
+				return;
+			}
+		}
+	}
+
+	r_entry.method = ClassDB::get_method(native_class, getter);
+	r_entry.index = index;
+}
+
+bool GDScriptFunction::_call_cached(int p_cache, Variant *p_base, const StringName &p_method, const Variant **p_args, int p_argcount, Variant *r_ret, Variant::CallError &r_error) {
+
+	Object *object;
+	GDScriptInstance *instance;
+	InlineCache::Entry receiver;
+
+	if (!_get_inline_cache_receiver(p_base, object, instance, receiver)) {
+		return false;
+	}
+
+	InlineCache::Entry entry;
+	InlineCacheLookup lookup = _find_inline_cache_entry(p_cache, receiver, entry);
+	if (lookup == INLINE_CACHE_FULL) {
+		return false;
+	}
+
+	if (lookup == INLINE_CACHE_MISS) {
+
+		uint32_t version = GDScriptLanguage::get_singleton()->get_inline_cache_version();
+		if (object) {
+			_resolve_call(object, instance, p_method, receiver);
+		} else {
+			receiver.built_in = Variant::get_built_in_method(p_base->get_type(), p_method);
+		}
+		_add_inline_cache_entry(p_cache, version, receiver);
+		entry = receiver;
+	}
+
+	if (entry.built_in) {
+		p_base->call_built_in_method(entry.built_in, p_args, p_argcount, r_ret, r_error);
+		return true;
+	}
+
+	if (!entry.function && !entry.method) {
+		return false;
+	}
+
+	r_error.error = Variant::CallError::CALL_OK;
+
+	Variant ret;
+	{
+#ifdef DEBUG_ENABLED
+		// like Object::call, so the receiver can't be freed while its method runs
+		_ObjectDebugLock debug_lock(object);
+#endif
+		if (entry.function) {
+			ret = entry.function->call(instance, p_args, p_argcount, r_error);
+		} else {
+			ret = entry.method->call(object, p_args, p_argcount, r_error);
+		}
+	}
+
+	if (r_ret && r_error.error == Variant::CallError::CALL_OK) {
+		*r_ret = ret;
+	}
+
+	return true;
+}
+
+static bool _is_ptrcall_type(const PropertyInfo &p_info) {
+
+	if (p_info.usage & PROPERTY_USAGE_CLASS_IS_ENUM) {
+		return false; // passed as int, not int64_t
+	}
+
+	switch (p_info.type) {
+		case Variant::BOOL:
+		case Variant::INT:
+		case Variant::REAL:
+		case Variant::VECTOR2:
+		case Variant::RECT2:
+		case Variant::VECTOR3:
+		case Variant::TRANSFORM2D:
+		case Variant::PLANE:
+		case Variant::QUAT:
+		case Variant::AABB:
+		case Variant::BASIS:
+		case Variant::TRANSFORM:
+		case Variant::COLOR: return true;
+		default: return false;
+	}
+}
+
+bool GDScriptFunction::can_ptrcall(const MethodBind *p_method) {
+
+#ifdef GDSCRIPT_PTRCALL_ENABLED
+	if (p_method->is_vararg() || p_method->get_argument_count() > MAX_PTRCALL_ARGS) {
+		return false;
+	}
+
+	for (int i = 0; i < p_method->get_argument_count(); i++) {
+		if (!_is_ptrcall_type(p_method->get_argument_info(i))) {
+			return false;
+		}
+	}
+
+	return !p_method->has_return() || _is_ptrcall_type(p_method->get_return_info());
+#else
+	return false;
+#endif
+}
+
+#ifdef GDSCRIPT_PTRCALL_ENABLED
+
+// Native representation of the values passed to ptrcall, as read by PtrToArg.
+// Only plain types are supported, so nothing needs to be destructed.
+union _PtrcallValue {
+
+	bool _bool;
+	int64_t _int;
+	double _real;
+	uint8_t _mem[sizeof(Transform) > sizeof(Transform2D) ? sizeof(Transform) : sizeof(Transform2D)];
+};
+
+static _FORCE_INLINE_ void _encode_ptrcall_value(const Variant &p_value, _PtrcallValue &r_value) {
+
+	switch (p_value.get_type()) {
+		case Variant::BOOL: r_value._bool = p_value; break;
+		case Variant::INT: r_value._int = p_value; break;
+		case Variant::REAL: r_value._real = p_value; break;
+		case Variant::VECTOR2: *reinterpret_cast<Vector2 *>(r_value._mem) = p_value; break;
+		case Variant::RECT2: *reinterpret_cast<Rect2 *>(r_value._mem) = p_value; break;
+		case Variant::VECTOR3: *reinterpret_cast<Vector3 *>(r_value._mem) = p_value; break;
+		case Variant::TRANSFORM2D: *reinterpret_cast<Transform2D *>(r_value._mem) = p_value; break;
+		case Variant::PLANE: *reinterpret_cast<Plane *>(r_value._mem) = p_value; break;
+		case Variant::QUAT: *reinterpret_cast<Quat *>(r_value._mem) = p_value; break;
+		case Variant::AABB: *reinterpret_cast<AABB *>(r_value._mem) = p_value; break;
+		case Variant::BASIS: *reinterpret_cast<Basis *>(r_value._mem) = p_value; break;
+		case Variant::TRANSFORM: *reinterpret_cast<Transform *>(r_value._mem) = p_value; break;
+		case Variant::COLOR: *reinterpret_cast<Color *>(r_value._mem) = p_value; break;
+		default: ERR_FAIL();
+	}
+}
+
+static _FORCE_INLINE_ void _decode_ptrcall_value(Variant::Type p_type, const _PtrcallValue &p_value, Variant &r_value) {
+
+	switch (p_type) {
+		case Variant::BOOL: r_value = p_value._bool; break;
+		case Variant::INT: r_value = p_value._int; break;
+		case Variant::REAL: r_value = p_value._real; break;
+		case Variant::VECTOR2: r_value = *reinterpret_cast<const Vector2 *>(p_value._mem); break;
+		case Variant::RECT2: r_value = *reinterpret_cast<const Rect2 *>(p_value._mem); break;
+		case Variant::VECTOR3: r_value = *reinterpret_cast<const Vector3 *>(p_value._mem); break;
+		case Variant::TRANSFORM2D: r_value = *reinterpret_cast<const Transform2D *>(p_value._mem); break;
+		case Variant::PLANE: r_value = *reinterpret_cast<const Plane *>(p_value._mem); break;
+		case Variant::QUAT: r_value = *reinterpret_cast<const Quat *>(p_value._mem); break;
+		case Variant::AABB: r_value = *reinterpret_cast<const AABB *>(p_value._mem); break;
+		case Variant::BASIS: r_value = *reinterpret_cast<const Basis *>(p_value._mem); break;
+		case Variant::TRANSFORM: r_value = *reinterpret_cast<const Transform *>(p_value._mem); break;
+		case Variant::COLOR: r_value = *reinterpret_cast<const Color *>(p_value._mem); break;
+		default: r_value = Variant();
+	}
+}
+
+#endif
+
+bool GDScriptFunction::_ptrcall_cached(int p_cache, Variant *p_base, const Variant **p_args, int p_argcount, Variant *r_ret) {
+
+#ifdef GDSCRIPT_PTRCALL_ENABLED
+	if (p_base->get_type() != Variant::OBJECT) {
+		return false;
+	}
+
+	Object *object;
+	GDScriptInstance *instance;
+	InlineCache::Entry receiver;
+
+	if (!_get_inline_cache_receiver(p_base, object, instance, receiver)) {
+		return false;
+	}
+
+	// entries are added by the regular call, which handles the first call and the errors
+	InlineCache::Entry entry;
+	if (_find_inline_cache_entry(p_cache, receiver, entry) != INLINE_CACHE_HIT || !entry.ptrcall) {
+		return false;
+	}
+
+	MethodBind *method = entry.method;
+	if (p_argcount != method->get_argument_count()) {
+		return false;
+	}
+
+	_PtrcallValue args[MAX_PTRCALL_ARGS];
+	const void *argptrs[MAX_PTRCALL_ARGS];
+
+	for (int i = 0; i < p_argcount; i++) {
+
+		if (p_args[i]->get_type() != method->get_argument_type(i)) {
+			return false;
+		}
+		_encode_ptrcall_value(*p_args[i], args[i]);
+		argptrs[i] = &args[i];
+	}
+
+	_PtrcallValue ret;
+	{
+#ifdef DEBUG_ENABLED
+		_ObjectDebugLock debug_lock(object);
+#endif
+		method->ptrcall(object, argptrs, &ret);
+	}
+
+	if (r_ret) {
+		if (method->has_return()) {
+			_decode_ptrcall_value(method->get_argument_type(-1), ret, *r_ret);
+		} else {
+			*r_ret = Variant();
+		}
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool GDScriptFunction::_get_cached(int p_cache, const Variant *p_base, const StringName &p_name, Variant &r_value) {
+
+	if (p_base->get_type() != Variant::OBJECT) {
+		return false;
+	}
+
+	Object *object;
+	GDScriptInstance *instance;
+	InlineCache::Entry receiver;
+
+	if (!_get_inline_cache_receiver(p_base, object, instance, receiver)) {
+		return false;
+	}
+
+	InlineCache::Entry entry;
+	InlineCacheLookup lookup = _find_inline_cache_entry(p_cache, receiver, entry);
+	if (lookup == INLINE_CACHE_FULL) {
+		return false;
+	}
+
+	if (lookup == INLINE_CACHE_MISS) {
+
+		uint32_t version = GDScriptLanguage::get_singleton()->get_inline_cache_version();
+		_resolve_get(object, instance, p_name, receiver);
+		_add_inline_cache_entry(p_cache, version, receiver);
+		entry = receiver;
+	}
+
+	if (entry.method) {
+
+		Variant::CallError ce;
+		if (entry.index >= 0) {
+			Variant index = entry.index;
+			const Variant *args[1] = { &index };
+			r_value = entry.method->call(object, args, 1, ce);
+		} else {
+			r_value = entry.method->call(object, NULL, 0, ce);
+		}
+		return true;
+	}
+
+	if (entry.index >= 0 && instance) {
+		r_value = instance->members[entry.index];
+		return true;
+	}
+
+	return false;
+}
+
 #if defined(__GNUC__)
 #define OPCODES_TABLE                         \
 	static const void *switch_table_ops[] = { \
 		&&OPCODE_OPERATOR,                    \
+		&&OPCODE_OPERATOR_INT,                \
+		&&OPCODE_OPERATOR_REAL,               \
+		&&OPCODE_OPERATOR_VECTOR2,            \
+		&&OPCODE_OPERATOR_VECTOR3,            \
 		&&OPCODE_EXTENDS_TEST,                \
 		&&OPCODE_SET,                         \
 		&&OPCODE_GET,                         \
 		&&OPCODE_SET_NAMED,                   \
 		&&OPCODE_GET_NAMED,                   \
+		&&OPCODE_SET_NAMED_VECTOR,            \
+		&&OPCODE_GET_NAMED_VECTOR,            \
 		&&OPCODE_SET_MEMBER,                  \
 		&&OPCODE_GET_MEMBER,                  \
 		&&OPCODE_ASSIGN,                      \
@@ -211,6 +954,8 @@ static String _get_var_type(const Variant *p_type) {
 		&&OPCODE_CONSTRUCT_DICTIONARY,        \
 		&&OPCODE_CALL,                        \
 		&&OPCODE_CALL_RETURN,                 \
+		&&OPCODE_CALL_PTRCALL,                \
+		&&OPCODE_CALL_PTRCALL_RETURN,         \
 		&&OPCODE_CALL_BUILT_IN,               \
 		&&OPCODE_CALL_SELF,                   \
 		&&OPCODE_CALL_SELF_BASE,              \
@@ -220,6 +965,7 @@ static String _get_var_type(const Variant *p_type) {
 		&&OPCODE_JUMP,                        \
 		&&OPCODE_JUMP_IF,                     \
 		&&OPCODE_JUMP_IF_NOT,                 \
+		&&OPCODE_JUMP_IF_NOT_COMPARE,         \
 		&&OPCODE_JUMP_TO_DEF_ARGUMENT,        \
 		&&OPCODE_RETURN,                      \
 		&&OPCODE_ITERATE_BEGIN,               \
@@ -267,6 +1013,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 	Variant self;
 	Variant retvalue;
 	Variant *stack = NULL;
+	bool stack_moved = false; // owned by the state of a yield
 	Variant **call_args;
 	int defarg = 0;
 
@@ -283,11 +1030,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 	if (p_state) {
 		//use existing (supplied) state (yielded)
-		stack = (Variant *)p_state->stack.ptr();
-		call_args = (Variant **)&p_state->stack.ptr()[sizeof(Variant) * p_state->stack_size]; //ptr() to avoid bounds check
+		stack = (Variant *)p_state->stack;
+		call_args = (Variant **)&p_state->stack[sizeof(Variant) * p_state->stack_size];
 		line = p_state->line;
 		ip = p_state->ip;
-		alloca_size = p_state->stack.size();
+		alloca_size = p_state->alloca_size;
 		_class = p_state->_class;
 		p_instance = p_state->instance;
 		defarg = p_state->defarg;
@@ -421,6 +1168,8 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 		profile.call_count++;
 		profile.frame_call_count++;
 	}
+
+	bool sampled = GDScriptLanguage::get_singleton()->sample_enter(this, &line);
 #endif
 	bool exit_ok = false;
 
@@ -434,6 +1183,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 		OPCODE_SWITCH(_code_ptr[ip]) {
 
 			OPCODE(OPCODE_OPERATOR) {
+			generic_operator:
 
 				CHECK_SPACE(5);
 
@@ -470,6 +1220,82 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_OPERATOR_INT) {
+
+				CHECK_SPACE(5);
+
+				GET_VARIANT_PTR(a, 2);
+				GET_VARIANT_PTR(b, 3);
+				GET_VARIANT_PTR(dst, 4);
+
+				if (unlikely(a->get_type() != Variant::INT || b->get_type() != Variant::INT)) {
+					goto generic_operator;
+				}
+
+				if (unlikely(!_evaluate_int_operator((Variant::Operator)_code_ptr[ip + 1], *a, *b, *dst))) {
+					goto generic_operator;
+				}
+
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_OPERATOR_REAL) {
+
+				CHECK_SPACE(5);
+
+				GET_VARIANT_PTR(a, 2);
+				GET_VARIANT_PTR(b, 3);
+				GET_VARIANT_PTR(dst, 4);
+
+				Variant::Type type_a = a->get_type();
+				Variant::Type type_b = b->get_type();
+
+				//int with int must stay int, so at least one of them has to be real
+				if (unlikely(!_is_number(type_a) || !_is_number(type_b) || (type_a == Variant::INT && type_b == Variant::INT))) {
+					goto generic_operator;
+				}
+
+				if (unlikely(!_evaluate_real_operator((Variant::Operator)_code_ptr[ip + 1], *a, *b, *dst))) {
+					goto generic_operator;
+				}
+
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_OPERATOR_VECTOR2) {
+
+				CHECK_SPACE(5);
+
+				GET_VARIANT_PTR(a, 2);
+				GET_VARIANT_PTR(b, 3);
+				GET_VARIANT_PTR(dst, 4);
+
+				if (unlikely(!_evaluate_vector_operator<Vector2>((Variant::Operator)_code_ptr[ip + 1], Variant::VECTOR2, *a, *b, *dst))) {
+					goto generic_operator;
+				}
+
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_OPERATOR_VECTOR3) {
+
+				CHECK_SPACE(5);
+
+				GET_VARIANT_PTR(a, 2);
+				GET_VARIANT_PTR(b, 3);
+				GET_VARIANT_PTR(dst, 4);
+
+				if (unlikely(!_evaluate_vector_operator<Vector3>((Variant::Operator)_code_ptr[ip + 1], Variant::VECTOR3, *a, *b, *dst))) {
+					goto generic_operator;
+				}
+
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
 			OPCODE(OPCODE_EXTENDS_TEST) {
 
 				CHECK_SPACE(4);
@@ -544,21 +1370,24 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_VARIANT_PTR(index, 2);
 				GET_VARIANT_PTR(value, 3);
 
-				bool valid;
-				dst->set(*index, *value, &valid);
+				if (index->get_type() != Variant::INT || !_set_element(*dst, *index, *value)) {
+
+					bool valid;
+					dst->set(*index, *value, &valid);
 
 #ifdef DEBUG_ENABLED
-				if (!valid) {
-					String v = index->operator String();
-					if (v != "") {
-						v = "'" + v + "'";
-					} else {
-						v = "of type '" + _get_var_type(index) + "'";
+					if (!valid) {
+						String v = index->operator String();
+						if (v != "") {
+							v = "'" + v + "'";
+						} else {
+							v = "of type '" + _get_var_type(index) + "'";
+						}
+						err_text = "Invalid set index " + v + " (on base: '" + _get_var_type(dst) + "') with value of type '" + _get_var_type(value) + "'";
+						OPCODE_BREAK;
 					}
-					err_text = "Invalid set index " + v + " (on base: '" + _get_var_type(dst) + "') with value of type '" + _get_var_type(value) + "'";
-					OPCODE_BREAK;
-				}
 #endif
+				}
 				ip += 4;
 			}
 			DISPATCH_OPCODE;
@@ -571,32 +1400,36 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_VARIANT_PTR(index, 2);
 				GET_VARIANT_PTR(dst, 3);
 
-				bool valid;
+				if (index->get_type() != Variant::INT || src == dst || !_get_element(*src, *index, *dst)) {
+
+					bool valid;
 #ifdef DEBUG_ENABLED
-				//allow better error message in cases where src and dst are the same stack position
-				Variant ret = src->get(*index, &valid);
+					//allow better error message in cases where src and dst are the same stack position
+					Variant ret = src->get(*index, &valid);
 #else
-				*dst = src->get(*index, &valid);
+					*dst = src->get(*index, &valid);
 
 #endif
 #ifdef DEBUG_ENABLED
-				if (!valid) {
-					String v = index->operator String();
-					if (v != "") {
-						v = "'" + v + "'";
-					} else {
-						v = "of type '" + _get_var_type(index) + "'";
+					if (!valid) {
+						String v = index->operator String();
+						if (v != "") {
+							v = "'" + v + "'";
+						} else {
+							v = "of type '" + _get_var_type(index) + "'";
+						}
+						err_text = "Invalid get index " + v + " (on base: '" + _get_var_type(src) + "').";
+						OPCODE_BREAK;
 					}
-					err_text = "Invalid get index " + v + " (on base: '" + _get_var_type(src) + "').";
-					OPCODE_BREAK;
-				}
-				*dst = ret;
+					*dst = ret;
 #endif
+				}
 				ip += 4;
 			}
 			DISPATCH_OPCODE;
 
 			OPCODE(OPCODE_SET_NAMED) {
+			generic_set_named:
 
 				CHECK_SPACE(3);
 
@@ -623,25 +1456,26 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			DISPATCH_OPCODE;
 
 			OPCODE(OPCODE_GET_NAMED) {
+			generic_get_named:
 
-				CHECK_SPACE(4);
+				CHECK_SPACE(5);
 
 				GET_VARIANT_PTR(src, 1);
-				GET_VARIANT_PTR(dst, 3);
+				GET_VARIANT_PTR(dst, 4);
 
 				int indexname = _code_ptr[ip + 2];
+				int cache = _code_ptr[ip + 3];
 
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
+				GD_ERR_BREAK(cache < 0 || cache >= _inline_cache_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
-				bool valid;
-#ifdef DEBUG_ENABLED
-				//allow better error message in cases where src and dst are the same stack position
-				Variant ret = src->get_named(*index, &valid);
-
-#else
-				*dst = src->get_named(*index, &valid);
-#endif
+				//also allows better error messages in cases where src and dst are the same stack position
+				bool valid = true;
+				Variant ret;
+				if (!_get_cached(cache, src, *index, ret)) {
+					ret = src->get_named(*index, &valid);
+				}
 #ifdef DEBUG_ENABLED
 				if (!valid) {
 					if (src->has_method(*index)) {
@@ -651,12 +1485,78 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					}
 					OPCODE_BREAK;
 				}
-				*dst = ret;
 #endif
+				*dst = ret;
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_SET_NAMED_VECTOR) {
+
+				CHECK_SPACE(3);
+
+				GET_VARIANT_PTR(dst, 1);
+				GET_VARIANT_PTR(value, 3);
+
+				int indexname = _code_ptr[ip + 2];
+
+				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
+
+				Variant::Type type = dst->get_type();
+				if (unlikely((type != Variant::VECTOR2 && type != Variant::VECTOR3) || !_is_number(value->get_type()))) {
+					goto generic_set_named;
+				}
+
+				int axis = _get_vector_axis(type, _global_names_ptr[indexname]);
+				if (unlikely(axis < 0)) {
+					goto generic_set_named;
+				}
+
+				if (type == Variant::VECTOR2) {
+					Vector2 v = *dst;
+					v[axis] = *value;
+					*dst = v;
+				} else {
+					Vector3 v = *dst;
+					v[axis] = *value;
+					*dst = v;
+				}
+
 				ip += 4;
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_GET_NAMED_VECTOR) {
+
+				CHECK_SPACE(5);
+
+				GET_VARIANT_PTR(src, 1);
+				GET_VARIANT_PTR(dst, 4);
+
+				int indexname = _code_ptr[ip + 2];
+
+				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
+
+				Variant::Type type = src->get_type();
+				if (unlikely(type != Variant::VECTOR2 && type != Variant::VECTOR3)) {
+					goto generic_get_named;
+				}
+
+				int axis = _get_vector_axis(type, _global_names_ptr[indexname]);
+				if (unlikely(axis < 0)) {
+					goto generic_get_named;
+				}
+
+				if (type == Variant::VECTOR2) {
+					*dst = src->operator Vector2()[axis];
+				} else {
+					*dst = src->operator Vector3()[axis];
+				}
+
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
 			OPCODE(OPCODE_SET_MEMBER) {
 
 				CHECK_SPACE(3);
@@ -1015,21 +1915,72 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_CALL_PTRCALL_RETURN)
+			OPCODE(OPCODE_CALL_PTRCALL) {
+
+#ifdef GDSCRIPT_PTRCALL_ENABLED
+				CHECK_SPACE(5);
+
+				int argc = _code_ptr[ip + 1];
+				GET_VARIANT_PTR(base, 2);
+				int cache = _code_ptr[ip + 4];
+
+				GD_ERR_BREAK(cache < 0 || cache >= _inline_cache_count);
+				GD_ERR_BREAK(argc < 0);
+				CHECK_SPACE(argc + 6);
+				Variant **argptrs = call_args;
+
+				for (int i = 0; i < argc; i++) {
+					GET_VARIANT_PTR(v, 5 + i);
+					argptrs[i] = v;
+				}
+
+				Variant *ret = NULL;
+				if (_code_ptr[ip] == OPCODE_CALL_PTRCALL_RETURN) {
+					GET_VARIANT_PTR(dst, 5 + argc);
+					ret = dst;
+				}
+
+#ifdef DEBUG_ENABLED
+				uint64_t call_time = 0;
+
+				if (GDScriptLanguage::get_singleton()->profiling) {
+					call_time = OS::get_singleton()->get_ticks_usec();
+				}
+#endif
+				if (_ptrcall_cached(cache, base, (const Variant **)argptrs, argc, ret)) {
+#ifdef DEBUG_ENABLED
+					if (GDScriptLanguage::get_singleton()->profiling) {
+						function_call_time += OS::get_singleton()->get_ticks_usec() - call_time;
+					}
+#endif
+					ip += argc + 6;
+					DISPATCH_OPCODE;
+				}
+#endif
+				//not the cached method, or the arguments don't have the expected types
+				goto generic_call;
+			}
+
 			OPCODE(OPCODE_CALL_RETURN)
 			OPCODE(OPCODE_CALL) {
 
-				CHECK_SPACE(4);
-				bool call_ret = _code_ptr[ip] == OPCODE_CALL_RETURN;
+			generic_call:
+
+				CHECK_SPACE(5);
+				bool call_ret = _code_ptr[ip] == OPCODE_CALL_RETURN || _code_ptr[ip] == OPCODE_CALL_PTRCALL_RETURN;
 
 				int argc = _code_ptr[ip + 1];
 				GET_VARIANT_PTR(base, 2);
 				int nameg = _code_ptr[ip + 3];
+				int cache = _code_ptr[ip + 4];
 
 				GD_ERR_BREAK(nameg < 0 || nameg >= _global_names_count);
+				GD_ERR_BREAK(cache < 0 || cache >= _inline_cache_count);
 				const StringName *methodname = &_global_names_ptr[nameg];
 
 				GD_ERR_BREAK(argc < 0);
-				ip += 4;
+				ip += 5;
 				CHECK_SPACE(argc + 1);
 				Variant **argptrs = call_args;
 
@@ -1050,10 +2001,14 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				if (call_ret) {
 
 					GET_VARIANT_PTR(ret, argc);
-					base->call_ptr(*methodname, (const Variant **)argptrs, argc, ret, err);
+					if (!_call_cached(cache, base, *methodname, (const Variant **)argptrs, argc, ret, err)) {
+						base->call_ptr(*methodname, (const Variant **)argptrs, argc, ret, err);
+					}
 				} else {
 
-					base->call_ptr(*methodname, (const Variant **)argptrs, argc, NULL, err);
+					if (!_call_cached(cache, base, *methodname, (const Variant **)argptrs, argc, NULL, err)) {
+						base->call_ptr(*methodname, (const Variant **)argptrs, argc, NULL, err);
+					}
 				}
 #ifdef DEBUG_ENABLED
 				if (GDScriptLanguage::get_singleton()->profiling) {
@@ -1231,11 +2186,17 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				Ref<GDScriptFunctionState> gdfs = memnew(GDScriptFunctionState);
 				gdfs->function = this;
 
-				gdfs->state.stack.resize(alloca_size);
-				//copy variant stack
-				for (int i = 0; i < _stack_size; i++) {
-					memnew_placement(&gdfs->state.stack.write[sizeof(Variant) * i], Variant(stack[i]));
+				// The state takes over the stack without copying the variants: a resumed
+				// function hands over its frame, otherwise the stack is moved out of alloca.
+				if (p_state) {
+					gdfs->state.stack = p_state->stack;
+					p_state->stack = NULL;
+				} else if (alloca_size) {
+					gdfs->state.stack = GDScriptLanguage::get_singleton()->alloc_frame(alloca_size);
+					copymem(gdfs->state.stack, stack, sizeof(Variant) * _stack_size);
 				}
+				stack = (Variant *)gdfs->state.stack;
+				stack_moved = true;
 				gdfs->state.stack_size = _stack_size;
 				gdfs->state.self = self;
 				gdfs->state.alloca_size = alloca_size;
@@ -1361,6 +2322,42 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_JUMP_IF_NOT_COMPARE) {
+
+				CHECK_SPACE(5);
+
+				Variant::Operator op = (Variant::Operator)_code_ptr[ip + 1];
+				GD_ERR_BREAK(op >= Variant::OP_MAX);
+
+				GET_VARIANT_PTR(a, 2);
+				GET_VARIANT_PTR(b, 3);
+
+				bool result;
+				if (unlikely(!_compare_numbers(op, *a, *b, result))) {
+
+					//not numbers after all, compare them as variants
+					bool valid;
+					Variant ret;
+					Variant::evaluate(op, *a, *b, ret, valid);
+#ifdef DEBUG_ENABLED
+					if (!valid) {
+						err_text = "Invalid operands '" + Variant::get_type_name(a->get_type()) + "' and '" + Variant::get_type_name(b->get_type()) + "' in operator '" + Variant::get_operator_name(op) + "'.";
+						OPCODE_BREAK;
+					}
+#endif
+					result = ret.booleanize();
+				}
+
+				if (!result) {
+					int to = _code_ptr[ip + 4];
+					GD_ERR_BREAK(to < 0 || to > _code_size);
+					ip = to;
+				} else {
+					ip += 5;
+				}
+			}
+			DISPATCH_OPCODE;
+
 			OPCODE(OPCODE_JUMP_TO_DEF_ARGUMENT) {
 
 				CHECK_SPACE(2);
@@ -1383,28 +2380,35 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				GET_VARIANT_PTR(counter, 1);
 				GET_VARIANT_PTR(container, 2);
+				GET_VARIANT_PTR(iterator, 4);
 
-				bool valid;
-				if (!container->iter_init(*counter, valid)) {
+				bool more;
+				if (!_iterate_fast(*container, *counter, true, *iterator, more)) {
+
+					bool valid;
+					more = container->iter_init(*counter, valid);
 #ifdef DEBUG_ENABLED
 					if (!valid) {
 						err_text = "Unable to iterate on object of type  " + Variant::get_type_name(container->get_type()) + "'.";
 						OPCODE_BREAK;
 					}
 #endif
+					if (more) {
+						*iterator = container->iter_get(*counter, valid);
+#ifdef DEBUG_ENABLED
+						if (!valid) {
+							err_text = "Unable to obtain iterator object of type  " + Variant::get_type_name(container->get_type()) + "'.";
+							OPCODE_BREAK;
+						}
+#endif
+					}
+				}
+
+				if (!more) {
 					int jumpto = _code_ptr[ip + 3];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
-					GET_VARIANT_PTR(iterator, 4);
-
-					*iterator = container->iter_get(*counter, valid);
-#ifdef DEBUG_ENABLED
-					if (!valid) {
-						err_text = "Unable to obtain iterator object of type  " + Variant::get_type_name(container->get_type()) + "'.";
-						OPCODE_BREAK;
-					}
-#endif
 					ip += 5; //skip regular iterate which is always next
 				}
 			}
@@ -1416,28 +2420,35 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 				GET_VARIANT_PTR(counter, 1);
 				GET_VARIANT_PTR(container, 2);
+				GET_VARIANT_PTR(iterator, 4);
 
-				bool valid;
-				if (!container->iter_next(*counter, valid)) {
+				bool more;
+				if (!_iterate_fast(*container, *counter, false, *iterator, more)) {
+
+					bool valid;
+					more = container->iter_next(*counter, valid);
 #ifdef DEBUG_ENABLED
 					if (!valid) {
 						err_text = "Unable to iterate on object of type  " + Variant::get_type_name(container->get_type()) + "' (type changed since first iteration?).";
 						OPCODE_BREAK;
 					}
 #endif
+					if (more) {
+						*iterator = container->iter_get(*counter, valid);
+#ifdef DEBUG_ENABLED
+						if (!valid) {
+							err_text = "Unable to obtain iterator object of type  " + Variant::get_type_name(container->get_type()) + "' (but was obtained on first iteration?).";
+							OPCODE_BREAK;
+						}
+#endif
+					}
+				}
+
+				if (!more) {
 					int jumpto = _code_ptr[ip + 3];
 					GD_ERR_BREAK(jumpto < 0 || jumpto > _code_size);
 					ip = jumpto;
 				} else {
-					GET_VARIANT_PTR(iterator, 4);
-
-					*iterator = container->iter_get(*counter, valid);
-#ifdef DEBUG_ENABLED
-					if (!valid) {
-						err_text = "Unable to obtain iterator object of type  " + Variant::get_type_name(container->get_type()) + "' (but was obtained on first iteration?).";
-						OPCODE_BREAK;
-					}
-#endif
 					ip += 5; //loop again
 				}
 			}
@@ -1474,6 +2485,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			OPCODE(OPCODE_LINE) {
 				CHECK_SPACE(2);
 
+#ifdef DEBUG_ENABLED
+				// sampled at the line that just ran
+				GDScriptLanguage::get_singleton()->sample_poll();
+#endif
+
 				line = _code_ptr[ip + 1];
 				ip += 2;
 
@@ -1561,14 +2577,23 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 	if (ScriptDebugger::get_singleton())
 		GDScriptLanguage::get_singleton()->exit_function();
+
+	if (sampled)
+		GDScriptLanguage::get_singleton()->sample_exit();
 #endif
 
-	if (_stack_size) {
+	if (stack && !stack_moved) {
 		//free stack
 		for (int i = 0; i < _stack_size; i++)
 			stack[i].~Variant();
 	}
 
+	if (p_state && p_state->stack) {
+		// ran to completion, the frame can be reused
+		GDScriptLanguage::get_singleton()->free_frame(p_state->stack, p_state->alloca_size);
+		p_state->stack = NULL;
+	}
+
 	return retvalue;
 }
 
@@ -1697,6 +2722,8 @@ GDScriptFunction::GDScriptFunction() :
 
 	_stack_size = 0;
 	_call_size = 0;
+	_inline_caches_ptr = NULL;
+	_inline_cache_count = 0;
 	rpc_mode = MultiplayerAPI::RPC_MODE_DISABLED;
 	name = "<anonymous>";
 #ifdef DEBUG_ENABLED
@@ -1725,6 +2752,11 @@ GDScriptFunction::GDScriptFunction() :
 }
 
 GDScriptFunction::~GDScriptFunction() {
+
+	if (_inline_caches_ptr) {
+		memdelete_arr(_inline_caches_ptr);
+	}
+
 #ifdef DEBUG_ENABLED
 	if (GDScriptLanguage::get_singleton()->lock) {
 		GDScriptLanguage::get_singleton()->lock->lock();
@@ -1886,15 +2918,17 @@ void GDScriptFunctionState::_bind_methods() {
 GDScriptFunctionState::GDScriptFunctionState() {
 
 	function = NULL;
+	state.stack = NULL;
 }
 
 GDScriptFunctionState::~GDScriptFunctionState() {
 
-	if (function != NULL) {
+	if (state.stack) {
 		//never called, deinitialize stack
 		for (int i = 0; i < state.stack_size; i++) {
 			Variant *v = (Variant *)&state.stack[sizeof(Variant) * i];
 			v->~Variant();
 		}
+		GDScriptLanguage::get_singleton()->free_frame(state.stack, state.alloca_size);
 	}
 }
@@ -39,6 +39,11 @@
 #include "string_db.h"
 #include "variant.h"
 
+// ptrcall needs the argument types of the methods, which are only kept along with the debug info
+#if defined(PTRCALL_ENABLED) && defined(DEBUG_METHODS_ENABLED)
+#define GDSCRIPT_PTRCALL_ENABLED
+#endif
+
 class GDScriptInstance;
 class GDScript;
 
@@ -135,11 +140,17 @@ class GDScriptFunction {
 public:
 	enum Opcode {
 		OPCODE_OPERATOR,
+		OPCODE_OPERATOR_INT, // typed operators, same layout as OPCODE_OPERATOR and fall back to it
+		OPCODE_OPERATOR_REAL,
+		OPCODE_OPERATOR_VECTOR2,
+		OPCODE_OPERATOR_VECTOR3,
 		OPCODE_EXTENDS_TEST,
 		OPCODE_SET,
 		OPCODE_GET,
 		OPCODE_SET_NAMED,
 		OPCODE_GET_NAMED,
+		OPCODE_SET_NAMED_VECTOR, // x/y/z of typed vectors, same layout as the named versions
+		OPCODE_GET_NAMED_VECTOR,
 		OPCODE_SET_MEMBER,
 		OPCODE_GET_MEMBER,
 		OPCODE_ASSIGN,
@@ -156,6 +167,8 @@ public:
 		OPCODE_CONSTRUCT_DICTIONARY,
 		OPCODE_CALL,
 		OPCODE_CALL_RETURN,
+		OPCODE_CALL_PTRCALL, // native methods with typed arguments, same layout as the regular calls
+		OPCODE_CALL_PTRCALL_RETURN,
 		OPCODE_CALL_BUILT_IN,
 		OPCODE_CALL_SELF,
 		OPCODE_CALL_SELF_BASE,
@@ -165,6 +178,7 @@ public:
 		OPCODE_JUMP,
 		OPCODE_JUMP_IF,
 		OPCODE_JUMP_IF_NOT,
+		OPCODE_JUMP_IF_NOT_COMPARE, // comparison of typed numbers and jump
 		OPCODE_JUMP_TO_DEF_ARGUMENT,
 		OPCODE_RETURN,
 		OPCODE_ITERATE_BEGIN,
@@ -201,6 +215,7 @@ public:
 
 private:
 	friend class GDScriptCompiler;
+	friend class GDScriptBytecode;
 
 	StringName source;
 
@@ -243,6 +258,54 @@ private:
 
 	List<StackDebug> stack_debug;
 
+	// Inline caches remember how the calls and named gets of an instruction were resolved
+	// for the last kinds of receivers, so the lookups can be skipped when they come again.
+	// Each instruction has one cache, entries are added to it under the language lock and a
+	// stale one is emptied in place. Readers don't lock: they copy the entry they need and
+	// check afterwards that the version didn't change meanwhile, like a sequence lock.
+
+	enum {
+		INLINE_CACHE_SIZE = 4, // receivers per instruction, after that it's left to the regular lookup
+		MAX_PTRCALL_ARGS = 8
+	};
+
+	struct InlineCache {
+
+		struct Entry {
+			const GDScript *script; // script of the receiver, if any
+			const void *native_class; // name of the native class of the receiver, or its type if it's not an object
+			GDScriptFunction *function; // script function to call
+			MethodBind *method; // native method to call, or getter of a native property
+			Variant::BuiltInMethod built_in; // method to call on receivers of built-in types
+			bool ptrcall; // native method can be called with ptrcall()
+			int index; // script member, or index argument of the getter (-1 if none)
+		};
+
+		volatile uint32_t version; // zero while empty or being emptied
+		volatile uint32_t entry_count;
+		Entry entries[INLINE_CACHE_SIZE];
+	};
+
+	enum InlineCacheLookup {
+		INLINE_CACHE_MISS,
+		INLINE_CACHE_HIT,
+		INLINE_CACHE_FULL // too many kinds of receivers, left to the regular lookup
+	};
+
+	InlineCache *_inline_caches_ptr;
+	int _inline_cache_count;
+
+	void _create_inline_caches(int p_count);
+
+	static _FORCE_INLINE_ bool _get_inline_cache_receiver(const Variant *p_base, Object *&r_object, GDScriptInstance *&r_instance, InlineCache::Entry &r_receiver);
+	_FORCE_INLINE_ InlineCacheLookup _find_inline_cache_entry(int p_cache, const InlineCache::Entry &p_receiver, InlineCache::Entry &r_entry) const;
+	void _add_inline_cache_entry(int p_cache, uint32_t p_version, const InlineCache::Entry &p_entry);
+	static void _resolve_call(Object *p_object, GDScriptInstance *p_instance, const StringName &p_method, InlineCache::Entry &r_entry);
+	static void _resolve_get(Object *p_object, GDScriptInstance *p_instance, const StringName &p_name, InlineCache::Entry &r_entry);
+	_FORCE_INLINE_ bool _call_cached(int p_cache, Variant *p_base, const StringName &p_method, const Variant **p_args, int p_argcount, Variant *r_ret, Variant::CallError &r_error);
+	_FORCE_INLINE_ bool _ptrcall_cached(int p_cache, Variant *p_base, const Variant **p_args, int p_argcount, Variant *r_ret);
+	_FORCE_INLINE_ bool _get_cached(int p_cache, const Variant *p_base, const StringName &p_name, Variant &r_value);
+
 	_FORCE_INLINE_ Variant *_get_variant(int p_address, GDScriptInstance *p_instance, GDScript *p_script, Variant &self, Variant *p_stack, String &r_error) const;
 	_FORCE_INLINE_ String _get_call_error(const Variant::CallError &p_err, const String &p_where, const Variant **argptrs) const;
 
@@ -275,7 +338,7 @@ public:
 		ObjectID script_id;
 
 		GDScriptInstance *instance;
-		Vector<uint8_t> stack;
+		uint8_t *stack; // frame from GDScriptLanguage::alloc_frame(), NULL once it ran to completion
 		int stack_size;
 		Variant self;
 		uint32_t alloca_size;
@@ -288,6 +351,8 @@ public:
 
 	_FORCE_INLINE_ bool is_static() const { return _static; }
 
+	static bool can_ptrcall(const MethodBind *p_method); // whether arguments of the method can be passed without Variants
+
 	const int *get_code() const; //used for debug
 	int get_code_size() const;
 	Variant get_constant(int p_idx) const;
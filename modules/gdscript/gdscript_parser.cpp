@@ -7906,6 +7906,377 @@ int GDScriptParser::get_error_column() const {
 	return error_column;
 }
 
+static GDScriptParser::LocalVarNode *_get_local_var(const GDScriptParser::Node *p_node) {
+
+	if (p_node->type != GDScriptParser::Node::TYPE_IDENTIFIER) {
+		return NULL;
+	}
+	const GDScriptParser::IdentifierNode *id = static_cast<const GDScriptParser::IdentifierNode *>(p_node);
+	if (!id->declared_block) {
+		return NULL;
+	}
+	Map<StringName, GDScriptParser::LocalVarNode *>::Element *E = id->declared_block->variables.find(id->name);
+	return E ? E->get() : NULL;
+}
+
+// Local variable modified by assigning to the given expression (either the variable itself or an index of it).
+static GDScriptParser::LocalVarNode *_get_assigned_local_var(const GDScriptParser::Node *p_node) {
+
+	while (p_node->type == GDScriptParser::Node::TYPE_OPERATOR) {
+		const GDScriptParser::OperatorNode *op = static_cast<const GDScriptParser::OperatorNode *>(p_node);
+		if ((op->op != GDScriptParser::OperatorNode::OP_INDEX && op->op != GDScriptParser::OperatorNode::OP_INDEX_NAMED) || op->arguments.size() < 1) {
+			return NULL;
+		}
+		p_node = op->arguments[0];
+	}
+	return _get_local_var(p_node);
+}
+
+// Types that are copied on assignment, and can't change from outside the variable holding them.
+static bool _is_value_type(Variant::Type p_type) {
+
+	switch (p_type) {
+		case Variant::OBJECT:
+		case Variant::DICTIONARY:
+		case Variant::ARRAY:
+		case Variant::POOL_BYTE_ARRAY:
+		case Variant::POOL_INT_ARRAY:
+		case Variant::POOL_REAL_ARRAY:
+		case Variant::POOL_STRING_ARRAY:
+		case Variant::POOL_VECTOR2_ARRAY:
+		case Variant::POOL_VECTOR3_ARRAY:
+		case Variant::POOL_COLOR_ARRAY: {
+			return false;
+		} break;
+		default: {
+			return true;
+		}
+	}
+}
+
+void GDScriptParser::_optimize_class(ClassNode *p_class) {
+
+	for (int i = 0; i < p_class->static_functions.size(); i++) {
+		_optimize_function(p_class->static_functions[i]);
+	}
+	for (int i = 0; i < p_class->functions.size(); i++) {
+		_optimize_function(p_class->functions[i]);
+	}
+	for (int i = 0; i < p_class->subclasses.size(); i++) {
+		_optimize_class(p_class->subclasses[i]);
+	}
+}
+
+void GDScriptParser::_optimize_function(FunctionNode *p_function) {
+
+	if (!p_function->body) {
+		return;
+	}
+
+	OptimizeState state;
+	_find_local_writes(p_function->body, state);
+	_optimize_block(p_function->body, state);
+}
+
+void GDScriptParser::_find_local_writes(const Node *p_node, OptimizeState &r_state) const {
+
+	if (!p_node) {
+		return;
+	}
+
+	switch (p_node->type) {
+		case Node::TYPE_BLOCK: {
+			const BlockNode *block = static_cast<const BlockNode *>(p_node);
+			for (const List<Node *>::Element *E = block->statements.front(); E; E = E->next()) {
+				_find_local_writes(E->get(), r_state);
+			}
+		} break;
+		case Node::TYPE_CONTROL_FLOW: {
+			const ControlFlowNode *cf = static_cast<const ControlFlowNode *>(p_node);
+			if (cf->cf_type == ControlFlowNode::CF_FOR && cf->arguments.size() > 0) {
+				const LocalVarNode *lv = _get_local_var(cf->arguments[0]);
+				if (lv) {
+					r_state.written.insert(lv);
+				}
+			}
+			for (int i = 0; i < cf->arguments.size(); i++) {
+				_find_local_writes(cf->arguments[i], r_state);
+			}
+			_find_local_writes(cf->body, r_state);
+			_find_local_writes(cf->body_else, r_state);
+			if (cf->cf_type == ControlFlowNode::CF_MATCH) {
+				_find_local_writes(cf->match->val_to_match, r_state);
+				for (int i = 0; i < cf->match->compiled_pattern_branches.size(); i++) {
+					_find_local_writes(cf->match->compiled_pattern_branches[i].compiled_pattern, r_state);
+					_find_local_writes(cf->match->compiled_pattern_branches[i].body, r_state);
+				}
+			}
+		} break;
+		case Node::TYPE_OPERATOR: {
+			const OperatorNode *op = static_cast<const OperatorNode *>(p_node);
+			switch (op->op) {
+				case OperatorNode::OP_ASSIGN:
+				case OperatorNode::OP_ASSIGN_ADD:
+				case OperatorNode::OP_ASSIGN_SUB:
+				case OperatorNode::OP_ASSIGN_MUL:
+				case OperatorNode::OP_ASSIGN_DIV:
+				case OperatorNode::OP_ASSIGN_MOD:
+				case OperatorNode::OP_ASSIGN_SHIFT_LEFT:
+				case OperatorNode::OP_ASSIGN_SHIFT_RIGHT:
+				case OperatorNode::OP_ASSIGN_BIT_AND:
+				case OperatorNode::OP_ASSIGN_BIT_OR:
+				case OperatorNode::OP_ASSIGN_BIT_XOR: {
+					const LocalVarNode *lv = op->arguments.size() > 0 ? _get_assigned_local_var(op->arguments[0]) : NULL;
+					if (lv && lv->assign_op != op) {
+						r_state.written.insert(lv);
+					}
+				} break;
+				case OperatorNode::OP_CALL: {
+					if (op->arguments.size() < 2 || op->arguments[0]->type == Node::TYPE_TYPE || op->arguments[0]->type == Node::TYPE_BUILT_IN_FUNCTION || op->arguments[1]->type != Node::TYPE_IDENTIFIER) {
+						break;
+					}
+					// Method call, which may modify the base
+					const LocalVarNode *lv = _get_local_var(op->arguments[0]);
+					if (lv) {
+						r_state.method_calls[lv].insert(static_cast<const IdentifierNode *>(op->arguments[1])->name);
+					} else {
+						lv = _get_assigned_local_var(op->arguments[0]);
+						if (lv) {
+							r_state.written.insert(lv);
+						}
+					}
+				} break;
+				default: {
+				}
+			}
+			for (int i = 0; i < op->arguments.size(); i++) {
+				_find_local_writes(op->arguments[i], r_state);
+			}
+		} break;
+		case Node::TYPE_ARRAY: {
+			const ArrayNode *an = static_cast<const ArrayNode *>(p_node);
+			for (int i = 0; i < an->elements.size(); i++) {
+				_find_local_writes(an->elements[i], r_state);
+			}
+		} break;
+		case Node::TYPE_DICTIONARY: {
+			const DictionaryNode *dn = static_cast<const DictionaryNode *>(p_node);
+			for (int i = 0; i < dn->elements.size(); i++) {
+				_find_local_writes(dn->elements[i].key, r_state);
+				_find_local_writes(dn->elements[i].value, r_state);
+			}
+		} break;
+		case Node::TYPE_CAST: {
+			_find_local_writes(static_cast<const CastNode *>(p_node)->source_node, r_state);
+		} break;
+		case Node::TYPE_ASSERT: {
+			_find_local_writes(static_cast<const AssertNode *>(p_node)->condition, r_state);
+		} break;
+		default: {
+		}
+	}
+}
+
+bool GDScriptParser::_is_propagable_local(const LocalVarNode *p_local, const Variant &p_value, const OptimizeState &p_state) const {
+
+	if (p_state.written.has(p_local) || !_is_value_type(p_value.get_type())) {
+		return false;
+	}
+	if (p_local->datatype.has_type && (p_local->datatype.kind != DataType::BUILTIN || p_local->datatype.builtin_type != p_value.get_type())) {
+		return false; // The assignment converts the value
+	}
+	const Map<const LocalVarNode *, Set<StringName> >::Element *E = p_state.method_calls.find(p_local);
+	if (E) {
+		for (const Set<StringName>::Element *F = E->get().front(); F; F = F->next()) {
+			if (!Variant::is_method_const(p_value.get_type(), F->get())) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void GDScriptParser::_optimize_block(BlockNode *p_block, OptimizeState &r_state) {
+
+	for (List<Node *>::Element *E = p_block->statements.front(); E;) {
+
+		List<Node *>::Element *N = E->next();
+		Node *statement = E->get();
+
+		switch (statement->type) {
+			case Node::TYPE_NEWLINE:
+			case Node::TYPE_BREAKPOINT:
+			case Node::TYPE_LOCAL_VAR: {
+				// Nothing to do
+			} break;
+			case Node::TYPE_ASSERT: {
+				AssertNode *as = static_cast<AssertNode *>(statement);
+				as->condition = _optimize_expression(as->condition, r_state);
+			} break;
+			case Node::TYPE_CONTROL_FLOW: {
+				ControlFlowNode *cf = static_cast<ControlFlowNode *>(statement);
+				for (int i = 0; i < cf->arguments.size(); i++) {
+					cf->arguments.write[i] = _optimize_expression(cf->arguments[i], r_state);
+				}
+				if (cf->body) {
+					_optimize_block(cf->body, r_state);
+				}
+				if (cf->body_else) {
+					_optimize_block(cf->body_else, r_state);
+				}
+				if (cf->cf_type == ControlFlowNode::CF_MATCH) {
+					cf->match->val_to_match = _optimize_expression(cf->match->val_to_match, r_state);
+					for (int i = 0; i < cf->match->compiled_pattern_branches.size(); i++) {
+						MatchNode::CompiledPatternBranch &branch = cf->match->compiled_pattern_branches.write[i];
+						if (branch.compiled_pattern) {
+							branch.compiled_pattern = _optimize_expression(branch.compiled_pattern, r_state);
+						}
+						if (branch.body) {
+							_optimize_block(branch.body, r_state);
+						}
+					}
+				}
+
+				if (cf->cf_type == ControlFlowNode::CF_RETURN || cf->cf_type == ControlFlowNode::CF_BREAK || cf->cf_type == ControlFlowNode::CF_CONTINUE) {
+					// Nothing after this is reachable
+					while (N) {
+						List<Node *>::Element *next = N->next();
+						p_block->statements.erase(N);
+						N = next;
+					}
+				}
+			} break;
+			default: {
+				if (statement->type == Node::TYPE_OPERATOR && static_cast<OperatorNode *>(statement)->op == OperatorNode::OP_ASSIGN) {
+					OperatorNode *op = static_cast<OperatorNode *>(statement);
+					LocalVarNode *lv = _get_local_var(op->arguments[0]);
+
+					if (lv && lv->assign_op == op) {
+						op->arguments.write[1] = _optimize_expression(op->arguments[1], r_state);
+						lv->assign = op->arguments[1];
+						if (lv->assign->type == Node::TYPE_CONSTANT && _is_propagable_local(lv, static_cast<ConstantNode *>(lv->assign)->value, r_state)) {
+							// Every use gets the value instead, so the assignment isn't needed
+							r_state.constants[lv] = static_cast<ConstantNode *>(lv->assign)->value;
+							p_block->statements.erase(E);
+						}
+						break;
+					}
+					if (lv && lv == _get_local_var(op->arguments[1])) {
+						p_block->statements.erase(E); // Assigning a variable to itself
+						break;
+					}
+				}
+
+				Node *expr = _optimize_expression(statement, r_state);
+				if (expr->type == Node::TYPE_CONSTANT) {
+					p_block->statements.erase(E); // No effect
+				} else {
+					E->get() = expr;
+				}
+			} break;
+		}
+
+		E = N;
+	}
+}
+
+GDScriptParser::Node *GDScriptParser::_optimize_expression(Node *p_node, const OptimizeState &p_state) {
+
+	switch (p_node->type) {
+		case Node::TYPE_IDENTIFIER: {
+			const LocalVarNode *lv = _get_local_var(p_node);
+			const Map<const LocalVarNode *, Variant>::Element *E = lv ? p_state.constants.find(lv) : NULL;
+			if (!E) {
+				return p_node;
+			}
+			ConstantNode *cn = alloc_node<ConstantNode>();
+			cn->value = E->get();
+			cn->datatype = _type_from_variant(cn->value);
+			cn->line = p_node->line;
+			cn->column = p_node->column;
+			return cn;
+		} break;
+		case Node::TYPE_ARRAY: {
+			ArrayNode *an = static_cast<ArrayNode *>(p_node);
+			for (int i = 0; i < an->elements.size(); i++) {
+				an->elements.write[i] = _optimize_expression(an->elements[i], p_state);
+			}
+			return an;
+		} break;
+		case Node::TYPE_DICTIONARY: {
+			DictionaryNode *dn = static_cast<DictionaryNode *>(p_node);
+			for (int i = 0; i < dn->elements.size(); i++) {
+				dn->elements.write[i].key = _optimize_expression(dn->elements[i].key, p_state);
+				dn->elements.write[i].value = _optimize_expression(dn->elements[i].value, p_state);
+			}
+			return dn;
+		} break;
+		case Node::TYPE_CAST: {
+			CastNode *cn = static_cast<CastNode *>(p_node);
+			cn->source_node = _optimize_expression(cn->source_node, p_state);
+			return cn;
+		} break;
+		case Node::TYPE_OPERATOR: {
+			OperatorNode *op = static_cast<OperatorNode *>(p_node);
+			for (int i = 0; i < op->arguments.size(); i++) {
+				op->arguments.write[i] = _optimize_expression(op->arguments[i], p_state);
+			}
+
+			Node *reduced = _reduce_expression(op);
+			if (error_set) {
+				// Can't be done here, leave it to fail at runtime as it did before
+				error_set = false;
+				error = String();
+				error_line = 0;
+				error_column = 0;
+				return op;
+			}
+			if (reduced != op) {
+				return reduced;
+			}
+
+			if (op->op == OperatorNode::OP_TERNARY_IF && op->arguments[0]->type == Node::TYPE_CONSTANT) {
+				return static_cast<ConstantNode *>(op->arguments[0])->value.booleanize() ? op->arguments[1] : op->arguments[2];
+			}
+
+			if (op->op == OperatorNode::OP_CALL && op->arguments.size() >= 2 && op->arguments[0]->type == Node::TYPE_CONSTANT && op->arguments[1]->type == Node::TYPE_IDENTIFIER) {
+				// Method without side effects called on a constant value
+				Variant base = static_cast<ConstantNode *>(op->arguments[0])->value;
+				const StringName &method = static_cast<IdentifierNode *>(op->arguments[1])->name;
+				if (!_is_value_type(base.get_type()) || !Variant::is_method_const(base.get_type(), method)) {
+					return op;
+				}
+
+				Vector<const Variant *> args;
+				for (int i = 2; i < op->arguments.size(); i++) {
+					if (op->arguments[i]->type != Node::TYPE_CONSTANT) {
+						return op;
+					}
+					args.push_back(&static_cast<ConstantNode *>(op->arguments[i])->value);
+				}
+
+				Variant::CallError ce;
+				Variant ret = base.call(method, args.size() ? (const Variant **)args.ptr() : NULL, args.size(), ce);
+				if (ce.error != Variant::CallError::CALL_OK || !_is_value_type(ret.get_type())) {
+					return op;
+				}
+
+				ConstantNode *cn = alloc_node<ConstantNode>();
+				cn->value = ret;
+				cn->datatype = _type_from_variant(ret);
+				cn->line = op->line;
+				cn->column = op->column;
+				return cn;
+			}
+
+			return op;
+		} break;
+		default: {
+			return p_node;
+		}
+	}
+}
+
 Error GDScriptParser::_parse(const String &p_base_path) {
 
 	base_path = p_base_path;
@@ -7989,6 +8360,10 @@ Error GDScriptParser::_parse(const String &p_base_path) {
 	}
 #endif // DEBUG_ENABLED
 
+	if (!validating && !for_completion && GLOBAL_GET("debug/gdscript/compiler/optimize").booleanize()) {
+		_optimize_class(main_class);
+	}
+
 	return OK;
 }
 
@@ -609,6 +609,19 @@ private:
 	void _check_class_blocks_types(ClassNode *p_class);
 	void _check_function_types(FunctionNode *p_function);
 	void _check_block_types(BlockNode *p_block);
+
+	struct OptimizeState {
+		Set<const LocalVarNode *> written;
+		Map<const LocalVarNode *, Set<StringName> > method_calls;
+		Map<const LocalVarNode *, Variant> constants;
+	};
+
+	void _optimize_class(ClassNode *p_class);
+	void _optimize_function(FunctionNode *p_function);
+	void _find_local_writes(const Node *p_node, OptimizeState &r_state) const;
+	bool _is_propagable_local(const LocalVarNode *p_local, const Variant &p_value, const OptimizeState &p_state) const;
+	void _optimize_block(BlockNode *p_block, OptimizeState &r_state);
+	Node *_optimize_expression(Node *p_node, const OptimizeState &p_state);
 	_FORCE_INLINE_ void _mark_line_as_safe(int p_line) const {
 #ifdef DEBUG_ENABLED
 		if (safe_lines) safe_lines->insert(p_line);
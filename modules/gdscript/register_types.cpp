@@ -32,6 +32,8 @@
 
 #include "editor/gdscript_highlighter.h"
 #include "gdscript.h"
+#include "gdscript_batch_loader.h"
+#include "gdscript_bytecode.h"
 #include "gdscript_tokenizer.h"
 #include "io/file_access_encrypted.h"
 #include "io/resource_loader.h"
@@ -51,24 +53,72 @@ class EditorExportGDScript : public EditorExportPlugin {
 
 	GDCLASS(EditorExportGDScript, EditorExportPlugin);
 
+	// Scripts to export are all loaded beforehand, compiled in parallel where possible
+	GDScriptBatchLoader loader;
+	bool export_debug;
+
 public:
+	virtual void _export_begin(const Set<String> &p_features, bool p_debug, const String &p_path, int p_flags) {
+
+		export_debug = p_debug;
+	}
+
+	virtual void _export_prepare(const Set<String> &p_paths) {
+
+		Vector<String> scripts;
+		for (const Set<String>::Element *E = p_paths.front(); E; E = E->next()) {
+			if (E->get().ends_with(".gd")) {
+				scripts.push_back(E->get());
+			}
+		}
+
+		loader.set_keep_tokens(true);
+		loader.load(scripts);
+	}
+
+	virtual void _export_finish() {
+
+		loader.clear();
+	}
+
 	virtual void _export_file(const String &p_path, const String &p_type, const Set<String> &p_features) {
 
 		if (!p_path.ends_with(".gd"))
 			return;
 
-		Vector<uint8_t> file = FileAccess::get_file_as_array(p_path);
-		if (file.empty())
-			return;
 		String txt;
-		txt.parse_utf8((const char *)file.ptr(), file.size());
-		file = GDScriptTokenizerBuffer::parse_code_string(txt);
+		Vector<uint8_t> file;
+		Ref<GDScript> script;
+
+		int index = loader.find(p_path);
+		if (index != -1) {
+			txt = loader.get_source(index);
+			file = loader.get_tokens(index);
+			script = loader.get_script(index);
+		} else {
+			file = FileAccess::get_file_as_array(p_path);
+			if (file.empty())
+				return;
+			txt.parse_utf8((const char *)file.ptr(), file.size());
+			file = GDScriptTokenizerBuffer::parse_code_string(txt);
+			script = ResourceLoader::load(p_path);
+		}
 
 		if (file.empty())
 			return;
 
+		// Add the compiled code if the script compiled from the same source, so it's not compiled again on load
+		if (script.is_valid() && script->is_valid() && script->get_source_code() == txt) {
+			file = GDScriptBytecode::make_buffer(script, file, export_debug);
+		}
+
 		add_file(p_path.get_basename() + ".gdc", file, true);
 	}
+
+	EditorExportGDScript() {
+
+		export_debug = false;
+	}
 };
 
 static void _editor_init() {
@@ -87,6 +87,7 @@ class GeometryInstance : public VisualInstance {
 public:
 	enum Flags {
 		FLAG_USE_BAKED_LIGHT = VS::INSTANCE_FLAG_USE_BAKED_LIGHT,
+		FLAG_OCCLUDER = VS::INSTANCE_FLAG_OCCLUDER,
 		FLAG_MAX = VS::INSTANCE_FLAG_MAX,
 	};
 
@@ -202,8 +202,8 @@ void Node::_propagate_enter_tree() {
 
 	data.inside_tree = true;
 
-	for (Map<StringName, GroupData>::Element *E = data.grouped.front(); E; E = E->next()) {
-		E->get().group = data.tree->add_to_group(E->key(), this);
+	for (const StringName *K = data.grouped.next(NULL); K; K = data.grouped.next(K)) {
+		data.grouped[*K].group = data.tree->add_to_group(*K, this);
 	}
 
 	notification(NOTIFICATION_ENTER_TREE);
@@ -285,9 +285,9 @@ void Node::_propagate_exit_tree() {
 
 	// exit groups
 
-	for (Map<StringName, GroupData>::Element *E = data.grouped.front(); E; E = E->next()) {
-		data.tree->remove_from_group(E->key(), this);
-		E->get().group = NULL;
+	for (const StringName *K = data.grouped.next(NULL); K; K = data.grouped.next(K)) {
+		data.tree->remove_from_group(*K, this);
+		data.grouped[*K].group = NULL;
 	}
 
 	data.viewport = NULL;
@@ -344,9 +344,9 @@ void Node::move_child(Node *p_child, int p_pos) {
 	for (int i = motion_from; i <= motion_to; i++) {
 		data.children[i]->notification(NOTIFICATION_MOVED_IN_PARENT);
 	}
-	for (const Map<StringName, GroupData>::Element *E = p_child->data.grouped.front(); E; E = E->next()) {
-		if (E->get().group)
-			E->get().group->changed = true;
+	for (OAHashMap<StringName, GroupData>::Iterator E = p_child->data.grouped.iter(); E.valid; E = p_child->data.grouped.next_iter(E)) {
+		if (E.value->group)
+			E.value->group->changed = true;
 	}
 
 	data.blocked--;
@@ -978,7 +978,7 @@ void Node::_validate_child_name(Node *p_child, bool p_force_human_readable) {
 			unique = false;
 		} else {
 			//check if exists
-			Node **children = data.children.ptrw();
+			Node **children = data.children.ptr();
 			int cc = data.children.size();
 
 			for (int i = 0; i < cc; i++) {
@@ -1607,14 +1607,10 @@ void Node::remove_from_group(const StringName &p_identifier) {
 
 	ERR_FAIL_COND(!data.grouped.has(p_identifier));
 
-	Map<StringName, GroupData>::Element *E = data.grouped.find(p_identifier);
-
-	ERR_FAIL_COND(!E);
-
 	if (data.tree)
-		data.tree->remove_from_group(E->key(), this);
+		data.tree->remove_from_group(p_identifier, this);
 
-	data.grouped.erase(E);
+	data.grouped.erase(p_identifier);
 }
 
 Array Node::_get_groups() const {
@@ -1631,18 +1627,18 @@ Array Node::_get_groups() const {
 
 void Node::get_groups(List<GroupInfo> *p_groups) const {
 
-	for (const Map<StringName, GroupData>::Element *E = data.grouped.front(); E; E = E->next()) {
+	for (OAHashMap<StringName, GroupData>::Iterator E = data.grouped.iter(); E.valid; E = data.grouped.next_iter(E)) {
 		GroupInfo gi;
-		gi.name = E->key();
-		gi.persistent = E->get().persistent;
+		gi.name = *E.key;
+		gi.persistent = E.value->persistent;
 		p_groups->push_back(gi);
 	}
 }
 
 bool Node::has_persistent_groups() const {
 
-	for (const Map<StringName, GroupData>::Element *E = data.grouped.front(); E; E = E->next()) {
-		if (E->get().persistent)
+	for (OAHashMap<StringName, GroupData>::Iterator E = data.grouped.iter(); E.valid; E = data.grouped.next_iter(E)) {
+		if (E.value->persistent)
 			return true;
 	}
 
@@ -32,8 +32,10 @@
 #define NODE_H
 
 #include "class_db.h"
+#include "local_vector.h"
 #include "map.h"
 #include "node_path.h"
+#include "oa_hash_map.h"
 #include "object.h"
 #include "project_settings.h"
 #include "scene/main/scene_tree.h"
@@ -93,7 +95,7 @@ private:
 
 		Node *parent;
 		Node *owner;
-		Vector<Node *> children; // list of children
+		LocalVector<Node *> children; // list of children
 		int pos;
 		int depth;
 		int blocked; // safeguard that throws an error when attempting to modify the tree in a harmful way while being traversed.
@@ -108,7 +110,7 @@ private:
 
 		Viewport *viewport;
 
-		Map<StringName, GroupData> grouped;
+		OAHashMap<StringName, GroupData> grouped;
 		List<Node *>::Element *OW; // owned element
 		List<Node *> owned;
 
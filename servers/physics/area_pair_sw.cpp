@@ -41,6 +41,16 @@ bool AreaPairSW::setup(real_t p_step) {
 		result = true;
 	}
 
+	process_collision = result;
+
+	return false; //never do any post solving
+}
+
+bool AreaPairSW::pre_solve(real_t p_step) {
+
+	// The area is shared with other islands, so it is only updated here.
+	bool result = process_collision;
+
 	if (result != colliding) {
 
 		if (result) {
@@ -74,6 +84,7 @@ AreaPairSW::AreaPairSW(BodySW *p_body, int p_body_shape, AreaSW *p_area, int p_a
 	body_shape = p_body_shape;
 	area_shape = p_area_shape;
 	colliding = false;
+	process_collision = false;
 	body->add_constraint(this, 0);
 	area->add_constraint(this);
 	if (p_body->get_mode() == PhysicsServer::BODY_MODE_KINEMATIC)
@@ -104,6 +115,15 @@ bool Area2PairSW::setup(real_t p_step) {
 		result = true;
 	}
 
+	process_collision = result;
+
+	return false; //never do any post solving
+}
+
+bool Area2PairSW::pre_solve(real_t p_step) {
+
+	bool result = process_collision;
+
 	if (result != colliding) {
 
 		if (result) {
@@ -139,6 +159,7 @@ Area2PairSW::Area2PairSW(AreaSW *p_area_a, int p_shape_a, AreaSW *p_area_b, int
 	shape_a = p_shape_a;
 	shape_b = p_shape_b;
 	colliding = false;
+	process_collision = false;
 	area_a->add_constraint(this);
 	area_b->add_constraint(this);
 }
@@ -221,6 +221,8 @@ real_t combine_friction(BodySW *A, BodySW *B) {
 
 bool BodyPairSW::setup(real_t p_step) {
 
+	check_ccd = false;
+
 	//cannot collide
 	if (!A->test_collision_mask(B) || A->has_exception(B->get_self()) || B->has_exception(A->get_self()) || (A->get_mode() <= PhysicsServer::BODY_MODE_KINEMATIC && B->get_mode() <= PhysicsServer::BODY_MODE_KINEMATIC && A->get_max_contacts_reported() == 0 && B->get_max_contacts_reported() == 0)) {
 		collided = false;
@@ -236,12 +238,11 @@ bool BodyPairSW::setup(real_t p_step) {
 
 	validate_contacts();
 
-	Vector3 offset_A = A->get_transform().get_origin();
 	Transform xform_Au = Transform(A->get_transform().basis, Vector3());
 	Transform xform_A = xform_Au * A->get_shape_transform(shape_A);
 
 	Transform xform_Bu = B->get_transform();
-	xform_Bu.origin -= offset_A;
+	xform_Bu.origin -= A->get_transform().get_origin();
 	Transform xform_B = xform_Bu * B->get_shape_transform(shape_B);
 
 	ShapeSW *shape_A_ptr = A->get_shape(shape_A);
@@ -250,10 +251,29 @@ bool BodyPairSW::setup(real_t p_step) {
 	bool collided = CollisionSolverSW::solve_static(shape_A_ptr, xform_A, shape_B_ptr, xform_B, _contact_added_callback, this, &sep_axis);
 	this->collided = collided;
 
+	// CCD changes the velocity of the body, so it is tested in pre_solve.
+	check_ccd = !collided;
+
+	return collided;
+}
+
+bool BodyPairSW::pre_solve(real_t p_step) {
+
+	Vector3 offset_A = A->get_transform().get_origin();
+	Transform xform_Au = Transform(A->get_transform().basis, Vector3());
+	Transform xform_Bu = B->get_transform();
+	xform_Bu.origin -= offset_A;
+
 	if (!collided) {
 
+		if (!check_ccd)
+			return false;
+
 		//test ccd (currently just a raycast)
 
+		Transform xform_A = xform_Au * A->get_shape_transform(shape_A);
+		Transform xform_B = xform_Bu * B->get_shape_transform(shape_B);
+
 		if (A->is_continuous_collision_detection_enabled() && A->get_mode() > PhysicsServer::BODY_MODE_KINEMATIC && B->get_mode() <= PhysicsServer::BODY_MODE_KINEMATIC) {
 			_test_ccd(p_step, A, shape_A, xform_A, B, shape_B, xform_B);
 		}
@@ -265,6 +285,9 @@ bool BodyPairSW::setup(real_t p_step) {
 		return false;
 	}
 
+	ShapeSW *shape_A_ptr = A->get_shape(shape_A);
+	ShapeSW *shape_B_ptr = B->get_shape(shape_B);
+
 	real_t max_penetration = space->get_contact_max_allowed_penetration();
 
 	real_t bias = (real_t)0.3;
@@ -486,6 +509,7 @@ BodyPairSW::BodyPairSW(BodySW *p_A, int p_shape_A, BodySW *p_B, int p_shape_B) :
 	B->add_constraint(this, 1);
 	contact_count = 0;
 	collided = false;
+	check_ccd = false;
 }
 
 BodyPairSW::~BodyPairSW() {
@@ -31,6 +31,7 @@
 #include "physics_server_sw.h"
 
 #include "broad_phase_basic.h"
+#include "broad_phase_bvh.h"
 #include "broad_phase_octree.h"
 #include "joints/cone_twist_joint_sw.h"
 #include "joints/generic_6dof_joint_sw.h"
@@ -38,6 +39,7 @@
 #include "joints/pin_joint_sw.h"
 #include "joints/slider_joint_sw.h"
 #include "os/os.h"
+#include "project_settings.h"
 #include "script_language.h"
 
 RID PhysicsServerSW::shape_create(ShapeType p_shape) {
@@ -1554,7 +1556,11 @@ void PhysicsServerSW::_shape_col_cbk(const Vector3 &p_point_A, const Vector3 &p_
 PhysicsServerSW *PhysicsServerSW::singleton = NULL;
 PhysicsServerSW::PhysicsServerSW() {
 	singleton = this;
-	BroadPhaseSW::create_func = BroadPhaseOctree::_create;
+	if (GLOBAL_DEF("physics/3d/godot_physics/use_bvh", false)) {
+		BroadPhaseSW::create_func = BroadPhaseBVH::_create;
+	} else {
+		BroadPhaseSW::create_func = BroadPhaseOctree::_create;
+	}
 	island_count = 0;
 	active_objects = 0;
 	collision_pairs = 0;
@@ -32,6 +32,7 @@
 #include "joints_sw.h"
 
 #include "os/os.h"
+#include "os/thread_work_pool.h"
 
 void StepSW::_populate_island(BodySW *p_body, BodySW **p_island, ConstraintSW **p_constraint_island) {
 
@@ -59,23 +60,30 @@ void StepSW::_populate_island(BodySW *p_body, BodySW **p_island, ConstraintSW **
 	}
 }
 
-void StepSW::_setup_island(ConstraintSW *p_island, real_t p_delta) {
+void StepSW::_setup_constraint(uint32_t p_constraint_index, real_t p_delta) {
+
+	all_constraints[p_constraint_index]->setup(p_delta);
+	//todo remove from island if process fails
+}
+
+void StepSW::_pre_solve_island(ConstraintSW *p_island, real_t p_delta) {
 
 	ConstraintSW *ci = p_island;
 	while (ci) {
-		ci->setup(p_delta);
-		//todo remove from island if process fails
+		ci->pre_solve(p_delta);
 		ci = ci->get_island_next();
 	}
 }
 
-void StepSW::_solve_island(ConstraintSW *p_island, int p_iterations, real_t p_delta) {
+void StepSW::_solve_island(uint32_t p_island_index, real_t p_delta) {
+
+	ConstraintSW *p_island = constraint_islands[p_island_index];
 
 	int at_priority = 1;
 
 	while (p_island) {
 
-		for (int i = 0; i < p_iterations; i++) {
+		for (int i = 0; i < iterations; i++) {
 
 			ConstraintSW *ci = p_island;
 			while (ci) {
@@ -229,17 +237,41 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 	}
 
 	//print_line("island count: "+itos(island_count)+" active count: "+itos(active_count));
-	/* SETUP CONSTRAINT ISLANDS */
+
+	// Islands don't share any dynamic body, so they can be set up and solved in parallel.
+	// Each island is still solved serially, which keeps results independent from the thread count.
+
+	// filled again every step, from the frame arena
+	constraint_islands.clear();
+	all_constraints.clear();
 
 	{
 		ConstraintSW *ci = constraint_island_list;
 		while (ci) {
 
-			_setup_island(ci, p_delta);
+			constraint_islands.push_back(ci);
+
+			ConstraintSW *c = ci;
+			while (c) {
+				all_constraints.push_back(c);
+				c = c->get_island_next();
+			}
+
 			ci = ci->get_island_list_next();
 		}
 	}
 
+	/* SETUP CONSTRAINTS / PROCESS COLLISIONS */
+
+	ThreadWorkPool::get_singleton()->do_work(all_constraints.size(), this, &StepSW::_setup_constraint, p_delta);
+
+	/* PRE-SOLVE CONSTRAINT ISLANDS */
+
+	// Not threaded, as it changes bodies and areas that may be shared between islands (contact reporting, area monitoring).
+	for (int i = 0; i < constraint_islands.size(); i++) {
+		_pre_solve_island(constraint_islands[i], p_delta);
+	}
+
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
 		p_space->set_elapsed_time(SpaceSW::ELAPSED_TIME_SETUP_CONSTRAINTS, profile_endtime - profile_begtime);
@@ -248,14 +280,9 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* SOLVE CONSTRAINT ISLANDS */
 
-	{
-		ConstraintSW *ci = constraint_island_list;
-		while (ci) {
-			//iterating each island separatedly improves cache efficiency
-			_solve_island(ci, p_iterations, p_delta);
-			ci = ci->get_island_list_next();
-		}
-	}
+	//iterating each island separatedly improves cache efficiency
+	iterations = p_iterations;
+	ThreadWorkPool::get_singleton()->do_work(constraint_islands.size(), this, &StepSW::_solve_island, p_delta, 1);
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
@@ -297,4 +324,5 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 StepSW::StepSW() {
 
 	_step = 1;
+	iterations = 0;
 }
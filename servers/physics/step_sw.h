@@ -31,15 +31,21 @@
 #ifndef STEP_SW_H
 #define STEP_SW_H
 
+#include "frame_arena.h"
 #include "space_sw.h"
 
 class StepSW {
 
 	uint64_t _step;
 
+	int iterations;
+	FrameVector<ConstraintSW *> constraint_islands;
+	FrameVector<ConstraintSW *> all_constraints;
+
 	void _populate_island(BodySW *p_body, BodySW **p_island, ConstraintSW **p_constraint_island);
-	void _setup_island(ConstraintSW *p_island, real_t p_delta);
-	void _solve_island(ConstraintSW *p_island, int p_iterations, real_t p_delta);
+	void _setup_constraint(uint32_t p_constraint_index, real_t p_delta);
+	void _pre_solve_island(ConstraintSW *p_island, real_t p_delta);
+	void _solve_island(uint32_t p_island_index, real_t p_delta);
 	void _check_suspend(BodySW *p_island, real_t p_delta);
 
 public:
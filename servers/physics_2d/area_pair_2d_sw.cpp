@@ -41,6 +41,16 @@ bool AreaPair2DSW::setup(real_t p_step) {
 		result = true;
 	}
 
+	process_collision = result;
+
+	return true;
+}
+
+bool AreaPair2DSW::pre_solve(real_t p_step) {
+
+	// The area is shared with other islands, so it is only updated here.
+	bool result = process_collision;
+
 	if (result != colliding) {
 
 		if (result) {
@@ -74,6 +84,7 @@ AreaPair2DSW::AreaPair2DSW(Body2DSW *p_body, int p_body_shape, Area2DSW *p_area,
 	body_shape = p_body_shape;
 	area_shape = p_area_shape;
 	colliding = false;
+	process_collision = false;
 	body->add_constraint(this, 0);
 	area->add_constraint(this);
 	if (p_body->get_mode() == Physics2DServer::BODY_MODE_KINEMATIC) //need to be active to process pair
@@ -104,6 +115,15 @@ bool Area2Pair2DSW::setup(real_t p_step) {
 		result = true;
 	}
 
+	process_collision = result;
+
+	return true;
+}
+
+bool Area2Pair2DSW::pre_solve(real_t p_step) {
+
+	bool result = process_collision;
+
 	if (result != colliding) {
 
 		if (result) {
@@ -139,6 +159,7 @@ Area2Pair2DSW::Area2Pair2DSW(Area2DSW *p_area_a, int p_shape_a, Area2DSW *p_area
 	shape_a = p_shape_a;
 	shape_b = p_shape_b;
 	colliding = false;
+	process_collision = false;
 	area_a->add_constraint(this);
 	area_b->add_constraint(this);
 }
@@ -203,8 +203,13 @@ public:
 		linear_velocity += p_impulse * _inv_mass;
 	}
 
+	// Static and kinematic bodies may be shared by islands that are solved at the same time.
+	// Impulses don't affect them (no inverse mass), so they are never written to.
 	_FORCE_INLINE_ void apply_impulse(const Vector2 &p_offset, const Vector2 &p_impulse) {
 
+		if (mode <= Physics2DServer::BODY_MODE_KINEMATIC)
+			return;
+
 		linear_velocity += p_impulse * _inv_mass;
 		angular_velocity += _inv_inertia * p_offset.cross(p_impulse);
 	}
@@ -215,6 +220,9 @@ public:
 
 	_FORCE_INLINE_ void apply_bias_impulse(const Vector2 &p_pos, const Vector2 &p_j) {
 
+		if (mode <= Physics2DServer::BODY_MODE_KINEMATIC)
+			return;
+
 		biased_linear_velocity += p_j * _inv_mass;
 		biased_angular_velocity += _inv_inertia * p_pos.cross(p_j);
 	}
@@ -245,7 +245,6 @@ bool BodyPair2DSW::setup(real_t p_step) {
 
 	_validate_contacts();
 
-	Vector2 offset_A = A->get_transform().get_origin();
 	Transform2D xform_Au = A->get_transform().untranslated();
 	Transform2D xform_A = xform_Au * A->get_shape_transform(shape_A);
 
@@ -269,6 +268,33 @@ bool BodyPair2DSW::setup(real_t p_step) {
 	//bool prev_collided=collided;
 
 	collided = CollisionSolver2DSW::solve(shape_A_ptr, xform_A, motion_A, shape_B_ptr, xform_B, motion_B, _add_contact, this, &sep_axis);
+	if (!collided) {
+
+		//ccd is tested in pre_solve, as it depends on the velocities of the bodies
+		bool test_ccd = (A->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_RAY && A->get_mode() > Physics2DServer::BODY_MODE_KINEMATIC) || (B->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_RAY && B->get_mode() > Physics2DServer::BODY_MODE_KINEMATIC);
+
+		if (!test_ccd) {
+			oneway_disabled = false;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool BodyPair2DSW::pre_solve(real_t p_step) {
+
+	Vector2 offset_A = A->get_transform().get_origin();
+	Transform2D xform_Au = A->get_transform().untranslated();
+	Transform2D xform_A = xform_Au * A->get_shape_transform(shape_A);
+
+	Transform2D xform_Bu = B->get_transform();
+	xform_Bu.elements[2] -= A->get_transform().get_origin();
+	Transform2D xform_B = xform_Bu * B->get_shape_transform(shape_B);
+
+	Shape2DSW *shape_A_ptr = A->get_shape(shape_A);
+	Shape2DSW *shape_B_ptr = B->get_shape(shape_B);
+
 	if (!collided) {
 
 		//test ccd (currently just a raycast)
@@ -71,7 +71,11 @@ public:
 	_FORCE_INLINE_ void disable_collisions_between_bodies(const bool p_disabled) { disabled_collisions_between_bodies = p_disabled; }
 	_FORCE_INLINE_ bool is_disabled_collisions_between_bodies() const { return disabled_collisions_between_bodies; }
 
+	// setup() may run in parallel with the setup of other constraints, so it must only change
+	// the constraint itself. Anything that touches bodies or areas goes in pre_solve(), which runs
+	// serially in island order. Returning false from either removes the constraint from the island.
 	virtual bool setup(real_t p_step) = 0;
+	virtual bool pre_solve(real_t p_step) { return true; }
 	virtual void solve(real_t p_step) = 0;
 
 	virtual ~Constraint2DSW() {}
@@ -138,6 +138,11 @@ bool PinJoint2DSW::setup(real_t p_step) {
 
 	bias = delta * -(get_bias() == 0 ? space->get_constraint_bias() : get_bias()) * (1.0 / p_step);
 
+	return true;
+}
+
+bool PinJoint2DSW::pre_solve(real_t p_step) {
+
 	// apply accumulated impulse
 	A->apply_impulse(rA, -P);
 	if (B)
@@ -304,11 +309,16 @@ bool GrooveJoint2DSW::setup(real_t p_step) {
 	real_t _b = 0.001;
 	gbias = (delta * -(_b == 0 ? space->get_constraint_bias() : _b) * (1.0 / p_step)).clamped(get_max_bias());
 
+	correct = true;
+	return true;
+}
+
+bool GrooveJoint2DSW::pre_solve(real_t p_step) {
+
 	// apply accumulated impulse
 	A->apply_impulse(rA, -jn_acc);
 	B->apply_impulse(rB, jn_acc);
 
-	correct = true;
 	return true;
 }
 
@@ -375,10 +385,15 @@ bool DampedSpringJoint2DSW::setup(real_t p_step) {
 
 	// apply spring force
 	real_t f_spring = (rest_length - dist) * stiffness;
-	Vector2 j = n * f_spring * (p_step);
+	spring_impulse = n * f_spring * (p_step);
 
-	A->apply_impulse(rA, -j);
-	B->apply_impulse(rB, j);
+	return true;
+}
+
+bool DampedSpringJoint2DSW::pre_solve(real_t p_step) {
+
+	A->apply_impulse(rA, -spring_impulse);
+	B->apply_impulse(rB, spring_impulse);
 
 	return true;
 }
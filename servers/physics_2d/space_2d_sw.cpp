@@ -1160,6 +1160,9 @@ void Space2DSW::setup() {
 
 	contact_debug_count = 0;
 
+	// pair objects moved since the last step, for broadphases that update pairs in batches
+	broadphase->update();
+
 	while (inertia_update_list.first()) {
 		inertia_update_list.first()->self()->update_inertias();
 		inertia_update_list.remove(inertia_update_list.first());
@@ -29,7 +29,10 @@
 /*************************************************************************/
 
 #include "step_2d_sw.h"
+
 #include "os/os.h"
+#include "os/thread_work_pool.h"
+#include "project_settings.h"
 
 void Step2DSW::_populate_island(Body2DSW *p_body, Body2DSW **p_island, Constraint2DSW **p_constraint_island) {
 
@@ -57,36 +60,41 @@ void Step2DSW::_populate_island(Body2DSW *p_body, Body2DSW **p_island, Constrain
 	}
 }
 
-bool Step2DSW::_setup_island(Constraint2DSW *p_island, real_t p_delta) {
+void Step2DSW::_setup_constraint(uint32_t p_constraint_index, real_t p_delta) {
+
+	constraint_setup_results[p_constraint_index] = all_constraints[p_constraint_index]->setup(p_delta);
+}
+
+Constraint2DSW *Step2DSW::_pre_solve_island(Constraint2DSW *p_island, int p_first_constraint, real_t p_delta) {
 
 	Constraint2DSW *ci = p_island;
 	Constraint2DSW *prev_ci = NULL;
-	bool removed_root = false;
+	int index = p_first_constraint;
 	while (ci) {
-		bool process = ci->setup(p_delta);
+		bool process = constraint_setup_results[index] && ci->pre_solve(p_delta);
 
 		if (!process) {
 			//remove from island if process fails
 			if (prev_ci) {
 				prev_ci->set_island_next(ci->get_island_next());
 			} else {
-				removed_root = true;
-				prev_ci = ci;
+				p_island = ci->get_island_next();
 			}
 		} else {
 			prev_ci = ci;
 		}
 		ci = ci->get_island_next();
+		index++;
 	}
 
-	return removed_root;
+	return p_island;
 }
 
-void Step2DSW::_solve_island(Constraint2DSW *p_island, int p_iterations, real_t p_delta) {
+void Step2DSW::_solve_island(uint32_t p_island_index, real_t p_delta) {
 
-	for (int i = 0; i < p_iterations; i++) {
+	for (int i = 0; i < iterations; i++) {
 
-		Constraint2DSW *ci = p_island;
+		Constraint2DSW *ci = constraint_islands[p_island_index];
 		while (ci) {
 			ci->solve(p_delta);
 			ci = ci->get_island_next();
@@ -217,44 +225,66 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 		profile_begtime = profile_endtime;
 	}
 
-	/* SETUP CONSTRAINT ISLANDS */
+	// Islands don't share any dynamic body, so their constraints can be set up and solved in parallel.
+	// Anything that depends on the order of the constraints is done serially in pre_solve, which keeps
+	// results independent from the thread count.
+
+	// the arrays are rebuilt every step from the frame arena, so stepping doesn't go through the heap
+	constraint_islands.clear();
+	all_constraints.clear();
+	constraint_setup_results.clear();
 
 	{
 		Constraint2DSW *ci = constraint_island_list;
-		Constraint2DSW *prev_ci = NULL;
 		while (ci) {
 
-			if (_setup_island(ci, p_delta) == true) {
+			constraint_islands.push_back(ci);
 
-				//removed the root from the island graph because it is not to be processed
+			Constraint2DSW *c = ci;
+			while (c) {
+				all_constraints.push_back(c);
+				c = c->get_island_next();
+			}
 
-				Constraint2DSW *next = ci->get_island_next();
+			ci = ci->get_island_list_next();
+		}
+	}
 
-				if (next) {
-					//root from list being deleted no longer exists, replace by next
-					next->set_island_list_next(ci->get_island_list_next());
-					if (prev_ci) {
-						prev_ci->set_island_list_next(next);
-					} else {
-						constraint_island_list = next;
-					}
-					prev_ci = next;
-				} else {
+	/* SETUP CONSTRAINTS / PROCESS COLLISIONS */
 
-					//list is empty, just skip
-					if (prev_ci) {
-						prev_ci->set_island_list_next(ci->get_island_list_next());
+	constraint_setup_results.resize(all_constraints.size());
 
-					} else {
-						constraint_island_list = ci->get_island_list_next();
-					}
-				}
-			} else {
-				prev_ci = ci;
+	if (use_threads) {
+		ThreadWorkPool::get_singleton()->do_work(all_constraints.size(), this, &Step2DSW::_setup_constraint, p_delta);
+	} else {
+		for (int i = 0; i < all_constraints.size(); i++) {
+			_setup_constraint(i, p_delta);
+		}
+	}
+
+	/* PRE-SOLVE CONSTRAINT ISLANDS */
+
+	{
+		// Not threaded, as it changes bodies and areas that may be shared between islands (contact reporting, area monitoring).
+		int first_constraint = 0;
+		int island_index = 0;
+		for (int i = 0; i < constraint_islands.size(); i++) {
+
+			Constraint2DSW *island = constraint_islands[i];
+			int island_size = 0;
+			for (Constraint2DSW *c = island; c; c = c->get_island_next()) {
+				island_size++;
 			}
 
-			ci = ci->get_island_list_next();
+			island = _pre_solve_island(island, first_constraint, p_delta);
+			first_constraint += island_size;
+
+			if (island) {
+				//keep only the islands that still have constraints to solve
+				constraint_islands[island_index++] = island;
+			}
 		}
+		constraint_islands.resize(island_index);
 	}
 
 	{ //profile
@@ -265,12 +295,13 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* SOLVE CONSTRAINT ISLANDS */
 
-	{
-		Constraint2DSW *ci = constraint_island_list;
-		while (ci) {
-			//iterating each island separatedly improves cache efficiency
-			_solve_island(ci, p_iterations, p_delta);
-			ci = ci->get_island_list_next();
+	//iterating each island separatedly improves cache efficiency
+	iterations = p_iterations;
+	if (use_threads) {
+		ThreadWorkPool::get_singleton()->do_work(constraint_islands.size(), this, &Step2DSW::_solve_island, p_delta, 1);
+	} else {
+		for (int i = 0; i < constraint_islands.size(); i++) {
+			_solve_island(i, p_delta);
 		}
 	}
 
@@ -315,4 +346,6 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 Step2DSW::Step2DSW() {
 
 	_step = 1;
+	iterations = 0;
+	use_threads = GLOBAL_DEF("physics/2d/multithreaded_step", false);
 }
@@ -31,15 +31,23 @@
 #ifndef STEP_2D_SW_H
 #define STEP_2D_SW_H
 
+#include "frame_arena.h"
 #include "space_2d_sw.h"
 
 class Step2DSW {
 
 	uint64_t _step;
 
+	bool use_threads;
+	int iterations;
+	FrameVector<Constraint2DSW *> constraint_islands;
+	FrameVector<Constraint2DSW *> all_constraints;
+	FrameVector<bool> constraint_setup_results;
+
 	void _populate_island(Body2DSW *p_body, Body2DSW **p_island, Constraint2DSW **p_constraint_island);
-	bool _setup_island(Constraint2DSW *p_island, real_t p_delta);
-	void _solve_island(Constraint2DSW *p_island, int p_iterations, real_t p_delta);
+	void _setup_constraint(uint32_t p_constraint_index, real_t p_delta);
+	Constraint2DSW *_pre_solve_island(Constraint2DSW *p_island, int p_first_constraint, real_t p_delta);
+	void _solve_island(uint32_t p_island_index, real_t p_delta);
 	void _check_suspend(Body2DSW *p_island, real_t p_delta);
 
 public:
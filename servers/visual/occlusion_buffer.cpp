@@ -0,0 +1,415 @@
+/*************************************************************************/
+/*  occlusion_buffer.cpp                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "occlusion_buffer.h"
+
+void OcclusionBuffer::set_size(int p_width, int p_height) {
+
+	ERR_FAIL_COND(p_width <= 0 || p_height <= 0);
+
+	if (width == p_width && height == p_height)
+		return;
+
+	width = p_width;
+	height = p_height;
+	tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+	tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+	depth.resize(width * height);
+	tile_max_depth.resize(tiles_x * tiles_y);
+	occluder_count = 0;
+}
+
+void OcclusionBuffer::begin(const CameraMatrix &p_projection, const Transform &p_cam_transform) {
+
+	view_projection = p_projection * CameraMatrix(p_cam_transform.affine_inverse());
+	occluder_count = 0;
+
+	float *d = depth.ptrw();
+	int size = depth.size();
+	for (int i = 0; i < size; i++) {
+		d[i] = 1.0;
+	}
+}
+
+// Whether the triangles form a flat convex quad, which is then rasterized as one polygon.
+// Otherwise the pixels along the edge they share wouldn't be entirely inside either of them.
+static bool _make_quad(const Vector3 *p_a, const Vector3 *p_b, Vector3 *r_quad) {
+
+	for (int i = 0; i < 3; i++) {
+
+		const Vector3 &p = p_a[i];
+		const Vector3 &q = p_a[(i + 1) % 3];
+
+		for (int j = 0; j < 3; j++) {
+
+			// same winding, so the shared edge goes the other way in the second triangle
+			if (p_b[j] != q || p_b[(j + 1) % 3] != p) {
+				continue;
+			}
+
+			r_quad[0] = p;
+			r_quad[1] = p_b[(j + 2) % 3];
+			r_quad[2] = q;
+			r_quad[3] = p_a[(i + 2) % 3];
+
+			Vector3 normal = (r_quad[1] - r_quad[0]).cross(r_quad[2] - r_quad[0]) + (r_quad[3] - r_quad[2]).cross(r_quad[0] - r_quad[2]);
+			real_t length = normal.length();
+			if (length < CMP_EPSILON) {
+				return false;
+			}
+			normal /= length;
+
+			real_t size = MAX((r_quad[2] - r_quad[0]).length(), (r_quad[3] - r_quad[1]).length());
+			if (Math::abs(normal.dot(r_quad[1] - r_quad[0])) > size * CMP_EPSILON) {
+				return false; // not flat
+			}
+
+			for (int k = 0; k < 4; k++) {
+				const Vector3 &v0 = r_quad[k];
+				const Vector3 &v1 = r_quad[(k + 1) % 4];
+				const Vector3 &v2 = r_quad[(k + 2) % 4];
+				if ((v1 - v0).cross(v2 - v1).dot(normal) < 0) {
+					return false; // not convex
+				}
+			}
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void OcclusionBuffer::add_occluder(const Transform &p_transform, const Vector3 *p_triangles, int p_vertex_count) {
+
+	ERR_FAIL_COND(width == 0);
+
+	CameraMatrix m = view_projection * CameraMatrix(p_transform);
+
+	for (int i = 0; i + 2 < p_vertex_count;) {
+
+		Vector3 quad[4];
+		const Vector3 *polygon = &p_triangles[i];
+		int count = 3;
+
+		if (i + 5 < p_vertex_count && _make_quad(&p_triangles[i], &p_triangles[i + 3], quad)) {
+			polygon = quad;
+			count = 4;
+			i += 6;
+		} else {
+			i += 3;
+		}
+
+		ClipVertex v[4];
+
+		for (int j = 0; j < count; j++) {
+
+			const Vector3 &p = polygon[j];
+			v[j].x = m.matrix[0][0] * p.x + m.matrix[1][0] * p.y + m.matrix[2][0] * p.z + m.matrix[3][0];
+			v[j].y = m.matrix[0][1] * p.x + m.matrix[1][1] * p.y + m.matrix[2][1] * p.z + m.matrix[3][1];
+			v[j].z = m.matrix[0][2] * p.x + m.matrix[1][2] * p.y + m.matrix[2][2] * p.z + m.matrix[3][2];
+			v[j].w = m.matrix[0][3] * p.x + m.matrix[1][3] * p.y + m.matrix[2][3] * p.z + m.matrix[3][3];
+		}
+
+		_clip_and_rasterize_polygon(v, count);
+	}
+
+	occluder_count++;
+}
+
+void OcclusionBuffer::_clip_and_rasterize_polygon(const ClipVertex *p_vertices, int p_count) {
+
+	// Only the near plane needs clipping, polygons going past the other planes are
+	// clamped to the screen when rasterized.
+
+	real_t dist[4];
+	int inside = 0;
+
+	for (int i = 0; i < p_count; i++) {
+		dist[i] = p_vertices[i].z + p_vertices[i].w;
+		if (dist[i] >= 0) {
+			inside++;
+		}
+	}
+
+	if (inside == 0)
+		return;
+
+	ScreenVertex screen[MAX_POLYGON_VERTICES];
+	int screen_count = 0;
+
+	for (int i = 0; i < p_count; i++) {
+
+		int n = (i + 1) % p_count;
+		const ClipVertex &a = p_vertices[i];
+		const ClipVertex &b = p_vertices[n];
+
+		if (dist[i] >= 0) {
+			screen[screen_count++] = _to_screen(a);
+		}
+
+		if ((dist[i] >= 0) != (dist[n] >= 0)) {
+
+			real_t t = dist[i] / (dist[i] - dist[n]);
+			ClipVertex c;
+			c.x = a.x + (b.x - a.x) * t;
+			c.y = a.y + (b.y - a.y) * t;
+			c.z = a.z + (b.z - a.z) * t;
+			c.w = a.w + (b.w - a.w) * t;
+			screen[screen_count++] = _to_screen(c);
+		}
+	}
+
+	// clipping a convex polygon by a plane keeps it convex
+	_rasterize_polygon(screen, screen_count);
+}
+
+void OcclusionBuffer::_rasterize_polygon(const ScreenVertex *p_vertices, int p_count) {
+
+	const ScreenVertex *v = p_vertices;
+
+	real_t area = 0;
+	for (int i = 0; i < p_count; i++) {
+		const ScreenVertex &n = v[(i + 1) % p_count];
+		area += v[i].x * n.y - n.x * v[i].y;
+	}
+
+	if (Math::abs(area) < CMP_EPSILON)
+		return;
+
+	real_t min_x = v[0].x, max_x = v[0].x;
+	real_t min_y = v[0].y, max_y = v[0].y;
+	for (int i = 1; i < p_count; i++) {
+		min_x = MIN(min_x, v[i].x);
+		max_x = MAX(max_x, v[i].x);
+		min_y = MIN(min_y, v[i].y);
+		max_y = MAX(max_y, v[i].y);
+	}
+
+	if (max_x < 0 || max_y < 0 || min_x >= width || min_y >= height)
+		return;
+
+	// clamp before converting, vertices close to the near plane can land very far away
+	int from_x = int(MAX(Math::floor(min_x), (real_t)0));
+	int to_x = int(MIN(Math::ceil(max_x), (real_t)(width - 1)));
+	int from_y = int(MAX(Math::floor(min_y), (real_t)0));
+	int to_y = int(MIN(Math::ceil(max_y), (real_t)(height - 1)));
+
+	// The depth plane, from the largest triangle of the polygon for precision.
+	int apex = 1;
+	real_t apex_area = 0;
+	for (int i = 1; i + 1 < p_count; i++) {
+		real_t a = (v[i].x - v[0].x) * (v[i + 1].y - v[0].y) - (v[i].y - v[0].y) * (v[i + 1].x - v[0].x);
+		if (Math::abs(a) > Math::abs(apex_area)) {
+			apex = i;
+			apex_area = a;
+		}
+	}
+
+	if (Math::abs(apex_area) < CMP_EPSILON)
+		return;
+
+	const ScreenVertex &a = v[0];
+	const ScreenVertex &b = v[apex];
+	const ScreenVertex &c = v[apex + 1];
+	real_t z_dx = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) / apex_area;
+	real_t z_dy = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) / apex_area;
+
+	// Edge functions, positive inside. Occluders are double sided, so they follow the winding.
+	real_t sign = area > 0 ? 1.0 : -1.0;
+	real_t e_dx[MAX_POLYGON_VERTICES];
+	real_t e_dy[MAX_POLYGON_VERTICES];
+	real_t e_offset[MAX_POLYGON_VERTICES];
+
+	for (int i = 0; i < p_count; i++) {
+		const ScreenVertex &n = v[(i + 1) % p_count];
+		e_dx[i] = (v[i].y - n.y) * sign;
+		e_dy[i] = (n.x - v[i].x) * sign;
+	}
+
+	// Coverage must be conservative, or objects peeking past the edges would be culled:
+	// a pixel is only written when its whole square is inside, so each edge function must
+	// clear the most it varies within half a pixel, and the depth written is the farthest
+	// one over the square instead of the one at its centre.
+	for (int i = 0; i < p_count; i++) {
+		e_offset[i] = (Math::abs(e_dx[i]) + Math::abs(e_dy[i])) * 0.5;
+	}
+	real_t z_offset = (Math::abs(z_dx) + Math::abs(z_dy)) * 0.5;
+
+	float *d = depth.ptrw();
+
+	for (int y = from_y; y <= to_y; y++) {
+
+		real_t px = from_x + 0.5;
+		real_t py = y + 0.5;
+
+		real_t e[MAX_POLYGON_VERTICES];
+		for (int i = 0; i < p_count; i++) {
+			e[i] = (px - v[i].x) * e_dx[i] + (py - v[i].y) * e_dy[i] - e_offset[i];
+		}
+		real_t z = a.z + (px - a.x) * z_dx + (py - a.y) * z_dy + z_offset;
+
+		float *row = &d[y * width];
+
+		for (int x = from_x; x <= to_x; x++) {
+
+			bool inside = true;
+			for (int i = 0; i < p_count; i++) {
+				inside = inside && e[i] >= 0;
+				e[i] += e_dx[i];
+			}
+
+			if (inside) {
+				float pz = MAX(z, 0);
+				if (pz < row[x]) {
+					row[x] = pz;
+				}
+			}
+
+			z += z_dx;
+		}
+	}
+}
+
+void OcclusionBuffer::end() {
+
+	const float *d = depth.ptr();
+	float *t = tile_max_depth.ptrw();
+
+	for (int ty = 0; ty < tiles_y; ty++) {
+
+		int to_y = MIN((ty + 1) * TILE_SIZE, height);
+
+		for (int tx = 0; tx < tiles_x; tx++) {
+
+			int from_x = tx * TILE_SIZE;
+			int to_x = MIN(from_x + TILE_SIZE, width);
+			float max_depth = 0;
+
+			for (int y = ty * TILE_SIZE; y < to_y; y++) {
+
+				const float *row = &d[y * width];
+
+				for (int x = from_x; x < to_x; x++) {
+					max_depth = MAX(max_depth, row[x]);
+				}
+			}
+
+			t[ty * tiles_x + tx] = max_depth;
+		}
+	}
+}
+
+bool OcclusionBuffer::is_occluded(const AABB &p_aabb) const {
+
+	if (occluder_count == 0)
+		return false;
+
+	real_t min_x = 1e20, max_x = -1e20;
+	real_t min_y = 1e20, max_y = -1e20;
+	real_t min_z = 1e20;
+
+	const CameraMatrix &m = view_projection;
+
+	for (int i = 0; i < 8; i++) {
+
+		Vector3 p = p_aabb.position;
+		if (i & 1)
+			p.x += p_aabb.size.x;
+		if (i & 2)
+			p.y += p_aabb.size.y;
+		if (i & 4)
+			p.z += p_aabb.size.z;
+
+		ClipVertex v;
+		v.x = m.matrix[0][0] * p.x + m.matrix[1][0] * p.y + m.matrix[2][0] * p.z + m.matrix[3][0];
+		v.y = m.matrix[0][1] * p.x + m.matrix[1][1] * p.y + m.matrix[2][1] * p.z + m.matrix[3][1];
+		v.z = m.matrix[0][2] * p.x + m.matrix[1][2] * p.y + m.matrix[2][2] * p.z + m.matrix[3][2];
+		v.w = m.matrix[0][3] * p.x + m.matrix[1][3] * p.y + m.matrix[2][3] * p.z + m.matrix[3][3];
+
+		if (v.z + v.w < 0 || v.w <= 0) {
+			return false; // crosses the near plane, assume visible
+		}
+
+		ScreenVertex s = _to_screen(v);
+		min_x = MIN(min_x, s.x);
+		max_x = MAX(max_x, s.x);
+		min_y = MIN(min_y, s.y);
+		max_y = MAX(max_y, s.y);
+		min_z = MIN(min_z, s.z);
+	}
+
+	if (max_x < 0 || max_y < 0 || min_x >= width || min_y >= height)
+		return false;
+
+	int from_x = int(MAX(Math::floor(min_x), (real_t)0));
+	int to_x = int(MIN(Math::floor(max_x), (real_t)(width - 1)));
+	int from_y = int(MAX(Math::floor(min_y), (real_t)0));
+	int to_y = int(MIN(Math::floor(max_y), (real_t)(height - 1)));
+
+	const float *d = depth.ptr();
+	const float *t = tile_max_depth.ptr();
+
+	for (int ty = from_y / TILE_SIZE; ty <= to_y / TILE_SIZE; ty++) {
+
+		for (int tx = from_x / TILE_SIZE; tx <= to_x / TILE_SIZE; tx++) {
+
+			if (t[ty * tiles_x + tx] < min_z)
+				continue; // everything in this tile is in front of the box
+
+			int tile_from_y = MAX(from_y, ty * TILE_SIZE);
+			int tile_to_y = MIN(to_y, ty * TILE_SIZE + TILE_SIZE - 1);
+			int tile_from_x = MAX(from_x, tx * TILE_SIZE);
+			int tile_to_x = MIN(to_x, tx * TILE_SIZE + TILE_SIZE - 1);
+
+			for (int y = tile_from_y; y <= tile_to_y; y++) {
+
+				const float *row = &d[y * width];
+
+				for (int x = tile_from_x; x <= tile_to_x; x++) {
+					if (row[x] >= min_z)
+						return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+OcclusionBuffer::OcclusionBuffer() {
+
+	width = 0;
+	height = 0;
+	tiles_x = 0;
+	tiles_y = 0;
+	occluder_count = 0;
+}
@@ -0,0 +1,108 @@
+/*************************************************************************/
+/*  occlusion_buffer.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2018 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2018 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef OCCLUSION_BUFFER_H
+#define OCCLUSION_BUFFER_H
+
+#include "camera_matrix.h"
+#include "vector.h"
+
+/**
+ * Low resolution depth buffer where occluder triangles are rasterized in software,
+ * used to discard instances hidden behind them before they are sent to the renderer.
+ *
+ * Depth is stored normalized (0 near, 1 far) and the farthest depth of each tile is
+ * kept, so most tests are answered from the tiles without looking at the pixels.
+ *
+ * Rasterization is conservative: a pixel is only written when it's entirely inside an
+ * occluder polygon, with the farthest depth of the polygon over it. Triangle pairs forming
+ * flat convex quads are drawn as one polygon, so quads don't lose the pixels along their
+ * diagonal, other shared edges still leave a line of pixels uncovered.
+ */
+
+class OcclusionBuffer {
+
+public:
+	enum {
+		TILE_SIZE = 8,
+		MAX_POLYGON_VERTICES = 5, // a quad clipped by the near plane
+	};
+
+private:
+	int width;
+	int height;
+	int tiles_x;
+	int tiles_y;
+
+	Vector<float> depth;
+	Vector<float> tile_max_depth;
+
+	CameraMatrix view_projection;
+	int occluder_count;
+
+	struct ClipVertex {
+		real_t x, y, z, w;
+	};
+
+	struct ScreenVertex {
+		real_t x, y, z;
+	};
+
+	_FORCE_INLINE_ ScreenVertex _to_screen(const ClipVertex &p_vertex) const {
+
+		ScreenVertex v;
+		real_t inv_w = 1.0 / p_vertex.w;
+		v.x = (p_vertex.x * inv_w * 0.5 + 0.5) * width;
+		v.y = (0.5 - p_vertex.y * inv_w * 0.5) * height;
+		v.z = p_vertex.z * inv_w * 0.5 + 0.5;
+		return v;
+	}
+
+	void _rasterize_polygon(const ScreenVertex *p_vertices, int p_count);
+	void _clip_and_rasterize_polygon(const ClipVertex *p_vertices, int p_count);
+
+public:
+	void set_size(int p_width, int p_height);
+	int get_width() const { return width; }
+	int get_height() const { return height; }
+
+	void begin(const CameraMatrix &p_projection, const Transform &p_cam_transform);
+	void add_occluder(const Transform &p_transform, const Vector3 *p_triangles, int p_vertex_count);
+	void end();
+
+	int get_occluder_count() const { return occluder_count; }
+
+	// read only, can be called from several threads once end() was called
+	bool is_occluded(const AABB &p_aabb) const;
+
+	OcclusionBuffer();
+};
+
+#endif // OCCLUSION_BUFFER_H
@@ -29,6 +29,7 @@
 /*************************************************************************/
 
 #include "visual_server_canvas.h"
+#include "frame_arena.h"
 #include "visual_server_global.h"
 #include "visual_server_viewport.h"
 
@@ -81,7 +82,8 @@ void VisualServerCanvas::_render_canvas_item(Item *p_canvas_item, const Transfor
 		return;
 
 	int child_item_count = ci->child_items.size();
-	Item **child_items = (Item **)alloca(child_item_count * sizeof(Item *));
+	// not on the stack, items can have too many children for it
+	Item **child_items = (Item **)FrameArena::alloc(child_item_count * sizeof(Item *));
 	copymem(child_items, ci->child_items.ptr(), child_item_count * sizeof(Item *));
 
 	if (ci->clip) {
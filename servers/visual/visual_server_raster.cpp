@@ -106,6 +106,7 @@ void VisualServerRaster::draw(bool p_swap_buffers, double frame_step) {
 
 	VSG::viewport->draw_viewports();
 	VSG::scene->render_probes();
+	VSG::scene->update_render_info();
 	_draw_margins();
 	VSG::rasterizer->end_frame(p_swap_buffers);
 
@@ -150,6 +151,12 @@ void VisualServerRaster::finish() {
 
 int VisualServerRaster::get_render_info(RenderInfo p_info) {
 
+	switch (p_info) {
+		case INFO_OCCLUDERS_IN_FRAME:
+		case INFO_OCCLUDED_OBJECTS_IN_FRAME: return VSG::scene->get_render_info(p_info);
+		default: {}
+	}
+
 	return VSG::storage->get_render_info(p_info);
 }
 
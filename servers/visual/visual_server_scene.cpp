@@ -30,6 +30,9 @@
 
 #include "visual_server_scene.h"
 #include "os/os.h"
+#include "os/thread_work_pool.h"
+#include "project_settings.h"
+#include "safe_refcount.h"
 #include "visual_server_global.h"
 #include "visual_server_raster.h"
 /* CAMERA API */
@@ -91,7 +94,7 @@ void VisualServerScene::camera_set_use_vertical_aspect(RID p_camera, bool p_enab
 
 /* SCENARIO API */
 
-void *VisualServerScene::_instance_pair(void *p_self, OctreeElementID, Instance *p_A, int, OctreeElementID, Instance *p_B, int) {
+void *VisualServerScene::_instance_pair(void *p_self, BVHElementID, Instance *p_A, int, BVHElementID, Instance *p_B, int) {
 
 	//VisualServerScene *self = (VisualServerScene*)p_self;
 	Instance *A = p_A;
@@ -170,7 +173,7 @@ void *VisualServerScene::_instance_pair(void *p_self, OctreeElementID, Instance
 
 	return NULL;
 }
-void VisualServerScene::_instance_unpair(void *p_self, OctreeElementID, Instance *p_A, int, OctreeElementID, Instance *p_B, int, void *udata) {
+void VisualServerScene::_instance_unpair(void *p_self, BVHElementID, Instance *p_A, int, BVHElementID, Instance *p_B, int, void *udata) {
 
 	//VisualServerScene *self = (VisualServerScene*)p_self;
 	Instance *A = p_A;
@@ -246,8 +249,8 @@ RID VisualServerScene::scenario_create() {
 	RID scenario_rid = scenario_owner.make_rid(scenario);
 	scenario->self = scenario_rid;
 
-	scenario->octree.set_pair_callback(_instance_pair, this);
-	scenario->octree.set_unpair_callback(_instance_unpair, this);
+	scenario->bvh.set_pair_callback(_instance_pair, this);
+	scenario->bvh.set_unpair_callback(_instance_unpair, this);
 	scenario->reflection_probe_shadow_atlas = VSG::scene_render->shadow_atlas_create();
 	VSG::scene_render->shadow_atlas_set_size(scenario->reflection_probe_shadow_atlas, 1024); //make enough shadows for close distance, don't bother with rest
 	VSG::scene_render->shadow_atlas_set_quadrant_subdivision(scenario->reflection_probe_shadow_atlas, 0, 4);
@@ -329,7 +332,7 @@ void VisualServerScene::instance_set_base(RID p_instance, RID p_base) {
 
 		if (instance->base_type == VS::INSTANCE_GI_PROBE) {
 			//if gi probe is baking, wait until done baking, else race condition may happen when removing it
-			//from octree
+			//from bvh
 			InstanceGIProbeData *gi_probe = static_cast<InstanceGIProbeData *>(instance->base_data);
 
 			//make sure probes are done baking
@@ -344,9 +347,9 @@ void VisualServerScene::instance_set_base(RID p_instance, RID p_base) {
 			}
 		}
 
-		if (scenario && instance->octree_id) {
-			scenario->octree.erase(instance->octree_id); //make dependencies generated by the octree go away
-			instance->octree_id = 0;
+		if (scenario && instance->bvh_id) {
+			scenario->bvh.erase(instance->bvh_id); //make dependencies generated by the bvh go away
+			instance->bvh_id = 0;
 		}
 
 		switch (instance->base_type) {
@@ -490,9 +493,9 @@ void VisualServerScene::instance_set_scenario(RID p_instance, RID p_scenario) {
 
 		instance->scenario->instances.remove(&instance->scenario_item);
 
-		if (instance->octree_id) {
-			instance->scenario->octree.erase(instance->octree_id); //make dependencies generated by the octree go away
-			instance->octree_id = 0;
+		if (instance->bvh_id) {
+			instance->scenario->bvh.erase(instance->bvh_id); //make dependencies generated by the bvh go away
+			instance->bvh_id = 0;
 		}
 
 		switch (instance->base_type) {
@@ -626,26 +629,26 @@ void VisualServerScene::instance_set_visible(RID p_instance, bool p_visible) {
 
 	switch (instance->base_type) {
 		case VS::INSTANCE_LIGHT: {
-			if (VSG::storage->light_get_type(instance->base) != VS::LIGHT_DIRECTIONAL && instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << VS::INSTANCE_LIGHT, p_visible ? VS::INSTANCE_GEOMETRY_MASK : 0);
+			if (VSG::storage->light_get_type(instance->base) != VS::LIGHT_DIRECTIONAL && instance->bvh_id && instance->scenario) {
+				instance->scenario->bvh.set_pairable(instance->bvh_id, p_visible, 1 << VS::INSTANCE_LIGHT, p_visible ? VS::INSTANCE_GEOMETRY_MASK : 0);
 			}
 
 		} break;
 		case VS::INSTANCE_REFLECTION_PROBE: {
-			if (instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << VS::INSTANCE_REFLECTION_PROBE, p_visible ? VS::INSTANCE_GEOMETRY_MASK : 0);
+			if (instance->bvh_id && instance->scenario) {
+				instance->scenario->bvh.set_pairable(instance->bvh_id, p_visible, 1 << VS::INSTANCE_REFLECTION_PROBE, p_visible ? VS::INSTANCE_GEOMETRY_MASK : 0);
 			}
 
 		} break;
 		case VS::INSTANCE_LIGHTMAP_CAPTURE: {
-			if (instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << VS::INSTANCE_LIGHTMAP_CAPTURE, p_visible ? VS::INSTANCE_GEOMETRY_MASK : 0);
+			if (instance->bvh_id && instance->scenario) {
+				instance->scenario->bvh.set_pairable(instance->bvh_id, p_visible, 1 << VS::INSTANCE_LIGHTMAP_CAPTURE, p_visible ? VS::INSTANCE_GEOMETRY_MASK : 0);
 			}
 
 		} break;
 		case VS::INSTANCE_GI_PROBE: {
-			if (instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << VS::INSTANCE_GI_PROBE, p_visible ? (VS::INSTANCE_GEOMETRY_MASK | (1 << VS::INSTANCE_LIGHT)) : 0);
+			if (instance->bvh_id && instance->scenario) {
+				instance->scenario->bvh.set_pairable(instance->bvh_id, p_visible, 1 << VS::INSTANCE_GI_PROBE, p_visible ? (VS::INSTANCE_GEOMETRY_MASK | (1 << VS::INSTANCE_LIGHT)) : 0);
 			}
 
 		} break;
@@ -747,7 +750,7 @@ Vector<ObjectID> VisualServerScene::instances_cull_aabb(const AABB &p_aabb, RID
 
 	int culled = 0;
 	Instance *cull[1024];
-	culled = scenario->octree.cull_aabb(p_aabb, cull, 1024);
+	culled = scenario->bvh.cull_aabb(p_aabb, cull, 1024);
 
 	for (int i = 0; i < culled; i++) {
 
@@ -770,7 +773,7 @@ Vector<ObjectID> VisualServerScene::instances_cull_ray(const Vector3 &p_from, co
 
 	int culled = 0;
 	Instance *cull[1024];
-	culled = scenario->octree.cull_segment(p_from, p_from + p_to * 10000, cull, 1024);
+	culled = scenario->bvh.cull_segment(p_from, p_from + p_to * 10000, cull, 1024);
 
 	for (int i = 0; i < culled; i++) {
 		Instance *instance = cull[i];
@@ -793,7 +796,7 @@ Vector<ObjectID> VisualServerScene::instances_cull_convex(const Vector<Plane> &p
 	int culled = 0;
 	Instance *cull[1024];
 
-	culled = scenario->octree.cull_convex(p_convex, cull, 1024);
+	culled = scenario->bvh.cull_convex(p_convex, cull, 1024);
 
 	for (int i = 0; i < culled; i++) {
 
@@ -825,6 +828,12 @@ void VisualServerScene::instance_geometry_set_flag(RID p_instance, VS::InstanceF
 			instance->redraw_if_visible = p_enabled;
 
 		} break;
+		case VS::INSTANCE_FLAG_OCCLUDER: {
+
+			instance->occluder = p_enabled;
+			_instance_queue_update(instance, false, true); // fetch or release the occluder faces
+
+		} break;
 	}
 }
 void VisualServerScene::instance_geometry_set_cast_shadows_setting(RID p_instance, VS::ShadowCastingSetting p_shadow_casting_setting) {
@@ -920,7 +929,7 @@ void VisualServerScene::_update_instance(Instance *p_instance) {
 		return;
 	}
 
-	if (p_instance->octree_id == 0) {
+	if (p_instance->bvh_id == 0) {
 
 		uint32_t base_type = 1 << p_instance->base_type;
 		uint32_t pairable_mask = 0;
@@ -938,8 +947,8 @@ void VisualServerScene::_update_instance(Instance *p_instance) {
 			pairable = true;
 		}
 
-		// not inside octree
-		p_instance->octree_id = p_instance->scenario->octree.create(p_instance, new_aabb, 0, pairable, base_type, pairable_mask);
+		// not inside bvh
+		p_instance->bvh_id = p_instance->scenario->bvh.create(p_instance, new_aabb, 0, pairable, base_type, pairable_mask);
 
 	} else {
 
@@ -948,7 +957,7 @@ void VisualServerScene::_update_instance(Instance *p_instance) {
 			return;
 		*/
 
-		p_instance->scenario->octree.move(p_instance->octree_id, new_aabb);
+		p_instance->scenario->bvh.move(p_instance->bvh_id, new_aabb);
 	}
 }
 
@@ -1258,7 +1267,71 @@ void VisualServerScene::_update_instance_lightmap_captures(Instance *p_instance)
 	}
 }
 
-void VisualServerScene::_light_instance_update_shadow(Instance *p_instance, const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_shadow_atlas, Scenario *p_scenario) {
+int VisualServerScene::_cull_convex(Scenario *p_scenario, const Plane *p_planes, int p_plane_count, LocalVector<Instance *> &r_result, uint32_t p_mask) {
+
+	if (r_result.size() == 0) {
+		r_result.resize(INSTANCE_CULL_MIN);
+	}
+
+	while (true) {
+
+		// culling doesn't modify the bvh, so it can be done from several threads
+		int cull_count = p_scenario->bvh.cull_convex(p_planes, p_plane_count, r_result.ptr(), r_result.size(), p_mask);
+
+		if (cull_count < r_result.size())
+			return cull_count;
+
+		// buffer was filled up, grow it and cull again (the buffer is kept for the next frames)
+		r_result.resize(r_result.size() * 2);
+	}
+}
+
+int VisualServerScene::_cull_shadow_casters(Scenario *p_scenario, const Plane *p_planes, int p_plane_count, LocalVector<Instance *> &r_casters) {
+
+	int cull_count = _cull_convex(p_scenario, p_planes, p_plane_count, r_casters, VS::INSTANCE_GEOMETRY_MASK);
+
+	Instance **casters = r_casters.ptr();
+	int caster_count = 0;
+
+	for (int i = 0; i < cull_count; i++) {
+
+		Instance *instance = casters[i];
+		if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
+			continue;
+		}
+
+		casters[caster_count++] = instance;
+	}
+
+	return caster_count;
+}
+
+void VisualServerScene::_add_shadow_cull_job(Instance *p_instance, const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, Scenario *p_scenario) {
+
+	if (shadow_cull_job_count == shadow_cull_jobs.size()) {
+		shadow_cull_jobs.resize(shadow_cull_job_count + 1);
+	}
+
+	ShadowCullJob &job = shadow_cull_jobs[shadow_cull_job_count++];
+	job.light = p_instance;
+	job.scenario = p_scenario;
+	job.cam_transform = p_cam_transform;
+	job.cam_projection = p_cam_projection;
+	job.cam_orthogonal = p_cam_orthogonal;
+	job.pass_count = 0;
+	job.restore_transform = false;
+}
+
+void VisualServerScene::_light_instance_cull_shadow(uint32_t p_index, ShadowCullJob *p_jobs) {
+
+	// Runs in a worker thread, only fills the job so the shadows can be rendered later from the render thread.
+
+	ShadowCullJob &job = p_jobs[p_index];
+	Instance *p_instance = job.light;
+	Scenario *p_scenario = job.scenario;
+	const Transform &p_cam_transform = job.cam_transform;
+	const CameraMatrix &p_cam_projection = job.cam_projection;
+	bool p_cam_orthogonal = job.cam_orthogonal;
 
 	InstanceLightData *light = static_cast<InstanceLightData *>(p_instance->base_data);
 
@@ -1281,8 +1354,11 @@ void VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 
 			if (depth_range_mode == VS::LIGHT_DIRECTIONAL_SHADOW_DEPTH_RANGE_OPTIMIZED) {
 				//optimize min/max
-				Vector<Plane> planes = p_cam_projection.get_projection_planes(p_cam_transform);
-				int cull_count = p_scenario->octree.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
+				Plane planes[6];
+				p_cam_projection.get_projection_planes(p_cam_transform, planes);
+				// the first pass buffer is free until the splits are culled
+				int cull_count = _cull_shadow_casters(p_scenario, planes, 6, job.passes[0].casters);
+				Instance **casters = job.passes[0].casters.ptr();
 				Plane base(p_cam_transform.origin, -p_cam_transform.basis.get_axis(2));
 				//check distance max and min
 
@@ -1292,10 +1368,7 @@ void VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 
 				for (int i = 0; i < cull_count; i++) {
 
-					Instance *instance = instance_shadow_cull_result[i];
-					if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-						continue;
-					}
+					Instance *instance = casters[i];
 
 					float max, min;
 					instance->transformed_aabb.project_range_in_plane(base, min, max);
@@ -1341,8 +1414,13 @@ void VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 
 			float first_radius = 0.0;
 
+			job.pass_count = splits;
+
 			for (int i = 0; i < splits; i++) {
 
+				ShadowCullPass &pass = job.passes[i];
+				pass.skip = true;
+
 				// setup a camera matrix for that range!
 				CameraMatrix camera_matrix;
 
@@ -1458,41 +1536,31 @@ void VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 					}
 				}
 
-				//now that we now all ranges, we can proceed to make the light frustum planes, for culling octree
+				//now that we now all ranges, we can proceed to make the light frustum planes, for culling the bvh
 
-				Vector<Plane> light_frustum_planes;
-				light_frustum_planes.resize(6);
+				Plane light_frustum_planes[6];
 
 				//right/left
-				light_frustum_planes.write[0] = Plane(x_vec, x_max);
-				light_frustum_planes.write[1] = Plane(-x_vec, -x_min);
+				light_frustum_planes[0] = Plane(x_vec, x_max);
+				light_frustum_planes[1] = Plane(-x_vec, -x_min);
 				//top/bottom
-				light_frustum_planes.write[2] = Plane(y_vec, y_max);
-				light_frustum_planes.write[3] = Plane(-y_vec, -y_min);
+				light_frustum_planes[2] = Plane(y_vec, y_max);
+				light_frustum_planes[3] = Plane(-y_vec, -y_min);
 				//near/far
-				light_frustum_planes.write[4] = Plane(z_vec, z_max + 1e6);
-				light_frustum_planes.write[5] = Plane(-z_vec, -z_min); // z_min is ok, since casters further than far-light plane are not needed
+				light_frustum_planes[4] = Plane(z_vec, z_max + 1e6);
+				light_frustum_planes[5] = Plane(-z_vec, -z_min); // z_min is ok, since casters further than far-light plane are not needed
 
-				int cull_count = p_scenario->octree.cull_convex(light_frustum_planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
+				pass.caster_count = _cull_shadow_casters(p_scenario, light_frustum_planes, 6, pass.casters);
+				pass.near_plane = Plane(light_transform.origin, -light_transform.basis.get_axis(2));
 
 				// a pre pass will need to be needed to determine the actual z-near to be used
 
-				Plane near_plane(light_transform.origin, -light_transform.basis.get_axis(2));
+				Instance **casters = pass.casters.ptr();
 
-				for (int j = 0; j < cull_count; j++) {
+				for (int j = 0; j < pass.caster_count; j++) {
 
 					float min, max;
-					Instance *instance = instance_shadow_cull_result[j];
-					if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-						cull_count--;
-						SWAP(instance_shadow_cull_result[j], instance_shadow_cull_result[cull_count]);
-						j--;
-						continue;
-					}
-
-					instance->transformed_aabb.project_range_in_plane(Plane(z_vec, 0), min, max);
-					instance->depth = near_plane.distance_to(instance->transform.origin);
-					instance->depth_layer = 0;
+					casters[j]->transformed_aabb.project_range_in_plane(Plane(z_vec, 0), min, max);
 					if (max > z_max)
 						z_max = max;
 				}
@@ -1509,10 +1577,14 @@ void VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 					ortho_transform.basis = transform.basis;
 					ortho_transform.origin = x_vec * (x_min_cam + half_x) + y_vec * (y_min_cam + half_y) + z_vec * z_max;
 
-					VSG::scene_render->light_instance_set_shadow_transform(light->instance, ortho_camera, ortho_transform, 0, distances[i + 1], i, bias_scale);
+					pass.projection = ortho_camera;
+					pass.transform = ortho_transform;
+					pass.far = 0;
+					pass.split = distances[i + 1];
+					pass.bias_scale = bias_scale;
 				}
 
-				VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)instance_shadow_cull_result, cull_count);
+				pass.skip = false;
 			}
 
 		} break;
@@ -1523,6 +1595,8 @@ void VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 			switch (shadow_mode) {
 				case VS::LIGHT_OMNI_SHADOW_DUAL_PARABOLOID: {
 
+					job.pass_count = 2;
+
 					for (int i = 0; i < 2; i++) {
 
 						//using this one ensures that raster deferred will have it
@@ -1530,32 +1604,22 @@ void VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 						float radius = VSG::storage->light_get_param(p_instance->base, VS::LIGHT_PARAM_RANGE);
 
 						float z = i == 0 ? -1 : 1;
-						Vector<Plane> planes;
-						planes.resize(5);
-						planes.write[0] = light_transform.xform(Plane(Vector3(0, 0, z), radius));
-						planes.write[1] = light_transform.xform(Plane(Vector3(1, 0, z).normalized(), radius));
-						planes.write[2] = light_transform.xform(Plane(Vector3(-1, 0, z).normalized(), radius));
-						planes.write[3] = light_transform.xform(Plane(Vector3(0, 1, z).normalized(), radius));
-						planes.write[4] = light_transform.xform(Plane(Vector3(0, -1, z).normalized(), radius));
-
-						int cull_count = p_scenario->octree.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
-						Plane near_plane(light_transform.origin, light_transform.basis.get_axis(2) * z);
-
-						for (int j = 0; j < cull_count; j++) {
-
-							Instance *instance = instance_shadow_cull_result[j];
-							if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-								cull_count--;
-								SWAP(instance_shadow_cull_result[j], instance_shadow_cull_result[cull_count]);
-								j--;
-							} else {
-								instance->depth = near_plane.distance_to(instance->transform.origin);
-								instance->depth_layer = 0;
-							}
-						}
-
-						VSG::scene_render->light_instance_set_shadow_transform(light->instance, CameraMatrix(), light_transform, radius, 0, i);
-						VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)instance_shadow_cull_result, cull_count);
+						Plane planes[5];
+						planes[0] = light_transform.xform(Plane(Vector3(0, 0, z), radius));
+						planes[1] = light_transform.xform(Plane(Vector3(1, 0, z).normalized(), radius));
+						planes[2] = light_transform.xform(Plane(Vector3(-1, 0, z).normalized(), radius));
+						planes[3] = light_transform.xform(Plane(Vector3(0, 1, z).normalized(), radius));
+						planes[4] = light_transform.xform(Plane(Vector3(0, -1, z).normalized(), radius));
+
+						ShadowCullPass &pass = job.passes[i];
+						pass.caster_count = _cull_shadow_casters(p_scenario, planes, 5, pass.casters);
+						pass.near_plane = Plane(light_transform.origin, light_transform.basis.get_axis(2) * z);
+						pass.projection = CameraMatrix();
+						pass.transform = light_transform;
+						pass.far = radius;
+						pass.split = 0;
+						pass.bias_scale = 1.0;
+						pass.skip = false;
 					}
 				} break;
 				case VS::LIGHT_OMNI_SHADOW_CUBE: {
@@ -1564,6 +1628,8 @@ void VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 					CameraMatrix cm;
 					cm.set_perspective(90, 1, 0.01, radius);
 
+					job.pass_count = 6;
+
 					for (int i = 0; i < 6; i++) {
 
 						//using this one ensures that raster deferred will have it
@@ -1587,30 +1653,24 @@ void VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 
 						Transform xform = light_transform * Transform().looking_at(view_normals[i], view_up[i]);
 
-						Vector<Plane> planes = cm.get_projection_planes(xform);
-
-						int cull_count = p_scenario->octree.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
-
-						Plane near_plane(xform.origin, -xform.basis.get_axis(2));
-						for (int j = 0; j < cull_count; j++) {
-
-							Instance *instance = instance_shadow_cull_result[j];
-							if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-								cull_count--;
-								SWAP(instance_shadow_cull_result[j], instance_shadow_cull_result[cull_count]);
-								j--;
-							} else {
-								instance->depth = near_plane.distance_to(instance->transform.origin);
-								instance->depth_layer = 0;
-							}
-						}
-
-						VSG::scene_render->light_instance_set_shadow_transform(light->instance, cm, xform, radius, 0, i);
-						VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)instance_shadow_cull_result, cull_count);
+						Plane planes[6];
+						cm.get_projection_planes(xform, planes);
+
+						ShadowCullPass &pass = job.passes[i];
+						pass.caster_count = _cull_shadow_casters(p_scenario, planes, 6, pass.casters);
+						pass.near_plane = Plane(xform.origin, -xform.basis.get_axis(2));
+						pass.projection = cm;
+						pass.transform = xform;
+						pass.far = radius;
+						pass.split = 0;
+						pass.bias_scale = 1.0;
+						pass.skip = false;
 					}
 
 					//restore the regular DP matrix
-					VSG::scene_render->light_instance_set_shadow_transform(light->instance, CameraMatrix(), light_transform, radius, 0, 0);
+					job.restore_transform = true;
+					job.light_transform = light_transform;
+					job.radius = radius;
 
 				} break;
 			}
@@ -1624,30 +1684,51 @@ void VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 			CameraMatrix cm;
 			cm.set_perspective(angle * 2.0, 1.0, 0.01, radius);
 
-			Vector<Plane> planes = cm.get_projection_planes(light_transform);
-			int cull_count = p_scenario->octree.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
+			Plane planes[6];
+			cm.get_projection_planes(light_transform, planes);
 
-			Plane near_plane(light_transform.origin, -light_transform.basis.get_axis(2));
-			for (int j = 0; j < cull_count; j++) {
+			job.pass_count = 1;
 
-				Instance *instance = instance_shadow_cull_result[j];
-				if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-					cull_count--;
-					SWAP(instance_shadow_cull_result[j], instance_shadow_cull_result[cull_count]);
-					j--;
-				} else {
-					instance->depth = near_plane.distance_to(instance->transform.origin);
-					instance->depth_layer = 0;
-				}
-			}
-
-			VSG::scene_render->light_instance_set_shadow_transform(light->instance, cm, light_transform, radius, 0, 0);
-			VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, 0, (RasterizerScene::InstanceBase **)instance_shadow_cull_result, cull_count);
+			ShadowCullPass &pass = job.passes[0];
+			pass.caster_count = _cull_shadow_casters(p_scenario, planes, 6, pass.casters);
+			pass.near_plane = Plane(light_transform.origin, -light_transform.basis.get_axis(2));
+			pass.projection = cm;
+			pass.transform = light_transform;
+			pass.far = radius;
+			pass.split = 0;
+			pass.bias_scale = 1.0;
+			pass.skip = false;
 
 		} break;
 	}
 }
 
+void VisualServerScene::_light_instance_render_shadow(ShadowCullJob &p_job, RID p_shadow_atlas) {
+
+	InstanceLightData *light = static_cast<InstanceLightData *>(p_job.light->base_data);
+
+	for (int i = 0; i < p_job.pass_count; i++) {
+
+		ShadowCullPass &pass = p_job.passes[i];
+		if (pass.skip)
+			continue;
+
+		// depth is shared by all the passes an instance is rendered in, so it's only set right before rendering
+		Instance **casters = pass.casters.ptr();
+		for (int j = 0; j < pass.caster_count; j++) {
+			casters[j]->depth = pass.near_plane.distance_to(casters[j]->transform.origin);
+			casters[j]->depth_layer = 0;
+		}
+
+		VSG::scene_render->light_instance_set_shadow_transform(light->instance, pass.projection, pass.transform, pass.far, pass.split, i, pass.bias_scale);
+		VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)casters, pass.caster_count);
+	}
+
+	if (p_job.restore_transform) {
+		VSG::scene_render->light_instance_set_shadow_transform(light->instance, CameraMatrix(), p_job.light_transform, p_job.radius, 0, 0);
+	}
+}
+
 void VisualServerScene::render_camera(RID p_camera, RID p_scenario, Size2 p_viewport_size, RID p_shadow_atlas) {
 // render to mono camera
 #ifndef _3D_DISABLED
@@ -1786,13 +1867,14 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 
 	//rasterizer->set_camera(camera->transform, camera_matrix,ortho);
 
-	Vector<Plane> planes = p_cam_projection.get_projection_planes(p_cam_transform);
+	Plane planes[6];
+	p_cam_projection.get_projection_planes(p_cam_transform, planes);
 
 	Plane near_plane(p_cam_transform.origin, -p_cam_transform.basis.get_axis(2).normalized());
 	float z_far = p_cam_projection.get_z_far();
 
 	/* STEP 2 - CULL */
-	instance_cull_count = scenario->octree.cull_convex(planes, instance_cull_result, MAX_INSTANCE_CULL);
+	instance_cull_count = _cull_convex(scenario, planes, 6, instance_cull_result);
 	light_cull_count = 0;
 
 	reflection_probe_cull_count = 0;
@@ -1810,23 +1892,62 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 
 	/* STEP 4 - REMOVE FURTHER CULLED OBJECTS, ADD LIGHTS */
 
+	// Geometry only touches its own instance, so it's prepared in parallel. Kept instances are marked with the current render pass.
+	GeometryCullData geometry_cull_data;
+	geometry_cull_data.visible_layers = camera_layer_mask;
+	geometry_cull_data.near_plane = near_plane;
+	geometry_cull_data.z_far = z_far;
+	geometry_cull_data.occlusion_buffer = NULL;
+	geometry_cull_data.occluded_count = 0;
+
+	if (occlusion_culling_enabled && _rasterize_occluders(p_cam_transform, p_cam_projection, camera_layer_mask)) {
+		geometry_cull_data.occlusion_buffer = &occlusion_buffer;
+	}
+
+	ThreadWorkPool::get_singleton()->do_work(instance_cull_count, this, &VisualServerScene::_prepare_culled_geometry, &geometry_cull_data);
+
+	occlusion_info.occluded_objects += geometry_cull_data.occluded_count;
+
+	Instance **cull_result = instance_cull_result.ptr();
+
 	for (int i = 0; i < instance_cull_count; i++) {
 
-		Instance *ins = instance_cull_result[i];
+		Instance *ins = cull_result[i];
 
-		bool keep = false;
+		if (ins->last_render_pass == render_pass) {
+
+			// kept geometry, request what can't be done from the worker threads
+			if (ins->redraw_if_visible) {
+				VisualServerRaster::redraw_request();
+			}
+
+			if (ins->base_type == VS::INSTANCE_PARTICLES) {
+				//particles visible? process them
+				VSG::storage->particles_request_process(ins->base);
+				//particles visible? request redraw
+				VisualServerRaster::redraw_request();
+			}
+
+			continue;
+		}
 
 		if ((camera_layer_mask & ins->layer_mask) == 0) {
 
 			//failure
 		} else if (ins->base_type == VS::INSTANCE_LIGHT && ins->visible) {
 
-			if (ins->visible && light_cull_count < MAX_LIGHTS_CULLED) {
+			if (ins->visible) {
 
 				InstanceLightData *light = static_cast<InstanceLightData *>(ins->base_data);
 
 				if (!light->geometries.empty()) {
 					//do not add this light if no geometry is affected by it..
+					if (light_cull_count == light_cull_result.size()) {
+						light_cull_result.resize(MAX(light_cull_count * 2, int(LIGHTS_CULLED_MIN)));
+					}
+					if (light_cull_count == light_instance_cull_result.size()) {
+						light_instance_cull_result.resize(MAX(light_cull_count * 2, int(LIGHTS_CULLED_MIN)));
+					}
 					light_cull_result[light_cull_count] = ins;
 					light_instance_cull_result[light_cull_count] = light->instance;
 					if (p_shadow_atlas.is_valid() && VSG::storage->light_has_shadow(ins->base)) {
@@ -1838,7 +1959,7 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 			}
 		} else if (ins->base_type == VS::INSTANCE_REFLECTION_PROBE && ins->visible) {
 
-			if (ins->visible && reflection_probe_cull_count < MAX_REFLECTION_PROBES_CULLED) {
+			if (ins->visible) {
 
 				InstanceReflectionProbeData *reflection_probe = static_cast<InstanceReflectionProbeData *>(ins->base_data);
 
@@ -1858,6 +1979,9 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 						}
 
 						if (VSG::scene_render->reflection_probe_instance_has_reflection(reflection_probe->instance)) {
+							if (reflection_probe_cull_count == reflection_probe_instance_cull_result.size()) {
+								reflection_probe_instance_cull_result.resize(MAX(reflection_probe_cull_count * 2, int(LIGHTS_CULLED_MIN)));
+							}
 							reflection_probe_instance_cull_result[reflection_probe_cull_count] = reflection_probe->instance;
 							reflection_probe_cull_count++;
 						}
@@ -1871,88 +1995,16 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 			if (!gi_probe->update_element.in_list()) {
 				gi_probe_update_list.add(&gi_probe->update_element);
 			}
-
-		} else if (((1 << ins->base_type) & VS::INSTANCE_GEOMETRY_MASK) && ins->visible && ins->cast_shadows != VS::SHADOW_CASTING_SETTING_SHADOWS_ONLY) {
-
-			keep = true;
-
-			InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(ins->base_data);
-
-			if (ins->redraw_if_visible) {
-				VisualServerRaster::redraw_request();
-			}
-
-			if (ins->base_type == VS::INSTANCE_PARTICLES) {
-				//particles visible? process them
-				VSG::storage->particles_request_process(ins->base);
-				//particles visible? request redraw
-				VisualServerRaster::redraw_request();
-			}
-
-			if (geom->lighting_dirty) {
-				int l = 0;
-				//only called when lights AABB enter/exit this geometry
-				ins->light_instances.resize(geom->lighting.size());
-
-				for (List<Instance *>::Element *E = geom->lighting.front(); E; E = E->next()) {
-
-					InstanceLightData *light = static_cast<InstanceLightData *>(E->get()->base_data);
-
-					ins->light_instances.write[l++] = light->instance;
-				}
-
-				geom->lighting_dirty = false;
-			}
-
-			if (geom->reflection_dirty) {
-				int l = 0;
-				//only called when reflection probe AABB enter/exit this geometry
-				ins->reflection_probe_instances.resize(geom->reflection_probes.size());
-
-				for (List<Instance *>::Element *E = geom->reflection_probes.front(); E; E = E->next()) {
-
-					InstanceReflectionProbeData *reflection_probe = static_cast<InstanceReflectionProbeData *>(E->get()->base_data);
-
-					ins->reflection_probe_instances.write[l++] = reflection_probe->instance;
-				}
-
-				geom->reflection_dirty = false;
-			}
-
-			if (geom->gi_probes_dirty) {
-				int l = 0;
-				//only called when reflection probe AABB enter/exit this geometry
-				ins->gi_probe_instances.resize(geom->gi_probes.size());
-
-				for (List<Instance *>::Element *E = geom->gi_probes.front(); E; E = E->next()) {
-
-					InstanceGIProbeData *gi_probe = static_cast<InstanceGIProbeData *>(E->get()->base_data);
-
-					ins->gi_probe_instances.write[l++] = gi_probe->probe_instance;
-				}
-
-				geom->gi_probes_dirty = false;
-			}
-
-			ins->depth = near_plane.distance_to(ins->transform.origin);
-			ins->depth_layer = CLAMP(int(ins->depth * 16 / z_far), 0, 15);
 		}
 
-		if (!keep) {
-			// remove, no reason to keep
-			instance_cull_count--;
-			SWAP(instance_cull_result[i], instance_cull_result[instance_cull_count]);
-			i--;
-			ins->last_render_pass = 0; // make invalid
-		} else {
-
-			ins->last_render_pass = render_pass;
-		}
+		// remove, no reason to keep
+		instance_cull_count--;
+		SWAP(cull_result[i], cull_result[instance_cull_count]);
+		i--;
 	}
 
 	/* STEP 5 - PROCESS LIGHTS */
 
-	RID *directional_light_ptr = &light_instance_cull_result[light_cull_count];
 	directional_light_count = 0;
 
 	// directional lights
@@ -1961,11 +2013,13 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 		Instance **lights_with_shadow = (Instance **)alloca(sizeof(Instance *) * scenario->directional_lights.size());
 		int directional_shadow_count = 0;
 
-		for (List<Instance *>::Element *E = scenario->directional_lights.front(); E; E = E->next()) {
+		if (light_cull_count + scenario->directional_lights.size() > light_instance_cull_result.size()) {
+			light_instance_cull_result.resize(MAX(light_cull_count + scenario->directional_lights.size(), int(LIGHTS_CULLED_MIN)));
+		}
 
-			if (light_cull_count + directional_light_count >= MAX_LIGHTS_CULLED) {
-				break;
-			}
+		RID *directional_light_ptr = light_instance_cull_result.ptr() + light_cull_count;
+
+		for (List<Instance *>::Element *E = scenario->directional_lights.front(); E; E = E->next()) {
 
 			if (!E->get()->visible)
 				continue;
@@ -1985,9 +2039,11 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 
 		VSG::scene_render->set_directional_shadow_count(directional_shadow_count);
 
+		shadow_cull_job_count = 0;
+
 		for (int i = 0; i < directional_shadow_count; i++) {
 
-			_light_instance_update_shadow(lights_with_shadow[i], p_cam_transform, p_cam_projection, p_cam_orthogonal, p_shadow_atlas, scenario);
+			_add_shadow_cull_job(lights_with_shadow[i], p_cam_transform, p_cam_projection, p_cam_orthogonal, scenario);
 		}
 	}
 
@@ -2086,10 +2142,131 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 
 			if (redraw) {
 				//must redraw!
-				_light_instance_update_shadow(ins, p_cam_transform, p_cam_projection, p_cam_orthogonal, p_shadow_atlas, scenario);
+				_add_shadow_cull_job(ins, p_cam_transform, p_cam_projection, p_cam_orthogonal, scenario);
 			}
 		}
 	}
+
+	{ //cull shadow casters of all the lights in parallel, then render the shadows in order
+
+		ThreadWorkPool::get_singleton()->do_work(shadow_cull_job_count, this, &VisualServerScene::_light_instance_cull_shadow, shadow_cull_jobs.ptr(), 1);
+
+		for (int i = 0; i < shadow_cull_job_count; i++) {
+
+			_light_instance_render_shadow(shadow_cull_jobs[i], p_shadow_atlas);
+		}
+	}
+}
+
+void VisualServerScene::_prepare_culled_geometry(uint32_t p_index, GeometryCullData *p_data) {
+
+	// Runs in a worker thread, must only modify the instance itself.
+
+	Instance *ins = instance_cull_result[p_index];
+
+	if ((p_data->visible_layers & ins->layer_mask) == 0 || !ins->visible || !((1 << ins->base_type) & VS::INSTANCE_GEOMETRY_MASK) || ins->cast_shadows == VS::SHADOW_CASTING_SETTING_SHADOWS_ONLY) {
+		ins->last_render_pass = 0; // make invalid
+		return;
+	}
+
+	if (p_data->occlusion_buffer && !ins->occluder && p_data->occlusion_buffer->is_occluded(ins->transformed_aabb)) {
+		ins->last_render_pass = 0; // hidden behind occluders
+		atomic_increment(&p_data->occluded_count);
+		return;
+	}
+
+	InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(ins->base_data);
+
+	if (geom->lighting_dirty) {
+		int l = 0;
+		//only called when lights AABB enter/exit this geometry
+		ins->light_instances.resize(geom->lighting.size());
+
+		for (List<Instance *>::Element *E = geom->lighting.front(); E; E = E->next()) {
+
+			InstanceLightData *light = static_cast<InstanceLightData *>(E->get()->base_data);
+
+			ins->light_instances.write[l++] = light->instance;
+		}
+
+		geom->lighting_dirty = false;
+	}
+
+	if (geom->reflection_dirty) {
+		int l = 0;
+		//only called when reflection probe AABB enter/exit this geometry
+		ins->reflection_probe_instances.resize(geom->reflection_probes.size());
+
+		for (List<Instance *>::Element *E = geom->reflection_probes.front(); E; E = E->next()) {
+
+			InstanceReflectionProbeData *reflection_probe = static_cast<InstanceReflectionProbeData *>(E->get()->base_data);
+
+			ins->reflection_probe_instances.write[l++] = reflection_probe->instance;
+		}
+
+		geom->reflection_dirty = false;
+	}
+
+	if (geom->gi_probes_dirty) {
+		int l = 0;
+		//only called when reflection probe AABB enter/exit this geometry
+		ins->gi_probe_instances.resize(geom->gi_probes.size());
+
+		for (List<Instance *>::Element *E = geom->gi_probes.front(); E; E = E->next()) {
+
+			InstanceGIProbeData *gi_probe = static_cast<InstanceGIProbeData *>(E->get()->base_data);
+
+			ins->gi_probe_instances.write[l++] = gi_probe->probe_instance;
+		}
+
+		geom->gi_probes_dirty = false;
+	}
+
+	ins->depth = p_data->near_plane.distance_to(ins->transform.origin);
+	ins->depth_layer = CLAMP(int(ins->depth * 16 / p_data->z_far), 0, 15);
+
+	ins->last_render_pass = render_pass;
+}
+
+bool VisualServerScene::_rasterize_occluders(const Transform &p_cam_transform, const CameraMatrix &p_cam_projection, uint32_t p_visible_layers) {
+
+	// Occluders outside the frustum can't hide anything inside it, so only the culled ones are drawn.
+	Instance **cull_result = instance_cull_result.ptr();
+	bool has_occluders = false;
+
+	for (int i = 0; i < instance_cull_count; i++) {
+
+		Instance *ins = cull_result[i];
+
+		if (!ins->occluder || !ins->visible || (p_visible_layers & ins->layer_mask) == 0 || ins->base_type != VS::INSTANCE_MESH) {
+			continue;
+		}
+
+		InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(ins->base_data);
+		if (geom->occluder_faces.empty()) {
+			continue;
+		}
+
+		if (!has_occluders) {
+
+			float aspect = p_cam_projection.get_aspect();
+			int height = aspect > 0 ? int(occlusion_buffer_width / aspect) : occlusion_buffer_width;
+			occlusion_buffer.set_size(occlusion_buffer_width, CLAMP(height, 16, occlusion_buffer_width * 4));
+			occlusion_buffer.begin(p_cam_projection, p_cam_transform);
+			has_occluders = true;
+		}
+
+		occlusion_buffer.add_occluder(ins->transform, geom->occluder_faces.ptr(), geom->occluder_faces.size());
+	}
+
+	if (!has_occluders) {
+		return false;
+	}
+
+	occlusion_buffer.end();
+	occlusion_info.occluders += occlusion_buffer.get_occluder_count();
+
+	return true;
 }
 
 void VisualServerScene::_render_scene(const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_force_environment, RID p_scenario, RID p_shadow_atlas, RID p_reflection_probe, int p_reflection_probe_pass) {
@@ -2108,7 +2285,7 @@ void VisualServerScene::_render_scene(const Transform p_cam_transform, const Cam
 
 	/* PROCESS GEOMETRY AND DRAW SCENE */
 
-	VSG::scene_render->render_scene(p_cam_transform, p_cam_projection, p_cam_orthogonal, (RasterizerScene::InstanceBase **)instance_cull_result, instance_cull_count, light_instance_cull_result, light_cull_count + directional_light_count, reflection_probe_instance_cull_result, reflection_probe_cull_count, environment, p_shadow_atlas, scenario->reflection_atlas, p_reflection_probe, p_reflection_probe_pass);
+	VSG::scene_render->render_scene(p_cam_transform, p_cam_projection, p_cam_orthogonal, (RasterizerScene::InstanceBase **)instance_cull_result.ptr(), instance_cull_count, light_instance_cull_result.ptr(), light_cull_count + directional_light_count, reflection_probe_instance_cull_result.ptr(), reflection_probe_cull_count, environment, p_shadow_atlas, scenario->reflection_atlas, p_reflection_probe, p_reflection_probe_pass);
 }
 
 void VisualServerScene::render_empty_scene(RID p_scenario, RID p_shadow_atlas) {
@@ -3200,6 +3377,73 @@ void VisualServerScene::render_probes() {
 	}
 }
 
+void VisualServerScene::_update_occluder_faces(Instance *p_instance) {
+
+	InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(p_instance->base_data);
+
+	geom->occluder_faces.clear();
+
+	if (!p_instance->occluder || p_instance->base_type != VS::INSTANCE_MESH) {
+		return;
+	}
+
+	// The faces are kept on the CPU side, so the occlusion buffer doesn't need to read them back every frame.
+	// Skinning and blend shapes are ignored, occluders are meant to be simple static meshes.
+	RID mesh = p_instance->base;
+	int surface_count = VSG::storage->mesh_get_surface_count(mesh);
+
+	for (int i = 0; i < surface_count; i++) {
+
+		if (VSG::storage->mesh_surface_get_primitive_type(mesh, i) != VS::PRIMITIVE_TRIANGLES) {
+			continue;
+		}
+
+		if (VSG::storage->mesh_surface_get_format(mesh, i) & VS::ARRAY_FLAG_USE_2D_VERTICES) {
+			continue;
+		}
+
+		Array arrays = VS::get_singleton()->mesh_surface_get_arrays(mesh, i);
+		ERR_CONTINUE(arrays.size() != VS::ARRAY_MAX);
+
+		PoolVector<Vector3> vertices = arrays[VS::ARRAY_VERTEX];
+		PoolVector<int> indices = arrays[VS::ARRAY_INDEX];
+		PoolVector<Vector3>::Read vr = vertices.read();
+
+		int from = geom->occluder_faces.size();
+
+		if (indices.size()) {
+
+			int index_count = indices.size() - indices.size() % 3;
+			int vertex_count = vertices.size();
+			geom->occluder_faces.resize(from + index_count);
+			Vector3 *w = geom->occluder_faces.ptrw() + from;
+			PoolVector<int>::Read ir = indices.read();
+
+			int written = 0;
+			for (int j = 0; j < index_count; j += 3) {
+				// skip faces with bad indices, the rest of the occluder is still usable
+				ERR_CONTINUE(ir[j + 0] < 0 || ir[j + 0] >= vertex_count || ir[j + 1] < 0 || ir[j + 1] >= vertex_count || ir[j + 2] < 0 || ir[j + 2] >= vertex_count);
+				w[written++] = vr[ir[j + 0]];
+				w[written++] = vr[ir[j + 1]];
+				w[written++] = vr[ir[j + 2]];
+			}
+
+			if (written < index_count) {
+				geom->occluder_faces.resize(from + written);
+			}
+		} else {
+
+			int vertex_count = vertices.size() - vertices.size() % 3;
+			geom->occluder_faces.resize(from + vertex_count);
+			Vector3 *w = geom->occluder_faces.ptrw() + from;
+
+			for (int j = 0; j < vertex_count; j++) {
+				w[j] = vr[j];
+			}
+		}
+	}
+}
+
 void VisualServerScene::_update_dirty_instance(Instance *p_instance) {
 
 	if (p_instance->update_aabb) {
@@ -3345,6 +3589,8 @@ void VisualServerScene::_update_dirty_instance(Instance *p_instance) {
 
 				geom->can_cast_shadows = can_cast_shadows;
 			}
+
+			_update_occluder_faces(p_instance);
 		}
 	}
 
@@ -3411,6 +3657,23 @@ bool VisualServerScene::free(RID p_rid) {
 	return true;
 }
 
+void VisualServerScene::update_render_info() {
+
+	occlusion_info_final = occlusion_info;
+	occlusion_info = OcclusionInfo();
+}
+
+int VisualServerScene::get_render_info(VS::RenderInfo p_info) const {
+
+	switch (p_info) {
+		case VS::INFO_OCCLUDERS_IN_FRAME: return occlusion_info_final.occluders;
+		case VS::INFO_OCCLUDED_OBJECTS_IN_FRAME: return occlusion_info_final.occluded_objects;
+		default: {}
+	}
+
+	return 0;
+}
+
 VisualServerScene *VisualServerScene::singleton = NULL;
 
 VisualServerScene::VisualServerScene() {
@@ -3422,6 +3685,11 @@ VisualServerScene::VisualServerScene() {
 	probe_bake_thread_exit = false;
 #endif
 
+	shadow_cull_job_count = 0;
+
+	occlusion_culling_enabled = GLOBAL_GET("rendering/quality/occlusion_culling/enable");
+	occlusion_buffer_width = MAX(int(GLOBAL_GET("rendering/quality/occlusion_culling/buffer_width")), 16);
+
 	render_pass = 1;
 	singleton = this;
 }
@@ -31,11 +31,13 @@
 #ifndef VISUALSERVERSCENE_H
 #define VISUALSERVERSCENE_H
 
+#include "servers/visual/occlusion_buffer.h"
 #include "servers/visual/rasterizer.h"
 
 #include "allocators.h"
+#include "bvh.h"
 #include "geometry.h"
-#include "octree.h"
+#include "local_vector.h"
 #include "os/semaphore.h"
 #include "os/thread.h"
 #include "self_list.h"
@@ -45,11 +47,10 @@ class VisualServerScene {
 public:
 	enum {
 
-		MAX_INSTANCE_CULL = 65536,
-		MAX_LIGHTS_CULLED = 4096,
-		MAX_REFLECTION_PROBES_CULLED = 4096,
 		MAX_ROOM_CULL = 32,
 		MAX_EXTERIOR_PORTALS = 128,
+		INSTANCE_CULL_MIN = 1024,
+		LIGHTS_CULLED_MIN = 64,
 	};
 
 	uint64_t render_pass;
@@ -122,7 +123,7 @@ public:
 		RID self;
 		// well wtf, balloon allocator is slower?
 
-		Octree<Instance, true> octree;
+		BVH<Instance, true> bvh;
 
 		List<Instance *> directional_lights;
 		RID environment;
@@ -137,8 +138,8 @@ public:
 
 	mutable RID_Owner<Scenario> scenario_owner;
 
-	static void *_instance_pair(void *p_self, OctreeElementID, Instance *p_A, int, OctreeElementID, Instance *p_B, int);
-	static void _instance_unpair(void *p_self, OctreeElementID, Instance *p_A, int, OctreeElementID, Instance *p_B, int, void *);
+	static void *_instance_pair(void *p_self, BVHElementID, Instance *p_A, int, BVHElementID, Instance *p_B, int);
+	static void _instance_unpair(void *p_self, BVHElementID, Instance *p_A, int, BVHElementID, Instance *p_B, int, void *);
 
 	virtual RID scenario_create();
 
@@ -158,7 +159,7 @@ public:
 
 		RID self;
 		//scenario stuff
-		OctreeElementID octree_id;
+		BVHElementID bvh_id;
 		Scenario *scenario;
 		SelfList<Instance> scenario_item;
 
@@ -180,6 +181,8 @@ public:
 		float lod_end_hysteresis;
 		RID lod_instance;
 
+		bool occluder;
+
 		uint64_t last_render_pass;
 		uint64_t last_frame_pass;
 
@@ -206,7 +209,7 @@ public:
 				scenario_item(this),
 				update_item(this) {
 
-			octree_id = 0;
+			bvh_id = 0;
 			scenario = NULL;
 
 			update_aabb = false;
@@ -222,6 +225,8 @@ public:
 			lod_begin_hysteresis = 0;
 			lod_end_hysteresis = 0;
 
+			occluder = false;
+
 			last_render_pass = 0;
 			last_frame_pass = 0;
 			version = 1;
@@ -256,6 +261,8 @@ public:
 
 		List<Instance *> lightmap_captures;
 
+		Vector<Vector3> occluder_faces; // local space triangles, only kept for meshes used as occluders
+
 		InstanceGeometryData() {
 
 			lighting_dirty = false;
@@ -434,16 +441,94 @@ public:
 		}
 	};
 
+	// Cull results are shared by every view rendered, they grow as needed and are kept between frames.
 	int instance_cull_count;
-	Instance *instance_cull_result[MAX_INSTANCE_CULL];
-	Instance *instance_shadow_cull_result[MAX_INSTANCE_CULL]; //used for generating shadowmaps
-	Instance *light_cull_result[MAX_LIGHTS_CULLED];
-	RID light_instance_cull_result[MAX_LIGHTS_CULLED];
+	LocalVector<Instance *> instance_cull_result;
+	LocalVector<Instance *> light_cull_result;
+	LocalVector<RID> light_instance_cull_result; // directional lights are appended after the culled ones
 	int light_cull_count;
 	int directional_light_count;
-	RID reflection_probe_instance_cull_result[MAX_REFLECTION_PROBES_CULLED];
+	LocalVector<RID> reflection_probe_instance_cull_result;
 	int reflection_probe_cull_count;
 
+	struct GeometryCullData {
+
+		uint32_t visible_layers;
+		Plane near_plane;
+		float z_far;
+		const OcclusionBuffer *occlusion_buffer; // NULL if there are no occluders in view
+		uint32_t occluded_count;
+	};
+
+	bool occlusion_culling_enabled;
+	int occlusion_buffer_width;
+	OcclusionBuffer occlusion_buffer;
+
+	struct OcclusionInfo {
+
+		int occluders;
+		int occluded_objects;
+
+		OcclusionInfo() {
+			occluders = 0;
+			occluded_objects = 0;
+		}
+	};
+
+	OcclusionInfo occlusion_info;
+	OcclusionInfo occlusion_info_final;
+
+	// Shadow casters are culled for all the lights at once in worker threads, then rendered in order.
+	struct ShadowCullPass {
+
+		LocalVector<Instance *> casters; // grows as needed, kept between frames
+		int caster_count;
+		Plane near_plane; // instance depth is measured from here
+		CameraMatrix projection;
+		Transform transform;
+		float far;
+		float split;
+		float bias_scale;
+		bool skip;
+
+		ShadowCullPass() {
+			caster_count = 0;
+			far = 0;
+			split = 0;
+			bias_scale = 1.0;
+			skip = false;
+		}
+	};
+
+	struct ShadowCullJob {
+
+		Instance *light;
+		Scenario *scenario;
+		Transform cam_transform;
+		CameraMatrix cam_projection;
+		bool cam_orthogonal;
+
+		int pass_count;
+		ShadowCullPass passes[6];
+
+		// cube shadows set the dual paraboloid transform back when done
+		bool restore_transform;
+		Transform light_transform;
+		float radius;
+
+		ShadowCullJob() {
+			light = NULL;
+			scenario = NULL;
+			cam_orthogonal = false;
+			pass_count = 0;
+			restore_transform = false;
+			radius = 0;
+		}
+	};
+
+	LocalVector<ShadowCullJob> shadow_cull_jobs;
+	int shadow_cull_job_count;
+
 	RID_Owner<Instance> instance_owner;
 
 	// from can be mesh, light,  area and portal so far.
@@ -483,7 +568,14 @@ public:
 	_FORCE_INLINE_ void _update_dirty_instance(Instance *p_instance);
 	_FORCE_INLINE_ void _update_instance_lightmap_captures(Instance *p_instance);
 
-	_FORCE_INLINE_ void _light_instance_update_shadow(Instance *p_instance, const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_shadow_atlas, Scenario *p_scenario);
+	static int _cull_convex(Scenario *p_scenario, const Plane *p_planes, int p_plane_count, LocalVector<Instance *> &r_result, uint32_t p_mask = 0xFFFFFFFF);
+	int _cull_shadow_casters(Scenario *p_scenario, const Plane *p_planes, int p_plane_count, LocalVector<Instance *> &r_casters);
+	void _add_shadow_cull_job(Instance *p_instance, const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, Scenario *p_scenario);
+	void _light_instance_cull_shadow(uint32_t p_index, ShadowCullJob *p_jobs);
+	void _light_instance_render_shadow(ShadowCullJob &p_job, RID p_shadow_atlas);
+	void _prepare_culled_geometry(uint32_t p_index, GeometryCullData *p_data);
+	bool _rasterize_occluders(const Transform &p_cam_transform, const CameraMatrix &p_cam_projection, uint32_t p_visible_layers);
+	void _update_occluder_faces(Instance *p_instance);
 
 	void _prepare_scene(const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_force_environment, uint32_t p_visible_layers, RID p_scenario, RID p_shadow_atlas, RID p_reflection_probe);
 	void _render_scene(const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_force_environment, RID p_scenario, RID p_shadow_atlas, RID p_reflection_probe, int p_reflection_probe_pass);
@@ -541,6 +633,9 @@ public:
 
 	void render_probes();
 
+	void update_render_info();
+	int get_render_info(VS::RenderInfo p_info) const;
+
 	bool free(RID p_rid);
 
 	VisualServerScene();
@@ -30,6 +30,7 @@
 
 #include "visual_server_viewport.h"
 
+#include "frame_arena.h"
 #include "project_settings.h"
 #include "visual_server_canvas.h"
 #include "visual_server_global.h"
@@ -74,7 +75,8 @@ void VisualServerViewport::_draw_viewport(Viewport *p_viewport, ARVRInterface::E
 	if (!p_viewport->hide_canvas) {
 		int i = 0;
 
-		Map<Viewport::CanvasKey, Viewport::CanvasData *> canvas_map;
+		// rebuilt every frame, its elements come from the frame arena
+		Map<Viewport::CanvasKey, Viewport::CanvasData *, Comparator<Viewport::CanvasKey>, FrameAllocator> canvas_map;
 
 		Rect2 clip_rect(0, 0, p_viewport->size.x, p_viewport->size.y);
 		RasterizerCanvas::Light *lights = NULL;
@@ -190,7 +192,7 @@ void VisualServerViewport::_draw_viewport(Viewport *p_viewport, ARVRInterface::E
 			scenario_draw_canvas_bg = false;
 		}
 
-		for (Map<Viewport::CanvasKey, Viewport::CanvasData *>::Element *E = canvas_map.front(); E; E = E->next()) {
+		for (Map<Viewport::CanvasKey, Viewport::CanvasData *, Comparator<Viewport::CanvasKey>, FrameAllocator>::Element *E = canvas_map.front(); E; E = E->next()) {
 
 			VisualServerCanvas::Canvas *canvas = static_cast<VisualServerCanvas::Canvas *>(E->get()->canvas);
 
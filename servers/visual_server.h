@@ -834,6 +834,7 @@ public:
 	enum InstanceFlags {
 		INSTANCE_FLAG_USE_BAKED_LIGHT,
 		INSTANCE_FLAG_DRAW_NEXT_FRAME_IF_VISIBLE,
+		INSTANCE_FLAG_OCCLUDER,
 		INSTANCE_FLAG_MAX
 	};
 
@@ -999,6 +1000,8 @@ public:
 		INFO_VIDEO_MEM_USED,
 		INFO_TEXTURE_MEM_USED,
 		INFO_VERTEX_MEM_USED,
+		INFO_OCCLUDERS_IN_FRAME,
+		INFO_OCCLUDED_OBJECTS_IN_FRAME,
 	};
 
 	virtual int get_render_info(RenderInfo p_info) = 0;